@@ -37,7 +37,32 @@ private:
     int *max_occupancy_per_ctx;
     int *to_be_reclaimed_per_ctx; 
     int *resource_size_per_ctx; 
+    int *full_size_per_ctx;     // resource_size_per_ctx at limit 1.0
     int already_initialized; //Used for limit policies
+    // 1D array, by resource: sum of occupancy_per_ctx over all contexts,
+    // kept up to date incrementally so space_available() is O(1)
+    int *total_occupancy;
+
+    // STEEPDES: each context's share (fraction of the full pooled size) is
+    // adjusted by steepest ascent on weighted speedup.  A round is one base
+    // epoch at the current shares, then one epoch per context with just its
+    // share perturbed; the gradient is estimated from those, and all
+    // shares step along it.  Speedups are relative to each context's IPC
+    // in the base epoch, since stand-alone IPCs aren't known.
+    struct {
+        i64 epoch_cyc;
+        double delta;           // perturbation size
+        double step;            // share change per unit gradient
+        double min_share;
+        double *share;          // [CtxCount]
+        double *perturb;        // [CtxCount] signed delta tried this round
+        double *base_ipc;       // [CtxCount]
+        double *trial_ws;       // [CtxCount] weighted speedup per trial
+        i64 *commits_at_start;  // [CtxCount]
+        i64 epoch_start;
+        int trial;              // context being perturbed, -1: base epoch
+        i64 rounds;
+    } sd;
     
     int get_resource_size_per_ctx(shared_resource sr, int id)
     {
@@ -109,6 +134,101 @@ private:
     }
 
 
+    // Set every context's pooled sizes from its STEEPDES share
+    void apply_shares()
+    {
+        for (int sr = 0; sr < last_shared_resource; sr++) {
+            for (int ctx_id = 0; ctx_id < CtxCount; ctx_id++) {
+                int i = sr*CtxCount+ctx_id;
+                int size = int(sd.share[ctx_id] * full_size_per_ctx[i]);
+                resource_size_per_ctx[i] = MAX_SCALAR(size, 1);
+            }
+        }
+    }
+
+    void steepdes_init()
+    {
+        sd.epoch_cyc = simcfg_get_i64("ResourcePooling/SteepDes/epoch_cyc");
+        sd.delta = simcfg_get_double("ResourcePooling/SteepDes/delta");
+        sd.step = simcfg_get_double("ResourcePooling/SteepDes/step");
+        sd.min_share = simcfg_get_double("ResourcePooling/SteepDes/min_share");
+        double init_share =
+            simcfg_get_double("ResourcePooling/SteepDes/init_share");
+        if ((sd.epoch_cyc < 1) || (sd.delta <= 0) || (sd.delta >= 1) ||
+            (sd.min_share <= 0) || (sd.min_share > 1) ||
+            (init_share < sd.min_share) || (init_share > 1)) {
+            fprintf(stderr, "Bad ResourcePooling/SteepDes parameters\n");
+            sim_abort();
+        }
+        sd.share = (double *)emalloc_zero(CtxCount*sizeof(double));
+        sd.perturb = (double *)emalloc_zero(CtxCount*sizeof(double));
+        sd.base_ipc = (double *)emalloc_zero(CtxCount*sizeof(double));
+        sd.trial_ws = (double *)emalloc_zero(CtxCount*sizeof(double));
+        sd.commits_at_start = (i64 *)emalloc_zero(CtxCount*sizeof(i64));
+        for (int i = 0; i < CtxCount; i++)
+            sd.share[i] = init_share;
+        sd.trial = -1;
+        sd.rounds = 0;
+        apply_shares();
+        steepdes_start_epoch();
+    }
+
+    void steepdes_start_epoch()
+    {
+        sd.epoch_start = cyc;
+        for (int i = 0; i < CtxCount; i++)
+            sd.commits_at_start[i] = Contexts[i]->stats.total_commits;
+    }
+
+    void steepdes_epoch_done()
+    {
+        double epoch_len = double(cyc - sd.epoch_start);
+        double ws = 0;
+        for (int i = 0; i < CtxCount; i++) {
+            double ipc = (Contexts[i]->stats.total_commits -
+                          sd.commits_at_start[i]) / epoch_len;
+            if (sd.trial < 0)
+                sd.base_ipc[i] = ipc;
+            // (idle in the base epoch: no basis for a speedup)
+            ws += (sd.base_ipc[i] > 0) ? (ipc / sd.base_ipc[i]) : 1.0;
+        }
+
+        if (sd.trial >= 0) {
+            sd.trial_ws[sd.trial] = ws;
+            sd.share[sd.trial] -= sd.perturb[sd.trial];
+            sd.trial++;
+        } else {
+            sd.trial = 0;
+        }
+
+        if (sd.trial < CtxCount) {
+            // Perturb the next context, downward if it's already maxed out
+            int t = sd.trial;
+            sd.perturb[t] = (sd.share[t] + sd.delta <= 1.0) ?
+                sd.delta : -sd.delta;
+            sd.share[t] += sd.perturb[t];
+        } else {
+            // Take the step; the base epoch's weighted speedup is CtxCount
+            for (int i = 0; i < CtxCount; i++) {
+                double grad = (sd.trial_ws[i] - CtxCount) / sd.perturb[i];
+                double share = sd.share[i] + sd.step * grad;
+                sd.share[i] = MIN_SCALAR(MAX_SCALAR(share, sd.min_share),
+                                         1.0);
+            }
+            sd.trial = -1;
+            sd.rounds++;
+            if (debug_adapt_mgr) {
+                printf("STEEPDES round %s, cyc %s: shares", 
+                       fmt_i64(sd.rounds), fmt_i64(cyc));
+                for (int i = 0; i < CtxCount; i++)
+                    printf(" %.3f", sd.share[i]);
+                printf("\n");
+            }
+        }
+        apply_shares();
+        steepdes_start_epoch();
+    }
+
     
 public:
 
@@ -145,6 +265,7 @@ public:
     {
         assert ( occupancy_per_ctx[sr*CtxCount+ctx->id] < INT_MAX - value);
         occupancy_per_ctx[sr*CtxCount+ctx->id] += value;
+        total_occupancy[sr] += value;
     }
 
     void make_final()
@@ -154,6 +275,7 @@ public:
             // Check for underflow
             assert ( occupancy_per_ctx[i] > INT_MIN + to_be_reclaimed_per_ctx[i]);
             occupancy_per_ctx[i] -= to_be_reclaimed_per_ctx[i];
+            total_occupancy[i/CtxCount] -= to_be_reclaimed_per_ctx[i];
             to_be_reclaimed_per_ctx[i] = 0; 
             // Update max values
             max_occupancy_per_ctx[i] = MAX_SCALAR(max_occupancy_per_ctx[i], occupancy_per_ctx[i]);
@@ -177,6 +299,16 @@ public:
             sim_assert( stageq_count(Contexts[i]->core->stage.intq) == occupancy_per_ctx[IQ*CtxCount+i]);
             sim_assert( stageq_count(Contexts[i]->core->stage.floatq) == occupancy_per_ctx[FQ*CtxCount+i]);
         }
+#ifdef DEBUG
+        // Verification: incremental totals
+        for (int sr = 0; sr < last_shared_resource; sr++)
+        {
+            int sum = 0;
+            for (int i = sr*CtxCount; i < (sr+1)*CtxCount; i++)
+                sum += occupancy_per_ctx[i];
+            sim_assert(total_occupancy[sr] == sum);
+        }
+#endif
     }
     
     void update_adapt_mgr_dec_tentative(context * ctx, shared_resource sr, int value)
@@ -208,11 +340,7 @@ public:
     {
 //        if (!(cyc%10000))
 //            printf("Debugging time\n");
-        int total_occupancy = 0;
-        for (int i = sr*CtxCount; i < (sr+1)*CtxCount; i++){
-            total_occupancy += occupancy_per_ctx[i];
-        }
-        return resource_size_per_ctx[sr*CtxCount+ctx->id] - total_occupancy;
+        return resource_size_per_ctx[sr*CtxCount+ctx->id] - total_occupancy[sr];
     }
 
     
@@ -259,6 +387,18 @@ public:
 	  break;
 
 
+        }
+        case STEEPDES: {
+            if (!already_initialized)
+            {
+                already_initialized = 1;
+                steepdes_init();
+            }
+            else if (cyc - sd.epoch_start >= sd.epoch_cyc)
+            {
+                steepdes_epoch_done();
+            }
+            break;
         }
         default:
             fprintf(stderr, "Unrecognized Limit Policy\n");
@@ -314,7 +454,14 @@ public:
                 sizeof(int));
         resource_size_per_ctx = (int *)emalloc_zero(CtxCount*last_shared_resource*
                 sizeof(u32));
+        total_occupancy = (int *)emalloc_zero(last_shared_resource*
+                sizeof(int));
         aggregate_pooled_resources(1.0); 
+        full_size_per_ctx = (int *)emalloc_zero(CtxCount*last_shared_resource*
+                sizeof(int));
+        memcpy(full_size_per_ctx, resource_size_per_ctx,
+               CtxCount*last_shared_resource*sizeof(int));
+        memset(&sd, 0, sizeof(sd));
         
         //print_pooled_resources();
 
@@ -332,6 +479,13 @@ public:
         free(resource_size_per_ctx); 
         free(occupancy_per_ctx); 
         free(max_occupancy_per_ctx); 
+        free(total_occupancy);
+        free(full_size_per_ctx);
+        free(sd.share);
+        free(sd.perturb);
+        free(sd.base_ipc);
+        free(sd.trial_ws);
+        free(sd.commits_at_start);
     }
 };
 
@@ -386,6 +540,13 @@ AdaptMgr::debug_print_internal_state(const char *pref)
             printf("\n%s%s", pref, pref);
     }
     printf("\n"); 
+
+    if (lp == STEEPDES && sd.share) {
+        printf("%sSTEEPDES rounds %s, shares:", pref, fmt_i64(sd.rounds));
+        for (int i = 0; i < CtxCount; i++)
+            printf(" %.3f", sd.share[i]);
+        printf("\n");
+    }
 }
 
 
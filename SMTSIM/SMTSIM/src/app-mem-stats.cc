@@ -0,0 +1,260 @@
+//
+// Per-app memory latency distributions and memory-level parallelism
+//
+// $Id$
+//
+
+const char RCSid_1760000030[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "app-mem-stats.h"
+#include "online-stats.h"
+#include "utils.h"
+
+
+const char *AppMemLevel_names[] = { "L1", "L2", "L3", "Mem", "Coher", NULL };
+
+
+namespace {
+
+const int ExactBucketLimit = 16;        // latencies below this: own bucket
+const int SubBucketsPerOctave = 8;      // must be a power of two <= limit
+
+// Map a latency to the (inclusive) lower bound of its bucket
+int
+latency_bucket(i64 latency)
+{
+    if (latency < 0)
+        latency = 0;
+    if (latency > INT_MAX)
+        latency = INT_MAX;
+    int lat = static_cast<int>(latency);
+    if (lat < ExactBucketLimit)
+        return lat;
+    int octave_base = ExactBucketLimit;
+    while ((octave_base <= (INT_MAX / 2)) && ((octave_base * 2) <= lat))
+        octave_base *= 2;
+    int step = octave_base / SubBucketsPerOctave;
+    return octave_base + (((lat - octave_base) / step) * step);
+}
+
+
+struct LevelStats {
+    HistCount_Int hist;         // key: bucket lower bound (cycles)
+    i64 sum;                    // exact sum of latencies, for the mean
+    LevelStats() : sum(0) { }
+    void reset() { hist.reset(); sum = 0; }
+    i64 count() const { return hist.total_count(); }
+
+    // Lower bound of the bucket holding the "frac" quantile, or -1 if empty
+    int quantile(double frac) const {
+        i64 total = count();
+        if (!total)
+            return -1;
+        i64 target = static_cast<i64>(frac * total);
+        if (target >= total)
+            target = total - 1;
+        HistCount_Int::KeySet keys;
+        hist.get_all_keys(keys);
+        i64 seen = 0;
+        int last = -1;
+        for (HistCount_Int::KeySet::const_iterator iter = keys.begin();
+             iter != keys.end(); ++iter) {
+            last = *iter;
+            seen += hist.get_count(*iter);
+            if (seen > target)
+                break;
+        }
+        return last;
+    }
+};
+
+
+void
+hist_subtract(HistCount_Int& dest, const HistCount_Int& l,
+              const HistCount_Int& r)
+{
+    HistCount_Int::KeySet keys;
+    l.get_all_keys(keys);
+    HistCount_Int result;
+    for (HistCount_Int::KeySet::const_iterator iter = keys.begin();
+         iter != keys.end(); ++iter) {
+        i64 diff = l.get_count(*iter) - r.get_count(*iter);
+        sim_assert(diff >= 0);
+        if (diff)
+            result.add_count(*iter, diff);
+    }
+    dest = result;
+}
+
+
+void
+print_buckets(FILE *out, const HistCount_Int& hist, char sep)
+{
+    HistCount_Int::KeySet keys;
+    hist.get_all_keys(keys);
+    bool first = true;
+    for (HistCount_Int::KeySet::const_iterator iter = keys.begin();
+         iter != keys.end(); ++iter) {
+        i64 count = hist.get_count(*iter);
+        if (!count)
+            continue;
+        fprintf(out, "%s%d:%s", (first) ? "" : ((sep == ',') ? "," : " "),
+                *iter, fmt_i64(count));
+        first = false;
+    }
+}
+
+} // Anonymous namespace close
+
+
+struct AppMemStats {
+    LevelStats levels[AppMemLevel_last];
+    i64 mlp_busy_cyc;           // cycles with >= 1 outstanding miss
+    i64 mlp_outstanding_sum;    // outstanding misses, summed over those
+
+    AppMemStats() { reset(); }
+    void reset() {
+        for (int i = 0; i < AppMemLevel_last; i++)
+            levels[i].reset();
+        mlp_busy_cyc = 0;
+        mlp_outstanding_sum = 0;
+    }
+};
+
+
+
+//
+// C interface
+//
+
+AppMemStats *
+appmemstats_create(void)
+{
+    return new AppMemStats();
+}
+
+
+void
+appmemstats_destroy(AppMemStats *ams)
+{
+    delete ams;
+}
+
+
+void
+appmemstats_reset(AppMemStats *ams)
+{
+    ams->reset();
+}
+
+
+void
+appmemstats_assign(AppMemStats *dest, const AppMemStats *src)
+{
+    *dest = *src;
+}
+
+
+void
+appmemstats_subtract(AppMemStats *dest, const AppMemStats *l,
+                     const AppMemStats *r)
+{
+    for (int i = 0; i < AppMemLevel_last; i++) {
+        hist_subtract(dest->levels[i].hist, l->levels[i].hist,
+                      r->levels[i].hist);
+        dest->levels[i].sum = l->levels[i].sum - r->levels[i].sum;
+    }
+    dest->mlp_busy_cyc = l->mlp_busy_cyc - r->mlp_busy_cyc;
+    dest->mlp_outstanding_sum = l->mlp_outstanding_sum -
+        r->mlp_outstanding_sum;
+}
+
+
+void
+appmemstats_add_latency(AppMemStats *ams, AppMemLevel level, i64 latency)
+{
+    sim_assert(ENUM_OK(AppMemLevel, level));
+    LevelStats& lev = ams->levels[level];
+    lev.hist.add_count(latency_bucket(latency));
+    lev.sum += (latency > 0) ? latency : 0;
+}
+
+
+void
+appmemstats_add_mlp(AppMemStats *ams, i64 busy_cyc, i64 outstanding_sum)
+{
+    sim_assert(busy_cyc >= 0);
+    sim_assert(outstanding_sum >= busy_cyc);
+    ams->mlp_busy_cyc += busy_cyc;
+    ams->mlp_outstanding_sum += outstanding_sum;
+}
+
+
+i64
+appmemstats_mlp_busy_cyc(const AppMemStats *ams)
+{
+    return ams->mlp_busy_cyc;
+}
+
+
+i64
+appmemstats_mlp_outstanding_sum(const AppMemStats *ams)
+{
+    return ams->mlp_outstanding_sum;
+}
+
+
+double
+appmemstats_mlp(const AppMemStats *ams)
+{
+    return (ams->mlp_busy_cyc) ?
+        static_cast<double>(ams->mlp_outstanding_sum) / ams->mlp_busy_cyc :
+        0.0;
+}
+
+
+void
+appmemstats_print(const AppMemStats *ams, void *c_FILE_out,
+                  const char *prefix)
+{
+    FILE *out = static_cast<FILE *>(c_FILE_out);
+    fprintf(out, "%smlp: %.3f (busy_cyc %s)\n", prefix,
+            appmemstats_mlp(ams), fmt_i64(ams->mlp_busy_cyc));
+    for (int i = 0; i < AppMemLevel_last; i++) {
+        const LevelStats& lev = ams->levels[i];
+        i64 count = lev.count();
+        if (!count)
+            continue;
+        fprintf(out, "%slat_%s: n %s mean %.2f p50 %d p90 %d p99 %d"
+                " hist: ", prefix, AppMemLevel_names[i], fmt_i64(count),
+                static_cast<double>(lev.sum) / count,
+                lev.quantile(0.50), lev.quantile(0.90), lev.quantile(0.99));
+        print_buckets(out, lev.hist, ' ');
+        fprintf(out, "\n");
+    }
+}
+
+
+void
+appmemstats_print_compact(const AppMemStats *ams, void *c_FILE_out)
+{
+    FILE *out = static_cast<FILE *>(c_FILE_out);
+    bool first = true;
+    for (int i = 0; i < AppMemLevel_last; i++) {
+        const LevelStats& lev = ams->levels[i];
+        if (!lev.count())
+            continue;
+        fprintf(out, "%s%s=", (first) ? "" : ";", AppMemLevel_names[i]);
+        print_buckets(out, lev.hist, ',');
+        first = false;
+    }
+    if (first)
+        fprintf(out, "-");
+}
@@ -0,0 +1,65 @@
+// -*- C++ -*-
+//
+// Per-app memory latency distributions and memory-level parallelism
+//
+// $Id$
+//
+
+#ifndef APP_MEM_STATS_H
+#define APP_MEM_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each AppStateExtras owns one of these.  Latencies are those summed into
+// "mem_delay" (address-ready to data-ready, per data access), split by the
+// level which serviced the access, and histogrammed with log-scaled buckets:
+// exact below 16 cycles, then eight buckets per power of two.  MLP is the
+// average count of the app's outstanding D-cache miss blocks (MSHR
+// producers), over the cycles in which it had at least one.
+
+typedef struct AppMemStats AppMemStats;
+
+typedef enum {
+    AppMem_L1, AppMem_L2, AppMem_L3, AppMem_Mem,
+    AppMem_Coher,               // supplied by a peer cache
+    AppMemLevel_last
+} AppMemLevel;
+extern const char *AppMemLevel_names[];
+
+AppMemStats *appmemstats_create(void);
+void appmemstats_destroy(AppMemStats *ams);
+void appmemstats_reset(AppMemStats *ams);
+
+// Stats-copy helpers, for interval logging (see appextra_assign_stats(),
+// appextra_subtract_stats())
+void appmemstats_assign(AppMemStats *dest, const AppMemStats *src);
+void appmemstats_subtract(AppMemStats *dest, const AppMemStats *l,
+                          const AppMemStats *r);
+
+void appmemstats_add_latency(AppMemStats *ams, AppMemLevel level,
+                             i64 latency);
+// Credit MLP accrued while the app was on a context (mshr_data_mlp() deltas)
+void appmemstats_add_mlp(AppMemStats *ams, i64 busy_cyc,
+                         i64 outstanding_sum);
+
+i64 appmemstats_mlp_busy_cyc(const AppMemStats *ams);
+i64 appmemstats_mlp_outstanding_sum(const AppMemStats *ams);
+// SimNAN-style: returns 0 if there were no busy cycles
+double appmemstats_mlp(const AppMemStats *ams);
+
+// Multi-line summary: one line per level with samples (count, mean,
+// percentiles, then "bucket:count" pairs)
+void appmemstats_print(const AppMemStats *ams, void *c_FILE_out,
+                       const char *prefix);
+
+// Compact single-token form for log files: "L1=b:c,b:c;L2=...;..."
+void appmemstats_print_compact(const AppMemStats *ams, void *c_FILE_out);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // APP_MEM_STATS_H
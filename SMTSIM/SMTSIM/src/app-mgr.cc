@@ -29,6 +29,7 @@ const char RCSid_1108950676[] =
 #include "utils.h"
 #include "utils-cc.h"
 #include "app-state.h"
+#include "prog-mem.h"
 #include "context.h"
 #include "dyn-inst.h"
 #include "core-resources.h"
@@ -44,6 +45,7 @@ const char RCSid_1108950676[] =
 #include "cache-array.h"
 #include "cache.h"
 #include "simple-pre.h"
+#include "wsm.h"
 
 using std::deque;
 using std::make_pair;
@@ -177,8 +179,23 @@ class PerAppInfo {
         BasicStat_I64 activ_commit;     // start_app -> finalfill(commit=t)
         BasicStat_I64 migrate_fetch;    // deact_sum+activ_fetch, for migrate
         BasicStat_I64 migrate_commit;   // deact_sum+activ_commit, for migrate
+        // migrate_warmup: post-migrate start_app -> Nth commit after that,
+        // for N = Hacking/migrate_warmup_commits (cold-cache cost, roughly)
+        BasicStat_I64 migrate_warmup;
     } migrate_timing;
 
+    // Watches for the end of post-migrate warmup
+    class WarmupCB : public CBQ_Callback {
+        PerAppInfo& ainfo;
+    public:
+        WarmupCB(PerAppInfo& ainfo_) : ainfo(ainfo_) { }
+        i64 invoke(CBQ_Args *args) {
+            ainfo.warmup_done();
+            return -1;
+        }
+    };
+    WarmupCB *warmup_cb;        // pending on app's commit-watch, or NULL
+
     struct {                    // post-halt callbacks
         vector<CBQ_Callback *> ord;             // (in registration order)
         set<CBQ_Callback *> uniq;               // (to ensure uniqueness)
@@ -187,7 +204,7 @@ class PerAppInfo {
 public:    
     PerAppInfo(AppState *as_) 
         : as(as_), id(as->app_id), state(AI_Ready), curr_ctx_id(-1),
-          prev_ctx_id(-1) {
+          prev_ctx_id(-1), warmup_cb(NULL) {
         memset(&st, 0, sizeof(st));     // Zero stats
         sim_assert(id >= 0);
         migrate_timing.last_halt_start = -1;
@@ -197,6 +214,7 @@ public:
         migrate_timing.last_finalfill_commit = -1;
     }
     ~PerAppInfo() {
+        cancel_warmup_watch();
         for (int i = 0; i < (int) posthalt_cb.ord.size(); i++)
             delete posthalt_cb.ord[i];
     }
@@ -211,6 +229,9 @@ public:
     bool is_resident_stalled() const {
         return state == AI_Running_LongMiss;
     }
+    bool is_resident() const {         // running, or stalled in place
+        return (state == AI_Running) || is_resident_stalled();
+    }
         
     void set_state(AppInfoState state_) {
         state_cyc.add_count((int) state, cyc - st.last_state_change);
@@ -345,11 +366,38 @@ public:
         sim_assert(state == AI_Running);
         sim_assert(target_ctx_id >= 0);
         st.migrates++;
+        cancel_warmup_watch();
         set_state(AI_SwapOut_Migrate);
         migrate_target_ctx = target_ctx_id;
         migrate_timing.last_halt_start = cyc;
         migrate_timing.last_migrate_start = cyc;
     }
+    void start_warmup_watch(i64 warmup_commits) {
+        // swapping in after a migrate; time the next "warmup_commits"
+        sim_assert(warmup_commits > 0);
+        cancel_warmup_watch();
+        warmup_cb = new WarmupCB(*this);
+        callbackq_enqueue(as->extra->watch.commit_count,
+                          app_commits() + warmup_commits, warmup_cb);
+    }
+    void cancel_warmup_watch() {
+        if (warmup_cb) {
+            callbackq_cancel(as->extra->watch.commit_count, warmup_cb);
+            warmup_cb = NULL;
+        }
+    }
+    void warmup_done() {
+        // (warmup_cb is deleted by its queue after this returns)
+        sim_assert(warmup_cb);
+        warmup_cb = NULL;
+        i64 warmup_cyc = cyc - st.last_swapin_cyc;
+        if (debug || kVerboseMigrateStats) {
+            printf("appmgr: A%d post-migrate warmup done at %s; "
+                   "%s cyc since swap-in\n", id, fmt_now(),
+                   fmt_i64(warmup_cyc));
+        }
+        migrate_timing.migrate_warmup.add_sample(warmup_cyc);
+    }
     bool last_halt_was_for_migrate() const {
         // test: have we ever migrated, and was the last halt for a migrate?
         return (migrate_timing.last_migrate_start >= 0) &&
@@ -422,6 +470,7 @@ public:
         sim_assert(!is_sched());
         return cyc - st.last_swapout_cyc;
     }
+    i64 g_long_misses() const { return st.long_misses; }
 
     void register_posthalt_callback(CBQ_Callback *cb) {
         sim_assert(posthalt_cb.uniq.size() == posthalt_cb.ord.size());
@@ -461,6 +510,8 @@ public:
                 fmt_bstat_i64(migrate_timing.migrate_fetch).c_str());
         fprintf(out, "%smigrate_commit: %s\n", pf,
                 fmt_bstat_i64(migrate_timing.migrate_commit).c_str());
+        fprintf(out, "%smigrate_warmup: %s\n", pf,
+                fmt_bstat_i64(migrate_timing.migrate_warmup).c_str());
     }
 };
 
@@ -1225,6 +1276,10 @@ public:
     virtual bool will_schedule() const = 0;
     virtual int schedule_one() = 0;
     virtual void undo_schedule(int app_id) = 0;
+
+    // Called once all contexts are registered
+    virtual void setup_done() { }
+    virtual void printstats(FILE *out, const char *pf) const { }
 };
 
 
@@ -1265,6 +1320,382 @@ public:
 };
 
 
+// SOS-style symbiotic scheduling, for mixes with more apps than contexts.
+// A sampling phase runs a series of candidate coschedules (sets of apps,
+// one per context) for "sample_slices" timeslices each, measuring each
+// app's IPC over all but the first (warm-up) slice.  Each candidate is
+// scored by weighted speedup, sum(IPC / IPC_ref), where IPC_ref is the
+// app's best IPC over all candidates sampled; the winner then runs until
+// "max_run_slices" elapse, its aggregate IPC drifts from the sampled value
+// by more than "phase_change_thresh" (a phase change), or the set of apps
+// changes, any of which starts a new sampling phase.
+//
+// The target coschedule is enforced here: ready target apps are always
+// scheduled first (others fill contexts only when no target app is ready),
+// and running non-target apps are halted at each slice boundary.
+class ASched_SOS : public ASched_OldestApp {
+    enum Phase { Sampling, Running };
+
+    class SliceCB : public CBQ_Callback {
+        ASched_SOS& sched;
+    public:
+        SliceCB(ASched_SOS& sched_) : sched(sched_) { }
+        i64 invoke(CBQ_Args *args) {
+            sched.slice_end();
+            return cyc + sched.timeslice_cyc;
+        }
+    };
+
+    struct AppSample {
+        int last_ctx;           // context at last slice end, or -1
+        i64 last_commits;
+        AppSample() : last_ctx(-1), last_commits(0) { }
+    };
+    typedef map<int, AppSample> AppSampleMap;
+
+    i64 timeslice_cyc;
+    int sample_slices;
+    int max_candidates;
+    int max_run_slices;
+    double phase_change_thresh;
+    PRNGState prng;
+
+    Phase phase;
+    IdSet known_apps;           // app set at start of current phase
+    IdSet target;               // coschedule being enforced
+    vector<IdVec> candidates;
+    vector<double> cand_score;
+    int cand_idx;
+    int cand_slices;            // slices run so far, current candidate
+    map<int, i64> meas_commits; // app -> commits at start of measurement
+    i64 meas_start_cyc;
+    vector< map<int, double> > cand_ipc;    // per candidate: app -> IPC
+    double run_ipc;             // sampled aggregate IPC of running target
+    double run_score;
+    int run_slices;
+    AppSampleMap samples;
+    scoped_ptr<CBQ_Callback> slice_cb;  // NULL => none; in GlobalEventQueue
+
+    struct {
+        i64 slices;
+        i64 sample_phases;
+        i64 candidates;         // candidate coschedules sampled
+        i64 max_run_expires;    // resampling: ran for max_run_slices
+        i64 phase_changes;      // resampling: aggregate IPC drifted
+        i64 app_set_changes;    // resampling: apps arrived/left
+        i64 halts;
+    } stats;
+
+    // Per-slice IPC of each app that ran in the same context for the
+    // whole slice
+    void sample_all(map<int, double>& slice_ipc) {
+        slice_ipc.clear();
+        FOR_CONST_ITER(IdSet, mgr_info.get_app_ids(), iter) {
+            const PerAppInfo& ainfo = mgr_info.get_appinfo(*iter);
+            AppSample& samp = samples[*iter];
+            int ctx_id = (ainfo.is_resident()) ? ainfo.g_ctx_id() : -1;
+            if ((ctx_id >= 0) && (ctx_id == samp.last_ctx)) {
+                slice_ipc[*iter] = (double)
+                    (ainfo.app_commits() - samp.last_commits) / timeslice_cyc;
+            }
+            samp.last_ctx = ctx_id;
+            samp.last_commits = ainfo.app_commits();
+        }
+    }
+
+    void start_measure() {
+        meas_commits.clear();
+        FOR_CONST_ITER(IdSet, mgr_info.get_app_ids(), iter) {
+            meas_commits[*iter] = mgr_info.get_appinfo(*iter).app_commits();
+        }
+        meas_start_cyc = cyc;
+    }
+
+    // IPC of each member of the current candidate since start_measure();
+    // members which didn't run at all in that time count as 0.
+    void finish_measure(map<int, double>& ipc_ret) const {
+        ipc_ret.clear();
+        double meas_cyc = (double) (cyc - meas_start_cyc);
+        FOR_CONST_ITER(IdSet, target, iter) {
+            i64 start_commits = map_at_default(meas_commits, *iter,
+                                               (i64) -1);
+            if ((start_commits < 0) || (meas_cyc <= 0)) {
+                ipc_ret[*iter] = 0;
+            } else {
+                ipc_ret[*iter] = (mgr_info.get_appinfo(*iter).app_commits() -
+                                  start_commits) / meas_cyc;
+            }
+        }
+    }
+
+    void gen_candidates(const IdVec& apps, int k) {
+        const int n = static_cast<int>(apps.size());
+        candidates.clear();
+        // C(n,k), saturating at just past max_candidates
+        double n_comb = 1;
+        for (int i = 0; (i < k) && (n_comb <= max_candidates); i++)
+            n_comb = n_comb * (n - i) / (i + 1);
+        if (n_comb <= max_candidates) {
+            // Enumerate every k-subset, in lexicographic order
+            vector<int> sel(k);
+            for (int i = 0; i < k; i++)
+                sel[i] = i;
+            while (true) {
+                IdVec cand;
+                for (int i = 0; i < k; i++)
+                    cand.push_back(apps[sel[i]]);
+                candidates.push_back(cand);
+                int i = k - 1;
+                while ((i >= 0) && (sel[i] == n - k + i))
+                    i--;
+                if (i < 0)
+                    break;
+                sel[i]++;
+                for (int j = i + 1; j < k; j++)
+                    sel[j] = sel[j - 1] + 1;
+            }
+        } else {
+            // Random subset: chop shuffled app lists into k-sized groups,
+            // so every app appears in the first ceil(n/k) candidates.
+            set<IdVec> seen;
+            int tries_left = 4 * max_candidates;
+            IdVec order;
+            size_t pos = apps.size();
+            while ((static_cast<int>(candidates.size()) < max_candidates) &&
+                   (tries_left-- > 0)) {
+                IdSet members;
+                while (static_cast<int>(members.size()) < k) {
+                    if (pos >= order.size()) {
+                        order = apps;
+                        shuffle_idvec(&prng, order);
+                        pos = 0;
+                    }
+                    members.insert(order[pos++]);
+                }
+                IdVec cand;
+                idvec_from_idset(cand, members);
+                if (!seen.count(cand)) {
+                    seen.insert(cand);
+                    candidates.push_back(cand);
+                }
+            }
+        }
+    }
+
+    void set_target(const IdVec& cand) {
+        target.clear();
+        target.insert(cand.begin(), cand.end());
+        FOR_CONST_ITER(IdSet, mgr_info.get_app_ids(), iter) {
+            const PerAppInfo& ainfo = mgr_info.get_appinfo(*iter);
+            if (target.count(*iter) || !ainfo.is_resident())
+                continue;
+            DEBUGPRINTF("SOS: halting non-target A%d\n", *iter);
+            AppState *as = const_cast<AppState *>(ainfo.g_as());
+            if (appmgr_signal_haltapp(GlobalAppMgr, as, CtxHaltStyle_Fast,
+                                      NULL))
+                stats.halts++;
+        }
+    }
+
+    void start_sampling() {
+        known_apps = mgr_info.get_app_ids();
+        IdVec apps;
+        idvec_from_idset(apps, known_apps);
+        int k = MIN_SCALAR(mgr_info.ctx_count(), (int) apps.size());
+        phase = Running;
+        run_slices = 0;
+        run_ipc = -1;
+        run_score = -1;
+        if ((int) apps.size() <= k) {
+            // Everything fits; nothing to choose
+            target = known_apps;
+            candidates.clear();
+            return;
+        }
+        gen_candidates(apps, k);
+        sim_assert(!candidates.empty());
+        DEBUGPRINTF("SOS: sampling %d candidates, %d apps on %d contexts\n",
+                    (int) candidates.size(), (int) apps.size(), k);
+        phase = Sampling;
+        stats.sample_phases++;
+        cand_score.assign(candidates.size(), 0.0);
+        cand_ipc.assign(candidates.size(), map<int, double>());
+        cand_idx = 0;
+        cand_slices = 0;
+        set_target(candidates[0]);
+        start_measure();
+    }
+
+    // Weighted speedup of each candidate; returns index of the best
+    int score_candidates() {
+        map<int, double> ref_ipc;
+        for (size_t c = 0; c < candidates.size(); c++) {
+            FOR_CONST_ITER(IdVec, candidates[c], iter) {
+                double ipc = map_at_default(cand_ipc[c], *iter, 0.0);
+                if (ipc > map_at_default(ref_ipc, *iter, 0.0))
+                    ref_ipc[*iter] = ipc;
+            }
+        }
+        int best = 0;
+        for (size_t c = 0; c < candidates.size(); c++) {
+            double ws = 0;
+            FOR_CONST_ITER(IdVec, candidates[c], iter) {
+                double ref = map_at_default(ref_ipc, *iter, 0.0);
+                if (ref > 0)
+                    ws += map_at_default(cand_ipc[c], *iter, 0.0) / ref;
+            }
+            cand_score[c] = ws;
+            if (ws > cand_score[best])
+                best = static_cast<int>(c);
+        }
+        return best;
+    }
+
+    void sample_slice_end() {
+        cand_slices++;
+        if ((cand_slices == 1) && (sample_slices > 1)) {
+            start_measure();    // first slice was warm-up
+            return;
+        }
+        if (cand_slices < sample_slices)
+            return;
+        finish_measure(cand_ipc[cand_idx]);
+        stats.candidates++;
+        cand_idx++;
+        if (cand_idx < (int) candidates.size()) {
+            cand_slices = 0;
+            set_target(candidates[cand_idx]);
+            start_measure();
+            return;
+        }
+        int best = score_candidates();
+        run_score = cand_score[best];
+        run_ipc = 0;
+        FOR_CONST_ITER(IdVec, candidates[best], iter) {
+            run_ipc += map_at_default(cand_ipc[best], *iter, 0.0);
+        }
+        DEBUGPRINTF("SOS: candidate %d wins, weighted speedup %.3f, "
+                    "IPC %.3f\n", best, run_score, run_ipc);
+        phase = Running;
+        run_slices = 0;
+        set_target(candidates[best]);
+    }
+
+    void run_slice_end(const map<int, double>& slice_ipc) {
+        if (candidates.empty())
+            return;             // not oversubscribed; nothing to revisit
+        run_slices++;
+        if (run_slices >= max_run_slices) {
+            stats.max_run_expires++;
+            start_sampling();
+            return;
+        }
+        // First slice after switching over is warm-up; also, nothing to
+        // compare against unless sampling actually happened.
+        if ((run_slices < 2) || (run_ipc <= 0))
+            return;
+        double agg_ipc = 0;
+        FOR_CONST_ITER(IdSet, target, iter) {
+            agg_ipc += map_at_default(slice_ipc, *iter, 0.0);
+        }
+        if (fabs(agg_ipc - run_ipc) > (phase_change_thresh * run_ipc)) {
+            DEBUGPRINTF("SOS: phase change, IPC %.3f vs. sampled %.3f\n",
+                        agg_ipc, run_ipc);
+            stats.phase_changes++;
+            start_sampling();
+        }
+    }
+
+public:
+    ASched_SOS(const MgrSchedInfo& mgr_info_)
+        : ASched_OldestApp(mgr_info_), phase(Running), cand_idx(0),
+          cand_slices(0), meas_start_cyc(0), run_ipc(-1), run_score(-1),
+          run_slices(0) {
+        const string cp("Hacking/SOS/");
+        timeslice_cyc = simcfg_get_i64((cp + "timeslice_cyc").c_str());
+        if (timeslice_cyc < 1) {
+            exit_printf("bad %stimeslice_cyc (%s)\n", cp.c_str(),
+                        fmt_i64(timeslice_cyc));
+        }
+        sample_slices = simcfg_get_int((cp + "sample_slices").c_str());
+        if (sample_slices < 1) {
+            exit_printf("bad %ssample_slices (%d)\n", cp.c_str(),
+                        sample_slices);
+        }
+        max_candidates = simcfg_get_int((cp + "max_candidates").c_str());
+        if (max_candidates < 1) {
+            exit_printf("bad %smax_candidates (%d)\n", cp.c_str(),
+                        max_candidates);
+        }
+        max_run_slices = simcfg_get_int((cp + "max_run_slices").c_str());
+        if (max_run_slices < 1) {
+            exit_printf("bad %smax_run_slices (%d)\n", cp.c_str(),
+                        max_run_slices);
+        }
+        phase_change_thresh =
+            simcfg_get_double((cp + "phase_change_thresh").c_str());
+        prng_reset(&prng, simcfg_get_int((cp + "seed").c_str()));
+        memset(&stats, 0, sizeof(stats));
+    }
+    virtual ~ASched_SOS() {
+        if (slice_cb)
+            callbackq_cancel_ret(GlobalEventQueue, slice_cb.get());
+    }
+
+    virtual void setup_done() {
+        slice_cb.reset(new SliceCB(*this));
+        callbackq_enqueue(GlobalEventQueue, cyc + timeslice_cyc,
+                          slice_cb.get());
+    }
+
+    virtual int schedule_one() {
+        sim_assert(!ready_order.empty());
+        deque<int>::iterator iter = ready_order.begin();
+        for (; iter != ready_order.end(); ++iter) {
+            if (target.count(*iter))
+                break;
+        }
+        if (iter == ready_order.end())
+            iter = ready_order.begin();
+        int next_app = *iter;
+        ready_order.erase(iter);
+        sim_assert(ready_all.count(next_app));
+        ready_all.erase(next_app);
+        return next_app;
+    }
+
+    void slice_end() {
+        map<int, double> slice_ipc;
+        sample_all(slice_ipc);
+        stats.slices++;
+        if (mgr_info.get_app_ids() != known_apps) {
+            if (!known_apps.empty())
+                stats.app_set_changes++;
+            start_sampling();
+        } else if (phase == Sampling) {
+            sample_slice_end();
+        } else {
+            run_slice_end(slice_ipc);
+        }
+    }
+
+    virtual void printstats(FILE *out, const char *pf) const {
+        fprintf(out, "%sSOS: slices %s sample_phases %s candidates %s "
+                "max_run_expires %s phase_changes %s app_set_changes %s "
+                "halts %s\n", pf, fmt_i64(stats.slices),
+                fmt_i64(stats.sample_phases), fmt_i64(stats.candidates),
+                fmt_i64(stats.max_run_expires), fmt_i64(stats.phase_changes),
+                fmt_i64(stats.app_set_changes), fmt_i64(stats.halts));
+        fprintf(out, "%sSOS target (%s, weighted speedup %.3f): [", pf,
+                (phase == Sampling) ? "sampling" : "running", run_score);
+        FOR_CONST_ITER(IdSet, target, iter) {
+            fprintf(out, " %d", *iter);
+        }
+        fprintf(out, " ]\n");
+    }
+};
+
+
 // Abstract context scheduler: selects next context to run an app, -1 for none
 class CtxSched {
 protected:
@@ -1288,6 +1719,10 @@ public:
     virtual int schedule_guess_core(int app_id) {
         return -1;
     }
+
+    // Called once all contexts are registered
+    virtual void setup_done() { }
+    virtual void printstats(FILE *out, const char *pf) const { }
 };
 
 
@@ -1418,6 +1853,323 @@ public:
 };
 
 
+// Heterogeneous cores: each core is "big" or "little", by its "core_type"
+// (see CoreTypes).  New apps go to the least-loaded big core with a free
+// context, else a little one.  Every "interval_cyc", each running app's
+// IPC (and long-miss rate) over the interval is folded into a per-app,
+// per-core-kind average; the little-core app with the best big-core
+// affinity is then moved to a free big context, or swapped with the
+// big-core app with the worst affinity if that's better by "swap_margin".
+//
+// A swap halts the big-core app, and migrates the little-core app into the
+// context that frees up; the halted app is then scheduled on whatever is
+// free (typically the context just vacated).  The big core is held for the
+// incoming app until its migration completes.
+class CSched_BigLittle : public CtxSched_MgrInfo {
+    enum Metric { IpcRatio, MemIntensity };
+    enum { Little = 0, Big = 1 };
+
+    struct AppSample {
+        double ipc[2];          // EWMA IPC by core kind; <0: none yet
+        double mpki;            // EWMA long misses / 1K commits; <0: none
+        int last_ctx;           // context at last sample, or -1
+        i64 last_commits;
+        i64 last_long_misses;
+        i64 last_cyc;
+        AppSample() : mpki(-1), last_ctx(-1), last_commits(0),
+                      last_long_misses(0), last_cyc(0) {
+            ipc[Little] = ipc[Big] = -1;
+        }
+    };
+    typedef map<int, AppSample> AppSampleMap;
+
+    class SampleCB : public CBQ_Callback {
+        CSched_BigLittle& sched;
+    public:
+        SampleCB(CSched_BigLittle& sched_) : sched(sched_) { }
+        i64 invoke(CBQ_Args *args) {
+            sched.sample_all();
+            sched.rebalance();
+            return cyc + sched.interval_cyc;
+        }
+    };
+    class ReserveDoneCB : public CBQ_Callback {
+        CSched_BigLittle& sched;
+        int app_id;
+    public:
+        ReserveDoneCB(CSched_BigLittle& sched_, int app_id_)
+            : sched(sched_), app_id(app_id_) { }
+        i64 invoke(CBQ_Args *args) {
+            // (Not done at destruction: the scheduler may already be gone)
+            sched.unreserve(app_id);
+            return -1;
+        }
+    };
+
+    string big_type;
+    Metric metric;
+    i64 interval_cyc;
+    i64 min_resident_cyc;
+    double unknown_ratio;
+    double swap_margin;
+    double ewma_weight;
+
+    map<int,int> core_kind;     // core ID -> Little/Big
+    bool have_both_kinds;
+    AppSampleMap samples;
+    scoped_ptr<CBQ_Callback> sample_cb; // NULL => none; in GlobalEventQueue
+    int reserved_core;          // big core held for a migrating app, or -1
+    int reserved_app;
+    i64 reserved_cyc;
+
+    struct {
+        i64 samples;
+        i64 moves;              // little->big moves into a free context
+        i64 swaps;              // little<->big exchanges
+        i64 blocked_by_reserve; // intervals skipped: migration in progress
+        i64 reserve_timeouts;   // reservations dropped, migration not done
+    } stats;
+
+    static double ewma(double old_val, double new_val, double weight) {
+        return (old_val < 0) ? new_val :
+            ((weight * new_val) + ((1.0 - weight) * old_val));
+    }
+
+    int kind_of_core(int core_id) const { return map_at(core_kind, core_id); }
+
+    int core_open_ctx(int core_id, int app_id) const {
+        if ((reserved_core == core_id) && (reserved_app != app_id))
+            return -1;
+        return mgr_info.core_idle_ctx(mgr_info.get_coreinfo(core_id));
+    }
+
+    // Idle context on the least-loaded core of the given kind, or -1
+    int pick_ctx(int kind, int app_id) const {
+        int best_ctx = -1;
+        int best_load = 0;
+        FOR_CONST_ITER(IdSet, mgr_info.get_core_ids(), iter) {
+            if (kind_of_core(*iter) != kind)
+                continue;
+            int ctx_id = core_open_ctx(*iter, app_id);
+            if (ctx_id < 0)
+                continue;
+            int load = mgr_info.core_load_count(mgr_info.get_coreinfo(*iter),
+                                                deduct_nonrun);
+            if ((best_ctx < 0) || (load < best_load)) {
+                best_ctx = ctx_id;
+                best_load = load;
+            }
+        }
+        return best_ctx;
+    }
+
+    // How much this app would gain from a big core (larger: more)
+    double affinity(int app_id) const {
+        AppSampleMap::const_iterator found = samples.find(app_id);
+        if (found == samples.end())
+            return (metric == IpcRatio) ? unknown_ratio : 1.0;
+        const AppSample& samp = found->second;
+        if (metric == IpcRatio) {
+            // Not yet seen on a big core: worth a try.  Seen only on big
+            // cores: no evidence either way.
+            if (samp.ipc[Big] <= 0)
+                return unknown_ratio;
+            if (samp.ipc[Little] <= 0)
+                return 1.0;
+            return samp.ipc[Big] / samp.ipc[Little];
+        }
+        return 1.0 / (1.0 + ((samp.mpki < 0) ? 0.0 : samp.mpki));
+    }
+
+    // Running long enough to be worth moving?
+    bool movable(const PerAppInfo& ainfo) const {
+        return (ainfo.g_state() == AI_Running) &&
+            (ainfo.cyc_since_swapin() >= min_resident_cyc);
+    }
+
+    void sample_all() {
+        FOR_CONST_ITER(IdSet, mgr_info.get_app_ids(), iter) {
+            const PerAppInfo& ainfo = mgr_info.get_appinfo(*iter);
+            AppSample& samp = samples[*iter];
+            int ctx_id = (ainfo.is_resident()) ? ainfo.g_ctx_id() : -1;
+            if ((ctx_id >= 0) && (ctx_id == samp.last_ctx) &&
+                (cyc > samp.last_cyc)) {
+                int kind =
+                    kind_of_core(mgr_info.get_ctxinfo(ctx_id).g_core_id());
+                i64 commits = ainfo.app_commits() - samp.last_commits;
+                i64 misses = ainfo.g_long_misses() - samp.last_long_misses;
+                samp.ipc[kind] = ewma(samp.ipc[kind],
+                                      (double) commits / (cyc - samp.last_cyc),
+                                      ewma_weight);
+                if (commits > 0) {
+                    samp.mpki = ewma(samp.mpki, 1000.0 * misses / commits,
+                                     ewma_weight);
+                }
+                stats.samples++;
+            }
+            samp.last_ctx = ctx_id;
+            samp.last_commits = ainfo.app_commits();
+            samp.last_long_misses = ainfo.g_long_misses();
+            samp.last_cyc = cyc;
+        }
+    }
+
+    void reserve(int core_id, int app_id) {
+        reserved_core = core_id;
+        reserved_app = app_id;
+        reserved_cyc = cyc;
+    }
+
+    void rebalance() {
+        if (!have_both_kinds)
+            return;
+        if ((reserved_core >= 0) && ((cyc - reserved_cyc) >= interval_cyc)) {
+            // Migration hasn't completed in a whole interval (e.g. the app
+            // exited); don't hold the core any longer.
+            stats.reserve_timeouts++;
+            reserved_core = reserved_app = -1;
+        }
+        if (reserved_core >= 0) {
+            stats.blocked_by_reserve++;
+            return;
+        }
+
+        int best_little = -1, worst_big = -1, worst_big_ctx = -1;
+        double best_little_aff = 0, worst_big_aff = 0;
+        FOR_CONST_ITER(IdSet, mgr_info.get_app_ids(), iter) {
+            const PerAppInfo& ainfo = mgr_info.get_appinfo(*iter);
+            if (!movable(ainfo))
+                continue;
+            int ctx_id = ainfo.g_ctx_id();
+            double aff = affinity(*iter);
+            if (kind_of_core(mgr_info.get_ctxinfo(ctx_id).g_core_id()) ==
+                Big) {
+                if ((worst_big < 0) || (aff < worst_big_aff)) {
+                    worst_big = *iter;
+                    worst_big_aff = aff;
+                    worst_big_ctx = ctx_id;
+                }
+            } else if ((best_little < 0) || (aff > best_little_aff)) {
+                best_little = *iter;
+                best_little_aff = aff;
+            }
+        }
+        if (best_little < 0)
+            return;
+
+        int free_ctx = pick_ctx(Big, best_little);
+        if (free_ctx >= 0) {
+            int targ_core = mgr_info.get_ctxinfo(free_ctx).g_core_id();
+            DEBUGPRINTF("BigLittle: moving A%d (aff %.3f) to C%d\n",
+                        best_little, best_little_aff, targ_core);
+            reserve(targ_core, best_little);
+            appmgr_migrate_app_soon(GlobalAppMgr, best_little, targ_core,
+                                    CtxHaltStyle_Fast,
+                                    new ReserveDoneCB(*this, best_little));
+            stats.moves++;
+        } else if ((worst_big >= 0) &&
+                   (best_little_aff > worst_big_aff * (1.0 + swap_margin))) {
+            int targ_core = mgr_info.get_ctxinfo(worst_big_ctx).g_core_id();
+            DEBUGPRINTF("BigLittle: swapping A%d (aff %.3f) into C%d, "
+                        "A%d (aff %.3f) out\n", best_little, best_little_aff,
+                        targ_core, worst_big, worst_big_aff);
+            reserve(targ_core, best_little);
+            AppState *evict_as = const_cast<AppState *>
+                (mgr_info.get_appinfo(worst_big).g_as());
+            appmgr_signal_haltapp(GlobalAppMgr, evict_as, CtxHaltStyle_Fast,
+                                  NULL);
+            appmgr_migrate_app_soon(GlobalAppMgr, best_little, targ_core,
+                                    CtxHaltStyle_Fast,
+                                    new ReserveDoneCB(*this, best_little));
+            stats.swaps++;
+        }
+    }
+
+public:
+    CSched_BigLittle(const MgrSchedInfo& mgr_info_)
+        : CtxSched_MgrInfo(mgr_info_), have_both_kinds(false),
+          reserved_core(-1), reserved_app(-1), reserved_cyc(0) {
+        const string cp("Hacking/BigLittle/");
+        big_type = simcfg_get_str((cp + "big_type").c_str());
+        string metric_name(simcfg_get_str((cp + "metric").c_str()));
+        if (metric_name == "IpcRatio") {
+            metric = IpcRatio;
+        } else if (metric_name == "MemIntensity") {
+            metric = MemIntensity;
+        } else {
+            exit_printf("bad %smetric \"%s\"\n", cp.c_str(),
+                        metric_name.c_str());
+        }
+        interval_cyc = simcfg_get_i64((cp + "interval_cyc").c_str());
+        if (interval_cyc < 1) {
+            exit_printf("bad %sinterval_cyc (%s)\n", cp.c_str(),
+                        fmt_i64(interval_cyc));
+        }
+        min_resident_cyc = simcfg_get_i64((cp + "min_resident_cyc").c_str());
+        unknown_ratio = simcfg_get_double((cp + "unknown_ratio").c_str());
+        swap_margin = simcfg_get_double((cp + "swap_margin").c_str());
+        ewma_weight = simcfg_get_double((cp + "ewma_weight").c_str());
+        if ((ewma_weight <= 0) || (ewma_weight > 1)) {
+            exit_printf("bad %sewma_weight (%g)\n", cp.c_str(), ewma_weight);
+        }
+        memset(&stats, 0, sizeof(stats));
+    }
+    virtual ~CSched_BigLittle() {
+        if (sample_cb)
+            callbackq_cancel_ret(GlobalEventQueue, sample_cb.get());
+    }
+
+    virtual void setup_done() {
+        int n_big = 0;
+        FOR_CONST_ITER(IdSet, mgr_info.get_core_ids(), iter) {
+            const CoreResources *core = mgr_info.get_coreinfo(*iter).g_core();
+            int kind = (big_type == core->params.core_type) ? Big : Little;
+            core_kind[*iter] = kind;
+            n_big += (kind == Big) ? 1 : 0;
+        }
+        have_both_kinds = (n_big > 0) && (n_big < mgr_info.core_count());
+        if (n_big == 0) {
+            err_printf("BigLittle: no cores of core_type \"%s\"; all cores "
+                       "treated as little\n", big_type.c_str());
+        }
+        sample_cb.reset(new SampleCB(*this));
+        callbackq_enqueue(GlobalEventQueue, cyc + interval_cyc,
+                          sample_cb.get());
+    }
+
+    virtual int schedule_one(int app_id) {
+        sim_assert(!idle_set.empty());
+        int next_ctx = pick_ctx(Big, app_id);
+        if (next_ctx < 0)
+            next_ctx = pick_ctx(Little, app_id);
+        if (next_ctx >= 0) {
+            sim_assert(idle_set.count(next_ctx));
+            idle_set.erase(next_ctx);
+        }
+        return next_ctx;
+    }
+
+    void unreserve(int app_id) {
+        if (reserved_app == app_id)
+            reserved_core = reserved_app = -1;
+    }
+
+    virtual void printstats(FILE *out, const char *pf) const {
+        fprintf(out, "%sBigLittle: samples %s moves %s swaps %s "
+                "blocked_by_reserve %s reserve_timeouts %s\n", pf,
+                fmt_i64(stats.samples), fmt_i64(stats.moves),
+                fmt_i64(stats.swaps), fmt_i64(stats.blocked_by_reserve),
+                fmt_i64(stats.reserve_timeouts));
+        fprintf(out, "%sBigLittle affinity (%s): [", pf,
+                (metric == IpcRatio) ? "IpcRatio" : "MemIntensity");
+        FOR_CONST_ITER(IdSet, mgr_info.get_app_ids(), iter) {
+            fprintf(out, " %.3f", affinity(*iter));
+        }
+        fprintf(out, " ]\n");
+    }
+};
+
+
 class CSched_Static : public CtxSched_MgrInfo {
 protected:
     map<int,int> static_sched;  // maps app ID to ctx#
@@ -1808,6 +2560,7 @@ private:
     int regs_per_sf_block;
     i64 min_swapin_commits;
     i64 min_swapin_cyc;
+    i64 migrate_warmup_commits; // <= 0: don't measure warmup
     typedef map<int, PendingMigrateInfo *> PendingMigrateMap;
     PendingMigrateMap pending_migrates;
     IdSet pending_halts;
@@ -1898,7 +2651,7 @@ public:
     void prereset_hook(context *ctx);
     void signal_finalfill(context *ctx, bool commit_not_rename);
     void signal_finalspill(context *ctx, bool commit_not_rename);
-    void signal_haltapp(AppState *app, CtxHaltStyle halt_style,
+    bool signal_haltapp(AppState *app, CtxHaltStyle halt_style,
                         CBQ_Callback *halted_cb);
 
     void alter_mutablemap_sched(int app_id, int targ_core_or_neg1);
@@ -1921,6 +2674,8 @@ AppMgr::AppMgr(const AppMgrParams& params_)
 
     if (sched_app_name == "OldestApp") {
         app_sched = new ASched_OldestApp(mgr_info); 
+    } else if (sched_app_name == "SOS") {
+        app_sched = new ASched_SOS(mgr_info);
     } else {
         fprintf(stderr, "AppMgr (%s:%i): unrecognized app-scheduler name: "
                 "%s\n", __FILE__, __LINE__, sched_app_name.c_str());
@@ -1933,6 +2688,8 @@ AppMgr::AppMgr(const AppMgrParams& params_)
         ctx_sched = new CSched_LightestLoad(mgr_info); 
     } else if (sched_ctx_name == "LeastIpc") {
         ctx_sched = new CSched_LeastIpc(mgr_info); 
+    } else if (sched_ctx_name == "BigLittle") {
+        ctx_sched = new CSched_BigLittle(mgr_info);
     } else if (sched_ctx_name == "Static") {
         ctx_sched = new CSched_Static(mgr_info); 
     } else if (sched_ctx_name == "StaticSetAffin") {
@@ -1983,6 +2740,8 @@ AppMgr::AppMgr(const AppMgrParams& params_)
 
     min_swapin_commits = simcfg_get_i64("Hacking/min_swapin_commits");
     min_swapin_cyc = simcfg_get_i64("Hacking/min_swapin_cyc");
+    migrate_warmup_commits =
+        simcfg_get_i64("Hacking/migrate_warmup_commits");
 }
 
 
@@ -2007,6 +2766,8 @@ AppMgr::setup_done()
     sim_assert(!setup_done_flag);
     setup_done_flag = true;
     mgr_info.setup_done();
+    app_sched->setup_done();
+    ctx_sched->setup_done();
 }
 
 
@@ -2015,6 +2776,8 @@ AppMgr::add_ready_app(AppState *app)
 {
     sim_assert(setup_done_flag);
     mgr_info.add_ready_app(app);
+    if (GlobalWSMCoord)
+        wsm_coord_register_app(GlobalWSMCoord, app);
     app_sched->app_ready(app->app_id);
     sched_hook();
 }
@@ -2025,6 +2788,8 @@ AppMgr::remove_app(AppState *app)
 {
     DEBUGPRINTF("AppMgr removing app A%d\n", app->app_id);
     app_sched->app_notready(app->app_id);
+    if (GlobalWSMCoord)
+        wsm_coord_destroying_app(GlobalWSMCoord, app);
     mgr_info.remove_app(app->app_id);
 }
 
@@ -2177,6 +2942,13 @@ AppMgr::start_app(int app_id, int ctx_id)
                       mgr_info.ctx_same_core(ctx_id,
                                              ainfo.g_prev_ctx()));
     crinfo.app_starting();
+    if (ainfo.last_halt_was_for_migrate()) {
+        if (migrate_warmup_commits > 0)
+            ainfo.start_warmup_watch(migrate_warmup_commits);
+        if (GlobalWSMCoord)
+            wsm_coord_signal_activate(GlobalWSMCoord, ainfo.g_as(),
+                                      cinfo.g_ctx());
+    }
 
     if (inst_spill_fill) {
         cinfo.prepare_fill(ainfo.g_as());
@@ -2186,8 +2958,10 @@ AppMgr::start_app(int app_id, int ctx_id)
         if (kMigrateFillsAreFree && ainfo.last_halt_was_for_migrate()) {
             swapin_done_cyc = cyc;
         } else {
-            swapin_done_cyc = corebus_access(cinfo.g_ctx()->core->reply_bus,
-                                             swap_in_time);
+            const CoreResources *core = cinfo.g_ctx()->core;
+            swapin_done_cyc = corebus_access_mem(core->reply_bus,
+                                                 core->core_id, 1,
+                                                 swap_in_time);
         }
         callbackq_enqueue(GlobalEventQueue, swapin_done_cyc - 1,
                           gen_cinfo_cb(cinfo, StaticSwapInDone));
@@ -2371,9 +3145,10 @@ AppMgr::signal_idlectx(context *ctx)
             if (inst_spill_fill) {
                 swapout_genspill_callback(cinfo);
             } else {
+                const CoreResources *core = cinfo.g_ctx()->core;
                 i64 swapout_done_cyc =
-                    corebus_access(cinfo.g_ctx()->core->reply_bus,
-                                   swap_out_time);
+                    corebus_access_mem(core->reply_bus, core->core_id, 0,
+                                       swap_out_time);
                 callbackq_enqueue(GlobalEventQueue, swapout_done_cyc, 
                                   gen_cinfo_cb(cinfo, StaticSwapOutDone));
             }
@@ -2440,7 +3215,7 @@ AppMgr::signal_finalspill(context *ctx, bool commit_not_rename)
 }
 
 
-void
+bool
 AppMgr::signal_haltapp(AppState *app, CtxHaltStyle halt_style,
                        CBQ_Callback *halted_cb)
 {
@@ -2454,9 +3229,10 @@ AppMgr::signal_haltapp(AppState *app, CtxHaltStyle halt_style,
     if (halted_cb) {
         ainfo.register_posthalt_callback(halted_cb);
     }
-    if (!is_halt_pending(ainfo)) {
-        halt_app_soon(app->app_id, halt_style);
-    }
+    if (is_halt_pending(ainfo))
+        return false;
+    halt_app_soon(app->app_id, halt_style);
+    return true;
 }
 
 
@@ -2568,6 +3344,9 @@ AppMgr::migrate_running_app(int app_id, int target_ctx_id,
         ainfo.set_state(AI_Running);
         curr_crinfo.app_stalldone_noevict();
     }
+    if (GlobalWSMCoord)
+        wsm_coord_signal_deactivate(GlobalWSMCoord, ainfo.g_as(),
+                                    cinfo.g_ctx());
     ainfo.migrating(target_ctx_id);
     targ_cinfo.reserve_for_app(app_id);
     cinfo.app_spill_begin();
@@ -3041,6 +3820,41 @@ AppMgr::printstats(void *FILE_out, const char *pf) const
         }
     }
 
+    {
+        // Only interesting with heterogeneous cores (see Core/core_type)
+        set<string> types;
+        for (IdSet::const_iterator i_core = cores.begin();
+             i_core != cores.end(); ++i_core) {
+            types.insert(mgr_info.get_coreinfo(*i_core).g_core()->
+                         params.core_type);
+        }
+        if (types.size() > 1) {
+            fprintf(out, "%sApp occupancy cycles by core type:\n", pf);
+            fprintf(out, "%s  \"cyc\"", pf);
+            FOR_CONST_ITER(set<string>, types, i_type) {
+                fprintf(out, ",\"%s\"", (i_type->empty()) ? "(none)" :
+                        i_type->c_str());
+            }
+            fprintf(out, "\n");
+            for (IdSet::const_iterator i_app = apps.begin();
+                 i_app != apps.end(); ++i_app) {
+                fprintf(out, "%s  \"A%d\"", pf, *i_app);
+                FOR_CONST_ITER(set<string>, types, i_type) {
+                    i64 val = 0;
+                    for (IdSet::const_iterator i_core = cores.begin();
+                         i_core != cores.end(); ++i_core) {
+                        if (*i_type == mgr_info.get_coreinfo(*i_core).
+                            g_core()->params.core_type)
+                            val += mgr_info.core_resident_cyc(*i_core,
+                                                              *i_app);
+                    }
+                    fprintf(out, ",%s", fmt_i64(val));
+                }
+                fprintf(out, "\n");
+            }
+        }
+    }
+
     {
         fprintf(out, "%sApp swap-ins on cores:\n", pf);
         fprintf(out, "%s  \"events\"", pf);
@@ -3061,6 +3875,31 @@ AppMgr::printstats(void *FILE_out, const char *pf) const
         }
     }
 
+    {
+        // Reserved: mapped segment sizes; touched: host memory behind them,
+        // which is less only for sparse (Global/Mem/SparseSegs) segments
+        const char *columns[] = {
+            "segs", "reserved", "touched", "sparse_reserved",
+            "sparse_touched"
+        };
+        fprintf(out, "%sApp simulated memory:\n", pf);
+        fprintf(out, "%s  \"KiB\"", pf);
+        for (int i = 0; i < (int) NELEM(columns); i++)
+            fprintf(out, ",\"%s\"", columns[i]);
+        fprintf(out, "\n");
+        for (IdSet::const_iterator i_app = apps.begin();
+             i_app != apps.end(); ++i_app) {
+            const AppState *as = mgr_info.get_appinfo(*i_app).g_as();
+            ProgMemStats mem_stats;
+            pmem_get_stats(as->pmem, &mem_stats);
+            fprintf(out, "%s  \"A%d\",%d,%s,%s,%s,%s\n", pf, *i_app,
+                    mem_stats.segs, fmt_i64(mem_stats.reserved_bytes / 1024),
+                    fmt_i64(mem_stats.touched_bytes / 1024),
+                    fmt_i64(mem_stats.sparse_reserved_bytes / 1024),
+                    fmt_i64(mem_stats.sparse_touched_bytes / 1024));
+        }
+    }
+
     {
         int max_tlp = mgr_info.biggest_core_contexts();
         fprintf(out, "%sCore \"scheduled - stalled\" TLP cycles:\n", pf);
@@ -3203,6 +4042,9 @@ AppMgr::printstats(void *FILE_out, const char *pf) const
             ainfo.report_migrate_timing(out, child_pf.c_str());
         }
     }
+
+    app_sched->printstats(out, pf);
+    ctx_sched->printstats(out, pf);
 }
 
 
@@ -3287,12 +4129,12 @@ appmgr_signal_finalspill(AppMgr *amgr, struct context *ctx,
     amgr->signal_finalspill(ctx, commit_not_rename);
 }
 
-void
+int
 appmgr_signal_haltapp(AppMgr *amgr, struct AppState *app,
                       int ctx_halt_style,
                       struct CBQ_Callback *halted_cb)
 {
-    amgr->signal_haltapp(app,
+    return amgr->signal_haltapp(app,
                          static_cast<CtxHaltStyle>(ctx_halt_style),
                          halted_cb);
 }
@@ -55,8 +55,9 @@ void appmgr_signal_finalspill(AppMgr *amgr, struct context *ctx,
 
 // Signal the appmgr to stop the given app (if it's running), swap it out
 // from any context where it may be resident, and trigger the given callback
-// (if non-NULL) once that app is idle.
-void appmgr_signal_haltapp(AppMgr *amgr, struct AppState *app,
+// (if non-NULL) once that app is idle.  Returns nonzero iff this started a
+// halt (zero: one was already pending).
+int appmgr_signal_haltapp(AppMgr *amgr, struct AppState *app,
                            int ctx_halt_style,
                            struct CBQ_Callback *halted_cb);
 
@@ -25,6 +25,7 @@ const char RCSid_1107455886[] =
 #include "prog-mem.h"
 #include "syscalls.h"
 #include "stash.h"      // for stash_create() / destroy
+#include "inst-trace.h"
 
 
 typedef std::map<int, AppState*> AppIdMap;
@@ -60,6 +61,17 @@ mem_err_handler(ProgMem *pmem, mem_addr va, int width,
 }
 
 
+// Trace replay has only code pages; data accesses read zero, and stores are
+// dropped.
+static int
+replay_mem_err_handler(ProgMem *pmem, mem_addr va, int width, 
+                       unsigned flags, unsigned err_code,
+                       void *err_data)
+{
+    return 0;
+}
+
+
 AppParams *
 app_params_create(void)
 {
@@ -129,6 +141,10 @@ appstate_vacate(AppState *as)
         syscalls_destroy(as->syscall_state);
         as->syscall_state = NULL;
     }
+    if (as->itrace_in) {
+        itrace_reader_destroy(as->itrace_in);
+        as->itrace_in = NULL;
+    }
 }
 
 
@@ -224,6 +240,53 @@ err:
 }
 
 
+AppState *
+appstate_new_fromtrace(const AppParams *params,
+                       struct RegionAlloc *r_alloc,
+                       const char *trace_file)
+{
+    AppState *as = 0;
+    int new_id = GlobalAppInfo.next_new_id;
+    std::string pmem_name;
+
+    if (!(as = (AppState *) malloc(sizeof(*as)))) {
+        fprintf(stderr, "Out of memory allocating AppState\n");
+        goto err;
+    }
+    memset(as, 0, sizeof(*as));
+    as->app_id = -1;
+
+    if (!(as->params = app_params_copy(params)))
+        goto err;
+
+    if (!(as->stash = stash_create(as))) {
+        fprintf(stderr, "Couldn't create stash (decode cache)\n");
+        goto err;
+    }
+
+    pmem_name = std::string("A") + fmt_i64(new_id) + ".pmem";
+    if (!(as->pmem = pmem_create(pmem_name.c_str(), r_alloc,
+                                 replay_mem_err_handler, as))) {
+        fprintf(stderr, "Couldn't create program memory manager\n");
+        goto err;
+    }
+
+    // Maps the initial code and sets as->npc
+    as->itrace_in = itrace_reader_create(as, trace_file);
+
+    register_global_app(as);
+    as->app_master_id = as->app_id;
+    sim_assert(as->app_id >= 0);
+    return as;
+
+err:
+    fprintf(stderr, "AppState creation from trace \"%s\" failed "
+            "(would've been app %d)\n", trace_file, new_id);
+    appstate_destroy(as);
+    return 0;
+}
+
+
 int
 appstate_count(void)
 {
@@ -23,6 +23,7 @@
 struct RegionAlloc;
 struct AppStateExtras;
 struct AppStatsLog;
+struct InstTraceReader;
 struct SyscallState;
 struct Stash;
 
@@ -49,6 +50,7 @@ struct AppState {
     struct Stash *stash;        // Owned by app_master_id; NULL iff vacated
     struct ProgMem *pmem;       // Program memory image; NULL iff "vacated"
     struct SyscallState *syscall_state;
+    struct InstTraceReader *itrace_in;  // Non-NULL: replaying a trace
 
     struct {
         // This stuff comes from the executable header, and is filled in by the
@@ -110,6 +112,11 @@ AppState *appstate_lookup_id(int app_id);
 // NULL: failure
 AppState *appstate_new_fromfile(const AppParams *params,
                                 struct RegionAlloc *r_alloc);
+// An app whose instructions come from "trace_file" (see inst-trace.h);
+// "params" are kept only for reporting.
+AppState *appstate_new_fromtrace(const AppParams *params,
+                                 struct RegionAlloc *r_alloc,
+                                 const char *trace_file);
 
 //int appstate_fork(AppState *as, AppState *parent);
 //int appstate_join(AppState *as, AppState *parent);
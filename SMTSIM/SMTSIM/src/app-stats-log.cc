@@ -11,6 +11,7 @@ const char RCSid_1124387573[] =
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <map>
 #include <string>
@@ -27,6 +28,7 @@ const char RCSid_1124387573[] =
 #include "cache.h"
 #include "main.h"
 #include "core-resources.h"
+#include "app-mem-stats.h"
 
 using std::map;
 using std::string;
@@ -43,7 +45,8 @@ enum { AS_cyc, AS_sched_cyc, AS_commits, AS_mem_commits, AS_itlb_hr,
        AS_intalu_acc, AS_fpalu_acc, AS_ldst_acc, AS_iq_acc, 
        AS_fq_acc, AS_ireg_acc, AS_freg_acc, AS_iren_acc, AS_fren_acc, 
        AS_lsq_acc, AS_rob_acc, AS_iq_occ, AS_fq_occ, AS_ireg_occ, 
-       AS_freg_occ, AS_lsq_occ, AS_rob_occ };
+       AS_freg_occ, AS_lsq_occ, AS_rob_occ, AS_mlp, AS_mem_lat_hist,
+       AS_cpi_stack };
 
 
 struct AppStatsLog {
@@ -287,6 +290,22 @@ AppStatsLog::emit_stats(i64 now_cyc)
         emit_float(1. * extra_deltas->lsq_occ / interval );
     if (GET_BITS_64(stat_mask, AS_rob_occ, 1)) //VK
         emit_float(1. * extra_deltas->rob_occ / interval );
+    if (GET_BITS_64(stat_mask, AS_mlp, 1))
+        emit_frac(appmemstats_mlp_outstanding_sum(extra_deltas->mem_stats),
+                  appmemstats_mlp_busy_cyc(extra_deltas->mem_stats));
+    if (GET_BITS_64(stat_mask, AS_mem_lat_hist, 1)) {
+        if (out_field > 0) putc(' ', file);
+        out_field++;
+        appmemstats_print_compact(extra_deltas->mem_stats, file);
+    }
+    if (GET_BITS_64(stat_mask, AS_cpi_stack, 1)) {
+        if (out_field > 0) putc(' ', file);
+        out_field++;
+        for (int i = 0; i < CpiCause_last; i++) {
+            if (i > 0) putc(',', file);
+            fputs(fmt_i64(extra_deltas->cpi_slots[i]), file);
+        }
+    }
     putc('\n', file);
 }
 
@@ -295,6 +314,7 @@ void
 AppStatsLog::log_point(i64 now_cyc)
 {
     i64 sched_cyc = app_sched_cyc(as);
+    cache_credit_all_app_mlp();
     appextra_subtract_stats(extra_deltas, as->extra, prev_extra);
 
     // We'll use the "sched_cyc_before_last" field of prev_extra/extra_deltas
@@ -415,6 +435,12 @@ AppStatsLog::read_stat_mask()
     if (simcfg_get_bool((path + "rob_occ").c_str()))
         result |= SET_BIT_64(AS_rob_occ);
     //ENDVK
+    if (simcfg_get_bool((path + "mlp").c_str()))
+        result |= SET_BIT_64(AS_mlp);
+    if (simcfg_get_bool((path + "mem_lat_hist").c_str()))
+        result |= SET_BIT_64(AS_mem_lat_hist);
+    if (simcfg_get_bool((path + "cpi_stack").c_str()))
+        result |= SET_BIT_64(AS_cpi_stack);
     stat_mask = result;
 }
 
@@ -516,6 +542,18 @@ AppStatsLog::fmt_stat_mask() const
         result += "lsq_occ ";
     if (GET_BITS_64(stat_mask, AS_rob_occ, 1)) //VK
         result += "rob_occ ";
+    if (GET_BITS_64(stat_mask, AS_mlp, 1))
+        result += "mlp ";
+    if (GET_BITS_64(stat_mask, AS_mem_lat_hist, 1))
+        result += "mem_lat_hist ";
+    if (GET_BITS_64(stat_mask, AS_cpi_stack, 1)) {
+        result += "cpi_stack(";
+        for (int i = 0; i < CpiCause_last; i++) {
+            if (i > 0) result += ",";
+            result += CpiCause_names[i];
+        }
+        result += ") ";
+    }
     result.erase(result.size() - 1);
     return result;
 }
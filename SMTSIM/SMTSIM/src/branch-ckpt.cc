@@ -0,0 +1,581 @@
+//
+// Branch checkpoints for mispredict recovery
+//
+// $Id$
+//
+
+const char RCSid_1760000036[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "main.h"
+#include "branch-ckpt.h"
+#include "core-resources.h"
+#include "context.h"
+#include "dyn-inst.h"
+#include "app-state.h"
+#include "stash.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stats-reg.h"
+
+
+using std::string;
+using std::vector;
+
+using SimCfg::conf_bool;
+using SimCfg::conf_int;
+
+
+namespace {
+
+// JRS resetting counters: 4 bits, cleared on a mispredict
+const int ConfCounterMax = 15;
+
+
+struct BranchCkptConfig {
+    int n_checkpoints;          // per thread
+    int conf_log_entries;       // log2 of confidence table size
+    int conf_threshold;         // counter >= this: high-confidence
+    bool all_branches;          // t: ignore confidence, checkpoint them all
+    bool stall_when_full;       // t: stall fetch for a free checkpoint
+    bool verify;                // t: walk back anyway, and check against ckpt
+
+    NoDefaultCopy nocopy;
+
+public:
+    BranchCkptConfig(const string& cfg_path);
+    ~BranchCkptConfig() { }
+};
+
+
+BranchCkptConfig::BranchCkptConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    n_checkpoints = conf_int(cp + "n_checkpoints");
+    if (n_checkpoints < 1) {
+        exit_printf("bad %sn_checkpoints (%d)\n", cp.c_str(),
+                    n_checkpoints);
+    }
+    conf_log_entries = conf_int(cp + "conf_log_entries");
+    if ((conf_log_entries < 0) || (conf_log_entries > 24)) {
+        exit_printf("bad %sconf_log_entries (%d)\n", cp.c_str(),
+                    conf_log_entries);
+    }
+    conf_threshold = conf_int(cp + "conf_threshold");
+    if ((conf_threshold < 0) || (conf_threshold > ConfCounterMax)) {
+        exit_printf("bad %sconf_threshold (%d)\n", cp.c_str(),
+                    conf_threshold);
+    }
+    all_branches = conf_bool(cp + "all_branches");
+    stall_when_full = conf_bool(cp + "stall_when_full");
+    verify = conf_bool(cp + "verify");
+}
+
+
+// State as of just after the owning branch was fetched (and emulated)
+struct Checkpoint {
+    bool in_use;
+    int owner_id;               // activelist ID of branch
+    i64 owner_fetchcyc;
+    reg_u regs[MAXREG];
+    int last_writer[MAXREG];
+    vector<i64> retstack;
+    int rs_size, rs_start;
+    unsigned ghr;
+    u64 ind_hist;
+    i64 bp_hist_pos;            // bpred_hist_pos() after the branch
+    // Context resource tallies just after the branch was renamed
+    bool renamed;
+    CtxRsrcTally alloced_at_rename, squash_freed_at_rename;
+
+    Checkpoint()
+        : in_use(false), owner_id(-1), owner_fetchcyc(0), rs_size(0),
+          rs_start(0), ghr(0), ind_hist(0), bp_hist_pos(0), renamed(false) {
+        memset(&alloced_at_rename, 0, sizeof(alloced_at_rename));
+        memset(&squash_freed_at_rename, 0, sizeof(squash_freed_at_rename));
+    }
+};
+
+
+struct ThreadCkpts {
+    vector<Checkpoint> ckpts;
+    vector<int> free_list;
+};
+
+} // Anonymous namespace close
+
+
+struct BranchCkpt {
+private:
+    string name_;
+    BranchCkptConfig conf_;
+    CoreResources *core_;
+    int inst_bytes_lg_;
+    vector<unsigned char> conf_table_;
+    vector<ThreadCkpts> threads_;       // by core_thread_id
+    BranchCkptStats stats_;
+
+    ThreadCkpts& thread(const context *ctx) {
+        int tid = ctx->core_thread_id;
+        if (tid >= intsize(threads_)) {
+            threads_.resize(tid + 1);
+            for (int i = 0; i <= tid; i++) {
+                ThreadCkpts& thr = threads_[i];
+                if (thr.ckpts.empty()) {
+                    thr.ckpts.resize(conf_.n_checkpoints);
+                    for (int c = conf_.n_checkpoints - 1; c >= 0; c--)
+                        thr.free_list.push_back(c);
+                }
+            }
+        }
+        return threads_[tid];
+    }
+    const ThreadCkpts& thread_c(const context *ctx) const {
+        int tid = ctx->core_thread_id;
+        sim_assert(tid < intsize(threads_));
+        return threads_[tid];
+    }
+    static bool is_candidate(int br_flags, int gen_flags) {
+        return br_flags && !(gen_flags & SGF_SysCall) &&
+            (SBF_CondBranch(br_flags) || SBF_IndirectBranch(br_flags));
+    }
+    int conf_index(mem_addr pc, int br_flags, unsigned ghr) const {
+        u64 idx = pc >> inst_bytes_lg_;
+        if (SBF_CondBranch(br_flags))
+            idx ^= ghr;
+        return static_cast<int>(idx & (conf_table_.size() - 1));
+    }
+    bool low_conf(mem_addr pc, int br_flags, unsigned ghr) const {
+        return conf_.all_branches ||
+            (conf_table_[conf_index(pc, br_flags, ghr)] <
+             conf_.conf_threshold);
+    }
+    // Whether a saved last_writer entry still refers to the in-flight inst
+    // it did when saved; as in undo_inst().
+    static bool writer_valid(const context *ctx, int writer_id,
+                             const activelist *br) {
+        if (writer_id == NONE)
+            return false;
+        const activelist *writer = &ctx->alist[writer_id];
+        return !(writer->status & (INVALID | SQUASHED)) &&
+            (writer->fetchcycle <= br->fetchcycle);
+    }
+    const Checkpoint& owned_ckpt(const context *ctx,
+                                 const activelist *br) const;
+
+public:
+    BranchCkpt(const char *name__, const char *config_path__,
+               CoreResources *core__);
+    ~BranchCkpt() { }
+
+    bool fetch_stall(const context *ctx, mem_addr pc, int br_flags,
+                     int gen_flags);
+    void inst_fetched(const context *ctx, activelist *inst);
+    void inst_renamed(const context *ctx, const activelist *inst);
+    void squashed_rsrc(const context *ctx, const activelist *br,
+                       CtxRsrcTally *held) const;
+    void release(const context *ctx, activelist *inst);
+    void restore(context *ctx, const activelist *br) const;
+    void verify(const context *ctx, const activelist *br) const;
+    bool verify_enabled() const { return conf_.verify; }
+    void note_recovery(bool from_checkpoint) {
+        if (from_checkpoint)
+            stats_.ckpt_recoveries++;
+        else
+            stats_.walk_recoveries++;
+    }
+    void br_committed(const context *ctx, const activelist *inst);
+
+    void reset_stats() { memset(&stats_, 0, sizeof(stats_)); }
+    const BranchCkptStats& get_stats() const { return stats_; }
+    void print_stats(FILE *out, const char *pf) const;
+};
+
+
+BranchCkpt::BranchCkpt(const char *name__, const char *config_path__,
+                       CoreResources *core__)
+    : name_(name__), conf_(config_path__), core_(core__)
+{
+    if ((inst_bytes_lg_ = log2_exact(core_->params.inst_bytes)) < 0) {
+        exit_printf("BranchCkpt %s: inst_bytes (%d) not a power of 2\n",
+                    name_.c_str(), core_->params.inst_bytes);
+    }
+    // Start out confident: cold branches don't grab every checkpoint
+    conf_table_.resize(1 << conf_.conf_log_entries,
+                       static_cast<unsigned char>(ConfCounterMax));
+    reset_stats();
+}
+
+
+bool
+BranchCkpt::fetch_stall(const context *ctx, mem_addr pc, int br_flags,
+                        int gen_flags)
+{
+    if (!conf_.stall_when_full || ctx->follow_sync ||
+        !is_candidate(br_flags, gen_flags))
+        return false;
+    if (!thread(ctx).free_list.empty() ||
+        !low_conf(pc, br_flags, ctx->ghr))
+        return false;
+    stats_.stall_cyc++;
+    return true;
+}
+
+
+void
+BranchCkpt::inst_fetched(const context *ctx, activelist *inst)
+{
+    sim_assert(inst->ckpt_id < 0);
+    // Insts fetched while following a sync op may be re-emulated by
+    // restore_from_sync_cp(), which would make a checkpoint stale.
+    if (ctx->follow_sync || !is_candidate(inst->br_flags, inst->gen_flags))
+        return;
+    stats_.branches++;
+    if (!low_conf(inst->pc, inst->br_flags, inst->ghr))
+        return;
+    stats_.low_conf++;
+
+    ThreadCkpts& thr = thread(ctx);
+    if (thr.free_list.empty()) {
+        stats_.full++;
+        return;
+    }
+    int ckpt_id = thr.free_list.back();
+    thr.free_list.pop_back();
+    Checkpoint& ck = thr.ckpts[ckpt_id];
+    sim_assert(!ck.in_use);
+    ck.in_use = true;
+    ck.owner_id = inst->id;
+    ck.owner_fetchcyc = inst->fetchcycle;
+
+    const AppState *as = ctx->as;
+    memcpy(ck.regs, as->R, sizeof(ck.regs));
+    memcpy(ck.last_writer, ctx->last_writer, sizeof(ck.last_writer));
+    ck.retstack.assign(ctx->return_stack,
+                       ctx->return_stack + ctx->params.retstack_entries);
+    ck.rs_size = ctx->rs_size;
+    ck.rs_start = ctx->rs_start;
+    ck.ghr = ctx->ghr;
+    ck.ind_hist = ctx->ind_hist;
+    ck.bp_hist_pos = bpred_hist_pos(ctx);
+    ck.renamed = false;
+
+    inst->ckpt_id = ckpt_id;
+    stats_.taken++;
+}
+
+
+void
+BranchCkpt::release(const context *ctx, activelist *inst)
+{
+    ThreadCkpts& thr = thread(ctx);
+    sim_assert(inst->ckpt_id >= 0);
+    sim_assert(inst->ckpt_id < intsize(thr.ckpts));
+    Checkpoint& ck = thr.ckpts[inst->ckpt_id];
+    sim_assert(ck.in_use && (ck.owner_id == inst->id));
+    ck.in_use = false;
+    ck.owner_id = -1;
+    thr.free_list.push_back(inst->ckpt_id);
+    inst->ckpt_id = -1;
+}
+
+
+const Checkpoint&
+BranchCkpt::owned_ckpt(const context *ctx, const activelist *br) const
+{
+    const ThreadCkpts& thr = thread_c(ctx);
+    sim_assert(br->ckpt_id >= 0);
+    sim_assert(br->ckpt_id < intsize(thr.ckpts));
+    const Checkpoint& ck = thr.ckpts[br->ckpt_id];
+    sim_assert(ck.in_use && (ck.owner_id == br->id) &&
+               (ck.owner_fetchcyc == br->fetchcycle));
+    return ck;
+}
+
+
+void
+BranchCkpt::inst_renamed(const context *ctx, const activelist *inst)
+{
+    ThreadCkpts& thr = thread(ctx);
+    Checkpoint& ck = thr.ckpts[inst->ckpt_id];
+    sim_assert(ck.in_use && (ck.owner_id == inst->id) && !ck.renamed);
+    ck.renamed = true;
+    ck.alloced_at_rename = ctx->rsrc_alloced;
+    ck.squash_freed_at_rename = ctx->rsrc_squash_freed;
+}
+
+
+// Resources held by the insts after "br": everything allocated since it
+// was renamed, less what squashes have released since.  (Only younger
+// insts can be renamed or squashed after "br" without squashing "br"
+// itself, and none of them can have committed.)
+void
+BranchCkpt::squashed_rsrc(const context *ctx, const activelist *br,
+                          CtxRsrcTally *held) const
+{
+    const Checkpoint& ck = owned_ckpt(ctx, br);
+    sim_assert(ck.renamed);
+    const CtxRsrcTally& now_a = ctx->rsrc_alloced;
+    const CtxRsrcTally& now_f = ctx->rsrc_squash_freed;
+    const CtxRsrcTally& ck_a = ck.alloced_at_rename;
+    const CtxRsrcTally& ck_f = ck.squash_freed_at_rename;
+    held->iregs = (now_a.iregs - ck_a.iregs) - (now_f.iregs - ck_f.iregs);
+    held->fregs = (now_a.fregs - ck_a.fregs) - (now_f.fregs - ck_f.fregs);
+    held->lsq = (now_a.lsq - ck_a.lsq) - (now_f.lsq - ck_f.lsq);
+    held->rob = (now_a.rob - ck_a.rob) - (now_f.rob - ck_f.rob);
+    sim_assert((held->iregs >= 0) && (held->fregs >= 0) &&
+               (held->lsq >= 0) && (held->rob >= 0));
+}
+
+
+void
+BranchCkpt::restore(context *ctx, const activelist *br) const
+{
+    const Checkpoint& ck = owned_ckpt(ctx, br);
+
+    memcpy(ctx->as->R, ck.regs, sizeof(ck.regs));
+    for (int reg = 0; reg < MAXREG; reg++) {
+        int writer_id = ck.last_writer[reg];
+        if (!writer_valid(ctx, writer_id, br))
+            writer_id = NONE;
+        // Registers no squashed inst wrote are left alone, as with the
+        // walk-back; that includes their "lasthazard" times.
+        if (ctx->last_writer[reg] != writer_id) {
+            ctx->last_writer[reg] = writer_id;
+            ctx->lasthazard[reg] = (writer_id != NONE) ?
+                ctx->alist[writer_id].donecycle : 0;
+        }
+    }
+    std::copy(ck.retstack.begin(), ck.retstack.end(), ctx->return_stack);
+    ctx->rs_size = ck.rs_size;
+    ctx->rs_start = ck.rs_start;
+    ctx->ghr = ck.ghr;
+    ctx->ind_hist = ck.ind_hist;
+    bpred_hist_restore(ctx, ck.bp_hist_pos);
+}
+
+
+void
+BranchCkpt::verify(const context *ctx, const activelist *br) const
+{
+    const Checkpoint& ck = owned_ckpt(ctx, br);
+    const char *what = NULL;
+    int which = -1;
+
+    for (int reg = 0; (reg < MAXREG) && !what; reg++) {
+        int ck_writer = ck.last_writer[reg];
+        if (!writer_valid(ctx, ck_writer, br))
+            ck_writer = NONE;
+        if (ctx->as->R[reg].i != ck.regs[reg].i) {
+            what = "register value";
+            which = reg;
+        } else if (ctx->last_writer[reg] != ck_writer) {
+            what = "last_writer";
+            which = reg;
+        }
+    }
+    if (!what && ((ctx->rs_size != ck.rs_size) ||
+                  (ctx->rs_start != ck.rs_start)))
+        what = "return stack size/start";
+    for (int i = 0; (i < ck.rs_size) && !what; i++) {
+        int idx = (ck.rs_start + i) % ctx->params.retstack_entries;
+        if (ctx->return_stack[idx] != ck.retstack[idx]) {
+            what = "return stack entry";
+            which = idx;
+        }
+    }
+    // (ghr and ind_hist are repaired from the branch itself, either way)
+
+    if (what) {
+        abort_printf("BranchCkpt %s: T%ds%d checkpoint mismatch after "
+                     "walk-back: %s (%d)\n", name_.c_str(), ctx->id, br->id,
+                     what, which);
+    }
+}
+
+
+void
+BranchCkpt::br_committed(const context *ctx, const activelist *inst)
+{
+    if (!is_candidate(inst->br_flags, inst->gen_flags))
+        return;
+    int idx = conf_index(inst->pc, inst->br_flags, inst->ghr);
+    bool was_low = conf_table_[idx] < conf_.conf_threshold;
+    bool mispred = inst->mispredict != MisPred_None;
+    stats_.conf_commits++;
+    if (was_low) {
+        stats_.conf_low_commits++;
+        if (mispred)
+            stats_.conf_low_mispred++;
+    } else if (mispred) {
+        stats_.conf_high_mispred++;
+    }
+    if (mispred) {
+        conf_table_[idx] = 0;
+    } else if (conf_table_[idx] < ConfCounterMax) {
+        conf_table_[idx]++;
+    }
+}
+
+
+void
+BranchCkpt::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%sBranchCkpt: branches %s low-conf %s taken %s"
+            " full %s stall_cyc %s\n", pf,
+            fmt_i64(stats_.branches), fmt_i64(stats_.low_conf),
+            fmt_i64(stats_.taken), fmt_i64(stats_.full),
+            fmt_i64(stats_.stall_cyc));
+    fprintf(out, "%sBranchCkpt: recoveries: checkpoint %s walk %s\n", pf,
+            fmt_i64(stats_.ckpt_recoveries), fmt_i64(stats_.walk_recoveries));
+    i64 high_commits = stats_.conf_commits - stats_.conf_low_commits;
+    fprintf(out, "%sBranchCkpt: confidence: committed %s, low %s"
+            " (%.2f%% mispred), high %s (%.2f%% mispred)\n", pf,
+            fmt_i64(stats_.conf_commits), fmt_i64(stats_.conf_low_commits),
+            (stats_.conf_low_commits) ?
+            (100.0 * stats_.conf_low_mispred / stats_.conf_low_commits) : 0.0,
+            fmt_i64(high_commits),
+            (high_commits) ?
+            (100.0 * stats_.conf_high_mispred / high_commits) : 0.0);
+}
+
+
+
+//
+// C interface
+//
+
+BranchCkpt *
+bckpt_create(const char *name, const char *config_path,
+             struct CoreResources *core)
+{
+    return new BranchCkpt(name, config_path, core);
+}
+
+void
+bckpt_destroy(BranchCkpt *bckpt)
+{
+    delete bckpt;
+}
+
+int
+bckpt_fetch_stall(BranchCkpt *bckpt, const struct context *ctx,
+                  mem_addr pc, int br_flags, int gen_flags)
+{
+    return bckpt->fetch_stall(ctx, pc, br_flags, gen_flags);
+}
+
+void
+bckpt_inst_fetched(BranchCkpt *bckpt, const struct context *ctx,
+                   struct activelist *inst)
+{
+    bckpt->inst_fetched(ctx, inst);
+}
+
+void
+bckpt_release(BranchCkpt *bckpt, const struct context *ctx,
+              struct activelist *inst)
+{
+    bckpt->release(ctx, inst);
+}
+
+void
+bckpt_inst_renamed(BranchCkpt *bckpt, const struct context *ctx,
+                   const struct activelist *inst)
+{
+    bckpt->inst_renamed(ctx, inst);
+}
+
+void
+bckpt_squashed_rsrc(const BranchCkpt *bckpt, const struct context *ctx,
+                    const struct activelist *br, struct CtxRsrcTally *held)
+{
+    bckpt->squashed_rsrc(ctx, br, held);
+}
+
+void
+bckpt_restore(BranchCkpt *bckpt, struct context *ctx,
+              const struct activelist *br)
+{
+    bckpt->restore(ctx, br);
+}
+
+void
+bckpt_verify(const BranchCkpt *bckpt, const struct context *ctx,
+             const struct activelist *br)
+{
+    bckpt->verify(ctx, br);
+}
+
+int
+bckpt_verify_enabled(const BranchCkpt *bckpt)
+{
+    return bckpt->verify_enabled();
+}
+
+void
+bckpt_note_recovery(BranchCkpt *bckpt, int from_checkpoint)
+{
+    bckpt->note_recovery(from_checkpoint);
+}
+
+void
+bckpt_br_committed(BranchCkpt *bckpt, const struct context *ctx,
+                   const struct activelist *inst)
+{
+    bckpt->br_committed(ctx, inst);
+}
+
+void
+bckpt_reset_stats(BranchCkpt *bckpt)
+{
+    bckpt->reset_stats();
+}
+
+void
+bckpt_get_stats(const BranchCkpt *bckpt, BranchCkptStats *dest)
+{
+    *dest = bckpt->get_stats();
+}
+
+static void
+bckpt_stats_provider(StatsEmitter *em, void *data)
+{
+    const BranchCkptStats& st = static_cast<const BranchCkpt *>(data)->get_stats();
+    statsemit_i64(em, "branches", st.branches);
+    statsemit_i64(em, "low_conf", st.low_conf);
+    statsemit_i64(em, "taken", st.taken);
+    statsemit_i64(em, "full", st.full);
+    statsemit_i64(em, "stall_cyc", st.stall_cyc);
+    statsemit_i64(em, "ckpt_recoveries", st.ckpt_recoveries);
+    statsemit_i64(em, "walk_recoveries", st.walk_recoveries);
+    statsemit_i64(em, "conf_commits", st.conf_commits);
+    statsemit_i64(em, "conf_low_commits", st.conf_low_commits);
+    statsemit_i64(em, "conf_low_mispred", st.conf_low_mispred);
+    statsemit_i64(em, "conf_high_mispred", st.conf_high_mispred);
+}
+
+void
+bckpt_register_stats(BranchCkpt *bckpt, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, bckpt_stats_provider, bckpt);
+}
+
+void
+bckpt_print_stats(const BranchCkpt *bckpt, void *c_FILE_out,
+                  const char *prefix)
+{
+    bckpt->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
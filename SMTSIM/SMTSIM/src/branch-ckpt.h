@@ -0,0 +1,126 @@
+// -*- C++ -*-
+//
+// Branch checkpoints for mispredict recovery
+//
+// $Id$
+//
+
+#ifndef BRANCH_CKPT_H
+#define BRANCH_CKPT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each core may have one of these, enabled by its "BranchCkpt" config block.
+//
+// Without checkpoints, a mispredict is recovered by walking the activelist
+// back from the youngest instruction, undoing each one's emulation (see
+// roll_back_insts() in execute.c).  With them, low-confidence branches
+// (per a JRS-style resetting-counter table) take a snapshot at fetch of the
+// state that undo_inst() would otherwise have to reconstruct: the emulator
+// registers, the rename map ("last_writer"), the return stack and the
+// branch histories.  A mispredict on a checkpointed branch restores the
+// snapshot in one step.  The pipeline resources held by the squashed
+// instructions are released in bulk too: each checkpoint records the
+// context's cumulative rename-allocation and squash-release tallies when its
+// branch is renamed, and their growth since then is exactly what the younger
+// instructions hold.  The squashed instructions are still visited, but only
+// to mark them squashed and to handle per-entry state (wrong-path stores,
+// LSQ-model entries, nested checkpoints).
+//
+// Each thread has "n_checkpoints" of these, as the hardware would; a
+// checkpoint is held from fetch until its branch resolves correctly, is
+// used, or is squashed.  When they run out, low-confidence branches either
+// go without ("stall_when_full" off) and fall back to the walk, or stall
+// fetch until one is freed.
+
+struct CoreResources;
+struct context;
+struct activelist;
+struct CtxRsrcTally;
+
+typedef struct BranchCkpt BranchCkpt;
+typedef struct BranchCkptStats BranchCkptStats;
+struct StatsReg;
+
+struct BranchCkptStats {
+    i64 branches;               // candidate branches fetched
+    i64 low_conf;               // ...estimated low-confidence
+    i64 taken;                  // checkpoints taken
+    i64 full;                   // low-conf branches without one: all in use
+    i64 stall_cyc;              // fetch stalls for "stall_when_full"
+    i64 ckpt_recoveries;        // mispredicts recovered from a checkpoint
+    i64 walk_recoveries;        // ...by walking back, without one
+    i64 conf_commits;           // committed candidate branches...
+    i64 conf_low_commits;       // ...estimated low-confidence...
+    i64 conf_low_mispred;       // ...which were mispredicted
+    i64 conf_high_mispred;      // high-confidence, but mispredicted
+};
+
+
+BranchCkpt *bckpt_create(const char *name, const char *config_path,
+                         struct CoreResources *core);
+void bckpt_destroy(BranchCkpt *bckpt);
+
+// Probe at fetch, before emulating the branch at "pc": must fetch stop here,
+// waiting for a free checkpoint?  Updates stall stats.
+int bckpt_fetch_stall(BranchCkpt *bckpt, const struct context *ctx,
+                      mem_addr pc, int br_flags, int gen_flags);
+
+// The inst just fetched into ctx->alisttop is done with fetch-time setup
+// (including its own last_writer entry).  If it's a branch in need of a
+// checkpoint and one is free, take it and set inst->ckpt_id.
+void bckpt_inst_fetched(BranchCkpt *bckpt, const struct context *ctx,
+                        struct activelist *inst);
+
+// The inst "inst", holding a checkpoint, was just renamed (with its own
+// resources added to ctx->rsrc_alloced).
+void bckpt_inst_renamed(BranchCkpt *bckpt, const struct context *ctx,
+                        const struct activelist *inst);
+
+// Write to "held" the resources held by the instructions after branch "br",
+// which holds a checkpoint and has been renamed.
+void bckpt_squashed_rsrc(const BranchCkpt *bckpt, const struct context *ctx,
+                         const struct activelist *br,
+                         struct CtxRsrcTally *held);
+
+// Free the checkpoint held by "inst" (which must have one).
+void bckpt_release(BranchCkpt *bckpt, const struct context *ctx,
+                   struct activelist *inst);
+
+// Restore the checkpoint held by branch "br" to "ctx"; the instructions
+// after "br" must already have been squashed.  Doesn't free it.
+void bckpt_restore(BranchCkpt *bckpt, struct context *ctx,
+                   const struct activelist *br);
+
+// Like bckpt_restore(), but instead of writing to "ctx", compare the
+// checkpoint against it (after a conventional walk-back), aborting on a
+// mismatch.
+void bckpt_verify(const BranchCkpt *bckpt, const struct context *ctx,
+                  const struct activelist *br);
+
+// Config "verify": recover by walking back, and check the checkpoint
+int bckpt_verify_enabled(const BranchCkpt *bckpt);
+
+// Note the means of recovery from a mispredict, for stats
+void bckpt_note_recovery(BranchCkpt *bckpt, int from_checkpoint);
+
+// A correct-path branch committed; trains the confidence estimator
+void bckpt_br_committed(BranchCkpt *bckpt, const struct context *ctx,
+                        const struct activelist *inst);
+
+void bckpt_reset_stats(BranchCkpt *bckpt);
+void bckpt_get_stats(const BranchCkpt *bckpt, BranchCkptStats *dest);
+// Register a provider for BranchCkptStats at "path" (stats-reg.h)
+void bckpt_register_stats(BranchCkpt *bckpt, struct StatsReg *sr,
+                          const char *path);
+void bckpt_print_stats(const BranchCkpt *bckpt, void *c_FILE_out,
+                       const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // BRANCH_CKPT_H
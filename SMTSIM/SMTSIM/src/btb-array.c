@@ -17,6 +17,7 @@ const char RCSid_1035567839[] =
 #include "btb-array.h"
 #include "assoc-array.h"
 #include "utils.h"
+#include "stats-reg.h"
 
 
 typedef struct BTBEntry {
@@ -235,6 +236,27 @@ btb_get_stats(const BTBArray *btb, BTBStats *dest)
 }
 
 
+static void
+btb_stats_provider(StatsEmitter *em, void *data)
+{
+    BTBStats st;
+    btb_get_stats((const BTBArray *) data, &st);
+    statsemit_i64(em, "hits", st.hits);
+    statsemit_i64(em, "misses", st.misses);
+    statsemit_i64(em, "jump_dest_mismatch", st.jump_dest_mismatch);
+    statsemit_i64(em, "miss_not_taken", st.miss_not_taken);
+    statsemit_i64(em, "eff_hits", st.eff_hits);
+    statsemit_i64(em, "eff_misses", st.eff_misses);
+}
+
+
+void
+btb_register_stats(BTBArray *btb, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, btb_stats_provider, btb);
+}
+
+
 u64
 btb_calc_baseaddr(const BTBArray *btb, u64 addr)
 {
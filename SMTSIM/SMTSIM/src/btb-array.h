@@ -16,6 +16,7 @@ extern "C" {
 typedef struct BTBArray BTBArray;
 typedef struct BTBStats BTBStats;
 typedef struct BTBLookupInfo BTBLookupInfo; 
+struct StatsReg;
 
 
 /* Extra info passed to btb_lookup() to help accounting */
@@ -74,6 +75,9 @@ int btb_probe(const BTBArray *btb, u64 addr, int thread_id, u64 *dest_ret);
 void btb_update(BTBArray *btb, u64 addr, int thread_id, u64 dest);
 
 void btb_get_stats(const BTBArray *btb, BTBStats *dest);
+/* Register a provider for this BTB's BTBStats at "path" (stats-reg.h) */
+void btb_register_stats(BTBArray *btb, struct StatsReg *sr,
+                        const char *path);
 
 u64 btb_calc_baseaddr(const BTBArray *btb, u64 addr);
 
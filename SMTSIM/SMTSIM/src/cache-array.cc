@@ -22,10 +22,13 @@ const char RCSid_1034634457[] =
 #include "sys-types.h"
 #include "cache-array.h"
 #include "assoc-array.h"
+#include "cache-compress.h"
 #include "coherence-mgr.h"
 #include "sim-cfg.h"
 #include "utils.h"
+#include "online-stats.h"
 #include "sim-params.h"
+#include "stats-reg.h"
 
 
 using std::string;
@@ -284,6 +287,39 @@ struct WritebackRec {
 typedef std::list<WritebackRec> WritebackQueue;
 
 
+// Compressed data array bookkeeping, kept parallel to the CacheEntry array.
+// "bytes" is the data-array space held (segment-rounded, 0 if no data);
+// "stamp" orders blocks by last use, for picking extra victims.
+struct CompEntry {
+    int bytes;
+    u64 stamp;
+    CompEntry() : bytes(0), stamp(0) { }
+};
+
+// Blocks displaced from a compressed set, beyond the one cache_fill()
+// reports, awaiting cache_fill_extra_evict()
+struct ExtraEvict {
+    LongAddr base_addr;
+    bool dirty;
+    ExtraEvict(const LongAddr& base_addr_, bool dirty_)
+        : base_addr(base_addr_), dirty(dirty_) { }
+};
+
+struct CompStats {
+    HistCount_Int fill_segs;    // fills by compressed size, in segments
+    i64 fills, fill_bytes;      // (fill_bytes: sum of compressed sizes)
+    i64 extra_evicts;           // victims beyond the tag-selected one
+    i64 over_budget;            // fills left over budget (no usable victim)
+    i64 decompress_hits;        // hits charged decompression latency
+    CompStats() { reset(); }
+    void reset() {
+        fill_segs.reset();
+        fills = fill_bytes = 0;
+        extra_evicts = over_budget = decompress_hits = 0;
+    }
+};
+
+
 } // Anonymous namespace close
 
 
@@ -303,6 +339,21 @@ private:
     int block_bytes_lg, n_banks_lg;
     int n_lines_lg, n_lines;
     int n_blocks;
+    int tag_ways;                       // tags per set; == assoc unless comp.
+    int tag_count;                      // n_lines * tag_ways
+
+    // Compressed data array (decoupled tags): each set holds up to
+    // "tag_ways" blocks, so long as their compressed sizes fit in the
+    // uncompressed set size (assoc * block_bytes)
+    CacheCompAlg comp_alg;
+    int comp_segment_bytes;
+    int comp_decompress_lat;
+    int comp_set_budget;
+    vector<CompEntry> comp_ents;        // 2D array [n_lines][tag_ways]
+    vector<int> comp_set_bytes;         // 1D array [n_lines]
+    std::list<ExtraEvict> extra_evicts;
+    u64 comp_stamp;
+    CompStats comp_stats;
 
     AssocArray *cam;
     vector<CacheEntry> entries;         // 2D array [n_lines][assoc]
@@ -337,9 +388,9 @@ private:
         sim_assert(line_num >= 0);
         sim_assert(way_num >= 0);
 #ifdef DEBUG
-        return entries.at(geom.assoc * line_num + way_num);
+        return entries.at(tag_ways * line_num + way_num);
 #else
-        return entries[geom.assoc * line_num + way_num];
+        return entries[tag_ways * line_num + way_num];
 #endif
     }
 
@@ -347,9 +398,9 @@ private:
         sim_assert(line_num >= 0);
         sim_assert(way_num >= 0);
 #ifdef DEBUG
-        return entries.at(geom.assoc * line_num + way_num);
+        return entries.at(tag_ways * line_num + way_num);
 #else
-        return entries[geom.assoc * line_num + way_num];
+        return entries[tag_ways * line_num + way_num];
 #endif
     }
 
@@ -393,7 +444,7 @@ private:
         pop_count.clear();
     }
     void pop_increment(const LongAddr& base_addr) {
-        sim_assert(pop_total < n_blocks);
+        sim_assert(pop_total < tag_count);
         sim_assert(pop_count[base_addr.id] <= pop_total);
         ++pop_count[base_addr.id];
         ++pop_total;
@@ -405,6 +456,28 @@ private:
         --pop_total;
     }
 
+    bool compressed() const { return comp_alg != CacheComp_None; }
+    CompEntry& comp_ref(long line_num, int way_num) {
+        return comp_ents[tag_ways * line_num + way_num];
+    }
+    const CompEntry& comp_ref(long line_num, int way_num) const {
+        return comp_ents[tag_ways * line_num + way_num];
+    }
+    void comp_touch(long line_num, int way_num) {
+        if (compressed())
+            comp_ref(line_num, way_num).stamp = ++comp_stamp;
+    }
+    void comp_release(long line_num, int way_num) {
+        if (compressed()) {
+            CompEntry& cent = comp_ref(line_num, way_num);
+            comp_set_bytes[line_num] -= cent.bytes;
+            sim_assert(comp_set_bytes[line_num] >= 0);
+            cent.bytes = 0;
+        }
+    }
+    void comp_place(const LongAddr& base_addr, long line_num, int way_num);
+    bool comp_pick_victim(long line_num, int keep_way, int *way_ret) const;
+
     void wb_enqueue(const LongAddr& base_addr, bool for_coher) {
         if (wb_fifo_used >= geom.wb_buffer_size) {
             abort_printf("cache %d WB buffer overflow, enqueue %s\n",
@@ -448,6 +521,7 @@ public:
         bool first_access = false;
         if (aarray_lookup(cam, &lookup_key, &line_num, &way_num)) {
             CacheEntry& entry = ent_ref(line_num, way_num);
+            comp_touch(line_num, way_num);
             if (!entry.data_present()) {
                 // tag match, data missing => coher. miss for stats purposes
                 stats.misses++;
@@ -505,6 +579,16 @@ public:
         return result;
     }
 
+    bool block_dirty(const LongAddr& addr) const {
+        AssocArrayKey lookup_key;
+        gen_aa_key(lookup_key, addr);
+        long line_num; int way_num;
+        bool result = false;
+        if (aarray_probe(cam, &lookup_key, &line_num, &way_num))
+            result = ent_ref(line_num, way_num).is_dirty();
+        return result;
+    }
+
     bool touch(const LongAddr& addr) {
         bool data_present = false;
         AssocArrayKey lookup_key;
@@ -512,6 +596,7 @@ public:
         long line_num; int way_num;
         if (aarray_lookup(cam, &lookup_key, &line_num, &way_num)) {
             CacheEntry& entry = ent_ref(line_num, way_num);
+            comp_touch(line_num, way_num);
             if (entry.data_present()) {
                 data_present = true;
             }
@@ -536,6 +621,7 @@ public:
         bool evicted_valid = false;
         bool evicted_dirty = false;
         sim_assert(!wb_buffer_full());
+        sim_assert(extra_evicts.empty());       // caller must drain these
         gen_aa_key(fill_key, addr);
         if (aarray_lookup(cam, &fill_key, &line_num, &way_num)) {
             // line_num / way_num set for later; data may be missing, though
@@ -591,6 +677,8 @@ public:
             evicted_ret->base_addr = e_base_addr;
             pop_decrement(e_base_addr);
         }
+        if (!already_present)
+            comp_release(line_num, way_num);
 
         entry.reset();
         switch (access_type) {
@@ -613,6 +701,15 @@ public:
         sim_assert(coher_ok(addr, entry));
         if (!already_present)           // (don't double-count upgrades)
             pop_increment(addr);
+        comp_touch(line_num, way_num);
+        if (!already_present && compressed()) {
+            // A clean tag-selected victim may yet need a WB buffer entry
+            // for an inclusion write-around (see l3_replace()), so hold one
+            // for it when choosing extra victims
+            comp_place(addr, line_num, way_num);
+            make_set_room(line_num, way_num,
+                          (evicted_valid && !evicted_dirty) ? 1 : 0);
+        }
 
         CacheFillOutcome outcome = CacheFill_NoEvict;
         if (evicted_valid) {
@@ -622,6 +719,35 @@ public:
         return outcome;
     }
 
+    void make_set_room(long line_num, int keep_way, int wb_reserved);
+
+    CacheFillOutcome fill_extra_evict(CacheEvicted *evicted_ret) {
+        if (extra_evicts.empty())
+            return CacheFill_NoEvict;
+        const ExtraEvict& ev = extra_evicts.front();
+        evicted_ret->base_addr = ev.base_addr;
+        CacheFillOutcome outcome = (ev.dirty) ? CacheFill_EvictDirty :
+            CacheFill_EvictClean;
+        extra_evicts.pop_front();
+        return outcome;
+    }
+
+    int decompress_latency(const LongAddr& addr) {
+        int result = 0;
+        if (compressed()) {
+            AssocArrayKey lookup_key;
+            gen_aa_key(lookup_key, addr);
+            long line_num; int way_num;
+            if (aarray_probe(cam, &lookup_key, &line_num, &way_num) &&
+                ent_ref(line_num, way_num).data_present() &&
+                (comp_ref(line_num, way_num).bytes < geom.block_bytes)) {
+                result = comp_decompress_lat;
+                comp_stats.decompress_hits++;
+            }
+        }
+        return result;
+    }
+
     bool writeback(const LongAddr& addr) {
         // (write-back from a cache above, into this cache)
         sim_assert(!wb_buffer_full());
@@ -748,6 +874,7 @@ public:
                     aarray_invalidate(cam, line_num, way_num);
                 entry.reset();
                 pop_decrement(base_addr);
+                comp_release(line_num, way_num);
             } else {
                 entry.set_state(CE_SharedClean);
                 entry.coher_lockout_done();
@@ -762,6 +889,30 @@ public:
         return outcome;
     }
 
+    CacheFillOutcome invalidate(const LongAddr& base_addr) {
+        AssocArrayKey lookup_key;
+        long line_num = 0; int way_num = 0;
+        gen_aa_key(lookup_key, base_addr);
+        bool data_present = aarray_probe(cam, &lookup_key,
+                                         &line_num, &way_num);
+        CacheEntry& entry = ent_ref(line_num, way_num);
+        if (data_present && !entry.data_present())
+            data_present = false;
+        CacheFillOutcome outcome = CacheFill_NoEvict;
+        if (data_present) {
+            outcome = (entry.is_dirty()) ? CacheFill_EvictDirty :
+                CacheFill_EvictClean;
+            stats.incl_invalidates++;
+            // Unlike coher_yield(), we don't keep the tag around: this isn't
+            // a coherence miss if the block is touched again.
+            aarray_invalidate(cam, line_num, way_num);
+            entry.reset();
+            pop_decrement(base_addr);
+            comp_release(line_num, way_num);
+        }
+        return outcome;
+    }
+
     i64 update_bank(const LongAddr& addr, i64 now, CacheBankOp bank_op) {
         int bank_num = block_bank_num(addr);
         CacheBank& bank = banks[bank_num];
@@ -829,6 +980,7 @@ public:
     }
 
     LongAddr *get_tags(int master_id, int *n_tags_ret) const;
+    void print_compress_stats(FILE *out, const char *prefix) const;
 
     int get_id() const { return cache_id; }
     const CacheGeometry *get_geom(int *n_lines_ret, int *n_blocks_ret) const {
@@ -847,7 +999,9 @@ CacheArray::CacheArray(int cache_id_, const CacheGeometry *geom_,
                        i64 now)
     : cache_id(cache_id_), geom(*geom_), timing(*timing_), coher(coher_),
       parent_core(parent_core_),
-      track_coher_misses(false), cam(0), wb_fifo_used(0), pop_total(0)
+      track_coher_misses(false), comp_alg(CacheComp_None),
+      comp_segment_bytes(0), comp_decompress_lat(0), comp_set_budget(0),
+      comp_stamp(0), cam(0), wb_fifo_used(0), pop_total(0)
 {
     int log_inexact;
 
@@ -915,13 +1069,43 @@ CacheArray::CacheArray(int cache_id_, const CacheGeometry *geom_,
         n_blocks = n_lines * geom.assoc;
     }
 
-    if (!(cam = aarray_create_simcfg(n_lines, geom.assoc, geom.config_path))) {
+    tag_ways = geom.assoc;
+    {
+        const string comp_base = config_base + "/Compression/";
+        if (SimCfg::have_conf(comp_base + "algorithm")) {
+            comp_alg = CacheCompAlg(SimCfg::conf_enum(CacheCompAlg_names,
+                                                      comp_base +
+                                                      "algorithm"));
+        }
+        if (compressed()) {
+            int tag_factor = SimCfg::conf_int(comp_base + "tag_factor");
+            comp_segment_bytes = SimCfg::conf_int(comp_base + "segment_bytes");
+            comp_decompress_lat =
+                SimCfg::conf_int(comp_base + "decompress_latency");
+            if ((tag_factor < 1) || (comp_segment_bytes < 1) ||
+                (comp_segment_bytes > geom.block_bytes) ||
+                (comp_decompress_lat < 0)) {
+                fprintf(stderr, "(%s:%i): bad Compression parameters in "
+                        "%s\n", __FILE__, __LINE__, comp_base.c_str());
+                goto fail;
+            }
+            tag_ways = geom.assoc * tag_factor;
+            comp_set_budget = geom.assoc * geom.block_bytes;
+        }
+    }
+    tag_count = n_lines * tag_ways;
+
+    if (!(cam = aarray_create_simcfg(n_lines, tag_ways, geom.config_path))) {
         fprintf(stderr, "(%s:%i): couldn't create AssocArray\n",
                 __FILE__, __LINE__);
         goto fail;
     }
 
-    entries.resize(n_lines * geom.assoc);
+    entries.resize(tag_count);
+    if (compressed()) {
+        comp_ents.resize(tag_count);
+        comp_set_bytes.resize(n_lines);
+    }
     
     for (int bnum = 0; bnum < geom.n_banks; bnum++)
         banks.push_back(CacheBank(geom.ports.r, geom.ports.w, geom.ports.rw));
@@ -972,6 +1156,10 @@ CacheArray::reset(i64 now)
         for (; iter != end; ++iter)
             iter->reset();
     }
+    comp_ents.assign(comp_ents.size(), CompEntry());
+    comp_set_bytes.assign(comp_set_bytes.size(), 0);
+    extra_evicts.clear();
+    comp_stamp = 0;
     pop_reset();
     reset_stats(now);
 }
@@ -992,7 +1180,131 @@ CacheArray::reset_stats(i64 now)
     stats.reads = stats.reads_ex = stats.writes = 0;
     stats.dirty_evicts = 0;
     stats.coher_writebacks = stats.coher_invalidates = 0;
+    stats.incl_invalidates = 0;
     stats.wbfull_confs = 0;
+    comp_stats.reset();
+}
+
+
+void
+CacheArray::comp_place(const LongAddr& base_addr, long line_num, int way_num)
+{
+    int bytes = cachecomp_sample_size(comp_alg, base_addr, geom.block_bytes);
+    int segs = (bytes + comp_segment_bytes - 1) / comp_segment_bytes;
+    bytes = segs * comp_segment_bytes;
+    if (bytes > geom.block_bytes)
+        bytes = geom.block_bytes;
+    CompEntry& cent = comp_ref(line_num, way_num);
+    sim_assert(cent.bytes == 0);
+    cent.bytes = bytes;
+    comp_set_bytes[line_num] += bytes;
+    comp_stats.fill_segs.add_count(segs);
+    comp_stats.fills++;
+    comp_stats.fill_bytes += bytes;
+}
+
+
+// Least-recently-used present block in the set, other than keep_way.
+// Blocks locked out for a pending coherence yield are off-limits, since the
+// coherence manager is about to come looking for them.
+bool
+CacheArray::comp_pick_victim(long line_num, int keep_way, int *way_ret) const
+{
+    int victim = -1;
+    u64 victim_stamp = 0;
+    for (int way_num = 0; way_num < tag_ways; way_num++) {
+        const CacheEntry& entry = ent_ref(line_num, way_num);
+        if ((way_num == keep_way) || !entry.data_present() ||
+            entry.is_coher_locked_out())
+            continue;
+        u64 stamp = comp_ref(line_num, way_num).stamp;
+        if ((victim < 0) || (stamp < victim_stamp)) {
+            victim = way_num;
+            victim_stamp = stamp;
+        }
+    }
+    if (victim >= 0)
+        *way_ret = victim;
+    return victim >= 0;
+}
+
+
+// After a fill into a compressed set, evict more blocks until the set's data
+// fits its byte budget.  Each extra victim holds a WB buffer entry (dirty
+// ones use it right away; clean ones keep it free for the caller), so if
+// the buffer runs out, the set is left over budget until a later fill.
+void
+CacheArray::make_set_room(long line_num, int keep_way, int wb_reserved)
+{
+    while (comp_set_bytes[line_num] > comp_set_budget) {
+        int wb_free = geom.wb_buffer_size - wb_fifo_used - wb_reserved;
+        int way_num;
+        if ((wb_free <= 0) ||
+            !comp_pick_victim(line_num, keep_way, &way_num)) {
+            comp_stats.over_budget++;
+            break;
+        }
+        AssocArrayKey victim_key;
+        bool key_valid = aarray_readkey(cam, line_num, way_num, &victim_key);
+        sim_assert(key_valid);
+        LongAddr v_base_addr;
+        reverse_aa_key(v_base_addr, victim_key);
+        CacheEntry& entry = ent_ref(line_num, way_num);
+        bool dirty = entry.is_dirty();
+        if (dirty) {
+            stats.dirty_evicts++;
+            wb_enqueue(v_base_addr, false);
+        } else {
+            wb_reserved++;
+        }
+        aarray_invalidate(cam, line_num, way_num);
+        entry.reset();
+        pop_decrement(v_base_addr);
+        comp_release(line_num, way_num);
+        extra_evicts.push_back(ExtraEvict(v_base_addr, dirty));
+        comp_stats.extra_evicts++;
+    }
+}
+
+
+void
+CacheArray::print_compress_stats(FILE *out, const char *prefix) const
+{
+    if (!compressed())
+        return;
+    fprintf(out, "%scompression: %s, %d tags/set, %d-byte segments, "
+            "decompress latency %d\n", prefix,
+            CacheCompAlg_names[comp_alg], tag_ways, comp_segment_bytes,
+            comp_decompress_lat);
+    fprintf(out, "%s  fills %s, avg ratio %.3f, extra evicts %s, "
+            "over-budget fills %s, decompress hits %s\n", prefix,
+            fmt_i64(comp_stats.fills),
+            (comp_stats.fill_bytes) ?
+            ((double) comp_stats.fills * geom.block_bytes /
+             comp_stats.fill_bytes) : 1.0,
+            fmt_i64(comp_stats.extra_evicts),
+            fmt_i64(comp_stats.over_budget),
+            fmt_i64(comp_stats.decompress_hits));
+    long resident_bytes = 0;
+    for (long line_num = 0; line_num < n_lines; line_num++)
+        resident_bytes += comp_set_bytes[line_num];
+    fprintf(out, "%s  resident blocks %d / %d frames (%.3f effective), "
+            "data array %.3f full\n", prefix, pop_total, n_blocks,
+            (double) pop_total / n_blocks,
+            (double) resident_bytes / ((double) n_lines * comp_set_budget));
+
+    // Ratio histogram: fills binned by compressed size in segments
+    HistCount_Int::KeySet keys;
+    comp_stats.fill_segs.get_all_keys(keys);
+    const int block_segs = (geom.block_bytes + comp_segment_bytes - 1) /
+        comp_segment_bytes;
+    for (HistCount_Int::KeySet::const_iterator iter = keys.begin();
+         iter != keys.end(); ++iter) {
+        i64 count = comp_stats.fill_segs.get_count(*iter);
+        fprintf(out, "%s  size %2d/%d segs (ratio %5.2f): %s (%.4f)\n",
+                prefix, *iter, block_segs, (double) block_segs / *iter,
+                fmt_i64(count), (double) count / comp_stats.fills);
+    }
 }
 
 
@@ -1001,7 +1313,7 @@ CacheArray::get_tags(int master_id, int *n_tags_ret) const
 {
     vector<LongAddr> matches;
     for (long line_num = 0; line_num < n_lines; line_num++) {
-        for (int way_num = 0; way_num < geom.assoc; way_num++) {
+        for (int way_num = 0; way_num < tag_ways; way_num++) {
             AssocArrayKey ent_key;
             if (aarray_readkey(cam, line_num, way_num, &ent_key)) {
                 const CacheEntry& entry = ent_ref(line_num, way_num);
@@ -1076,6 +1388,12 @@ cache_access_ok(const CacheArray *cache, LongAddr addr,
     return cache->access_ok(addr, access_type);
 }
 
+int
+cache_block_dirty(const CacheArray *cache, LongAddr addr)
+{
+    return cache->block_dirty(addr);
+}
+
 int
 cache_touch(CacheArray *cache, LongAddr addr)
 {
@@ -1101,6 +1419,18 @@ cache_fill(CacheArray *cache, LongAddr addr,
     return cache->fill(addr, access_type, evicted_ret);
 }
 
+CacheFillOutcome
+cache_fill_extra_evict(CacheArray *cache, CacheEvicted *evicted_ret)
+{
+    return cache->fill_extra_evict(evicted_ret);
+}
+
+int
+cache_decompress_latency(CacheArray *cache, LongAddr addr)
+{
+    return cache->decompress_latency(addr);
+}
+
 int
 cache_writeback(CacheArray *cache, LongAddr addr)
 {
@@ -1138,6 +1468,12 @@ cache_coher_yield(CacheArray *cache, LongAddr base_addr,
     return cache->coher_yield(base_addr, invalidate, bypass_wb_alloc);
 }
 
+CacheFillOutcome
+cache_invalidate(CacheArray *cache, LongAddr base_addr)
+{
+    return cache->invalidate(base_addr);
+}
+
 i64
 cache_update_bank(CacheArray *cache, LongAddr addr, i64 now,
                   CacheBankOp bank_op)
@@ -1151,6 +1487,35 @@ cache_get_stats(const CacheArray *cache, CacheStats *dest)
     cache->get_stats(dest);
 }
 
+static void
+cache_stats_provider(StatsEmitter *em, void *data)
+{
+    const CacheArray *cache = static_cast<const CacheArray *>(data);
+    CacheStats st;
+    cache->get_stats(&st);
+    statsemit_i64(em, "lookups", st.lookups);
+    statsemit_i64(em, "hits", st.hits);
+    statsemit_i64(em, "misses", st.misses);
+    statsemit_i64(em, "upgrade_misses", st.upgrade_misses);
+    statsemit_i64(em, "coher_busy", st.coher_busy);
+    statsemit_i64(em, "coher_misses", st.coher_misses);
+    statsemit_i64(em, "reads", st.reads);
+    statsemit_i64(em, "reads_ex", st.reads_ex);
+    statsemit_i64(em, "upgrades", st.upgrades);
+    statsemit_i64(em, "writes", st.writes);
+    statsemit_i64(em, "dirty_evicts", st.dirty_evicts);
+    statsemit_i64(em, "coher_writebacks", st.coher_writebacks);
+    statsemit_i64(em, "coher_invalidates", st.coher_invalidates);
+    statsemit_i64(em, "incl_invalidates", st.incl_invalidates);
+    statsemit_i64(em, "wbfull_confs", st.wbfull_confs);
+}
+
+void
+cache_register_stats(CacheArray *cache, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, cache_stats_provider, cache);
+}
+
 void 
 cache_get_bankstats(const CacheArray *cache, i64 now, int bank,
                     CacheBankStats *dest)
@@ -1197,6 +1562,13 @@ cache_get_geom(const CacheArray *cache,
     return cache->get_geom(n_lines_ret, n_blocks_ret);
 }
 
+void
+cache_print_compress_stats(const CacheArray *cache, void *c_FILE_out,
+                           const char *prefix)
+{
+    cache->print_compress_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
+
 
 
 //
@@ -17,6 +17,7 @@ extern "C" {
 
 struct CoherenceMgr;
 struct CoreResources;
+struct StatsReg;
 
 
 typedef struct CacheEvicted CacheEvicted;
@@ -62,6 +63,9 @@ struct CacheStats {
     // Collected at coher_yield()
     i64 coher_writebacks, coher_invalidates;
 
+    // Collected at invalidate() (inclusion enforcement)
+    i64 incl_invalidates;
+
     // Collected by calls to cache_log_wbfull_conflict()
     i64 wbfull_confs;
 };
@@ -110,6 +114,9 @@ cache_lookup(CacheArray *cache, LongAddr addr,
 int cache_access_ok(const CacheArray *cache, LongAddr addr,
                     CacheAccessType access_type);
 
+// Peek: is the given block present and dirty?  No changes are made.
+int cache_block_dirty(const CacheArray *cache, LongAddr addr);
+
 // If the block is present in the cache, "touch" it, updating replacement info
 // (e.g. LRU).  Does not update other stats or timing, does not perform any
 // replacement.  Returns true iff the block is present.
@@ -143,6 +150,20 @@ CacheFillOutcome
 cache_fill(CacheArray *cache, LongAddr addr,
            CacheAccessType access_type, CacheEvicted *evicted_ret);
 
+// Compressed caches only (see the "Compression" config section): a fill may
+// displace further blocks, to fit the set's data budget.  After each
+// cache_fill(), call this until it returns CacheFill_NoEvict, treating each
+// block it reports like the one cache_fill() did (dirty ones already hold a
+// writeback buffer entry).  For other caches, it always returns
+// CacheFill_NoEvict.
+CacheFillOutcome
+cache_fill_extra_evict(CacheArray *cache, CacheEvicted *evicted_ret);
+
+// Extra hit latency for reading the given block: the decompression delay
+// if it's present and stored compressed, otherwise 0.  Counted as a
+// decompressing hit in the cache's stats.
+int cache_decompress_latency(CacheArray *cache, LongAddr addr);
+
 // Process an inbound writeback on the given block.  The cache's writeback
 // buffer must not be full.  If the block is in the cache, nonzero is
 // returned, and the block is marked dirty.  If the block is not in the cache,
@@ -187,6 +208,18 @@ CacheFillOutcome
 cache_coher_yield(CacheArray *cache, LongAddr base_addr, int invalidate,
                   int bypass_wb_alloc);
 
+// Discard the given block from the cache, if present, on behalf of an
+// inclusion policy between cache levels (e.g. back-invalidation from an
+// inclusive L3).  No writeback buffer entry is allocated and the coherence
+// manager is not told; the caller is responsible for any dirty data, and for
+// cache_core_evict_maybe()-style notification.
+//
+// Returns CacheFill_NoEvict if the block was absent, otherwise
+// CacheFill_EvictClean or CacheFill_EvictDirty, according to the state of the
+// discarded copy.
+CacheFillOutcome
+cache_invalidate(CacheArray *cache, LongAddr base_addr);
+
 // Update the cache-bank accounting for the given operation on the given
 // address.  This returns the time at which the operation will have completed.
 // If the resource is already occupied, the operation will not begin
@@ -197,6 +230,9 @@ i64 cache_update_bank(CacheArray *cache, LongAddr addr, i64 now,
                       CacheBankOp bank_op);
 
 void cache_get_stats(const CacheArray *cache, CacheStats *dest);
+// Register a provider for this cache's CacheStats at "path" (stats-reg.h)
+void cache_register_stats(CacheArray *cache, struct StatsReg *sr,
+                          const char *path);
 void cache_get_bankstats(const CacheArray *cache, i64 now, int bank,
                          CacheBankStats *dest);
 
@@ -222,6 +258,10 @@ int cache_get_id(const CacheArray *cache);
 const CacheGeometry *cache_get_geom(const CacheArray *cache,
                                     int *n_lines_ret, int *n_blocks_ret);
 
+// Prints nothing if the cache isn't compressed
+void cache_print_compress_stats(const CacheArray *cache, void *c_FILE_out,
+                                const char *prefix);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,215 @@
+//
+// Cache block compression: size estimates from simulated data values
+//
+// $Id$
+//
+
+const char RCSid_1760000029[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "cache-compress.h"
+#include "app-state.h"
+#include "prog-mem.h"
+#include "utils.h"
+
+
+using std::vector;
+
+
+const char *CacheCompAlg_names[] = { "None", "BDI", "FPC", NULL };
+
+
+namespace {
+
+// Read an n-byte little-endian (Alpha order) value at "src"
+u64
+read_le(const unsigned char *src, int n_bytes)
+{
+    u64 val = 0;
+    for (int i = n_bytes - 1; i >= 0; i--)
+        val = (val << 8) | src[i];
+    return val;
+}
+
+// Does "val", taken as a two's-complement number of "width_bytes" bytes,
+// fit in a signed field of "field_bytes" bytes?
+bool
+fits_signed(u64 val, int width_bytes, int field_bytes)
+{
+    if (field_bytes >= width_bytes)
+        return true;
+    const int width_bits = 8 * width_bytes;
+    const int field_bits = 8 * field_bytes;
+    // sign-extend from width_bits, then check the bits above field_bits-1
+    i64 sval = static_cast<i64>(val << (64 - width_bits)) >> (64 - width_bits);
+    i64 lim = static_cast<i64>(1) << (field_bits - 1);
+    return (sval >= -lim) && (sval < lim);
+}
+
+u64
+width_mask(int width_bytes)
+{
+    return (width_bytes >= 8) ? ~U64_LIT(0) :
+        ((U64_LIT(1) << (8 * width_bytes)) - 1);
+}
+
+
+// Base-Delta-Immediate (Pekhimenko et al., PACT'12): the block is viewed
+// as an array of base_bytes-wide values, each stored as a delta_bytes-wide
+// difference from either zero or a single explicit base (the first value
+// that isn't near zero).  A per-value bit selects the base.
+int
+bdi_try(const unsigned char *data, int block_bytes, int base_bytes,
+        int delta_bytes)
+{
+    const int n_vals = block_bytes / base_bytes;
+    const u64 mask = width_mask(base_bytes);
+    bool have_base = false;
+    u64 base = 0;
+    for (int i = 0; i < n_vals; i++) {
+        u64 val = read_le(data + i * base_bytes, base_bytes);
+        if (fits_signed(val, base_bytes, delta_bytes))
+            continue;
+        if (!have_base) {
+            base = val;
+            have_base = true;
+        }
+        if (!fits_signed((val - base) & mask, base_bytes, delta_bytes))
+            return -1;
+    }
+    return base_bytes + (n_vals * delta_bytes) + ((n_vals + 7) / 8);
+}
+
+int
+bdi_size(const unsigned char *data, int block_bytes)
+{
+    static const struct { int base, delta; } encodings[] = {
+        { 8, 1 }, { 8, 2 }, { 8, 4 }, { 4, 1 }, { 4, 2 }, { 2, 1 }
+    };
+
+    bool all_zero = true, all_repeat = (block_bytes >= 8);
+    for (int i = 0; i < block_bytes; i++) {
+        if (data[i] != 0)
+            all_zero = false;
+        if (all_repeat && (i >= 8) && (data[i] != data[i % 8]))
+            all_repeat = false;
+    }
+    if (all_zero)
+        return 1;
+    if (all_repeat)
+        return 8;
+
+    int best = block_bytes;
+    for (int enc = 0; enc < (int) NELEM(encodings); enc++) {
+        if ((block_bytes % encodings[enc].base) != 0)
+            continue;
+        int size = bdi_try(data, block_bytes, encodings[enc].base,
+                           encodings[enc].delta);
+        if ((size > 0) && (size < best))
+            best = size;
+    }
+    return best;
+}
+
+
+// Frequent Pattern Compression (Alameldeen & Wood, ISCA'04): each 32-bit
+// word gets a 3-bit prefix and a pattern-dependent payload; runs of up to
+// eight zero words share one prefix.
+int
+fpc_word_bits(u32 word)
+{
+    const u64 w = word;
+    if (fits_signed(w, 4, 1)) {
+        // 4-bit or 8-bit sign-extended
+        i32 sval = static_cast<i32>(word);
+        return ((sval >= -8) && (sval < 8)) ? 4 : 8;
+    }
+    if (fits_signed(w, 4, 2))
+        return 16;                              // 16-bit sign-extended
+    if ((word & 0xffff) == 0)
+        return 16;                              // halfword, zero-padded
+    if (fits_signed(word & 0xffff, 2, 1) &&
+        fits_signed(word >> 16, 2, 1))
+        return 16;                              // two sign-extended bytes
+    if ((word >> 8) == (word & 0xffffff))
+        return 8;                               // repeated bytes
+    return 32;
+}
+
+int
+fpc_size(const unsigned char *data, int block_bytes)
+{
+    const int prefix_bits = 3, zero_run_max = 8;
+    const int n_words = block_bytes / 4;
+    int bits = 0;
+    int zero_run = 0;
+    for (int i = 0; i < n_words; i++) {
+        u32 word = static_cast<u32>(read_le(data + i * 4, 4));
+        if (word == 0) {
+            if (zero_run == 0)
+                bits += prefix_bits + 3;
+            if (++zero_run == zero_run_max)
+                zero_run = 0;
+            continue;
+        }
+        zero_run = 0;
+        bits += prefix_bits + fpc_word_bits(word);
+    }
+    int size = (bits + 7) / 8;
+    return (size < block_bytes) ? size : block_bytes;
+}
+
+} // Anonymous namespace close
+
+
+
+//
+// C interface
+//
+
+int
+cachecomp_block_size(CacheCompAlg alg, const void *data, int block_bytes)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    int size;
+    sim_assert(block_bytes > 0);
+    switch (alg) {
+    case CacheComp_None:
+        size = block_bytes; break;
+    case CacheComp_BDI:
+        size = bdi_size(bytes, block_bytes); break;
+    case CacheComp_FPC:
+        size = ((block_bytes % 4) == 0) ? fpc_size(bytes, block_bytes) :
+            block_bytes;
+        break;
+    default:
+        ENUM_ABORT(CacheCompAlg, alg);
+        size = block_bytes;
+    }
+    sim_assert((size > 0) && (size <= block_bytes));
+    return size;
+}
+
+
+int
+cachecomp_sample_size(CacheCompAlg alg, LongAddr base_addr, int block_bytes)
+{
+    if (alg == CacheComp_None)
+        return block_bytes;
+    AppState *as = appstate_lookup_id(base_addr.id);
+    if (!as || !as->pmem ||
+        !pmem_access_ok(as->pmem, base_addr.a, block_bytes, PMAF_R))
+        return block_bytes;
+    vector<unsigned char> buf(block_bytes);
+    pmem_read_memcpy(as->pmem, &buf[0], base_addr.a, block_bytes,
+                     PMAF_R | PMAF_NoExcept);
+    return cachecomp_block_size(alg, &buf[0], block_bytes);
+}
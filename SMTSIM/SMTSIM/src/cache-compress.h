@@ -0,0 +1,46 @@
+// -*- C++ -*-
+//
+// Cache block compression: size estimates from simulated data values
+//
+// $Id$
+//
+
+#ifndef CACHE_COMPRESS_H
+#define CACHE_COMPRESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// These only size blocks; nothing is actually stored compressed.  A cache
+// that compresses (see the "Compression" section of its config) samples the
+// block's current contents from program memory at fill time, and uses the
+// resulting size to pack its sets.
+
+typedef enum {
+    CacheComp_None,
+    CacheComp_BDI,              // Base-Delta-Immediate (one base + zero)
+    CacheComp_FPC,              // Frequent Pattern Compression (32-bit words)
+    CacheCompAlg_last
+} CacheCompAlg;
+extern const char *CacheCompAlg_names[];
+
+
+// Compressed size, in bytes, of the "block_bytes" bytes at "data" (in
+// target byte order).  Never more than block_bytes; incompressible blocks
+// come back as block_bytes.
+int cachecomp_block_size(CacheCompAlg alg, const void *data,
+                         int block_bytes);
+
+// Like cachecomp_block_size(), but reads the block at base_addr from the
+// memory image of the app that owns it.  Blocks which can't be read (no
+// such app, unmapped, etc.) are treated as incompressible.
+int cachecomp_sample_size(CacheCompAlg alg, LongAddr base_addr,
+                          int block_bytes);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CACHE_COMPRESS_H
@@ -77,6 +77,9 @@ which contains the following copyright:
 #include "prefetch-streambuf.h"
 #include "deadblock-pred.h"
 #include "mshr.h"
+#include "core-net.h"
+#include "app-mem-stats.h"
+#include "stats-reg.h"
 
 
 #define DEBUG 1
@@ -116,6 +119,18 @@ static int FreeHolderCount;
 
 static i64 totmem=0, totmemdelay=0;
 
+// Traffic due to the L3 inclusion policy (GlobalParams.mem.l3cache_inclusion)
+static struct {
+    i64 back_invals;            // Inclusive: L3 evictions of any block
+    i64 back_inval_blocks;      // Inclusive: upper-level copies discarded
+    i64 back_inval_dirty;       // Inclusive: ...subset holding dirty data
+    i64 victim_fills_clean;     // Exclusive: clean L2 victims inserted
+    i64 victim_fills_dirty;     // Exclusive: dirty L2 victims inserted
+    i64 victim_fill_hits;       // Exclusive: victims already resident
+    i64 excl_hits_moved;        // Exclusive: L3 hits handed up to the L2
+    i64 excl_hits_kept;         // Exclusive: dirty L3 hits left resident
+} L3InclStats;
+
 
 const char *CacheSource_names[] = { 
     "None",
@@ -381,6 +396,37 @@ creq_single_core(const CacheRequest *creq)
 }
 
 
+static void
+l3_incl_stats_provider(StatsEmitter *em, void *data)
+{
+    statsemit_i64(em, "back_invals", L3InclStats.back_invals);
+    statsemit_i64(em, "back_inval_blocks", L3InclStats.back_inval_blocks);
+    statsemit_i64(em, "back_inval_dirty", L3InclStats.back_inval_dirty);
+    statsemit_i64(em, "victim_fills_clean", L3InclStats.victim_fills_clean);
+    statsemit_i64(em, "victim_fills_dirty", L3InclStats.victim_fills_dirty);
+    statsemit_i64(em, "victim_fill_hits", L3InclStats.victim_fill_hits);
+    statsemit_i64(em, "excl_hits_moved", L3InclStats.excl_hits_moved);
+    statsemit_i64(em, "excl_hits_kept", L3InclStats.excl_hits_kept);
+}
+
+
+// Providers for the structures below the cores, under "mem"
+static void
+register_shared_stats(StatsReg *sr)
+{
+    if (SharedL2Cache)
+        cache_register_stats(SharedL2Cache, sr, "mem/l2cache");
+    if (SharedL3Cache) {
+        cache_register_stats(SharedL3Cache, sr, "mem/l3cache");
+        statsreg_add_provider(sr, "mem/l3_inclusion", l3_incl_stats_provider,
+                              NULL);
+    }
+    corebus_register_stats(SharedCoreRequestBus, sr, "mem/request_bus");
+    if (SharedCoreReplyBus != SharedCoreRequestBus)
+        corebus_register_stats(SharedCoreReplyBus, sr, "mem/reply_bus");
+}
+
+
 void
 initcache(void) 
 {
@@ -397,13 +443,34 @@ initcache(void)
         goto fail;
     }
 
-    {
+    if (GlobalParams.mem.interconnect == CoreNet_Bus) {
         SharedCoreRequestBus = corebus_create();
         if (GlobalParams.mem.split_bus) {
             SharedCoreReplyBus = corebus_create();
         } else {
             SharedCoreReplyBus = SharedCoreRequestBus;
         }
+    } else {
+        // Home slices live in whichever shared cache is just below the
+        // interconnect; with private L2s and no L3, that's main memory.
+        int sliced_home = !GlobalParams.mem.private_l2caches ||
+            GlobalParams.mem.use_l3cache;
+        SharedCoreRequestBus = corebus_create_routed(
+            corenet_create((GlobalParams.mem.split_bus) ? "ReqNet" : "Net",
+                           "Global/Mem/Interconnect",
+                           GlobalParams.mem.interconnect,
+                           GlobalParams.num_cores,
+                           GlobalParams.mem.cache_block_bytes, sliced_home));
+        if (GlobalParams.mem.split_bus) {
+            SharedCoreReplyBus = corebus_create_routed(
+                corenet_create("ReplyNet", "Global/Mem/Interconnect",
+                               GlobalParams.mem.interconnect,
+                               GlobalParams.num_cores,
+                               GlobalParams.mem.cache_block_bytes,
+                               sliced_home));
+        } else {
+            SharedCoreReplyBus = SharedCoreRequestBus;
+        }
     }
     
     if (!GlobalParams.mem.private_l2caches) {
@@ -423,6 +490,9 @@ initcache(void)
     }
 
     SharedMemUnit = memunit_create(&GlobalParams.mem.main_mem, cyc);
+
+    if (GlobalStatsReg)
+        register_shared_stats(GlobalStatsReg);
     
     return;
 
@@ -433,11 +503,29 @@ fail:
 }
 
 
+// Directory protocols: an entry may only be evicted if nothing is in flight
+// for its block, since arriving fills would then create unregistered copies
+static int
+coher_dir_evict_ok(LongAddr base_addr)
+{
+    CacheRequest **reqs = cacheq_find_multi(CacheQ, base_addr,
+                                            CACHEQ_ALL_CORES, CQFS_All);
+    int result = (reqs[0] == NULL);
+    free(reqs);
+    return result;
+}
+
+
 void
 init_coher(void) 
 {
-    if ((GlobalParams.num_cores > 1) && GlobalParams.mem.use_coherence) 
+    if ((GlobalParams.num_cores > 1) && GlobalParams.mem.use_coherence) {
         GlobalCoherMgr = cm_create();
+        cm_set_evict_ok_func(GlobalCoherMgr, coher_dir_evict_ok);
+        if (GlobalStatsReg)
+            cm_register_stats(GlobalCoherMgr, GlobalStatsReg,
+                              "mem/coherence");
+    }
 }
 
 
@@ -828,6 +916,27 @@ enq_evict_writeback(CoreResources *evict_core, const CacheEvicted *evicted,
 }
 
 
+// Exclusive L3: send a clean L2 victim down to the L3 for insertion.  It
+// travels the same path as a writeback, but with Cache_ReadExcl as its
+// access_type, and it holds no writeback-buffer entry in the cache it left.
+static void
+enq_evict_clean_victim(CoreResources *evict_core, const CacheEvicted *evicted,
+                       CacheAction action, i64 ready_time)
+{
+    sim_assert((action == L3_WB) || (action == BUS_WB));
+    CacheRequest *victim_req =
+        get_c_request_holder(ready_time, evicted->base_addr, Cache_ReadExcl,
+                             action, CSrc_WB, evict_core);
+    place_in_cache_queue(victim_req);
+}
+
+static int
+wb_is_clean_victim(const CacheRequest * restrict creq)
+{
+    return creq->access_type != Cache_Write;
+}
+
+
 // Generate and enqueue coherence-related writeback/invalidate requests to
 // peers.
 //
@@ -848,13 +957,24 @@ enq_coher_peer_msgs(CacheRequest *for_creq,
     sim_assert(ENUM_OK(CoherAccessResult, stall_type));
     CacheAction peer_action = (GlobalParams.mem.private_l2caches) ?
         COHER_WBI_L2_UP : COHER_WBI_L1;
+    const int directed = (cm_protocol(GlobalCoherMgr) != CoherProt_Broadcast);
     for (int peer_idx = 0; peer_idx < peer_info->node_count; peer_idx++) {
         int peer_core_id = peer_info->nodes[peer_idx];
         sim_assert(IDX_OK(peer_core_id, CoreCount));
         CoreResources *peer_core = Cores[peer_core_id];
+        i64 peer_ready_time = ready_time;
+        if (directed) {
+            // Directory: rather than snooping the request, each peer gets
+            // its own message forwarded from the block's home
+            peer_ready_time +=
+                corebus_access_home(peer_core->reply_bus, peer_core_id,
+                                    for_creq->base_addr, 1,
+                                    GlobalParams.mem.bus_request_time) - cyc;
+        }
         CacheRequest *peer_creq = 
-            get_c_request_holder(ready_time, for_creq->base_addr, Cache_Read,
-                                 peer_action, CSrc_Coher, peer_core);
+            get_c_request_holder(peer_ready_time, for_creq->base_addr,
+                                 Cache_Read, peer_action, CSrc_Coher,
+                                 peer_core);
         peer_creq->coher_for = for_creq;
         peer_creq->coher_wb_type = stall_type;
         place_in_cache_queue(peer_creq);
@@ -1030,15 +1150,43 @@ core_has_coher_block_maybe(const CoreResources *core, LongAddr base_addr)
 }
 
 
+// Send dirty data held by a core's coherence-interface cache to the level
+// below the interconnect, as a new writeback request
+static void
+enq_offcore_wb(CoreResources *core, LongAddr base_addr, i64 start_time)
+{
+    CacheRequest * restrict wb_req;
+    CacheAction wb_action;
+    int miss_penalty;
+    if (GlobalParams.mem.private_l2caches) {
+        miss_penalty = core->params.private_l2cache.timing.miss_penalty;
+        wb_action = (GlobalParams.mem.use_l3cache) ? L3_WB : MEM_WB;
+    } else {
+        miss_penalty = core->params.dcache.timing.miss_penalty;
+        wb_action = L2_WB;
+    }
+    wb_req = get_c_request_holder(start_time + miss_penalty, base_addr,
+                                  Cache_Write, wb_action, CSrc_WB, core);
+    place_in_cache_queue(wb_req);
+}
+
+
 // Called when some core-private resource discards a cache block.  If
 // coherence is in use, and no other on-core resources hold the block, it
 // can be removed from the CoherenceMgr.  (This is somewhat sketchy in that
 // it effectively implements evict-notification messages for free.)
 static void
-cache_core_evict_maybe(const CoreResources *core, LongAddr base_addr)
+cache_core_evict_maybe(CoreResources *core, LongAddr base_addr)
 {
     if (GlobalCoherMgr && !core_has_coher_block_maybe(core, base_addr)) {
-        cm_evict_notify(GlobalCoherMgr, base_addr, core->core_id);
+        if (cm_evict_notify(GlobalCoherMgr, base_addr, core->core_id)) {
+            // DirMOESI Owner leaving: its deferred writeback goes out now
+            i64 bus_done_cyc =
+                corebus_access_home(core->request_bus, core->core_id,
+                                    base_addr, 0,
+                                    GlobalParams.mem.bus_transfer_time);
+            enq_offcore_wb(core, base_addr, bus_done_cyc);
+        }
     }
 }
 
@@ -1158,6 +1306,43 @@ dcache_replace(CacheRequest *for_creq, CoreResources *core, LongAddr base_addr,
 }
 
 
+// Dispose of one block evicted from the L2 by a fill
+static void
+l2_evicted(CoreResources *core, CacheArray *l2cache,
+           CacheFillOutcome fill_stat, const CacheEvicted *evicted,
+           i64 start_time, int discard_wb)
+{
+    if (fill_stat == CacheFill_EvictDirty) {
+        CacheAction wb_action;
+        if (GlobalParams.mem.private_l2caches) {
+            wb_action = BUS_WB;
+        } else {
+            wb_action = (GlobalParams.mem.use_l3cache) ? L3_WB : MEM_WB;
+        }
+        if (!discard_wb) {
+            enq_evict_writeback(core, evicted, wb_action, start_time);
+        } else {
+            // (see dcache_replace() )
+          //printf("tick %s %s\n",fmt_now(), fmt_laddr(base_addr));  
+	  DEBUGPRINTF("cache: dropping evicted L2-cache block %s\n",
+                        fmt_laddr(evicted->base_addr));
+            cache_wb_accepted(l2cache, evicted->base_addr);
+        }
+    } else if ((fill_stat == CacheFill_EvictClean) && !discard_wb &&
+               GlobalParams.mem.use_l3cache &&
+               (GlobalParams.mem.l3cache_inclusion == L3Incl_Exclusive)) {
+        // An exclusive L3 takes clean victims too
+        CacheAction victim_action = (GlobalParams.mem.private_l2caches) ?
+            BUS_WB : L3_WB;
+        enq_evict_clean_victim(core, evicted, victim_action, start_time);
+    }
+    if (fill_stat != CacheFill_NoEvict) {
+        if (GlobalParams.mem.private_l2caches)
+            cache_core_evict_maybe(core, evicted->base_addr);
+    }
+}
+
+
 static void
 l2_replace(CacheRequest *for_creq, CoreResources *core, CacheArray *l2cache,
            LongAddr base_addr, CacheAccessType access_type, i64 start_time,
@@ -1182,35 +1367,114 @@ l2_replace(CacheRequest *for_creq, CoreResources *core, CacheArray *l2cache,
                 fmt_now(), fmt_laddr(base_addr),
                 CacheFillOutcome_names[fill_stat],
                 fmt_laddr(evicted.base_addr));
-    if (fill_stat == CacheFill_EvictDirty) {
-        CacheAction wb_action;
-        if (GlobalParams.mem.private_l2caches) {
-            wb_action = BUS_WB;
-        } else {
-            wb_action = (GlobalParams.mem.use_l3cache) ? L3_WB : MEM_WB;
+    l2_evicted(core, l2cache, fill_stat, &evicted, start_time, discard_wb);
+
+    // A compressed L2 may have displaced more blocks to make room
+    while ((fill_stat = cache_fill_extra_evict(l2cache, &evicted)) !=
+           CacheFill_NoEvict) {
+        DEBUGPRINTF("cache: time %s addr %s fill, L2 extra evict: %s, %s\n",
+                    fmt_now(), fmt_laddr(base_addr),
+                    CacheFillOutcome_names[fill_stat],
+                    fmt_laddr(evicted.base_addr));
+        l2_evicted(core, l2cache, fill_stat, &evicted, start_time,
+                   discard_wb);
+    }
+}
+
+
+static void
+note_back_inval(CacheFillOutcome inv_stat, int *any_dirty)
+{
+    if (inv_stat != CacheFill_NoEvict) {
+        L3InclStats.back_inval_blocks++;
+        if (inv_stat == CacheFill_EvictDirty) {
+            L3InclStats.back_inval_dirty++;
+            *any_dirty = 1;
         }
-        if (!discard_wb) {
-            enq_evict_writeback(core, &evicted, wb_action, start_time);
-        } else {
-            // (see dcache_replace() )
-          //printf("tick %s %s\n",fmt_now(), fmt_laddr(base_addr));  
-	  DEBUGPRINTF("cache: dropping evicted L2-cache block %s\n",
-                        fmt_laddr(evicted.base_addr));
-            cache_wb_accepted(l2cache, evicted.base_addr);
+    }
+}
+
+
+// Inclusive L3: the L3 is evicting base_addr, so strip it from every cache
+// above.  Returns nonzero iff any discarded copy held dirty data, which the
+// caller must then send on to memory.  (Fills already in flight for this
+// block can still violate inclusion briefly; we don't chase those down.
+// Stream buffers are left alone, as they're outside the inclusion domain.)
+static int
+l3_back_invalidate(LongAddr base_addr)
+{
+    int any_dirty = 0;
+    L3InclStats.back_invals++;
+    if (!GlobalParams.mem.private_l2caches)
+        note_back_inval(cache_invalidate(SharedL2Cache, base_addr),
+                        &any_dirty);
+    for (int core_id = 0; core_id < CoreCount; core_id++) {
+        CoreResources * restrict core = Cores[core_id];
+        CacheFillOutcome inv_stat;
+        int core_had_block = 0;
+
+        inv_stat = cache_invalidate(core->icache, base_addr);
+        sim_assert(inv_stat != CacheFill_EvictDirty);
+        if (inv_stat != CacheFill_NoEvict) {
+            core_had_block = 1;
+            if (core->i_dbp)
+                dbp_block_kill(core->i_dbp, base_addr);
+        }
+        note_back_inval(inv_stat, &any_dirty);
+
+        inv_stat = cache_invalidate(core->dcache, base_addr);
+        if (inv_stat != CacheFill_NoEvict) {
+            core_had_block = 1;
+            if (core->d_dbp)
+                dbp_block_kill(core->d_dbp, base_addr);
         }
+        note_back_inval(inv_stat, &any_dirty);
+
+        if (GlobalParams.mem.private_l2caches) {
+            inv_stat = cache_invalidate(core->l2cache, base_addr);
+            if (inv_stat != CacheFill_NoEvict)
+                core_had_block = 1;
+            note_back_inval(inv_stat, &any_dirty);
+        }
+
+        if (core_had_block)
+            cache_core_evict_maybe(core, base_addr);
     }
-    if (fill_stat != CacheFill_NoEvict) {
-        if (GlobalParams.mem.private_l2caches)
-            cache_core_evict_maybe(core, evicted.base_addr);
+    DEBUGPRINTF("cache: time %s addr %s, L3 back-invalidate%s\n",
+                fmt_now(), fmt_laddr(base_addr),
+                (any_dirty) ? " (dirty copy found)" : "");
+    return any_dirty;
+}
+
+
+// Dispose of one block evicted from the L3 by a fill
+static void
+l3_evicted(CacheArray *l3cache, CacheFillOutcome fill_stat,
+           const CacheEvicted *evicted, i64 start_time)
+{
+    if (fill_stat == CacheFill_EvictDirty) {
+        // Core is NULL: L3 cache is off-core
+        enq_evict_writeback(NULL, evicted, MEM_WB, start_time);
+    }
+    if ((fill_stat != CacheFill_NoEvict) &&
+        (GlobalParams.mem.l3cache_inclusion == L3Incl_Inclusive)) {
+        int upper_dirty = l3_back_invalidate(evicted->base_addr);
+        if (upper_dirty && (fill_stat != CacheFill_EvictDirty)) {
+            // The L3 victim was clean, but newer data was discarded above;
+            // pass it through the L3 as a write-around writeback (using the
+            // WB buffer entry this clean eviction didn't need).
+            int wb_hit = cache_writeback(l3cache, evicted->base_addr);
+            sim_assert(!wb_hit);
+            enq_evict_writeback(NULL, evicted, MEM_WB, start_time);
+        }
     }
 }
 
 
 static void
 l3_replace(CacheRequest *for_creq, CacheArray *l3cache, LongAddr base_addr,
-           i64 start_time)
+           CacheAccessType access_type, i64 start_time)
 {
-    CacheAccessType access_type = Cache_ReadExcl;
     CacheEvicted evicted;
     CacheFillOutcome fill_stat;
     laddr_set(evicted.base_addr, 0, 0);
@@ -1224,12 +1488,38 @@ l3_replace(CacheRequest *for_creq, CacheArray *l3cache, LongAddr base_addr,
                 fmt_now(), fmt_laddr(base_addr),
                 CacheFillOutcome_names[fill_stat],
                 fmt_laddr(evicted.base_addr));
-    if (fill_stat == CacheFill_EvictDirty) {
-        // Core is NULL: L3 cache is off-core
-        enq_evict_writeback(NULL, &evicted, MEM_WB, start_time);
+    l3_evicted(l3cache, fill_stat, &evicted, start_time);
+
+    // A compressed L3 may have displaced more blocks to make room
+    while ((fill_stat = cache_fill_extra_evict(l3cache, &evicted)) !=
+           CacheFill_NoEvict) {
+        DEBUGPRINTF("cache: time %s addr %s fill, L3 extra evict: %s, %s\n",
+                    fmt_now(), fmt_laddr(base_addr),
+                    CacheFillOutcome_names[fill_stat],
+                    fmt_laddr(evicted.base_addr));
+        l3_evicted(l3cache, fill_stat, &evicted, start_time);
     }
-    if (fill_stat != CacheFill_NoEvict) {
+}
+
+
+// Exclusive L3: a hit hands the block up to the L2, leaving no copy here;
+// dirty data travels with it, via "is_dirty_fill" (see process_l2fill()).
+// The exception is a private L2 asking for a shared copy of a dirty block,
+// which it couldn't hold dirty; that block stays resident here.
+static void
+l3_exclusive_promote(CacheRequest *creq, CacheArray *l3cache)
+{
+    if (GlobalParams.mem.private_l2caches &&
+        (creq->access_type == Cache_Read) &&
+        cache_block_dirty(l3cache, creq->base_addr)) {
+        L3InclStats.excl_hits_kept++;
+        return;
     }
+    CacheFillOutcome inv_stat = cache_invalidate(l3cache, creq->base_addr);
+    sim_assert(inv_stat != CacheFill_NoEvict);
+    L3InclStats.excl_hits_moved++;
+    if (inv_stat == CacheFill_EvictDirty)
+        creq->is_dirty_fill = 1;
 }
 
 
@@ -1259,7 +1549,8 @@ process_ifill_context(CoreResources *core, CacheRequest *creq, context *ctx,
 
     mshr_cfree_inst(core->inst_mshr, creq->base_addr, ctx->id);
 
-    if (ctx->long_mem_stat != LongMem_None) {
+    if ((ctx->long_mem_stat != LongMem_None) &&
+        (ctx->long_mem_stat != LongMem_Runahead)) {
         DEBUGPRINTF("T%d long_mem_op completing at %s\n", ctx->id,
                     fmt_i64(ready_time));
         ctx->long_mem_stat = LongMem_Completing;
@@ -1302,6 +1593,21 @@ process_l1fill_ifill(CacheRequest *creq)
 }
 
 
+static AppMemLevel
+service_level_to_memlevel(int service_level)
+{
+    switch (service_level) {
+    case 1: return AppMem_L1;
+    case 2: return AppMem_L2;
+    case 3: return AppMem_L3;
+    case SERVICED_COHER: return AppMem_Coher;
+    default:
+        // SERVICED_MEM, plus any stragglers which didn't record a level
+        return AppMem_Mem;
+    }
+}
+
+
 // Caller of this must be sure to wake up any "blocked_app", even if there are
 // no instructions left in the creq due to flushing!
 static void
@@ -1332,6 +1638,7 @@ process_dfill_inst(CacheRequest *creq, CoreResources *core,
         meminst->dcache_sim.latency = meminst->donecycle - meminst->addrcycle;
 
         if ((ctx->long_mem_stat != LongMem_None) &&
+            (ctx->long_mem_stat != LongMem_Runahead) &&
             (meminst->id == ctx->next_to_commit)) {
             DEBUGPRINTF("T%ds%d long_mem_op completing at %s\n", ctx->id,
                         meminst->id, fmt_i64(ready_time));
@@ -1356,6 +1663,9 @@ process_dfill_inst(CacheRequest *creq, CoreResources *core,
             if (meminst->as) {
                 meminst->as->extra->mem_delay.delay_sum += mem_delay;
                 meminst->as->extra->mem_delay.sample_count++;
+                appmemstats_add_latency(meminst->as->extra->mem_stats,
+                    service_level_to_memlevel(creq->service_level),
+                    mem_delay);
             }
         }
     }
@@ -1564,8 +1874,10 @@ process_bus_req_nocoher(CacheRequest * restrict creq)
         merge_and_free_creq(pending_req, creq);
         creq = NULL;
     } else {
-        i64 bus_done_cyc = corebus_access(req_core->request_bus,
-                                          GlobalParams.mem.bus_request_time);
+        i64 bus_done_cyc =
+            corebus_access_home(req_core->request_bus, req_core->core_id,
+                                creq->base_addr, 0,
+                                GlobalParams.mem.bus_request_time);
         // Proceed down normally
         creq->request_time = bus_done_cyc;
         creq->action = bus_route_down();
@@ -1574,6 +1886,59 @@ process_bus_req_nocoher(CacheRequest * restrict creq)
 }
 
 
+// Directory protocols: strip the blocks of any directory entries that
+// cm_access() just evicted from every core, writing back dirty copies.
+static void
+coher_dir_back_invalidate(CoherenceMgr *cm)
+{
+    LongAddr base_addr;
+    while (cm_pop_dir_victim(cm, &base_addr)) {
+        for (int core_id = 0; core_id < CoreCount; core_id++) {
+            CoreResources * restrict core = Cores[core_id];
+            CacheFillOutcome inv_stat;
+            int core_had_block = 0, core_dirty = 0;
+
+            inv_stat = cache_invalidate(core->icache, base_addr);
+            sim_assert(inv_stat != CacheFill_EvictDirty);
+            if (inv_stat != CacheFill_NoEvict) {
+                core_had_block = 1;
+                if (core->i_dbp)
+                    dbp_block_kill(core->i_dbp, base_addr);
+            }
+            inv_stat = cache_invalidate(core->dcache, base_addr);
+            if (inv_stat != CacheFill_NoEvict) {
+                core_had_block = 1;
+                core_dirty |= (inv_stat == CacheFill_EvictDirty);
+                if (core->d_dbp)
+                    dbp_block_kill(core->d_dbp, base_addr);
+            }
+            if (GlobalParams.mem.private_l2caches) {
+                inv_stat = cache_invalidate(core->l2cache, base_addr);
+                if (inv_stat != CacheFill_NoEvict) {
+                    core_had_block = 1;
+                    core_dirty |= (inv_stat == CacheFill_EvictDirty);
+                }
+            }
+            if (core->d_streambuf)
+                pfsg_coher_yield(core->d_streambuf, base_addr, 1);
+
+            if (core_dirty) {
+                i64 bus_done_cyc =
+                    corebus_access_home(core->request_bus, core_id,
+                                        base_addr, 0,
+                                        GlobalParams.mem.bus_transfer_time);
+                enq_offcore_wb(core, base_addr, bus_done_cyc);
+            }
+            if (core_had_block)
+                cache_core_evict_maybe(core, base_addr);
+        }
+        DEBUGPRINTF("cache: time %s addr %s, directory eviction\n",
+                    fmt_now(), fmt_laddr(base_addr));
+        cm_reset_entry(cm, base_addr);
+    }
+}
+
+
 static void
 process_bus_req_coher(CacheRequest * restrict creq)
 {
@@ -1615,6 +1980,7 @@ process_bus_req_coher(CacheRequest * restrict creq)
         cm_access(req_core->params.coher_mgr, creq->base_addr,
                   req_cache_id, coher_access_type, &peer_info,
                   &have_write_perm);
+    coher_dir_back_invalidate(req_core->params.coher_mgr);
 
     if (coher_result != Coher_EntryBusy) {
         // Don't send out on the bus, if another core has an
@@ -1627,8 +1993,13 @@ process_bus_req_coher(CacheRequest * restrict creq)
         // complete a memory instruction, which could lead to deadlock if not
         // handled carefully.
         creq->coher_accessed = 1;
-        bus_done_cyc = corebus_access(req_core->request_bus,
-                                      GlobalParams.mem.bus_request_time);
+        bus_done_cyc = corebus_access_home(req_core->request_bus,
+                                           req_core->core_id,
+                                           creq->base_addr, 0,
+                                           GlobalParams.mem.bus_request_time);
+        // (directory: the request is resolved at the home's directory)
+        bus_done_cyc +=
+            cm_dir_lookup_latency(req_core->params.coher_mgr);
     }
 
     switch (coher_result) {
@@ -1774,8 +2145,10 @@ process_bus_reply(CacheRequest *creq)
     // the coherence manager.
     assert_ifthen(GlobalCoherMgr, creq_single_core(creq));
 
-    xfer_done = corebus_access(creq->cores[0].core->reply_bus, 
-                               GlobalParams.mem.bus_transfer_time);
+    xfer_done = corebus_access_home(creq->cores[0].core->reply_bus,
+                                    creq->cores[0].core->core_id,
+                                    creq->base_addr, 1,
+                                    GlobalParams.mem.bus_transfer_time);
     creq->request_time = xfer_done;
     creq->action = bus_route_up();
 
@@ -1802,10 +2175,12 @@ process_bus_wb(CacheRequest *creq)
     i64 bus_done_cyc;
     sim_assert(creq_single_core(creq));
     CoreResources *solo_core = creq->cores[0].core;
-    bus_done_cyc = corebus_access(solo_core->request_bus,
-                                  GlobalParams.mem.bus_transfer_time);
+    bus_done_cyc = corebus_access_home(solo_core->request_bus,
+                                       solo_core->core_id, creq->base_addr, 0,
+                                       GlobalParams.mem.bus_transfer_time);
     if (GlobalParams.mem.private_l2caches) {
-        cache_wb_accepted(solo_core->l2cache, creq->base_addr);
+        if (!wb_is_clean_victim(creq))
+            cache_wb_accepted(solo_core->l2cache, creq->base_addr);
         creq->request_time = bus_done_cyc + 
             solo_core->params.private_l2cache.timing.miss_penalty;
         creq->action = (GlobalParams.mem.use_l3cache) ? L3_WB : MEM_WB;
@@ -2068,6 +2443,19 @@ process_coher_reply(CacheRequest * restrict creq)
         DEBUGPRINTF("cache: marking blocked request as "
                     "dirty-fill, cancelling writeback; creq: %s\n",
                     fmt_creq_static(blocked_req));
+    } else if (wb_to_lower_level &&
+               (creq->coher_wb_type == Coher_StallForWB) &&
+               cache_access_ok((GlobalParams.mem.private_l2caches) ?
+                               reply_core->l2cache : reply_core->dcache,
+                               creq->base_addr, Cache_Read) &&
+               cm_defer_owner_wb(reply_core->params.coher_mgr,
+                                 creq->base_addr, reply_core->core_id)) {
+        // DirMOESI: the downgraded peer kept its copy, and stays on as the
+        // block's Owner; its writeback waits until that copy is evicted.
+        // (The data still goes to the requestor, below.)
+        wb_to_lower_level = 0;
+        DEBUGPRINTF("cache: C%d keeps dirty %s as Owner, deferring WB\n",
+                    reply_core->core_id, fmt_laddr(creq->base_addr));
     }
 
     full_block_transfer = 0;
@@ -2097,27 +2485,16 @@ process_coher_reply(CacheRequest * restrict creq)
 
     assert_ifthen(wb_to_lower_level, full_block_transfer);
 
-    bus_done_cyc = corebus_access(reply_core->reply_bus,
-                                  ((full_block_transfer) ?
-                                   GlobalParams.mem.bus_transfer_time :
-                                   GlobalParams.mem.bus_request_time));
-    if (wb_to_lower_level) {
-        CacheRequest * restrict wb_req;
-        CacheAction wb_action;
-        int miss_penalty;
-        if (GlobalParams.mem.private_l2caches) {
-            miss_penalty = reply_core->params.private_l2cache
-                .timing.miss_penalty;
-            wb_action = (GlobalParams.mem.use_l3cache) ? L3_WB : MEM_WB;
-        } else {
-            miss_penalty = reply_core->params.dcache.timing.miss_penalty;
-            wb_action = L2_WB;
-        }
-        wb_req = get_c_request_holder(bus_done_cyc + miss_penalty,
-                                      creq->base_addr, Cache_Write,
-                                      wb_action, CSrc_WB, reply_core);
-        place_in_cache_queue(wb_req);
-    }
+    // (a routed net carries this peer->requestor; any writeback to the
+    // lower level rides along, as with the plain bus)
+    bus_done_cyc = corebus_access_cores(reply_core->reply_bus,
+                                        reply_core->core_id,
+                                        blocked_req->cores[0].core->core_id,
+                                        ((full_block_transfer) ?
+                                         GlobalParams.mem.bus_transfer_time :
+                                         GlobalParams.mem.bus_request_time));
+    if (wb_to_lower_level)
+        enq_offcore_wb(reply_core, creq->base_addr, bus_done_cyc);
 
     int reply_cache_id = reply_core->core_id;   // crufty assumption
     int was_final = 
@@ -2211,7 +2588,8 @@ process_l2access(CacheRequest *creq)
     assert_ifthen(!GlobalCoherMgr, (cache_stat != Cache_UpgradeMiss));
 
     if (cache_stat == Cache_Hit) {
-        creq->request_time = ready_time;
+        creq->request_time = ready_time +
+            cache_decompress_latency(l2cache, creq->base_addr);
         if (GlobalParams.mem.private_l2caches) {
             creq->action = L1FILL;
         } else {
@@ -2307,6 +2685,11 @@ process_l2fill(CacheRequest *creq)
                                    CacheBank_Fill);
     l2_replace(creq, first_core, l2cache, base_addr,
                creq->access_type, ready_time, 0);
+    if (creq->is_dirty_fill &&
+        (GlobalParams.mem.l3cache_inclusion == L3Incl_Exclusive)) {
+        // Modified data handed up from an exclusive L3
+        cache_mark_dirty(l2cache, base_addr);
+    }
 
     int any_consumers = 1;
     if (GlobalParams.mem.private_l2caches) {
@@ -2417,11 +2800,14 @@ process_l3access(CacheRequest *creq)
     sim_assert(cache_stat != Cache_UpgradeMiss);
 
     if (cache_stat == Cache_Hit) {
-        creq->request_time = ready_time;
+        creq->request_time = ready_time +
+            cache_decompress_latency(l3cache, creq->base_addr);
         creq->action = (GlobalParams.mem.private_l2caches) ?
             BUS_REPLY : L2FILL;
         creq->service_level = 3;
         sim_assert(cache_access_ok(l3cache, creq->base_addr, access_type));
+        if (GlobalParams.mem.l3cache_inclusion == L3Incl_Exclusive)
+            l3_exclusive_promote(creq, l3cache);
     } else if (cache_stat == Cache_Miss) {
         creq->request_time = ready_time +
             GlobalParams.mem.l3cache_timing.miss_penalty;
@@ -2463,7 +2849,7 @@ process_l3fill(CacheRequest *creq)
 
     ready_time = cache_update_bank(l3cache, creq->base_addr, cyc,
                                    CacheBank_Fill);
-    l3_replace(creq, l3cache, creq->base_addr, ready_time);
+    l3_replace(creq, l3cache, creq->base_addr, Cache_ReadExcl, ready_time);
 
     creq->request_time = ready_time;
     creq->action = (GlobalParams.mem.private_l2caches) ?
@@ -2472,6 +2858,50 @@ process_l3fill(CacheRequest *creq)
 }
 
 
+// Exclusive L3: insert an L2 victim (clean or dirty).  Unlike a writeback in
+// the other modes, a miss here allocates a block rather than writing around.
+static void
+process_l3_victim_fill(CacheRequest *creq)
+{
+    CacheArray *l3cache = SharedL3Cache;
+    LongAddr base_addr = creq->base_addr;
+    int is_dirty = !wb_is_clean_victim(creq);
+    i64 ready_time;
+
+    if (cache_access_ok(l3cache, base_addr, Cache_Read)) {
+        // Already resident: e.g. a dirty block kept for a shared requestor
+        // (l3_exclusive_promote()), or a copy from a peer's private L2
+        ready_time = cache_update_bank(l3cache, base_addr, cyc, CacheBank_WB);
+        if (is_dirty) {
+            int hit = cache_writeback(l3cache, base_addr);
+            sim_assert(hit);
+        } else {
+            cache_touch(l3cache, base_addr);
+        }
+        L3InclStats.victim_fill_hits++;
+    } else {
+        ready_time = cache_update_bank(l3cache, base_addr, cyc,
+                                       CacheBank_Fill);
+        l3_replace(creq, l3cache, base_addr,
+                   (is_dirty) ? Cache_Write : Cache_ReadExcl, ready_time);
+        if (is_dirty) {
+            L3InclStats.victim_fills_dirty++;
+        } else {
+            L3InclStats.victim_fills_clean++;
+        }
+    }
+
+    DEBUGPRINTF("cache: time %s addr %s, L3 %s victim fill, ready at %s\n",
+                fmt_now(), fmt_laddr(base_addr),
+                (is_dirty) ? "dirty" : "clean", fmt_i64(ready_time));
+
+    if (!GlobalParams.mem.private_l2caches && is_dirty)
+        cache_wb_accepted(SharedL2Cache, base_addr);
+    sim_assert(!creq->dependent_coher);         // Not used (and not handled)
+    free_cache_request(creq);
+}
+
+
 // Begin writeback _to_ L3
 static void
 process_l3wb(CacheRequest *creq)
@@ -2497,6 +2927,11 @@ process_l3wb(CacheRequest *creq)
         return;
     }
 
+    if (GlobalParams.mem.l3cache_inclusion == L3Incl_Exclusive) {
+        process_l3_victim_fill(creq);
+        return;
+    }
+
     int hit = cache_writeback(l3cache, creq->base_addr);
     i64 ready_time = 
         cache_update_bank(l3cache, creq->base_addr, cyc, CacheBank_WB);
@@ -2535,9 +2970,11 @@ process_memaccess(CacheRequest *creq)
 
 
     creq->service_level = SERVICED_MEM;
-    if (GlobalParams.mem.use_l3cache) {
+    if (GlobalParams.mem.use_l3cache &&
+        (GlobalParams.mem.l3cache_inclusion != L3Incl_Exclusive)) {
         creq->action = L3FILL;
     } else {
+        // (an exclusive L3 is bypassed; it's only filled with L2 victims)
         creq->action = (GlobalParams.mem.private_l2caches) ? 
             BUS_REPLY : L2FILL;
     }
@@ -2589,6 +3026,40 @@ process_memwb(CacheRequest *creq)
 */
 
 
+// Memory-level parallelism: the data MSHRs integrate each context's count of
+// outstanding demand D-miss blocks (producers with a waiting load/store) as
+// it changes; apps are credited with their contexts' share lazily, here.
+void
+cache_credit_app_mlp(context *ctx)
+{
+    i64 busy_cyc, outstanding_sum;
+    if (!ctx->core)
+        return;
+    mshr_data_mlp(ctx->core->data_mshr, ctx->id, &busy_cyc,
+                  &outstanding_sum);
+    if (ctx->as) {
+        appmemstats_add_mlp(ctx->as->extra->mem_stats,
+                            busy_cyc - ctx->mlp_credited.busy_cyc,
+                            outstanding_sum -
+                            ctx->mlp_credited.outstanding_sum);
+    }
+    ctx->mlp_credited.busy_cyc = busy_cyc;
+    ctx->mlp_credited.outstanding_sum = outstanding_sum;
+}
+
+
+void
+cache_credit_all_app_mlp(void)
+{
+    int core_num, ctx_num;
+    for (core_num = 0; core_num < CoreCount; core_num++) {
+        CoreResources *core = Cores[core_num];
+        for (ctx_num = 0; ctx_num < core->n_contexts; ctx_num++)
+            cache_credit_app_mlp(core->contexts[ctx_num]);
+    }
+}
+
+
 void
 process_cache_queues(void) 
 {
@@ -3188,6 +3659,7 @@ dodaccess_cache(LongAddr base_addr, int block_offset, int is_write,
                 as->extra->hitrate.dtlb.hits++;
             as->extra->mem_delay.delay_sum += penalty;
             as->extra->mem_delay.sample_count++;
+            appmemstats_add_latency(as->extra->mem_stats, AppMem_L1, penalty);
         }
         *tlb_miss_ret = (tlb_penalty != 0);
         sim_assert(cache_access_ok(dcache, base_addr, access_type));
@@ -3649,10 +4121,19 @@ print_cstats_core(CoreResources *core)
                fmt_i64(l2_stats.coher_invalidates),
                fmt_i64(l2_stats.wbfull_confs),
                fmt_i64(l2_stats.coher_busy));
+        cache_print_compress_stats(core->l2cache, stdout, "  SCACHE: ");
         printf("  Stalls for L2 MSHR conflicts: %s\n",
                fmt_i64(core->private_l2mshr_confs));
     }
 
+    {
+        i64 busy_cyc, outstanding_sum;
+        mshr_data_mlp(core->data_mshr, -1, &busy_cyc, &outstanding_sum);
+        printf("  DCACHE: MLP: %.3f (busy_cyc %s, outstanding_sum %s)\n",
+               (busy_cyc) ? ((double) outstanding_sum / busy_cyc) : 0.0,
+               fmt_i64(busy_cyc), fmt_i64(outstanding_sum));
+    }
+
     if (core->d_streambuf) {
         printf("  D-streambuf stats:\n");
         pfsg_print_stats(core->d_streambuf, stdout, "    ");
@@ -3699,6 +4180,76 @@ print_cstats_core(CoreResources *core)
 }
 
 
+// Count the blocks resident in "upper" which are also in the L3.
+static int
+count_l3_duplicates(const CacheArray *upper, int *upper_blocks_ret)
+{
+    int n_tags, dups = 0;
+    LongAddr *tags = cache_get_tags(upper, -1, &n_tags);
+    for (int i = 0; i < n_tags; i++) {
+        if (cache_access_ok(SharedL3Cache, tags[i], Cache_Read))
+            dups++;
+    }
+    free(tags);
+    *upper_blocks_ret = n_tags;
+    return dups;
+}
+
+
+// Report traffic due to the L3 inclusion policy, along with the effective
+// L2+L3 capacity: the number of distinct blocks held across the two levels,
+// sampled at report time.  (With private L2s, a block held by several cores
+// is counted once per L2.)
+static void
+report_l3_inclusion(void)
+{
+    int l2_blocks = 0, l3_blocks, dup_blocks = 0;
+    const int block_bytes = GlobalParams.mem.cache_block_bytes;
+    {
+        LongAddr *tags = cache_get_tags(SharedL3Cache, -1, &l3_blocks);
+        free(tags);
+    }
+    if (GlobalParams.mem.private_l2caches) {
+        for (int i = 0; i < CoreCount; i++) {
+            int core_l2_blocks;
+            dup_blocks += count_l3_duplicates(Cores[i]->l2cache,
+                                              &core_l2_blocks);
+            l2_blocks += core_l2_blocks;
+        }
+    } else {
+        dup_blocks = count_l3_duplicates(SharedL2Cache, &l2_blocks);
+    }
+    int unique_blocks = l2_blocks + l3_blocks - dup_blocks;
+
+    printf("3CACHE: inclusion: %s\n", ENUM_STR(L3InclusionPolicy,
+           GlobalParams.mem.l3cache_inclusion));
+    printf("3CACHE: capacity: L2 %d blocks, L3 %d blocks, "
+           "%d in both; effective %.1f KB\n", l2_blocks, l3_blocks,
+           dup_blocks, (double) unique_blocks * block_bytes / 1024);
+    switch (GlobalParams.mem.l3cache_inclusion) {
+    case L3Incl_NonInclusive:
+        break;
+    case L3Incl_Inclusive:
+        printf("3CACHE: back_invals: %s, blocks invalidated: %s "
+               "(%s dirty)\n", fmt_i64(L3InclStats.back_invals),
+               fmt_i64(L3InclStats.back_inval_blocks),
+               fmt_i64(L3InclStats.back_inval_dirty));
+        break;
+    case L3Incl_Exclusive:
+        printf("3CACHE: victim fills: %s clean, %s dirty, %s already "
+               "present\n", fmt_i64(L3InclStats.victim_fills_clean),
+               fmt_i64(L3InclStats.victim_fills_dirty),
+               fmt_i64(L3InclStats.victim_fill_hits));
+        printf("3CACHE: hits moved to L2: %s, dirty hits kept: %s\n",
+               fmt_i64(L3InclStats.excl_hits_moved),
+               fmt_i64(L3InclStats.excl_hits_kept));
+        break;
+    default:
+        ENUM_ABORT(L3InclusionPolicy, GlobalParams.mem.l3cache_inclusion);
+    }
+}
+
+
 void 
 print_cstats(void) 
 {
@@ -3725,6 +4276,7 @@ print_cstats(void)
                    (double) 100*l2_stats.hits/(l2_stats.hits+l2_stats.misses));
         }
         printf("SCACHE: wbfull_confs: %s\n", fmt_i64(l2_stats.wbfull_confs));
+        cache_print_compress_stats(SharedL2Cache, stdout, "SCACHE: ");
     }
     if (GlobalParams.mem.use_l3cache) {
         CacheStats l3_stats;
@@ -3740,7 +4292,11 @@ print_cstats(void)
                    (double) 100*l3_stats.hits/(l3_stats.hits+l3_stats.misses));
         }
         printf("3CACHE: wbfull_confs: %s\n", fmt_i64(l3_stats.wbfull_confs));
+        cache_print_compress_stats(SharedL3Cache, stdout, "3CACHE: ");
+        report_l3_inclusion();
     }
+    if (GlobalCoherMgr)
+        cm_print_stats(GlobalCoherMgr, stdout, "");
     printf("avg mem delay %.3f\n", (double) totmemdelay/totmem);
     if (!GlobalParams.mem.private_l2caches) {
         printf("L2 bank util. ");
@@ -3751,7 +4307,13 @@ print_cstats(void)
         }
         printf("\n");
     }
-    {
+    if (corebus_net(SharedCoreRequestBus)) {
+        corenet_print_stats(corebus_net(SharedCoreRequestBus), stdout, "");
+        if (SharedCoreReplyBus != SharedCoreRequestBus) {
+            corenet_print_stats(corebus_net(SharedCoreReplyBus), stdout,
+                                "");
+        }
+    } else {
         CoreBusStats bus_stats;
         if (GlobalParams.mem.split_bus) {
             corebus_get_stats(SharedCoreRequestBus, &bus_stats);
@@ -3843,12 +4405,19 @@ zero_cstats(void)
             tc_reset_stats(core->tcache);
         if (GlobalParams.mem.private_l2caches)
             cache_reset_stats(core->l2cache, cyc);
+        mshr_reset_data_mlp(core->data_mshr);
     }
 
     if (!GlobalParams.mem.private_l2caches)
         cache_reset_stats(SharedL2Cache, cyc);
     if (GlobalParams.mem.use_l3cache)
         cache_reset_stats(SharedL3Cache, cyc);
+    memset(&L3InclStats, 0, sizeof(L3InclStats));
+    corebus_reset_stats(SharedCoreRequestBus);
+    if (SharedCoreReplyBus != SharedCoreRequestBus)
+        corebus_reset_stats(SharedCoreReplyBus);
+    if (GlobalCoherMgr)
+        cm_reset_stats(GlobalCoherMgr);
 }
 
 
@@ -4053,6 +4622,38 @@ clean_creq_for_squash(CacheRequest *creq)
 }
 
 
+// Detach a D-miss instruction from its cache request, leaving the request to
+// complete without it, as a prefetch.  Returns 0 iff the instruction isn't
+// linked to a request (e.g. it's waiting to be merged).
+int
+cache_detach_dmiss(activelist *meminst)
+{
+    CacheRequest *creq = meminst->dmiss_cache_entry;
+    if (!creq)
+        return 0;
+
+    activelist **d_req_prev = &(creq->drequestor);
+    while (*d_req_prev && (*d_req_prev != meminst))
+        d_req_prev = &((*d_req_prev)->mergeinst);
+    sim_assert(*d_req_prev == meminst);
+    *d_req_prev = meminst->mergeinst;
+    meminst->mergeinst = NULL;
+    meminst->dmiss_cache_entry = NULL;
+    mshr_cfree_data(Contexts[meminst->thread]->core->data_mshr,
+                    creq->base_addr, meminst->thread, meminst->id);
+    assert_ifthen(TEST_CREQ_INVARIANT, creq_invariant(creq, 1));
+    return 1;
+}
+
+
+int
+cache_dmiss_service_level(const activelist *meminst)
+{
+    const CacheRequest *creq = meminst->dmiss_cache_entry;
+    return (creq) ? creq->service_level : SERVICED_UNKNOWN;
+}
+
+
 void 
 clean_cache_queue_squash(void)
 {
@@ -4424,3 +5025,165 @@ cachesim_prefetch_for_nextblock(struct CoreResources *core, LongAddr base_addr,
                                             pf_source, &merge_stat, &creq);
     return success;
 }
+
+
+int
+cachesim_prefetch_for_wsm(struct CoreResources *core, LongAddr base_addr,
+                          int exclusive_access, CacheSource pf_source)
+{
+    CacheMergeResult merge_stat = CacheMerge_NoMerge;
+    CacheRequest *creq = NULL;
+    sim_assert((pf_source == CSrc_L1_ICache) ||
+               (pf_source == CSrc_L1_DCache));
+    int success = cachesim_prefetch_at_core(core, base_addr, exclusive_access,
+                                            pf_source, &merge_stat, &creq);
+    return success;
+}
+
+
+// Idealized ("oracle") fill of one block into some of a core's caches:
+// blocks are installed immediately, with no request traffic or timing, and
+// any victims are handled as in a normal fill.  Caches which already hold
+// the block with enough permission, or which have a fill for it in flight,
+// are skipped, as are caches whose writeback buffers are full.
+//
+// Under coherence, we have no way to acquire permission for free, so the
+// injection is only performed if the core may already hold the block
+// (see core_has_coher_block_maybe()), and then never as exclusive.
+void
+cachesim_oracle_inject_core(struct CoreResources *core, LongAddr base_addr,
+                            int inject_as_excl, unsigned cache_select_mask)
+{
+    const char *fname = "cachesim_oracle_inject_core";
+    CacheAccessType access_type = (inject_as_excl) ? Cache_ReadExcl :
+        Cache_Read;
+    if (!GlobalCoherMgr)
+        access_type = Cache_ReadExcl;
+    core->cache_inject_stats.calls++;
+
+    DEBUGPRINTF("cache: %s, time %s C%d addr %s excl %d mask 0x%x\n",
+                fname, fmt_now(), core->core_id, fmt_laddr(base_addr),
+                inject_as_excl, cache_select_mask);
+
+    if (GlobalCoherMgr) {
+        if (!core_has_coher_block_maybe(core, base_addr)) {
+            core->cache_inject_stats.gave_up++;
+            return;
+        }
+        access_type = Cache_Read;
+    }
+
+    if ((cache_select_mask & CACHE_INJECT_L2) &&
+        GlobalParams.mem.private_l2caches &&
+        !cache_access_ok(core->l2cache, base_addr, access_type) &&
+        !(core->private_l2mshr &&
+          mshr_any_producer(core->private_l2mshr, base_addr))) {
+        core->cache_inject_stats.cache_inj++;
+        if (cache_wb_buffer_full(core->l2cache)) {
+            core->cache_inject_stats.cache_wb_full++;
+        } else {
+            l2_replace(NULL, core, core->l2cache, base_addr, access_type,
+                       cyc, 0);
+        }
+    }
+    if ((cache_select_mask & CACHE_INJECT_L1D) &&
+        !cache_access_ok(core->dcache, base_addr, access_type) &&
+        !mshr_any_producer(core->data_mshr, base_addr)) {
+        core->cache_inject_stats.cache_inj++;
+        if (cache_wb_buffer_full(core->dcache)) {
+            core->cache_inject_stats.cache_wb_full++;
+        } else {
+            dcache_replace(NULL, core, base_addr, access_type, cyc, 0, 0);
+        }
+    }
+    if ((cache_select_mask & CACHE_INJECT_L1I) &&
+        !cache_access_ok(core->icache, base_addr, Cache_Read) &&
+        !mshr_any_producer(core->inst_mshr, base_addr)) {
+        core->cache_inject_stats.cache_inj++;
+        if (cache_wb_buffer_full(core->icache)) {
+            core->cache_inject_stats.cache_wb_full++;
+        } else {
+            icache_replace(NULL, core, base_addr, cyc);
+        }
+    }
+}
+
+
+// Yield one cache's copy of a block: invalidate it, or just give up
+// exclusive permission; dirty data is written back.  Returns 1 if the block
+// was yielded, 0 if it was absent, or -1 if it was dirty and the writeback
+// buffer is full.
+static int
+oracle_discard_one(CoreResources *core, CacheArray *cache,
+                   DeadBlockPred *dbp, LongAddr base_addr, int downgrade_only,
+                   CacheAction wb_action)
+{
+    if (!cache_access_ok(cache, base_addr, Cache_Read))
+        return 0;
+    int dirty = cache_block_dirty(cache, base_addr);
+    if (dirty && cache_wb_buffer_full(cache))
+        return -1;
+    CacheEvicted evicted;
+    evicted.base_addr = base_addr;
+    CacheFillOutcome yield_stat =
+        cache_coher_yield(cache, base_addr, !downgrade_only, !dirty);
+    sim_assert(yield_stat != CacheFill_NoEvict);
+    if (dirty)
+        enq_evict_writeback(core, &evicted, wb_action, cyc);
+    if (!downgrade_only && dbp)
+        dbp_block_kill(dbp, base_addr);
+    return 1;
+}
+
+
+// Idealized discard of one block from some of a core's caches, with no
+// request traffic or timing beyond any needed writebacks.  Downgrades
+// would leave the coherence manager with stale ownership info, so they're
+// skipped when coherence is in use.
+void
+cachesim_oracle_discard_block(struct CoreResources *core, LongAddr base_addr,
+                              int downgrade_only, unsigned cache_select_mask)
+{
+    const char *fname = "cachesim_oracle_discard_block";
+    int discarded = 0;
+    core->cache_discard_stats.calls++;
+
+    DEBUGPRINTF("cache: %s, time %s C%d addr %s downgrade %d mask 0x%x\n",
+                fname, fmt_now(), core->core_id, fmt_laddr(base_addr),
+                downgrade_only, cache_select_mask);
+
+    if (downgrade_only && GlobalCoherMgr) {
+        core->cache_discard_stats.gave_up++;
+        return;
+    }
+
+    CacheAction wb_action = (GlobalParams.mem.private_l2caches) ? L2_WB :
+        BUS_WB;
+    int outcome[3] = { 0, 0, 0 };
+    if (cache_select_mask & CACHE_INJECT_L1I) {
+        outcome[0] = oracle_discard_one(core, core->icache, core->i_dbp,
+                                        base_addr, downgrade_only, wb_action);
+    }
+    if (cache_select_mask & CACHE_INJECT_L1D) {
+        outcome[1] = oracle_discard_one(core, core->dcache, core->d_dbp,
+                                        base_addr, downgrade_only, wb_action);
+    }
+    if ((cache_select_mask & CACHE_INJECT_L2) &&
+        GlobalParams.mem.private_l2caches) {
+        outcome[2] = oracle_discard_one(core, core->l2cache, core->l2_dbp,
+                                        base_addr, downgrade_only, BUS_WB);
+    }
+    int blocked = 0;
+    for (int i = 0; i < NELEM(outcome); i++) {
+        if (outcome[i] > 0)
+            discarded++;
+        else if (outcome[i] < 0)
+            blocked++;
+    }
+
+    core->cache_discard_stats.cache_matches += discarded;
+    if (blocked && !discarded)
+        core->cache_discard_stats.gave_up++;
+    if (discarded && !downgrade_only)
+        cache_core_evict_maybe(core, base_addr);
+}
@@ -107,10 +107,20 @@ void zero_cstats(void);
 void init_tlbs(void);
 void clean_cache_queue_mispredict(struct context *current);
 void clean_cache_queue_squash(void);
+int cache_detach_dmiss(struct activelist *meminst);
+// Level servicing "meminst"'s outstanding D-miss, once known; else
+// SERVICED_UNKNOWN (also if it has none)
+int cache_dmiss_service_level(const struct activelist *meminst);
 mem_addr calc_lock_paddr(struct context *ctx, mem_addr addr);
 
 int cache_register_blocked_app(struct context *ctx, int dmiss_alist_id);
 
+// Credit ctx->as (if any) with the D-miss MLP accrued on "ctx" since the last
+// credit; call before ctx->as changes.  The "all" form covers every context,
+// before app stats are read.
+void cache_credit_app_mlp(struct context *ctx);
+void cache_credit_all_app_mlp(void);
+
 
 struct CacheArray;
 extern struct CacheArray *SharedL2Cache;        // May be NULL
@@ -144,6 +154,30 @@ int
 cachesim_prefetch_for_nextblock(struct CoreResources *core, LongAddr base_addr,
                                 int exclusive_access, CacheSource pf_source);
 
+// prefetch on behalf of working-set migration (see wsm.h); pf_source must be
+// CSrc_L1_ICache or CSrc_L1_DCache
+int
+cachesim_prefetch_for_wsm(struct CoreResources *core, LongAddr base_addr,
+                          int exclusive_access, CacheSource pf_source);
+
+
+// cache_select_mask bits for the "oracle" inject/discard calls
+#define CACHE_INJECT_L1I        0x1
+#define CACHE_INJECT_L1D        0x2
+#define CACHE_INJECT_L2         0x4     // ignored unless private L2s
+
+// Instantly place a block in some of a core's caches, bypassing the usual
+// request path; stats in core->cache_inject_stats
+void
+cachesim_oracle_inject_core(struct CoreResources *core, LongAddr base_addr,
+                            int inject_as_excl, unsigned cache_select_mask);
+
+// Instantly discard (or just downgrade) a block from some of a core's
+// caches; stats in core->cache_discard_stats
+void
+cachesim_oracle_discard_block(struct CoreResources *core, LongAddr base_addr,
+                              int downgrade_only, unsigned cache_select_mask);
+
 
 #ifdef __cplusplus
 }
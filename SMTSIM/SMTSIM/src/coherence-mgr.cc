@@ -12,6 +12,7 @@ const char RCSid_1037074903[] =
 #include <stdlib.h>
 #include <string.h>
 
+#include <list>
 #include <map>
 #include <set>
 #include <sstream>
@@ -27,6 +28,8 @@ const char RCSid_1037074903[] =
 #include "utils-cc.h"
 #include "sim-cfg.h"
 #include "prng.h"
+#include "sim-params.h"
+#include "stats-reg.h"
 
 using std::string;
 using std::ostringstream;
@@ -53,6 +56,9 @@ const char *CoherAccessResult_names[] = {
     "NoStall", "EntryBusy", "StallForInvl", "StallForWB", "StallForXfer",
     "StallForShared", NULL
 };
+const char *CoherProtocol_names[] = {
+    "Broadcast", "DirMESI", "DirMOESI", NULL
+};
 
 
 namespace {
@@ -60,8 +66,13 @@ namespace {
 typedef int CacheID;
 typedef std::set<CacheID> CacheIDSet;
 
-enum CoherEntryState { Coher_Shared, Coher_Exclusive, CoherEntryState_last };
-const char *CoherEntryState_names[] = { "Shared", "Exclusive", NULL };
+// (Coher_Exclusive covers both MESI "E" and "M"; Coher_Owned is DirMOESI-only)
+enum CoherEntryState {
+    Coher_Shared, Coher_Exclusive, Coher_Owned, CoherEntryState_last
+};
+const char *CoherEntryState_names[] = {
+    "Shared", "Exclusive", "Owned", NULL
+};
 
 class CoherEntry {
     bool busy_shared_;          // protected access to SHARED memory underway
@@ -70,6 +81,9 @@ class CoherEntry {
     CacheIDSet holders_;        // current(!busy)/next(busy) holders
     // outstanding replies expected; nonempty <=> access to peers underway
     CacheIDSet waiting_for_;
+    // Owned: the holder responsible for the block's data (and writeback)
+    CacheID owner_;
+    bool owner_dirty_;          // owner_'s writeback is still pending
 
     inline bool invariant() const {
         bool result;
@@ -77,9 +91,13 @@ class CoherEntry {
             result = (holders_.size() == 1);
         } else if (state_ == Coher_Shared) {
             result = !holders_.empty();
+        } else if (state_ == Coher_Owned) {
+            result = holders_.count(owner_) > 0;
         } else {
             result = false;
         }
+        if ((state_ != Coher_Owned) && ((owner_ >= 0) || owner_dirty_))
+            result = false;
         if (busy_shared_ && !waiting_for_.empty())
             result = false;
         if (!result) {
@@ -90,7 +108,9 @@ class CoherEntry {
 
 public:
     CoherEntry(CoherEntryState init_state, CacheID first_holder) 
-        : busy_shared_(false), state_(init_state) {
+        : busy_shared_(false), state_(init_state), owner_(-1),
+          owner_dirty_(false) {
+        sim_assert(init_state != Coher_Owned);
         holders_.insert(first_holder);
         sim_assert(invariant());
     }
@@ -98,19 +118,54 @@ public:
     void assign(CoherEntryState new_state, CacheID first_holder) {
         sim_assert(invariant());
         sim_assert(first_holder >= 0);
+        sim_assert(new_state != Coher_Owned);
         holders_.clear();
         holders_.insert(first_holder);
         state_ = new_state;
+        owner_ = -1;
+        owner_dirty_ = false;
         sim_assert(invariant());
     }
 
     CoherEntryState get_state() const { return state_; }
 
+    // Exclusive -> Owned: the current exclusive holder keeps ownership while
+    // "reader" joins as a sharer
+    void downgrade_to_owned(CacheID reader) {
+        sim_assert(invariant());
+        sim_assert(state_ == Coher_Exclusive);
+        owner_ = get_excl_holder();
+        owner_dirty_ = false;           // until the owner's reply says so
+        state_ = Coher_Owned;
+        holders_.insert(reader);
+        sim_assert(invariant());
+    }
+    CacheID get_owner() const {
+        sim_assert(state_ == Coher_Owned);
+        return owner_;
+    }
+    bool is_owner_dirty() const { return owner_dirty_; }
+    void set_owner_dirty(CacheID owner) {
+        sim_assert(state_ == Coher_Owned);
+        sim_assert(owner == owner_);
+        owner_dirty_ = true;
+    }
+    // The owner is giving up its copy; returns true iff it was dirty.
+    // Demotes the entry to Shared.
+    bool drop_owner() {
+        sim_assert(state_ == Coher_Owned);
+        bool was_dirty = owner_dirty_;
+        state_ = Coher_Shared;
+        owner_ = -1;
+        owner_dirty_ = false;
+        return was_dirty;
+    }
+
     // Holder must not be in entry
     void add_holder(CacheID holder) {
         sim_assert(invariant());
         sim_assert(!holders_.count(holder));
-        if (state_ == Coher_Exclusive) {
+        if (state_ == Coher_Exclusive) {     // (Owned: stays Owned)
             state_ = Coher_Shared;
         }
         holders_.insert(holder);
@@ -122,6 +177,7 @@ public:
     void remove_holder(CacheID holder) {
         sim_assert(invariant());
         sim_assert(holders_.count(holder));
+        sim_assert((state_ != Coher_Owned) || (holder != owner_));
         holders_.erase(holder);
         // if empty, caller must remove us
         sim_assert(!any_holders() || invariant());
@@ -178,6 +234,10 @@ public:
     string fmt() const {
         ostringstream ostr;
         ostr << ENUM_STR(CoherEntryState, state_);
+        if (state_ == Coher_Owned) {
+            ostr << "(" << owner_ << ((owner_dirty_) ? ",dirty" : "")
+                 << ")";
+        }
         if (is_busy()) {
             ostr << "(busy";
             if (is_busy_peers())
@@ -218,6 +278,71 @@ coherwaitinfo_create(int invl_needed, int node_count)
     typedef std::map<LongAddr, CoherEntry> CoherAddrMap;
 #endif
 
+
+// Sparse directory capacity model: which blocks currently hold one of the
+// limited directory entries.  The holder state itself still lives in the
+// CoherAddrMap; this only decides when an entry must be given up.
+class DirTagArray {
+    typedef std::list<LongAddr> DirSet;         // MRU first
+    vector<DirSet> sets_;
+    int assoc_;
+    int block_bytes_lg_;
+
+    DirSet& set_for(const LongAddr& base_addr) {
+        u64 block_num = base_addr.a >> block_bytes_lg_;
+        return sets_[block_num % sets_.size()];
+    }
+
+public:
+    DirTagArray() : assoc_(0), block_bytes_lg_(0) { }
+    void init(int entries, int assoc, int block_bytes_lg) {
+        sim_assert((entries > 0) && (assoc > 0));
+        sets_.clear();
+        sets_.resize((entries + assoc - 1) / assoc);
+        assoc_ = assoc;
+        block_bytes_lg_ = block_bytes_lg;
+    }
+    void clear() {
+        FOR_ITER(vector<DirSet>, sets_, iter) { iter->clear(); }
+    }
+
+    void touch(const LongAddr& base_addr) {
+        DirSet& dset = set_for(base_addr);
+        FOR_ITER(DirSet, dset, iter) {
+            if (*iter == base_addr) {
+                dset.splice(dset.begin(), dset, iter);
+                return;
+            }
+        }
+    }
+    // Inserts base_addr as MRU; returns the number of entries by which its
+    // set is now over capacity
+    int insert(const LongAddr& base_addr) {
+        DirSet& dset = set_for(base_addr);
+        dset.push_front(base_addr);
+        return intsize(dset) - assoc_;
+    }
+    void remove(const LongAddr& base_addr) {
+        DirSet& dset = set_for(base_addr);
+        FOR_ITER(DirSet, dset, iter) {
+            if (*iter == base_addr) {
+                dset.erase(iter);
+                return;
+            }
+        }
+    }
+    // Victim candidates from base_addr's set, LRU first (excludes base_addr)
+    void get_candidates(const LongAddr& base_addr, vector<LongAddr>& dest) {
+        DirSet& dset = set_for(base_addr);
+        dest.clear();
+        for (DirSet::reverse_iterator iter = dset.rbegin();
+             iter != dset.rend(); ++iter) {
+            if (!(*iter == base_addr))
+                dest.push_back(*iter);
+        }
+    }
+};
+
 }       // Anonymous namespace close
 
 
@@ -229,8 +354,42 @@ protected:
     bool apply_evict_notifies_;
     bool prefer_neighbor_shared_;
     PRNGState local_prng_;
+
+    CoherProtocol protocol_;
+    int dir_lookup_latency_;
+    DirTagArray dir_tags_;                      // directory protocols only
+    vector<LongAddr> dir_victims_;              // awaiting cm_pop_dir_victim()
+    CoherEvictOkFunc evict_ok_func_;
+
+    struct {
+        i64 accesses;           // excluding Coher_EntryBusy outcomes
+        i64 busy;               // Coher_EntryBusy outcomes
+        i64 no_xfer;            // served from below, or already held
+        i64 two_hop;            // peer-served; broadcast snoop reply
+        i64 three_hop;          // peer-served; forwarded by the directory
+        i64 upgrades;           // invalidates only; requestor had data
+        i64 writes;             // exclusive-access requests
+        i64 write_invals;       // peers invalidated on behalf of writes
+        i64 dir_evictions;      // directory entries given up for capacity
+        i64 dir_evict_holders;  // holders which lost a copy to those
+        i64 dir_overflows;      // no evictable candidate; set overfilled
+        i64 owned_downgrades;   // DirMOESI: Exclusive -> Owned
+        i64 owned_fwds;         // DirMOESI: reads served by the Owner
+        i64 owned_wbs_deferred; // DirMOESI: downgrade writebacks skipped
+        i64 owned_wbs;          // DirMOESI: deferred writebacks performed
+        i64 owned_wbs_elided;   // DirMOESI: dirty Owner superseded by writer
+    } stats_;
+
     NoDefaultCopy no_copy_;
 
+    bool is_directory() const { return protocol_ != CoherProt_Broadcast; }
+    void dir_alloc(const LongAddr& base_addr);
+    void erase_entry(const LongAddr& base_addr) {
+        addr_to_entry_.erase(base_addr);
+        if (is_directory())
+            dir_tags_.remove(base_addr);
+    }
+
     CoherWaitInfo *gen_wait_info(const CacheIDSet& to_wait_for,
                                  bool invl_for_excl);
     CoherWaitInfo *
@@ -249,7 +408,24 @@ public:
 
     void reset() {
         addr_to_entry_.clear();
+        dir_tags_.clear();
+        dir_victims_.clear();
+    }
+
+    CoherProtocol protocol() const { return protocol_; }
+    int dir_lookup_latency() const { return dir_lookup_latency_; }
+    void set_evict_ok_func(CoherEvictOkFunc func) { evict_ok_func_ = func; }
+    bool pop_dir_victim(LongAddr *victim_ret) {
+        if (dir_victims_.empty())
+            return false;
+        *victim_ret = dir_victims_.back();
+        dir_victims_.pop_back();
+        return true;
     }
+    bool defer_owner_wb(const LongAddr& base_addr, int cache_id);
+    void print_stats(FILE *out, const char *pf) const;
+    void emit_stats(StatsEmitter *em) const;
+    void reset_stats() { memset(&stats_, 0, sizeof(stats_)); }
 
     void reset_cache(int cache_id);
     void reset_entry(const LongAddr& base_addr);
@@ -276,7 +452,7 @@ public:
     void shared_reply(const LongAddr& base_addr);
     int peer_reply(const LongAddr& base_addr, int reply_cache_id);
 
-    void evict_notify(const LongAddr& base_addr, int cache_id);
+    bool evict_notify(const LongAddr& base_addr, int cache_id);
 
     bool holder_okay(const LongAddr& base_addr, int cache_id, 
                      bool dirty, bool writeable) const;
@@ -292,6 +468,60 @@ CoherenceMgr::CoherenceMgr()
         SimCfg::conf_bool("Global/Mem/Coher/apply_evict_notifies");
     prefer_neighbor_shared_ =
         SimCfg::conf_bool("Global/Mem/Coher/prefer_neighbor_shared");
+    protocol_ = static_cast<CoherProtocol>
+        (SimCfg::conf_enum(CoherProtocol_names, "Global/Mem/Coher/protocol"));
+    dir_lookup_latency_ = 0;
+    evict_ok_func_ = NULL;
+    if (is_directory()) {
+        const string cp = "Global/Mem/Coher/Directory/";
+        int entries = SimCfg::conf_int(cp + "entries");
+        int assoc = SimCfg::conf_int(cp + "assoc");
+        dir_lookup_latency_ = SimCfg::conf_int(cp + "lookup_latency");
+        if ((entries < 1) || (assoc < 1) || (assoc > entries)) {
+            exit_printf("bad %sentries/assoc (%d/%d)\n", cp.c_str(),
+                        entries, assoc);
+        }
+        if (dir_lookup_latency_ < 0) {
+            exit_printf("bad %slookup_latency (%d)\n", cp.c_str(),
+                        dir_lookup_latency_);
+        }
+        dir_tags_.init(entries, assoc, GlobalParams.mem.cache_block_bytes_lg);
+    }
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+
+// Claim a directory entry for the newly-tracked block at base_addr; if that
+// overfills its set, pick idle LRU entries to give up.  Those are queued for
+// the cache simulator, which strips their blocks from every holder.  If
+// nothing is evictable, we let the set run over for now.
+void
+CoherenceMgr::dir_alloc(const LongAddr& base_addr)
+{
+    int excess = dir_tags_.insert(base_addr);
+    if (excess <= 0)
+        return;
+    vector<LongAddr> cands;
+    dir_tags_.get_candidates(base_addr, cands);
+    FOR_CONST_ITER(vector<LongAddr>, cands, iter) {
+        if (excess <= 0)
+            break;
+        const CoherEntry *ent = map_find(addr_to_entry_, *iter);
+        sim_assert(ent != NULL);
+        if (ent->is_busy())
+            continue;
+        if (evict_ok_func_ && !evict_ok_func_(*iter))
+            continue;
+        COHER_DB(1)(" (dir evict %s %s)", fmt_laddr(*iter),
+                    ent->fmt().c_str());
+        stats_.dir_evictions++;
+        stats_.dir_evict_holders += intsize(ent->g_holders());
+        dir_tags_.remove(*iter);
+        dir_victims_.push_back(*iter);
+        excess--;
+    }
+    if (excess > 0)
+        stats_.dir_overflows++;
 }
 
 
@@ -433,7 +663,7 @@ CoherenceMgr::reset_entry(const LongAddr& base_addr)
     CoherEntry *ent = map_find(addr_to_entry_, base_addr);
     if (ent) {
         COHER_DB(1)(" %s\n", ent->fmt().c_str());
-        addr_to_entry_.erase(base_addr);
+        erase_entry(base_addr);
         ent = NULL;
     } else {
         COHER_DB(1)("(uncached)\n");
@@ -463,6 +693,8 @@ CoherenceMgr::access(const LongAddr& base_addr, int cache_id,
         old_state = ent->get_state();
 
         COHER_DB(1)("%s", ent->fmt().c_str());
+        if (is_directory())
+            dir_tags_.touch(base_addr);
 
         if (ent->is_busy()) {
             result = Coher_EntryBusy;
@@ -520,11 +752,52 @@ CoherenceMgr::access(const LongAddr& base_addr, int cache_id,
                     // data eviction" situations.) 
                     result = Coher_StallForWB;
                 }
-                CoherWaitInfo *cwi = 
-                    invalidate_excl_rw(ent, base_addr, cache_id,
-                                       transfer_owner);
-                sim_assert(cwi->node_count > 0);
-                *coher_wait_ret = cwi;
+                if (!transfer_owner && (protocol_ == CoherProt_DirMOESI)) {
+                    // The old holder stays on as Owner; whether it then
+                    // keeps dirty data is settled by its reply, through
+                    // defer_owner_wb().
+                    CacheIDSet to_wait_for;
+                    to_wait_for.insert(ent->get_excl_holder());
+                    *coher_wait_ret = gen_wait_info(to_wait_for, false);
+                    ent->downgrade_to_owned(cache_id);
+                    ent->start_busy_peers(to_wait_for);
+                    stats_.owned_downgrades++;
+                } else {
+                    CoherWaitInfo *cwi = 
+                        invalidate_excl_rw(ent, base_addr, cache_id,
+                                           transfer_owner);
+                    sim_assert(cwi->node_count > 0);
+                    *coher_wait_ret = cwi;
+                }
+            }
+        } else if (old_state == Coher_Owned) {
+            // DirMOESI: held by one Owner (maybe dirty) plus clean sharers
+            CacheID owner = ent->get_owner();
+            if (excl_access) {
+                // Every holder has the same data, and the writer is about to
+                // dirty its copy, so any writeback the Owner owed is
+                // subsumed by the writer's.
+                if (ent->drop_owner())
+                    stats_.owned_wbs_elided++;
+                result = (requestor_was_holder) ? Coher_StallForInvl :
+                    Coher_StallForXfer;
+                CoherWaitInfo *cwi =
+                    invalidate_shared_write(ent, base_addr, cache_id);
+                if (cwi->node_count) {
+                    *coher_wait_ret = cwi;
+                } else {
+                    result = Coher_NoStall;
+                    coherwaitinfo_destroy(cwi);
+                }
+            } else if (!requestor_was_holder) {
+                // Forward to the Owner, who supplies the data and stays Owner
+                CacheIDSet to_ask;
+                to_ask.insert(owner);
+                *coher_wait_ret = gen_wait_info(to_ask, false);
+                ent->start_busy_peers(to_ask);
+                ent->add_holder(cache_id);
+                result = Coher_StallForShared;
+                stats_.owned_fwds++;
             }
         }
         new_state = ent->get_state();
@@ -536,6 +809,34 @@ CoherenceMgr::access(const LongAddr& base_addr, int cache_id,
             ? Coher_Shared : Coher_Exclusive;
         ent = & map_put_uniq(addr_to_entry_, base_addr,
                              CoherEntry(new_state, cache_id));
+        if (is_directory())
+            dir_alloc(base_addr);
+    }
+
+    if (result == Coher_EntryBusy) {
+        stats_.busy++;
+    } else {
+        stats_.accesses++;
+        switch (result) {
+        case Coher_NoStall:
+            stats_.no_xfer++;
+            break;
+        case Coher_StallForInvl:
+            stats_.upgrades++;
+            break;
+        default:
+            // A peer supplies the data: directly in response to the
+            // broadcast, or via the home's forward
+            if (is_directory())
+                stats_.three_hop++;
+            else
+                stats_.two_hop++;
+        }
+        if (excl_access) {
+            stats_.writes++;
+            if (*coher_wait_ret && COHER_WB_NEEDS_INVAL(result))
+                stats_.write_invals += (*coher_wait_ret)->node_count;
+        }
     }
 
     COHER_DB(1)(" -> %s %s\n", ent->fmt().c_str(),
@@ -599,9 +900,10 @@ CoherenceMgr::peer_reply(const LongAddr& base_addr, int reply_cache_id)
 }
 
 
-void 
+bool
 CoherenceMgr::evict_notify(const LongAddr& base_addr, int cache_id)
 {
+    bool owner_wb = false;
     CoherEntry *ent = map_find(addr_to_entry_, base_addr);
     COHER_DB(1)("coher: evict_notify: base_addr %s cache_id %d:",
                 fmt_laddr(base_addr), cache_id);
@@ -613,6 +915,15 @@ CoherenceMgr::evict_notify(const LongAddr& base_addr, int cache_id)
     }
 
     COHER_DB(1)(" %s", ent->fmt().c_str());
+    if ((ent->get_state() == Coher_Owned) && (ent->get_owner() == cache_id)) {
+        // The Owner's last copy is leaving; it has to settle any writeback
+        // it deferred, whatever else happens to the entry
+        owner_wb = ent->drop_owner();
+        if (owner_wb) {
+            COHER_DB(1)(" (owner WB)");
+            stats_.owned_wbs++;
+        }
+    }
     if (ent->is_busy() && ent->is_waiting_for(cache_id)) {
         // A cache has evicted a block for which there is an outstanding
         // writeback/invalidate request; the eviction occurred before
@@ -626,13 +937,93 @@ CoherenceMgr::evict_notify(const LongAddr& base_addr, int cache_id)
             ent->remove_holder(cache_id);
             if (!ent->any_holders()) {
                 COHER_DB(1)(" (sole holder)");
-                addr_to_entry_.erase(base_addr);
+                erase_entry(base_addr);
                 ent = NULL;
             }
         }
     }
 
     COHER_DB(1)("\n");
+    return owner_wb;
+}
+
+
+bool
+CoherenceMgr::defer_owner_wb(const LongAddr& base_addr, int cache_id)
+{
+    CoherEntry *ent = map_find(addr_to_entry_, base_addr);
+    bool result = (protocol_ == CoherProt_DirMOESI) && ent &&
+        (ent->get_state() == Coher_Owned) && (ent->get_owner() == cache_id);
+    if (result) {
+        ent->set_owner_dirty(cache_id);
+        stats_.owned_wbs_deferred++;
+    }
+    COHER_DB(1)("coher: defer_owner_wb: base_addr %s cache_id %d -> %d\n",
+                fmt_laddr(base_addr), cache_id, result);
+    return result;
+}
+
+
+void
+CoherenceMgr::print_stats(FILE *out, const char *pf) const
+{
+    const char *name = "Coher";
+    fprintf(out, "%s%s: protocol %s", pf, name,
+            CoherProtocol_names[protocol_]);
+    if (is_directory())
+        fprintf(out, ", dir lookup %d cyc", dir_lookup_latency_);
+    fprintf(out, ", %ld entries tracked\n", entry_count());
+    fprintf(out, "%s%s: %s accesses (%s busy), %s no_xfer, %s two_hop, "
+            "%s three_hop, %s upgrades\n", pf, name,
+            fmt_i64(stats_.accesses), fmt_i64(stats_.busy),
+            fmt_i64(stats_.no_xfer), fmt_i64(stats_.two_hop),
+            fmt_i64(stats_.three_hop), fmt_i64(stats_.upgrades));
+    fprintf(out, "%s%s: %s writes, %s invals, %.3f invals/write\n",
+            pf, name, fmt_i64(stats_.writes), fmt_i64(stats_.write_invals),
+            (stats_.writes) ?
+            (double) stats_.write_invals / stats_.writes : 0.0);
+    if (is_directory()) {
+        fprintf(out, "%s%s: dir_evictions %s, dir_evict_holders %s, "
+                "dir_overflows %s\n", pf, name,
+                fmt_i64(stats_.dir_evictions),
+                fmt_i64(stats_.dir_evict_holders),
+                fmt_i64(stats_.dir_overflows));
+    }
+    if (protocol_ == CoherProt_DirMOESI) {
+        fprintf(out, "%s%s: owned_downgrades %s, owned_fwds %s, "
+                "owned_wbs_deferred %s, owned_wbs %s, owned_wbs_elided %s\n",
+                pf, name, fmt_i64(stats_.owned_downgrades),
+                fmt_i64(stats_.owned_fwds),
+                fmt_i64(stats_.owned_wbs_deferred),
+                fmt_i64(stats_.owned_wbs), fmt_i64(stats_.owned_wbs_elided));
+    }
+}
+
+
+void
+CoherenceMgr::emit_stats(StatsEmitter *em) const
+{
+    statsemit_i64(em, "entries", entry_count());
+    statsemit_i64(em, "accesses", stats_.accesses);
+    statsemit_i64(em, "busy", stats_.busy);
+    statsemit_i64(em, "no_xfer", stats_.no_xfer);
+    statsemit_i64(em, "two_hop", stats_.two_hop);
+    statsemit_i64(em, "three_hop", stats_.three_hop);
+    statsemit_i64(em, "upgrades", stats_.upgrades);
+    statsemit_i64(em, "writes", stats_.writes);
+    statsemit_i64(em, "write_invals", stats_.write_invals);
+    if (is_directory()) {
+        statsemit_i64(em, "dir_evictions", stats_.dir_evictions);
+        statsemit_i64(em, "dir_evict_holders", stats_.dir_evict_holders);
+        statsemit_i64(em, "dir_overflows", stats_.dir_overflows);
+    }
+    if (protocol_ == CoherProt_DirMOESI) {
+        statsemit_i64(em, "owned_downgrades", stats_.owned_downgrades);
+        statsemit_i64(em, "owned_fwds", stats_.owned_fwds);
+        statsemit_i64(em, "owned_wbs_deferred", stats_.owned_wbs_deferred);
+        statsemit_i64(em, "owned_wbs", stats_.owned_wbs);
+        statsemit_i64(em, "owned_wbs_elided", stats_.owned_wbs_elided);
+    }
 }
 
 
@@ -648,7 +1039,8 @@ CoherenceMgr::holder_okay(const LongAddr& base_addr, int cache_id,
 
         if (!ent->is_holder(cache_id)) {
             result = false;
-        } else if (state == Coher_Shared) {
+        } else if ((state == Coher_Shared) || (state == Coher_Owned)) {
+            // (a DirMOESI Owner's dirtiness is tracked here, not in-cache)
             result = !dirty && !writeable;
         } else {
             sim_assert(state == Coher_Exclusive);
@@ -755,10 +1147,10 @@ cm_peer_reply(CoherenceMgr *cm, LongAddr base_addr,
     return cm->peer_reply(base_addr, reply_cache_id);
 }
 
-void 
+int
 cm_evict_notify(CoherenceMgr *cm, LongAddr base_addr, int cache_id)
 {
-    cm->evict_notify(base_addr, cache_id);
+    return cm->evict_notify(base_addr, cache_id);
 }
 
 int 
@@ -768,6 +1160,60 @@ cm_holder_okay(const CoherenceMgr *cm, LongAddr base_addr,
     return cm->holder_okay(base_addr, cache_id, dirty, writeable);
 }
 
+CoherProtocol
+cm_protocol(const CoherenceMgr *cm)
+{
+    return cm->protocol();
+}
+
+int
+cm_dir_lookup_latency(const CoherenceMgr *cm)
+{
+    return cm->dir_lookup_latency();
+}
+
+void
+cm_set_evict_ok_func(CoherenceMgr *cm, CoherEvictOkFunc func)
+{
+    cm->set_evict_ok_func(func);
+}
+
+int
+cm_pop_dir_victim(CoherenceMgr *cm, LongAddr *victim_ret)
+{
+    return cm->pop_dir_victim(victim_ret);
+}
+
+int
+cm_defer_owner_wb(CoherenceMgr *cm, LongAddr base_addr, int cache_id)
+{
+    return cm->defer_owner_wb(base_addr, cache_id);
+}
+
+void
+cm_print_stats(const CoherenceMgr *cm, void *c_FILE_out, const char *prefix)
+{
+    cm->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
+
+void
+cm_reset_stats(CoherenceMgr *cm)
+{
+    cm->reset_stats();
+}
+
+static void
+cm_stats_provider(StatsEmitter *em, void *data)
+{
+    static_cast<const CoherenceMgr *>(data)->emit_stats(em);
+}
+
+void
+cm_register_stats(CoherenceMgr *cm, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, cm_stats_provider, cm);
+}
+
 void
 coherwaitinfo_destroy(CoherWaitInfo *cwi)
 {
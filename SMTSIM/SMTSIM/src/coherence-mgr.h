@@ -15,10 +15,26 @@ extern "C" {
 
 struct CacheArray;
 struct CoreResources;
+struct StatsReg;
 
 
 typedef struct CoherenceMgr CoherenceMgr;
 
+// How coherence requests find the other holders of a block.  "Broadcast"
+// snoops every peer over the shared bus, with perfect (unbounded) holder
+// tracking.  The directory protocols keep a bounded, set-associative sparse
+// directory at the block's home slice (see core-net.h); requests pay a
+// lookup there, and are forwarded point-to-point to only the holders.
+// Directory entries evicted for capacity invalidate all copies of their
+// block.  DirMOESI adds an Owned state: a dirty exclusive holder downgraded
+// by a reader keeps its data (and its writeback obligation), and serves
+// later readers, rather than writing back on the spot.
+typedef enum {
+    CoherProt_Broadcast, CoherProt_DirMESI, CoherProt_DirMOESI,
+    CoherProtocol_last
+} CoherProtocol;
+extern const char *CoherProtocol_names[];
+
 typedef enum {
     Coher_InstRead, Coher_DataRead, Coher_DataReadExcl,
     CoherAccessType_last
@@ -79,6 +95,26 @@ void cm_reset_entry(CoherenceMgr *cm, LongAddr base_addr);
 void cm_add_cache(CoherenceMgr *cm, struct CacheArray *cache, int cache_id,
                   struct CoreResources *parent_core);
 
+CoherProtocol cm_protocol(const CoherenceMgr *cm);
+// Directory protocols: cycles for a directory lookup at the home slice
+int cm_dir_lookup_latency(const CoherenceMgr *cm);
+
+// Directory protocols: predicate from the cache simulator, used to pass over
+// directory-eviction candidates whose block still has requests in flight.
+// (Without one, any idle entry may be chosen.)
+typedef int (*CoherEvictOkFunc)(LongAddr base_addr);
+void cm_set_evict_ok_func(CoherenceMgr *cm, CoherEvictOkFunc func);
+
+// Directory protocols: after cm_access(), fetch the next directory entry
+// evicted to make room (returns 0 when there are none).  The caller must
+// strip the block from every holder, and then call cm_reset_entry().
+int cm_pop_dir_victim(CoherenceMgr *cm, LongAddr *victim_ret);
+
+// DirMOESI: a peer replying to a downgrade (Coher_StallForWB) with dirty data
+// may keep it as the block's Owner, instead of writing it back.  Returns
+// nonzero (and records the deferred writeback) iff so.
+int cm_defer_owner_wb(CoherenceMgr *cm, LongAddr base_addr, int cache_id);
+
 
 // The typical progression of a request is one of the following:
 // 1. cm_access --uncached--> cm_shared_request -> 
@@ -138,8 +174,11 @@ int cm_peer_reply(CoherenceMgr *cm, LongAddr base_addr, int reply_cache_id);
 // explicitly-simulation eviction notification, enforced inclusion/exclusion,
 // etc.  At the moment, these calls may end up being ignored, and are only
 // used to help recover simulator memory.
-void cm_evict_notify(CoherenceMgr *cm, LongAddr base_addr,
-                     int cache_id);
+//
+// Returns nonzero iff the evicting cache was a DirMOESI Owner still holding
+// dirty data, in which case the caller must send a writeback below.
+int cm_evict_notify(CoherenceMgr *cm, LongAddr base_addr,
+                    int cache_id);
 
 
 // Query for consistency checking; prints details on failure, but still
@@ -147,6 +186,14 @@ void cm_evict_notify(CoherenceMgr *cm, LongAddr base_addr,
 int cm_holder_okay(const CoherenceMgr *cm, LongAddr base_addr,
                    int cache_id, int dirty, int writeable);
 
+void cm_print_stats(const CoherenceMgr *cm, void *c_FILE_out,
+                    const char *prefix);
+void cm_reset_stats(CoherenceMgr *cm);
+// Register a provider for the protocol / directory counters at "path"
+// (stats-reg.h)
+void cm_register_stats(CoherenceMgr *cm, struct StatsReg *sr,
+                       const char *path);
+
 
 #ifdef __cplusplus
 }
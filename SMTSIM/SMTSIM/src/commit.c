@@ -32,6 +32,12 @@ Copyright (C) Jack Lo
 #include "inst.h"
 #include "smt.h"
 #include "core-resources.h"
+#include "fetch-policy.h"
+#include "lsq-model.h"
+#include "runahead.h"
+#include "branch-ckpt.h"
+#include "reconf-ctl.h"
+#include "inst-trace.h"
 #include "trace-fill-unit.h"
 #include "branch-bias-table.h"
 #include "context.h"
@@ -50,6 +56,7 @@ Copyright (C) Jack Lo
 #include "prefetch-streambuf.h"
 #include "deadblock-pred.h"
 #include "adapt-mgr.h"
+#include "mem-profiler.h"
 
 
 void *FILE_DumpCommitFile = 0;
@@ -149,6 +156,78 @@ static int timeord_cmp(const void *v1, const void *v2)
 }
 
 
+// CPI-stack attribution: charge this cycle's commit slots for "ctx" (after
+// its commits) to Cpi_Base, to Cpi_BrMispredict for reaped wrong-path
+// insts, and the rest to whatever is holding up its oldest instruction.
+// Runahead pseudo-retirement is charged to the miss which started the
+// episode, and retiring injected (non-app) insts to Cpi_Base.
+static void
+cpi_account(context * restrict ctx, int committed, int reaped,
+            int ra_retired, int injected)
+{
+    const activelist * restrict head = &ctx->alist[ctx->next_to_commit];
+    i64 * restrict slots = ctx->as->extra->cpi_slots;
+    int unused = ctx->core->params.commit.single_limit - committed - reaped -
+        ra_retired - injected;
+    CpiCause cause;
+
+    slots[Cpi_Base] += committed + injected;
+    slots[Cpi_BrMispredict] += reaped;
+    slots[ctx->cpi.runahead_cause] += ra_retired;
+    if (!(head->status & (INVALID | SQUASHED)))
+        ctx->cpi.refill = 0;            // correct path has reached the head
+    if (ctx->cpi.mem_wait &&
+        ((ctx->cpi.mem_wait != head) || !(head->status & MEMORY)))
+        context_cpi_flush_memwait(ctx);
+    // (commit_for_core() stops each thread at single_limit)
+    sim_assert(unused >= 0);
+    if (unused == 0)
+        return;
+
+    if (head->status & INVALID) {
+        // Empty pipe
+        if (ctx->cpi.refill)
+            cause = Cpi_BrMispredict;
+        else if (ctx->sync_lock_blocked)
+            cause = Cpi_Sync;
+        else if (ctx->imiss_cache_entry || (ctx->fetchcycle > cyc))
+            cause = Cpi_IMiss;
+        else
+            cause = Cpi_Frontend;
+    } else if (head->status & (SQUASHED | RETIREABLE)) {
+        // Could have committed/reaped more, but ran out of commit bandwidth
+        // (or was held by a commit group, runahead sync, etc.)
+        cause = Cpi_CommitBW;
+    } else if (head->renamecycle < head->fetchcycle) {
+        // Not renamed yet (renamecycle is stale from the entry's last use);
+        // rename runs after commit, so last cycle's stall is the latest.
+        cause = ((ctx->cpi.rename_stall != Cpi_Base) &&
+                 (ctx->cpi.rename_stall_cyc >= cyc - 1)) ?
+            (CpiCause) ctx->cpi.rename_stall : Cpi_Frontend;
+    } else if (head->fu == SYNCH) {
+        cause = Cpi_Sync;
+    } else if (head->status & MEMORY) {
+        // Outstanding D-miss: which level services it isn't known yet
+        ctx->cpi.mem_wait = head;
+        ctx->cpi.mem_wait_slots += unused;
+        return;
+    } else if ((head->mem_flags & SMF_Read) && (head->status & EXECUTING)) {
+        switch (head->dcache_sim.service_level) {
+        case 2: cause = Cpi_L2Load; break;
+        case 3: cause = Cpi_L3Load; break;
+        case SERVICED_MEM:
+        case SERVICED_COHER:
+            cause = Cpi_MemLoad; break;
+        default: cause = Cpi_L1Load;    // hit, or address not yet ready
+        }
+    } else {
+        // Executing, or ready and waiting for a functional unit
+        cause = Cpi_FU;
+    }
+    slots[cause] += unused;
+}
+
+
 /* This is the final stage.  A number of things get done here.
    Instructions that have reached this stage commit in order 
    (per thread)..
@@ -170,6 +249,9 @@ commit_for_core(CoreResources *core)
   int total_commits_left = core->params.commit.total_limit;
   TimeOrder thread_order[n_contexts];   // OK in C99
   int commits_this_cyc[n_contexts];     // (NOT global thread ID numbers!)
+  int reaped_this_cyc[n_contexts];      // squashed insts reaped, likewise
+  int ra_retired_this_cyc[n_contexts];  // runahead pseudo-retired, likewise
+  int injected_this_cyc[n_contexts];    // injected (non-app) retired, likewise
 
   for (int i = 0; i < n_contexts; i++) {
       context * restrict ctx = core->contexts[i];
@@ -180,6 +262,9 @@ commit_for_core(CoreResources *core)
       thread_order[i].time = ord_time;
       thread_order[i].ctx = ctx;
       commits_this_cyc[i] = 0;
+      reaped_this_cyc[i] = 0;
+      ra_retired_this_cyc[i] = 0;
+      injected_this_cyc[i] = 0;
   }
   if (n_contexts > 1)
       qsort(thread_order, n_contexts, sizeof(thread_order[0]), timeord_cmp);
@@ -199,6 +284,14 @@ commit_for_core(CoreResources *core)
       // assert: reap_alist_at_squash set -> "top" isn't SQUASHED
       sim_assert(!GlobalParams.reap_alist_at_squash || 
                  !(top->status & SQUASHED));
+      // Runahead insts pseudo-retire: they just give up their resources.
+      // Synchronization insts can't, so they hold things up until the
+      // episode ends.
+      const int is_runahead =
+          (current->long_mem_stat == LongMem_Runahead) &&
+          !(top->status & SQUASHED);
+      if (is_runahead && (top->fu == SYNCH))
+        break;
       if (next == top->commit_group.leader_id) {
         if (top->commit_group.remaining != 0) {
           current->commit_group.commit_block_cyc++;
@@ -215,8 +308,17 @@ commit_for_core(CoreResources *core)
         synchexecute(top);
       }
       const int is_from_app = top->as != NULL;
-      const int is_retireable = (top->status & RETIREABLE) && is_from_app;
+      const int is_retireable = (top->status & RETIREABLE) && is_from_app &&
+          !is_runahead;
       const int is_inject_retire = (top->status & RETIREABLE) && !is_from_app;
+      if (top->status & SQUASHED)
+        reaped_this_cyc[current->core_thread_id]++;
+      if (is_runahead && is_from_app) {
+        ra_retired_this_cyc[current->core_thread_id]++;
+        runahead_inst_retired(core->runahead, current, top);
+      }
+      if (is_inject_retire)
+        injected_this_cyc[current->core_thread_id]++;
       if (is_retireable) {
         commits_this_cyc[current->core_thread_id]++;
         if (FILE_DumpCommitFile && i==0) {
@@ -235,11 +337,26 @@ commit_for_core(CoreResources *core)
                            top->tc.predict_num, top->taken_branch,
                            (top->taken_branch == top->taken_predict));
             } else {
-                update_pht(current, top->pc, top->taken_branch, top->ghr);
+                update_pht(current, top->pc, top->taken_branch, top->ghr,
+                           top->undo.bp_hist_pos);
             }
         }
         if (SBF_CondBranch(top->br_flags))
             bbt_update(core->br_bias, top->pc, i, top->taken_branch);
+        if (core->bckpt && top->br_flags)
+            bckpt_br_committed(core->bckpt, current, top);
+        if (core->reconf)
+            reconf_inst_committed(core->reconf, current, top);
+        if (top->as->extra->itrace_out)
+            itrace_writer_commit(top->as->extra->itrace_out, top->as, top);
+        if (top->as->itrace_in)
+            itrace_reader_committed(top->as->itrace_in, top->app_inst_num);
+        if (GlobalMemProfiler)
+            memprof_inst_commit(GlobalMemProfiler, current, top);
+        if (SBF_IndirectBranch(top->br_flags) &&
+            !SBF_ReadsRetStack(top->br_flags) &&
+            !(top->gen_flags & SGF_SysCall))
+            update_indirect(current, top);
         if (core->tfill)
             tfu_inst_commit(core->tfill, current, top);
         if (current->long_mem_stat == LongMem_Completing) {
@@ -248,6 +365,8 @@ commit_for_core(CoreResources *core)
         }
         if (!IS_ZERO_REG(top->dest))
             current->bmt_regdirty[top->dest] = 1;
+        if (core->runahead && (top->mem_flags & SMF_Read))
+            runahead_load_committed(core->runahead, current, top);
         if ((core->d_streambuf || core->d_dbp) && top->mem_flags) {
             LongAddr addr;
             laddr_set(addr, (top->mem_flags & SMF_Read) ? top->srcmem
@@ -272,11 +391,15 @@ commit_for_core(CoreResources *core)
           current->core->mb.current_epoch++;
       else if (top->syncop == WMB)
           current->core->wmb.current_epoch++;
+      if (top->ckpt_id >= 0)
+          bckpt_release(core->bckpt, current, top);
       top->status = INVALID;
       if (current->last_writer[top->dest] == next)
           current->last_writer[top->dest] = NONE;
       core->i_registers_freed += top->iregs_used;
       core->f_registers_freed += top->fregs_used;
+      if (top->lsqentry && core->lsqm)
+          lsqm_removed(core->lsqm, current, top);
       core->lsq_freed += top->lsqentry;
       current->lsq_freed += top->lsqentry;
       current->rob_freed_this_cyc += top->robentry;
@@ -338,6 +461,9 @@ commit_for_core(CoreResources *core)
       context * restrict ctx = core->contexts[i];
       activelist * restrict oldest_inst = &ctx->alist[ctx->next_to_commit];
       int app_id = (ctx->as) ? ctx->as->app_id : -1;    // ctx->as may be NULL
+      if (GlobalParams.cpi_stack && ctx->as)
+          cpi_account(ctx, commits_this_cyc[i], reaped_this_cyc[i],
+                      ra_retired_this_cyc[i], injected_this_cyc[i]);
       if (oldest_inst->status & INVALID) {
           // Empty pipe
           if (!commits_this_cyc[i] && GlobalParams.long_mem_cyc &&
@@ -367,6 +493,9 @@ commit_for_core(CoreResources *core)
           long_mem_detect(ctx, oldest_inst, 1);
       }
 
+      if (commits_this_cyc[i])
+          fpol_note_commits(core->fpol, i, commits_this_cyc[i]);
+
       // See if we've crossed some N-commits-since-go boundary this cycle
       // (note that we may overshoot by up to the per-thread-commit-limit)
       if (commits_this_cyc[i] && (ctx->as != NULL)) {
@@ -389,6 +518,9 @@ commit_for_core(CoreResources *core)
           }
       }
   }
+
+  if (core->reconf)
+      reconf_cycle(core->reconf);
 }
 
 
@@ -25,6 +25,11 @@ const char RCSid_1107553048[] =
 #include "app-stats-log.h"
 #include "callback-queue.h"
 #include "app-mgr.h"            // for appmgr_signal_idlectx() callback
+#include "app-mem-stats.h"
+#include "inst-trace.h"
+#include "sim-params.h"
+#include "stats-reg.h"
+#include "cache.h"
 
 
 // This auto-grows as needed
@@ -41,13 +46,20 @@ const char *CtxHalt_names[] = {
 };
 
 const char *LongMem_names[] = {
-    "None", "Detecting", "Ignored", "FlushedBlocked", "Completing", NULL
+    "None", "Detecting", "Ignored", "FlushedBlocked", "Completing", "Runahead",
+    NULL
 };
 
 const char *MisPred_names[] = { 
     "None", "CorrectPath", "WrongPath", NULL
 };
 
+const char *CpiCause_names[] = {
+    "base", "imiss", "br_mispredict", "frontend", "iq_full", "fq_full",
+    "rob_full", "lsq_full", "rename_full", "l1_load", "l2_load", "l3_load",
+    "mem_load", "fu", "sync", "commit_bw", NULL
+};
+
 
 namespace {
 
@@ -140,6 +152,7 @@ reset_alist(activelist *inst, int id)
     inst->id = id;
     inst->status = INVALID;
     inst->deps = 0;
+    inst->ckpt_id = -1;
 }
 
 
@@ -230,6 +243,8 @@ context_reset_minstate(context *ctx)
     ctx->follow_sync = 0;
     ctx->wrong_path = 0;
     ctx->misfetching = 0;
+    if (ctx->core)
+        discard_misfetches(ctx);
     ctx->draining = 0;
     ctx->halting = CtxHalt_NoHalt;
     sim_assert(!ctx->halt_done_cb);
@@ -245,6 +260,7 @@ context_reset_minstate(context *ctx)
 
     ctx->icache_sim.service_level = 0;          // (SERVICED_NONE)
     ctx->icache_sim.was_merged = 0;
+    context_cpi_flush_memwait(ctx);
 
     // When first created, contexts are "reset" while ctx->core is still NULL
     if (ctx->core) {
@@ -252,6 +268,7 @@ context_reset_minstate(context *ctx)
             tfu_context_threadswap(ctx->core->tfill, ctx);
     }
     if (ctx->as) {
+        cache_credit_app_mlp(ctx);
         log_appstop_time(ctx);
         ctx->as = NULL;
     }
@@ -261,6 +278,8 @@ context_reset_minstate(context *ctx)
 void
 context_reset(context *ctx)
 {
+    context_cpi_flush_memwait(ctx);     // (before zeroing ctx->cpi)
+
     context temp = *ctx;
 
     memset(ctx, 0, sizeof(*ctx));
@@ -275,6 +294,9 @@ context_reset(context *ctx)
     ctx->return_stack = temp.return_stack;
     ctx->tc.block = temp.tc.block;
     ctx->stats = temp.stats;
+    ctx->rsrc_alloced = temp.rsrc_alloced;      // (cumulative)
+    ctx->rsrc_squash_freed = temp.rsrc_squash_freed;
+    ctx->mlp_credited = temp.mlp_credited;
 
     // Copy any AppState pointer, so reset_minstate() can do stats on it before
     // clearing it.
@@ -295,6 +317,31 @@ context_reset(context *ctx)
 }
 
 
+void
+context_cpi_flush_memwait(context *ctx)
+{
+    if (ctx->cpi.mem_wait_slots && ctx->as) {
+        CpiCause cause =
+            context_cpi_dmiss_cause(ctx->cpi.mem_wait->dcache_sim.service_level);
+        ctx->as->extra->cpi_slots[cause] += ctx->cpi.mem_wait_slots;
+    }
+    ctx->cpi.mem_wait = NULL;
+    ctx->cpi.mem_wait_slots = 0;
+}
+
+
+CpiCause
+context_cpi_dmiss_cause(int service_level)
+{
+    switch (service_level) {
+    case 1: return Cpi_L1Load;
+    case 2: return Cpi_L2Load;
+    case 3: return Cpi_L3Load;
+    default: return Cpi_MemLoad;        // SERVICED_MEM, _COHER, or unknown
+    }
+}
+
+
 void
 context_reset_resteer(context *ctx)
 {
@@ -337,6 +384,7 @@ context_reset_resteer(context *ctx)
     ctx->rs_size = ctx->rs_start = 0;
     // Nuke the GHR, for the same reason
     ctx->ghr = 0;
+    ctx->ind_hist = 0;
 }
 
 
@@ -422,6 +470,7 @@ void
 context_go(context *ctx, struct AppState *app, i64 fetch_cyc)
 {
     sim_assert(context_ready_to_go(ctx));
+    cache_credit_app_mlp(ctx);          // (discards any accrued while idle)
     ctx->as = app;
     ctx->running = 1;
     ctx->fetchcycle = MAX_SCALAR(fetch_cyc, cyc);
@@ -493,6 +542,7 @@ appextra_create(void)
     n->bmt.spill_retstack.size = NELEM(n->bmt.spill_retstack.ents);
     n->bmt.spill_dtlb.size = NELEM(n->bmt.spill_dtlb.ents);
 
+    n->mem_stats = appmemstats_create();
     n->watch.commit_count = callbackq_create();
     n->watch.app_inst_commit = callbackq_create();
     return n;
@@ -504,10 +554,13 @@ appextra_destroy(AppStateExtras *extra)
 {
     if (extra) {
         appstatslog_destroy(extra->stats_log);
+        if (extra->itrace_out)
+            itrace_writer_destroy(extra->itrace_out);
         if (extra->stats_log_cb)
             callbackq_cancel(GlobalEventQueue, extra->stats_log_cb);
         callbackq_destroy(extra->watch.commit_count);
         callbackq_destroy(extra->watch.app_inst_commit);
+        appmemstats_destroy(extra->mem_stats);
         free(extra);
     }
 }
@@ -533,7 +586,10 @@ appextra_assign_stats(AppStateExtras *out,
     out->mem_accesses = in->mem_accesses;
     out->mem_delay.delay_sum = in->mem_delay.delay_sum;
     out->mem_delay.sample_count = in->mem_delay.sample_count;
+    appmemstats_assign(out->mem_stats, in->mem_stats);
     out->instq_conf_cyc = in->instq_conf_cyc;
+    for (int i = 0; i < CpiCause_last; i++)
+        out->cpi_slots[i] = in->cpi_slots[i];
     out->total_go_count = in->total_go_count;
     out->long_mem_detected = in->long_mem_detected;
     out->long_mem_flushed = in->long_mem_flushed;
@@ -582,7 +638,9 @@ appextra_subtract_stats(AppStateExtras *out,
                         const AppStateExtras *r)
 {
     // don't forget to sync appextra_assign_stats()
+    AppMemStats *out_mem_stats = out->mem_stats;        // owned by "out"
     memset(out, 0, sizeof(*out));
+    out->mem_stats = out_mem_stats;
     out->total_commits = l->total_commits - r->total_commits;
     out->cp_insts_discarded = l->cp_insts_discarded - r->cp_insts_discarded;
     out->mem_commits = l->mem_commits - r->mem_commits;
@@ -608,7 +666,10 @@ appextra_subtract_stats(AppStateExtras *out,
     out->mem_delay.delay_sum = l->mem_delay.delay_sum - r->mem_delay.delay_sum;
     out->mem_delay.sample_count = l->mem_delay.sample_count -
         r->mem_delay.sample_count;
+    appmemstats_subtract(out->mem_stats, l->mem_stats, r->mem_stats);
     out->instq_conf_cyc = l->instq_conf_cyc - r->instq_conf_cyc;
+    for (int i = 0; i < CpiCause_last; i++)
+        out->cpi_slots[i] = l->cpi_slots[i] - r->cpi_slots[i];
     out->total_go_count = l->total_go_count - r->total_go_count;
     out->long_mem_detected = l->long_mem_detected - r->long_mem_detected;
     out->long_mem_flushed = l->long_mem_flushed - r->long_mem_flushed;
@@ -683,6 +744,16 @@ void update_acc_occ_per_inst(context * restrict ctx, activelist * restrict inst,
     }
 }
 
+void
+ctx_rsrc_tally_add(CtxRsrcTally *tally, const struct activelist *inst)
+{
+    tally->iregs += inst->iregs_used;
+    tally->fregs += inst->fregs_used;
+    tally->lsq += inst->lsqentry;
+    tally->rob += inst->robentry;
+}
+
+
 i64
 app_sched_cyc(const struct AppState *as)
 {
@@ -708,6 +779,100 @@ app_alive_cyc(const struct AppState *as)
 }
 
 
+static void
+emit_hitrate(StatsEmitter *em, const char *name, const ASE_HitRate& hr)
+{
+    statsemit_group_begin(em, name);
+    statsemit_i64(em, "acc", hr.acc);
+    statsemit_i64(em, "hits", hr.hits);
+    statsemit_group_end(em);
+}
+
+
+// One group per app, "A<id>", for every app created so far
+static void
+appextra_stats_provider(StatsEmitter *em, void *data)
+{
+    const AppState *as;
+    appstate_global_iter_reset();
+    while ((as = appstate_global_iter_next()) != NULL) {
+        const AppStateExtras *ase = as->extra;
+        i64 sched_cyc = app_sched_cyc(as);
+        char name[40];
+        e_snprintf(name, sizeof(name), "A%d", as->app_id);
+        statsemit_group_begin(em, name);
+        statsemit_i64(em, "total_commits", ase->total_commits);
+        statsemit_i64(em, "mem_commits", ase->mem_commits);
+        statsemit_i64(em, "sched_cyc", sched_cyc);
+        statsemit_double(em, "sched_ipc", (sched_cyc > 0) ?
+                         (double) ase->total_commits / sched_cyc : 0.0);
+        statsemit_i64(em, "total_go_count", ase->total_go_count);
+        statsemit_i64(em, "long_mem_detected", ase->long_mem_detected);
+        statsemit_i64(em, "long_mem_flushed", ase->long_mem_flushed);
+        statsemit_i64(em, "mem_delay_sum", ase->mem_delay.delay_sum);
+        statsemit_i64(em, "mem_delay_samples", ase->mem_delay.sample_count);
+
+        statsemit_group_begin(em, "hitrate");
+        emit_hitrate(em, "icache", ase->hitrate.icache);
+        emit_hitrate(em, "dcache", ase->hitrate.dcache);
+        emit_hitrate(em, "itlb", ase->hitrate.itlb);
+        emit_hitrate(em, "dtlb", ase->hitrate.dtlb);
+        emit_hitrate(em, "l2cache", ase->hitrate.l2cache);
+        emit_hitrate(em, "l3cache", ase->hitrate.l3cache);
+        emit_hitrate(em, "bpred", ase->hitrate.bpred);
+        emit_hitrate(em, "retpred", ase->hitrate.retpred);
+        statsemit_group_end(em);
+
+        statsemit_group_begin(em, "acc");
+        statsemit_i64(em, "itlb", ase->itlb_acc);
+        statsemit_i64(em, "dtlb", ase->dtlb_acc);
+        statsemit_i64(em, "icache", ase->icache_acc);
+        statsemit_i64(em, "dcache", ase->dcache_acc);
+        statsemit_i64(em, "l2cache", ase->l2cache_acc);
+        statsemit_i64(em, "l3cache", ase->l3cache_acc);
+        statsemit_i64(em, "bpred", ase->bpred_acc);
+        statsemit_i64(em, "intalu", ase->intalu_acc);
+        statsemit_i64(em, "fpalu", ase->fpalu_acc);
+        statsemit_i64(em, "ldst", ase->ldst_acc);
+        statsemit_i64(em, "lsq", ase->lsq_acc);
+        statsemit_i64(em, "iq", ase->iq_acc);
+        statsemit_i64(em, "fq", ase->fq_acc);
+        statsemit_i64(em, "ireg", ase->ireg_acc);
+        statsemit_i64(em, "freg", ase->freg_acc);
+        statsemit_i64(em, "iren", ase->iren_acc);
+        statsemit_i64(em, "fren", ase->fren_acc);
+        statsemit_i64(em, "rob", ase->rob_acc);
+        statsemit_group_end(em);
+
+        if (GlobalParams.cpi_stack) {
+            statsemit_group_begin(em, "cpi_slots");
+            for (int i = 0; i < CpiCause_last; i++)
+                statsemit_i64(em, CpiCause_names[i], ase->cpi_slots[i]);
+            statsemit_group_end(em);
+        }
+
+        InstTraceStats its;
+        if (itrace_get_app_stats(as, &its)) {
+            statsemit_group_begin(em, "itrace");
+            statsemit_i64(em, "insts_written", its.insts_written);
+            statsemit_i64(em, "pages_written", its.pages_written);
+            statsemit_i64(em, "records_read", its.records_read);
+            statsemit_i64(em, "noops_filled", its.noops_filled);
+            statsemit_i64(em, "wp_insts", its.wp_insts);
+            statsemit_group_end(em);
+        }
+        statsemit_group_end(em);
+    }
+}
+
+
+void
+appextra_register_stats(StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, appextra_stats_provider, NULL);
+}
+
+
 struct CBQ_Args *
 commit_watchpoint_args(context *ctx, int commits_this_cyc)
 {
@@ -13,6 +13,7 @@
 
 #include "reg-defs.h"
 #include "emulate.h"            // For EmuInstState definition
+#include "inst-trace.h"         // For InstTraceStats
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,6 +26,7 @@ struct activelist;
 struct AppState;
 struct CallbackQueue;
 struct CBQ_Callback;
+struct StatsReg;
 struct CBQ_Args;
 
 
@@ -75,10 +77,41 @@ typedef enum {
     LongMem_Ignored,
     LongMem_FlushedBlocked,
     LongMem_Completing,
+    LongMem_Runahead,           // see runahead.h
     LongMem_last
 } LongMem;
 extern const char *LongMem_names[];
 
+// CPI-stack categories (with Global/cpi_stack): each cycle, every commit
+// slot of each context running an app is charged to exactly one of these,
+// by the state of its oldest instruction.  (See cpi_account() in commit.c)
+typedef enum {
+    Cpi_Base=0,                 // slot used to commit an inst (or injected)
+    Cpi_IMiss,                  // pipe empty; fetch waiting on I-cache/ITLB
+    Cpi_BrMispredict,           // reaping wrong-path insts, or refilling
+    Cpi_Frontend,               // pipe empty, or oldest not yet renamed
+    Cpi_IQFull,                 // rename blocked: int queue full
+    Cpi_FQFull,                 // ...FP queue full
+    Cpi_ROBFull,                // ...reorder buffer full
+    Cpi_LSQFull,                // ...load/store queue full
+    Cpi_RenameFull,             // ...out of int/FP rename registers
+    Cpi_L1Load,                 // oldest is a load, serviced by level 1
+    Cpi_L2Load,
+    Cpi_L3Load,
+    Cpi_MemLoad,                // ...serviced by memory (or coherence)
+    Cpi_FU,                     // oldest executing, or waiting to issue
+    Cpi_Sync,                   // oldest is a sync op, or lock-blocked
+    Cpi_CommitBW,               // oldest ready; commit bandwidth used up
+    CpiCause_last
+} CpiCause;
+extern const char *CpiCause_names[];
+
+
+// Pipeline resources allocated at rename, tallied by kind
+typedef struct CtxRsrcTally {
+    i64 iregs, fregs, lsq, rob;
+} CtxRsrcTally;
+
 
 struct context {
     ThreadParams params;
@@ -112,7 +145,9 @@ struct context {
     int wrong_path;                     // Must be 0 or 1
     int last_writer[MAXREG];
     int misfetching, num_misfetches;
+    int num_misfetch_brs;               // (branches among num_misfetches)
     unsigned ghr;
+    u64 ind_hist;                       // ITTAGE history (see predict.c)
     int fthiscycle;
     int next_to_commit;
     int draining;
@@ -184,6 +219,33 @@ struct context {
         mem_addr pc;
         int addr_regnum;        // (only for non-StaticTarget branches)
     } commit_taken_br;
+
+    // CPI-stack bookkeeping (only maintained with Global/cpi_stack)
+    struct {
+        int refill;             // flag: refilling after a mispredict
+        // Slots lost to an outstanding D-miss at the head of the pipe are
+        // held here until it leaves the head and its service level is known
+        const struct activelist *mem_wait;      // NULL: none pending
+        i64 mem_wait_slots;
+        // Most recent stall of this context's insts at rename
+        int rename_stall;               // CpiCause; Cpi_Base: none yet
+        i64 rename_stall_cyc;
+        // Slots used by runahead pseudo-retirement are charged here, by the
+        // level servicing the load which started the episode
+        int runahead_cause;             // CpiCause
+    } cpi;
+
+    // Resources allocated at rename, and those released by squashes
+    // (cumulative); branch checkpoints difference these to release a
+    // squashed range's resources in bulk
+    CtxRsrcTally rsrc_alloced, rsrc_squash_freed;
+
+    // This context's mshr_data_mlp() values already credited to an app
+    // (cumulative; see cache_credit_app_mlp())
+    struct {
+        i64 busy_cyc;
+        i64 outstanding_sum;
+    } mlp_credited;
 };
 
 
@@ -203,8 +265,18 @@ context *context_create(const ThreadParams *params, int ctx_id);
 void context_destroy(context *ctx);
 
 void context_reset(context *ctx);
+
+void ctx_rsrc_tally_add(CtxRsrcTally *tally,
+                        const struct activelist *inst);
 void context_reset_resteer(context *ctx);
 
+// Charge any CPI-stack slots held for a pending D-miss to ctx->as, by
+// service level (memory, if still unknown), and clear them
+void context_cpi_flush_memwait(context *ctx);
+// CPI-stack cause for time spent waiting on a D-miss serviced at
+// "service_level" (memory, if SERVICED_UNKNOWN)
+CpiCause context_cpi_dmiss_cause(int service_level);
+
 int context_okay_to_halt(const context * restrict ctx);
 
 // Signal a context to: halt execution soon and invoke a callback afterward.
@@ -302,7 +374,9 @@ struct AppStateExtras {
         i64 delay_sum;
         i64 sample_count;
     } mem_delay;
+    struct AppMemStats *mem_stats;      // latency histograms + MLP; non-NULL
     i64 instq_conf_cyc;
+    i64 cpi_slots[CpiCause_last];       // commit slots by CPI-stack category
 
     struct {
         i64 spill_cyc;
@@ -324,6 +398,8 @@ struct AppStateExtras {
 
     struct AppStatsLog *stats_log;
     struct CBQ_Callback *stats_log_cb;  // non-null <=> in GlobalEventQueue
+    struct InstTraceWriter *itrace_out; // non-null <=> capturing commits
+    InstTraceStats itrace_stats;        // capture counts; outlive itrace_out
 
     struct {
         // always non-NULL
@@ -342,6 +418,9 @@ void appextra_subtract_stats(AppStateExtras *out,
 
 i64 app_sched_cyc(const struct AppState *as);
 i64 app_alive_cyc(const struct AppState *as);
+// Register a provider for every app's AppStateExtras counters, one group
+// per app, at "path" (stats-reg.h)
+void appextra_register_stats(struct StatsReg *sr, const char *path);
 void update_acc_occ_per_inst(context * ctx, 
         struct activelist * inst, int add_or_remove, int fp_or_int);
 
@@ -0,0 +1,489 @@
+//
+// Routed on-chip interconnect (ring / 2D mesh) between cores and the
+// address-interleaved slices of the shared level below them
+//
+// $Id$
+//
+
+const char RCSid_1760000027[] =
+"$Id$";
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "core-net.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "main.h"               // For cyc
+#include "stats-reg.h"
+
+
+using std::string;
+using std::vector;
+
+using SimCfg::conf_int;
+
+
+namespace {
+
+// Output ports of each router; a ring only uses the first two
+enum NetPort {
+    Port_East,                  // ring: node+1; mesh: x+1
+    Port_West,                  // ring: node-1; mesh: x-1
+    Port_South,                 // mesh: y+1
+    Port_North,                 // mesh: y-1
+    NetPort_last
+};
+
+
+struct NetConfig {
+    int mesh_cols;
+    int router_latency;
+    int n_vcs;
+    int home_slices;
+    int mem_node;
+
+    NetConfig(const string& cfg_path);
+};
+
+
+NetConfig::NetConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    mesh_cols = conf_int(cp + "mesh_cols");
+    if (mesh_cols < 0) {
+        exit_printf("bad %s (%d)\n", (cp + "mesh_cols").c_str(), mesh_cols);
+    }
+    router_latency = conf_int(cp + "router_latency");
+    if (router_latency < 0) {
+        exit_printf("bad %s (%d)\n", (cp + "router_latency").c_str(),
+                    router_latency);
+    }
+    n_vcs = conf_int(cp + "virtual_channels");
+    if (n_vcs < 1) {
+        exit_printf("bad %s (%d)\n", (cp + "virtual_channels").c_str(),
+                    n_vcs);
+    }
+    home_slices = conf_int(cp + "home_slices");
+    if (home_slices < 0) {
+        exit_printf("bad %s (%d)\n", (cp + "home_slices").c_str(),
+                    home_slices);
+    }
+    mem_node = conf_int(cp + "mem_node");
+}
+
+
+class NetLink {
+    int from_, to_;
+    vector<i64> vc_avail_;      // [n_vcs]: when each VC buffer frees up
+    i64 avail_cyc_;             // when the physical channel is next free
+
+    i64 xfers_;
+    i64 busy_cyc_;
+    i64 wait_cyc_;
+    i64 vc_stalls_;
+
+public:
+    NetLink(int from, int to, int n_vcs)
+        : from_(from), to_(to), vc_avail_(n_vcs, 0), avail_cyc_(0),
+          xfers_(0), busy_cyc_(0), wait_cyc_(0), vc_stalls_(0) { }
+
+    bool exists() const { return from_ >= 0; }
+    int to_node() const { return to_; }
+
+    // Returns the time the message head reaches the downstream router
+    i64 traverse(i64 arrive, const OpTime& op_time, int router_latency) {
+        int vc = 0;
+        for (int i = 1; i < intsize(vc_avail_); i++) {
+            if (vc_avail_[i] < vc_avail_[vc])
+                vc = i;
+        }
+        if (vc_avail_[vc] > arrive)
+            vc_stalls_++;
+        i64 start = MAX_SCALAR(arrive, MAX_SCALAR(vc_avail_[vc], avail_cyc_));
+        i64 next_hop = start + op_time.latency + router_latency;
+        avail_cyc_ = start + op_time.interval;
+        vc_avail_[vc] = next_hop;
+        xfers_++;
+        busy_cyc_ += op_time.interval;
+        wait_cyc_ += start - arrive;
+        return next_hop;
+    }
+
+    bool probe_avail(i64 test_time) const {
+        if (avail_cyc_ > test_time)
+            return false;
+        for (int i = 0; i < intsize(vc_avail_); i++) {
+            if (vc_avail_[i] <= test_time)
+                return true;
+        }
+        return false;
+    }
+
+    void reset_stats() {
+        xfers_ = busy_cyc_ = wait_cyc_ = vc_stalls_ = 0;
+    }
+    void get_stats(CoreNetLinkStats *dest, i64 elapsed_cyc) const {
+        dest->from_node = from_;
+        dest->to_node = to_;
+        dest->xfers = xfers_;
+        dest->busy_cyc = busy_cyc_;
+        dest->wait_cyc = wait_cyc_;
+        dest->vc_stalls = vc_stalls_;
+        dest->util = (elapsed_cyc > 0) ?
+            (double) busy_cyc_ / elapsed_cyc : 0.0;
+    }
+};
+
+} // Anonymous namespace close
+
+
+struct CoreNet {
+private:
+    string name_;
+    CoreNetTopology topo_;
+    NetConfig conf_;
+    int n_cores_;
+    int cols_, rows_;           // mesh geometry (ring: n_routers x 1)
+    int n_routers_;
+    int n_slices_;
+    int block_bytes_lg_;
+    bool sliced_home_;
+    vector<NetLink> links_;     // [n_routers * NetPort_last]
+    i64 stats_start_cyc_;       // for link utilization
+
+    struct {
+        i64 msgs;
+        i64 local_msgs;         // src == dst; no links used
+        i64 hops;
+        i64 latency;            // sum of (delivery - injection)
+        i64 max_hops;
+    } stats_;
+
+    NoDefaultCopy nocopy;
+
+    int neighbor(int node, int port) const {
+        if (topo_ == CoreNet_Ring) {
+            switch (port) {
+            case Port_East: return (node + 1) % n_routers_;
+            case Port_West: return (node + n_routers_ - 1) % n_routers_;
+            default: return -1;
+            }
+        }
+        int x = node % cols_, y = node / cols_;
+        switch (port) {
+        case Port_East: x++; break;
+        case Port_West: x--; break;
+        case Port_South: y++; break;
+        case Port_North: y--; break;
+        default: return -1;
+        }
+        if ((x < 0) || (x >= cols_) || (y < 0) || (y >= rows_))
+            return -1;
+        return y * cols_ + x;
+    }
+
+    int route_port(int node, int dst) const {
+        if (topo_ == CoreNet_Ring) {
+            int east_dist = (dst - node + n_routers_) % n_routers_;
+            return (east_dist <= n_routers_ - east_dist) ?
+                Port_East : Port_West;
+        }
+        int x = node % cols_, y = node / cols_;
+        int dst_x = dst % cols_, dst_y = dst / cols_;
+        if (dst_x != x)
+            return (dst_x > x) ? Port_East : Port_West;
+        return (dst_y > y) ? Port_South : Port_North;
+    }
+
+public:
+    CoreNet(const string& name, const string& cfg_path,
+            CoreNetTopology topology, int n_cores, int block_bytes,
+            bool sliced_home);
+
+    int core_node(int core_id) const {
+        sim_assert((core_id >= 0) && (core_id < n_cores_));
+        return core_id;
+    }
+    int mem_node() const { return conf_.mem_node; }
+    int home_node(const LongAddr& base_addr) const {
+        if (!sliced_home_)
+            return conf_.mem_node;
+        int slice = static_cast<int>((base_addr.a >> block_bytes_lg_) %
+                                     n_slices_);
+        return static_cast<int>((static_cast<i64>(slice) * n_routers_) /
+                                n_slices_);
+    }
+
+    i64 xfer(int src, int dst, i64 now, const OpTime& op_time);
+    bool probe_avail(int src, i64 test_time) const;
+
+    int link_count() const { return intsize(links_); }
+    void get_linkstats(int link_num, CoreNetLinkStats *dest) const {
+        links_.at(link_num).get_stats(dest, cyc - stats_start_cyc_);
+    }
+    void reset_stats();
+
+    void print_stats(FILE *out, const char *pf) const;
+    void emit_stats(StatsEmitter *em) const;
+};
+
+
+CoreNet::CoreNet(const string& name, const string& cfg_path,
+                 CoreNetTopology topology, int n_cores, int block_bytes,
+                 bool sliced_home)
+    : name_(name), topo_(topology), conf_(cfg_path), n_cores_(n_cores),
+      sliced_home_(sliced_home), stats_start_cyc_(cyc)
+{
+    sim_assert(ENUM_OK(CoreNetTopology, topo_));
+    sim_assert(topo_ != CoreNet_Bus);
+    sim_assert(n_cores_ > 0);
+
+    if (topo_ == CoreNet_Ring) {
+        cols_ = n_cores_;
+        rows_ = 1;
+    } else {
+        cols_ = conf_.mesh_cols;
+        if (!cols_)
+            cols_ = static_cast<int>(ceil(sqrt(static_cast<double>
+                                               (n_cores_))));
+        rows_ = (n_cores_ + cols_ - 1) / cols_;
+    }
+    // Mesh routers past the last core (partial last row) host no core, but
+    // are still present, so XY routes never leave the rectangle
+    n_routers_ = cols_ * rows_;
+
+    if ((conf_.mem_node < 0) || (conf_.mem_node >= n_routers_)) {
+        exit_printf("bad %s/mem_node (%d); %s has %d routers\n",
+                    cfg_path.c_str(), conf_.mem_node, name_.c_str(),
+                    n_routers_);
+    }
+    n_slices_ = (conf_.home_slices) ? conf_.home_slices : n_routers_;
+
+    {
+        int log_inexact;
+        block_bytes_lg_ = floor_log2(block_bytes, &log_inexact);
+        sim_assert(!log_inexact);
+    }
+
+    links_.reserve(n_routers_ * NetPort_last);
+    for (int node = 0; node < n_routers_; node++) {
+        for (int port = 0; port < NetPort_last; port++) {
+            int to = neighbor(node, port);
+            // Two-router rings would get parallel east/west links; fine
+            if ((to >= 0) && (to != node)) {
+                links_.push_back(NetLink(node, to, conf_.n_vcs));
+            } else {
+                links_.push_back(NetLink(-1, -1, 1));
+            }
+        }
+    }
+
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+
+i64
+CoreNet::xfer(int src, int dst, i64 now, const OpTime& op_time)
+{
+    sim_assert((src >= 0) && (src < n_routers_));
+    sim_assert((dst >= 0) && (dst < n_routers_));
+    i64 t = now + conf_.router_latency;         // source router
+    int hops = 0;
+    if (src == dst) {
+        // Local slice (or memory controller) port: no link traversal, but
+        // the data still has to be delivered
+        t += op_time.latency;
+        stats_.local_msgs++;
+    }
+    for (int node = src; node != dst; hops++) {
+        int port = route_port(node, dst);
+        NetLink& link = links_[node * NetPort_last + port];
+        sim_assert(link.exists());
+        t = link.traverse(t, op_time, conf_.router_latency);
+        node = link.to_node();
+        sim_assert(hops < n_routers_);
+    }
+    stats_.msgs++;
+    stats_.hops += hops;
+    stats_.latency += t - now;
+    if (hops > stats_.max_hops)
+        stats_.max_hops = hops;
+    return t;
+}
+
+
+bool
+CoreNet::probe_avail(int src, i64 test_time) const
+{
+    sim_assert((src >= 0) && (src < n_routers_));
+    for (int port = 0; port < NetPort_last; port++) {
+        const NetLink& link = links_[src * NetPort_last + port];
+        if (link.exists() && !link.probe_avail(test_time))
+            return false;
+    }
+    return true;
+}
+
+
+void
+CoreNet::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%s%s: %s, %d routers", pf, name_.c_str(),
+            CoreNetTopology_names[topo_], n_routers_);
+    if (topo_ == CoreNet_Mesh)
+        fprintf(out, " (%dx%d)", cols_, rows_);
+    fprintf(out, ", %d home slices, mem at %d\n", n_slices_,
+            conf_.mem_node);
+    fprintf(out, "%s%s: %s msgs, %s local, avg %.3f hops (max %s), "
+            "avg latency %.3f\n", pf, name_.c_str(), fmt_i64(stats_.msgs),
+            fmt_i64(stats_.local_msgs),
+            (stats_.msgs) ? (double) stats_.hops / stats_.msgs : 0.0,
+            fmt_i64(stats_.max_hops),
+            (stats_.msgs) ? (double) stats_.latency / stats_.msgs : 0.0);
+    for (int i = 0; i < intsize(links_); i++) {
+        if (!links_[i].exists())
+            continue;
+        CoreNetLinkStats ls;
+        get_linkstats(i, &ls);
+        fprintf(out, "%s%s link %d->%d: %s xfers, %s busy_cyc, "
+                "%s wait_cyc, %s vc_stalls, %.3f util\n", pf, name_.c_str(),
+                ls.from_node, ls.to_node, fmt_i64(ls.xfers),
+                fmt_i64(ls.busy_cyc), fmt_i64(ls.wait_cyc),
+                fmt_i64(ls.vc_stalls), ls.util);
+    }
+}
+
+
+void
+CoreNet::reset_stats()
+{
+    memset(&stats_, 0, sizeof(stats_));
+    for (int i = 0; i < intsize(links_); i++)
+        links_[i].reset_stats();
+    stats_start_cyc_ = cyc;
+}
+
+
+// One group per link, named "<from>-<to>"
+void
+CoreNet::emit_stats(StatsEmitter *em) const
+{
+    statsemit_i64(em, "msgs", stats_.msgs);
+    statsemit_i64(em, "local_msgs", stats_.local_msgs);
+    statsemit_i64(em, "hops", stats_.hops);
+    statsemit_i64(em, "max_hops", stats_.max_hops);
+    statsemit_i64(em, "latency", stats_.latency);
+    for (int i = 0; i < intsize(links_); i++) {
+        if (!links_[i].exists())
+            continue;
+        CoreNetLinkStats ls;
+        get_linkstats(i, &ls);
+        statsemit_group_begin(em, (string(fmt_i64(ls.from_node)) + "-" +
+                                   fmt_i64(ls.to_node)).c_str());
+        statsemit_i64(em, "xfers", ls.xfers);
+        statsemit_i64(em, "busy_cyc", ls.busy_cyc);
+        statsemit_i64(em, "wait_cyc", ls.wait_cyc);
+        statsemit_i64(em, "vc_stalls", ls.vc_stalls);
+        statsemit_double(em, "util", ls.util);
+        statsemit_group_end(em);
+    }
+}
+
+
+
+//
+// C interface
+//
+
+CoreNet *
+corenet_create(const char *name, const char *config_path,
+               CoreNetTopology topology, int n_cores, int block_bytes,
+               int sliced_home)
+{
+    return new CoreNet(name, config_path, topology, n_cores, block_bytes,
+                       sliced_home);
+}
+
+void
+corenet_destroy(CoreNet *net)
+{
+    delete net;
+}
+
+int
+corenet_core_node(const CoreNet *net, int core_id)
+{
+    return net->core_node(core_id);
+}
+
+int
+corenet_mem_node(const CoreNet *net)
+{
+    return net->mem_node();
+}
+
+int
+corenet_home_node(const CoreNet *net, LongAddr base_addr)
+{
+    return net->home_node(base_addr);
+}
+
+i64
+corenet_xfer(CoreNet *net, int src_node, int dst_node, i64 now,
+             OpTime op_time)
+{
+    return net->xfer(src_node, dst_node, now, op_time);
+}
+
+int
+corenet_probe_avail(const CoreNet *net, int src_node, i64 test_time)
+{
+    return net->probe_avail(src_node, test_time);
+}
+
+int
+corenet_link_count(const CoreNet *net)
+{
+    return net->link_count();
+}
+
+void
+corenet_get_linkstats(const CoreNet *net, int link_num,
+                      CoreNetLinkStats *stats_ret)
+{
+    net->get_linkstats(link_num, stats_ret);
+}
+
+void
+corenet_reset_stats(CoreNet *net)
+{
+    net->reset_stats();
+}
+
+void
+corenet_print_stats(const CoreNet *net, void *c_FILE_out, const char *prefix)
+{
+    net->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
+
+static void
+corenet_stats_provider(StatsEmitter *em, void *data)
+{
+    static_cast<const CoreNet *>(data)->emit_stats(em);
+}
+
+void
+corenet_register_stats(CoreNet *net, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, corenet_stats_provider, net);
+}
@@ -0,0 +1,93 @@
+// -*- C++ -*-
+//
+// Routed on-chip interconnect (ring / 2D mesh) between cores and the
+// address-interleaved slices of the shared level below them
+//
+// $Id$
+//
+
+#ifndef CORE_NET_H
+#define CORE_NET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sim-params.h"
+
+// This replaces the single avail_cyc/done_cyc resource of the plain CoreBus
+// with a set of routers connected by point-to-point links.  Each core sits at
+// its own router (core N at router N); the shared cache level just below the
+// interconnect (the shared L2, or the L3 when L2s are private) is split into
+// address-interleaved "home slices", each attached to a router, so an access
+// pays for the distance between the requesting core and the block's home.
+// Slice S serves blocks whose block number is congruent to S mod the slice
+// count; when that count divides the cache's n_banks, each slice is exactly
+// the set of CacheArray banks that block_bank_num() maps those blocks to.
+//
+// Each link has a physical channel, billed with the OpTime of the message
+// (interval: serialization occupancy, i.e. link bandwidth; latency: wire
+// delay) and a small set of virtual channels.  A message holds its VC buffer
+// at the downstream router until its head arrives there, so heavy traffic
+// through a link stalls on VC allocation even when the wire itself is free.
+// Routing is deterministic: shortest-direction on the (bidirectional) ring,
+// X-then-Y dimension order on the mesh.
+//
+// Like the plain bus, links are reserved at the time a message is injected,
+// possibly into the future; there's no modeling of back-pressure beyond that.
+
+typedef struct CoreNet CoreNet;
+struct StatsReg;
+
+typedef struct CoreNetLinkStats {
+    int from_node, to_node;
+    i64 xfers;
+    i64 busy_cyc;               // sum of message intervals on the wire
+    i64 wait_cyc;               // arrival-to-start delay, summed
+    i64 vc_stalls;              // xfers which found every VC occupied
+    double util;                // busy_cyc / cyc
+} CoreNetLinkStats;
+
+
+// Reads "topology"-specific parameters from "config_path".  If sliced_home
+// is zero, there's no cache below the interconnect, and every home node is
+// the memory controller's.
+CoreNet *corenet_create(const char *name, const char *config_path,
+                        CoreNetTopology topology, int n_cores,
+                        int block_bytes, int sliced_home);
+void corenet_destroy(CoreNet *net);
+
+int corenet_core_node(const CoreNet *net, int core_id);
+int corenet_mem_node(const CoreNet *net);
+int corenet_home_node(const CoreNet *net, LongAddr base_addr);
+
+// Send a message from src_node to dst_node, injected at "now"; bills
+// each link along the route, and returns the delivery time.
+i64 corenet_xfer(CoreNet *net, int src_node, int dst_node, i64 now,
+                 OpTime op_time);
+
+// Non-modifying probe: could a message leaving "src_node" start on its
+// first link at test_time?  (Like corebus_probe_avail(), not a promise.)
+int corenet_probe_avail(const CoreNet *net, int src_node, i64 test_time);
+
+// Zero the message and link counters (e.g. at the end of warmup); link
+// utilization is then measured from now
+void corenet_reset_stats(CoreNet *net);
+
+int corenet_link_count(const CoreNet *net);
+void corenet_get_linkstats(const CoreNet *net, int link_num,
+                           CoreNetLinkStats *stats_ret);
+
+void corenet_print_stats(const CoreNet *net, void *c_FILE_out,
+                         const char *prefix);
+// Register a provider for the network totals and per-link stats at "path"
+// (stats-reg.h)
+void corenet_register_stats(CoreNet *net, struct StatsReg *sr,
+                            const char *path);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CORE_NET_H
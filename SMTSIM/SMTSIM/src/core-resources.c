@@ -20,6 +20,14 @@ const char RCSid_1036522097[] =
 #include "tlb-array.h"
 #include "btb-array.h"
 #include "pht-predict.h"
+#include "tage-predict.h"
+#include "ittage-predict.h"
+#include "fetch-policy.h"
+#include "lsq-model.h"
+#include "runahead.h"
+#include "branch-ckpt.h"
+#include "reconf-ctl.h"
+#include "uop-cache.h"
 #include "branch-bias-table.h"
 #include "main.h"
 #include "context.h"
@@ -29,6 +37,9 @@ const char RCSid_1036522097[] =
 #include "prefetch-streambuf.h"
 #include "deadblock-pred.h"
 #include "mshr.h"
+#include "core-net.h"
+#include "wsm.h"
+#include "stats-reg.h"
 
 
 struct CoreBus {
@@ -39,6 +50,11 @@ struct CoreBus {
     i64 total_idle_cyc;
 
     i64 sync_wait_cyc;
+    i64 stats_start_cyc;        // for idle/useful/util
+
+    // When non-NULL, the routers/links of "net" carry the traffic instead;
+    // avail_cyc is then unused, and done_cyc tracks the latest delivery.
+    CoreNet *net;
 };
 
 
@@ -72,6 +88,68 @@ cache_param_block_count(const CoreCacheParams *params)
 }
 
 
+static void
+core_mshr_stats_provider(StatsEmitter *em, void *data)
+{
+    const CoreResources *core = (const CoreResources *) data;
+    i64 mlp_busy_cyc, mlp_outstanding_sum;
+    mshr_data_mlp(core->data_mshr, -1, &mlp_busy_cyc, &mlp_outstanding_sum);
+    statsemit_i64(em, "data_confs", core->q_stats.d_mshr_conf);
+    statsemit_i64(em, "private_l2_confs", core->private_l2mshr_confs);
+    statsemit_i64(em, "d_mlp_busy_cyc", mlp_busy_cyc);
+    statsemit_i64(em, "d_mlp_outstanding_sum", mlp_outstanding_sum);
+}
+
+
+static const char *
+core_stats_path(char *buf, size_t buf_size, const CoreResources *core,
+                const char *name)
+{
+    e_snprintf(buf, buf_size, "cores/C%d/%s", core->core_id, name);
+    return buf;
+}
+
+
+// Register providers for this core's structures, under "cores/C<id>"; each
+// module supplies its own.  Only the predictor in use is included: the PHT
+// is always created, but TAGE replaces it when enabled.
+static void
+core_register_stats(CoreResources *core, StatsReg *sr)
+{
+    char path[80];
+#define CORE_STATS_PATH(name) core_stats_path(path, sizeof(path), core, (name))
+    cache_register_stats(core->icache, sr, CORE_STATS_PATH("icache"));
+    cache_register_stats(core->dcache, sr, CORE_STATS_PATH("dcache"));
+    if (GlobalParams.mem.private_l2caches)
+        cache_register_stats(core->l2cache, sr, CORE_STATS_PATH("l2cache"));
+    tlb_register_stats(core->itlb, sr, CORE_STATS_PATH("itlb"));
+    tlb_register_stats(core->dtlb, sr, CORE_STATS_PATH("dtlb"));
+    btb_register_stats(core->btb, sr, CORE_STATS_PATH("btb"));
+    if (core->btb_l0)
+        btb_register_stats(core->btb_l0, sr, CORE_STATS_PATH("btb_l0"));
+    if (core->tage)
+        tage_register_stats(core->tage, sr, CORE_STATS_PATH("tage"));
+    else
+        pht_register_stats(core->pht, sr, CORE_STATS_PATH("pht"));
+    if (core->ittage)
+        ittage_register_stats(core->ittage, sr, CORE_STATS_PATH("ittage"));
+    statsreg_add_provider(sr, CORE_STATS_PATH("mshr"),
+                          core_mshr_stats_provider, core);
+    if (core->lsqm)
+        lsqm_register_stats(core->lsqm, sr, CORE_STATS_PATH("lsqm"));
+    if (core->runahead)
+        runahead_register_stats(core->runahead, sr,
+                                CORE_STATS_PATH("runahead"));
+    if (core->bckpt)
+        bckpt_register_stats(core->bckpt, sr, CORE_STATS_PATH("bckpt"));
+    if (core->reconf)
+        reconf_register_stats(core->reconf, sr, CORE_STATS_PATH("reconf"));
+    if (core->uopc)
+        uopc_register_stats(core->uopc, sr, CORE_STATS_PATH("uopc"));
+#undef CORE_STATS_PATH
+}
+
+
 CoreResources *
 core_create(int core_id, const CoreParams *params)
 {
@@ -98,8 +176,6 @@ core_create(int core_id, const CoreParams *params)
 
     n->n_contexts = 0;
     n->contexts = NULL;
-    n->sched.priority = NULL;
-    n->sched.key = NULL;
 
     sim_assert(n->params.fetch.n_stages > 0);
     sim_assert(n->params.decode.n_stages > 0);
@@ -207,12 +283,165 @@ core_create(int core_id, const CoreParams *params)
         goto fail;
     }
 
+    n->btb_l0 = NULL;
+    {
+        int l0_entries, l0_assoc;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/BTBHierarchy/l0_enable",
+                   n->params.config_path);
+        if (simcfg_get_bool(temp_path)) {
+            e_snprintf(temp_path, sizeof(temp_path),
+                       "%s/BTBHierarchy/l0_entries", n->params.config_path);
+            l0_entries = simcfg_get_int(temp_path);
+            e_snprintf(temp_path, sizeof(temp_path),
+                       "%s/BTBHierarchy/l0_assoc", n->params.config_path);
+            l0_assoc = simcfg_get_int(temp_path);
+            e_snprintf(temp_path, sizeof(temp_path),
+                       "%s/BTBHierarchy/l1_extra_lat", n->params.config_path);
+            n->btb_l1_extra_lat = simcfg_get_int(temp_path);
+            if (n->btb_l1_extra_lat < 0) {
+                err_printf("core %d: bad BTBHierarchy/l1_extra_lat (%d)\n",
+                           core_id, n->btb_l1_extra_lat);
+                goto fail;
+            }
+            if (!(n->btb_l0 = btb_create(l0_entries, l0_assoc,
+                                         n->params.inst_bytes))) {
+                fprintf(stderr, "%s (%s:%i): couldn't create L0 BTB\n",
+                        __func__, __FILE__, __LINE__);
+                goto fail;
+            }
+        }
+    }
+
+    {
+        int enable = 0;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/ITTAGE/enable",
+                   n->params.config_path);
+        enable = simcfg_get_bool(temp_path);
+        e_snprintf(temp_path, sizeof(temp_path), "%s/ITTAGE",
+                   n->params.config_path);
+        e_snprintf(temp_id, sizeof(temp_id), "C%d.ittage", core_id);
+        n->ittage = NULL;
+        if (enable && !(n->ittage = ittage_create(temp_id, temp_path,
+                                                  n->params.inst_bytes))) {
+            fprintf(stderr, "%s (%s:%i): couldn't create ITTAGE predictor\n",
+                    __func__, __FILE__, __LINE__);
+            goto fail;
+        }
+    }
+
     if (!(n->pht = pht_create(n->params.pht_entries, n->params.inst_bytes))) {
         fprintf(stderr, "%s (%s:%i): couldn't create PHT\n", __func__,
                 __FILE__, __LINE__);
         goto fail;
     }
 
+    {
+        int enable = 0;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/TageSCL/enable",
+                   n->params.config_path);
+        enable = simcfg_get_bool(temp_path);
+        e_snprintf(temp_path, sizeof(temp_path), "%s/TageSCL",
+                   n->params.config_path);
+        e_snprintf(temp_id, sizeof(temp_id), "C%d.tage", core_id);
+        n->tage = NULL;
+        if (enable && !(n->tage = tage_create(temp_id, temp_path,
+                                              n->params.inst_bytes))) {
+            fprintf(stderr, "%s (%s:%i): couldn't create TAGE predictor\n",
+                    __func__, __FILE__, __LINE__);
+            goto fail;
+        }
+    }
+
+    e_snprintf(temp_path, sizeof(temp_path), "%s/FetchPolicy",
+               n->params.config_path);
+    e_snprintf(temp_id, sizeof(temp_id), "C%d.fpol", core_id);
+    if (!(n->fpol = fpol_create(temp_id, temp_path, n))) {
+        fprintf(stderr, "%s (%s:%i): couldn't create fetch policy\n",
+                __func__, __FILE__, __LINE__);
+        goto fail;
+    }
+
+    {
+        int enable = 0;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/LSQModel/enable",
+                   n->params.config_path);
+        enable = simcfg_get_bool(temp_path);
+        e_snprintf(temp_path, sizeof(temp_path), "%s/LSQModel",
+                   n->params.config_path);
+        e_snprintf(temp_id, sizeof(temp_id), "C%d.lsqm", core_id);
+        n->lsqm = NULL;
+        if (enable && !(n->lsqm = lsqm_create(temp_id, temp_path, n))) {
+            fprintf(stderr, "%s (%s:%i): couldn't create LSQ model\n",
+                    __func__, __FILE__, __LINE__);
+            goto fail;
+        }
+    }
+
+    {
+        int enable = 0;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/Runahead/enable",
+                   n->params.config_path);
+        enable = simcfg_get_bool(temp_path);
+        e_snprintf(temp_path, sizeof(temp_path), "%s/Runahead",
+                   n->params.config_path);
+        e_snprintf(temp_id, sizeof(temp_id), "C%d.runahead", core_id);
+        n->runahead = NULL;
+        if (enable &&
+            !(n->runahead = runahead_create(temp_id, temp_path, n))) {
+            fprintf(stderr, "%s (%s:%i): couldn't create runahead state\n",
+                    __func__, __FILE__, __LINE__);
+            goto fail;
+        }
+    }
+
+    {
+        int enable = 0;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/BranchCkpt/enable",
+                   n->params.config_path);
+        enable = simcfg_get_bool(temp_path);
+        e_snprintf(temp_path, sizeof(temp_path), "%s/BranchCkpt",
+                   n->params.config_path);
+        e_snprintf(temp_id, sizeof(temp_id), "C%d.bckpt", core_id);
+        n->bckpt = NULL;
+        if (enable && !(n->bckpt = bckpt_create(temp_id, temp_path, n))) {
+            fprintf(stderr, "%s (%s:%i): couldn't create branch checkpoints\n",
+                    __func__, __FILE__, __LINE__);
+            goto fail;
+        }
+    }
+
+    {
+        int enable = 0;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/Reconfig/enable",
+                   n->params.config_path);
+        enable = simcfg_get_bool(temp_path);
+        e_snprintf(temp_path, sizeof(temp_path), "%s/Reconfig",
+                   n->params.config_path);
+        e_snprintf(temp_id, sizeof(temp_id), "C%d.reconf", core_id);
+        n->reconf = NULL;
+        if (enable && !(n->reconf = reconf_create(temp_id, temp_path, n))) {
+            fprintf(stderr, "%s (%s:%i): couldn't create reconfiguration "
+                    "controller\n", __func__, __FILE__, __LINE__);
+            goto fail;
+        }
+    }
+
+    {
+        int enable = 0;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/UopCache/enable",
+                   n->params.config_path);
+        enable = simcfg_get_bool(temp_path);
+        e_snprintf(temp_path, sizeof(temp_path), "%s/UopCache",
+                   n->params.config_path);
+        e_snprintf(temp_id, sizeof(temp_id), "C%d.uopc", core_id);
+        n->uopc = NULL;
+        if (enable && !(n->uopc = uopc_create(temp_id, temp_path, n))) {
+            fprintf(stderr, "%s (%s:%i): couldn't create uop cache\n",
+                    __func__, __FILE__, __LINE__);
+            goto fail;
+        }
+    }
+
     if (!(n->multi_bp = mbp_create(&n->params.multi_bp))) {
         fprintf(stderr, "%s (%s:%i): couldn't create multi branch predictor\n",
                 __func__, __FILE__, __LINE__);
@@ -297,6 +526,9 @@ core_create(int core_id, const CoreParams *params)
     n->l3cache = n->params.shared_l3cache;
     n->l3_dbp = NULL;   // place-holder
 
+    if (GlobalStatsReg)
+        core_register_stats(n, GlobalStatsReg);
+
     return n;
 
 fail:
@@ -328,7 +560,10 @@ core_destroy(CoreResources *core)
         tlb_destroy(core->itlb);
         tlb_destroy(core->dtlb);
         btb_destroy(core->btb);
+        btb_destroy(core->btb_l0);
+        ittage_destroy(core->ittage);
         pht_destroy(core->pht);
+        tage_destroy(core->tage);
         mbp_destroy(core->multi_bp);
         dbp_destroy(core->i_dbp);
         dbp_destroy(core->d_dbp);
@@ -337,8 +572,14 @@ core_destroy(CoreResources *core)
             cache_destroy(core->l2cache);
             dbp_destroy(core->l2_dbp);
         }
-        free(core->sched.priority);
-        free(core->sched.key);
+        fpol_destroy(core->fpol);
+        lsqm_destroy(core->lsqm);
+        runahead_destroy(core->runahead);
+        bckpt_destroy(core->bckpt);
+        reconf_destroy(core->reconf);
+        uopc_destroy(core->uopc);
+        if (core->wsm_capture)
+            wsm_threadcap_destroy(core->wsm_capture);
         free(core->contexts);
         free(core);
     }
@@ -370,24 +611,13 @@ void
 core_add_context(CoreResources *core, struct context *ctx)
 {
     struct context **new_contexts;
-    int *new_key, *new_priority;
 
     if (!(new_contexts = realloc(core->contexts, (core->n_contexts + 1) *
                                  sizeof(core->contexts[0])))) 
         goto nomem;
-    if (!(new_priority = realloc(core->sched.priority, (core->n_contexts + 1) *
-                                 sizeof(core->sched.priority[0]))))
-        goto nomem;
-    if (!(new_key = realloc(core->sched.key, (core->n_contexts + 1) *
-                            sizeof(core->sched.key[0]))))
-        goto nomem;
 
-    core->sched.priority = new_priority;
-    core->sched.key = new_key;
     core->contexts = new_contexts;
 
-    core->sched.priority[core->n_contexts] = 0;
-    core->sched.key[core->n_contexts] = 0;
     core->contexts[core->n_contexts] = ctx;    
 
     ctx->core = core;
@@ -449,9 +679,21 @@ corebus_create(void)
 }
 
 
+CoreBus *
+corebus_create_routed(CoreNet *net)
+{
+    CoreBus *n = corebus_create();
+    sim_assert(net != NULL);
+    n->net = net;
+    return n;
+}
+
+
 void
 corebus_destroy(CoreBus *bus)
 {
+    if (bus->net)
+        corenet_destroy(bus->net);
     free(bus);
 }
 
@@ -465,6 +707,24 @@ corebus_reset(CoreBus *bus)
     bus->syncs = 0;
     bus->total_idle_cyc = 0;
     bus->sync_wait_cyc = 0;
+    bus->stats_start_cyc = 0;
+}
+
+
+void
+corebus_reset_stats(CoreBus *bus)
+{
+    bus->xfers = 0;
+    bus->syncs = 0;
+    bus->total_idle_cyc = 0;
+    bus->sync_wait_cyc = 0;
+    bus->stats_start_cyc = cyc;
+    // Idle time is billed when the next op starts; don't count any before
+    // now.  (No effect on timing: ops never start before "cyc" anyway.)
+    if (!bus->net && (bus->avail_cyc < cyc))
+        bus->avail_cyc = cyc;
+    if (bus->net)
+        corenet_reset_stats(bus->net);
 }
 
 
@@ -474,11 +734,72 @@ corebus_get_stats(const CoreBus *bus, CoreBusStats *stats_ret)
     stats_ret->xfers = bus->xfers;
     stats_ret->syncs = bus->syncs;
     stats_ret->idle_cyc = bus->total_idle_cyc;
+    if (bus->net) {
+        // No single resource to be idle; report mean link utilization
+        int n_links = corenet_link_count(bus->net), used_links = 0, i;
+        double util_sum = 0;
+        for (i = 0; i < n_links; i++) {
+            CoreNetLinkStats link_stats;
+            corenet_get_linkstats(bus->net, i, &link_stats);
+            if (link_stats.from_node >= 0) {
+                util_sum += link_stats.util;
+                used_links++;
+            }
+        }
+        stats_ret->idle_cyc = 0;
+        stats_ret->sync_cyc = bus->sync_wait_cyc;
+        stats_ret->useful_cyc = 0;
+        stats_ret->util = (used_links) ? util_sum / used_links : 0.0;
+        return;
+    }
     if (bus->avail_cyc < cyc)
         stats_ret->idle_cyc += cyc - bus->avail_cyc;
     stats_ret->sync_cyc = bus->sync_wait_cyc;
-    stats_ret->useful_cyc = cyc - (stats_ret->idle_cyc + stats_ret->sync_cyc);
-    stats_ret->util = (double) stats_ret->useful_cyc / cyc;
+    {
+        i64 elapsed = cyc - bus->stats_start_cyc;
+        stats_ret->useful_cyc = elapsed -
+            (stats_ret->idle_cyc + stats_ret->sync_cyc);
+        stats_ret->util = (elapsed > 0) ?
+            (double) stats_ret->useful_cyc / elapsed : 0.0;
+    }
+}
+
+
+static void
+corebus_stats_provider(StatsEmitter *em, void *data)
+{
+    CoreBusStats st;
+    corebus_get_stats((const CoreBus *) data, &st);
+    statsemit_i64(em, "xfers", st.xfers);
+    statsemit_i64(em, "syncs", st.syncs);
+    statsemit_i64(em, "idle_cyc", st.idle_cyc);
+    statsemit_i64(em, "sync_cyc", st.sync_cyc);
+    statsemit_i64(em, "useful_cyc", st.useful_cyc);
+    statsemit_double(em, "util", st.util);
+}
+
+
+void
+corebus_register_stats(CoreBus *bus, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, corebus_stats_provider, bus);
+    if (bus->net) {
+        char net_path[200];
+        e_snprintf(net_path, sizeof(net_path), "%s/net", path);
+        corenet_register_stats(bus->net, sr, net_path);
+    }
+}
+
+
+static i64
+corebus_route(CoreBus *bus, int src_node, int dst_node, OpTime op_time)
+{
+    i64 ready_time = corenet_xfer(bus->net, src_node, dst_node, cyc,
+                                  op_time);
+    if (ready_time > bus->done_cyc)
+        bus->done_cyc = ready_time;
+    bus->xfers++;
+    return ready_time;
 }
 
 
@@ -486,6 +807,10 @@ i64
 corebus_access(CoreBus *bus, OpTime op_time)
 {
     i64 ready_time;
+    if (bus->net) {
+        int mem_node = corenet_mem_node(bus->net);
+        return corebus_route(bus, mem_node, mem_node, op_time);
+    }
     if (bus->avail_cyc < cyc)
         bus->total_idle_cyc += cyc - bus->avail_cyc;
     bill_resource_time(ready_time, bus->avail_cyc, cyc, op_time);
@@ -496,6 +821,44 @@ corebus_access(CoreBus *bus, OpTime op_time)
 }
 
 
+i64
+corebus_access_home(CoreBus *bus, int core_id, LongAddr base_addr,
+                    int to_core, OpTime op_time)
+{
+    int core_node, home_node;
+    if (!bus->net)
+        return corebus_access(bus, op_time);
+    core_node = corenet_core_node(bus->net, core_id);
+    home_node = corenet_home_node(bus->net, base_addr);
+    return (to_core) ? corebus_route(bus, home_node, core_node, op_time) :
+        corebus_route(bus, core_node, home_node, op_time);
+}
+
+
+i64
+corebus_access_mem(CoreBus *bus, int core_id, int to_core, OpTime op_time)
+{
+    int core_node, mem_node;
+    if (!bus->net)
+        return corebus_access(bus, op_time);
+    core_node = corenet_core_node(bus->net, core_id);
+    mem_node = corenet_mem_node(bus->net);
+    return (to_core) ? corebus_route(bus, mem_node, core_node, op_time) :
+        corebus_route(bus, core_node, mem_node, op_time);
+}
+
+
+i64
+corebus_access_cores(CoreBus *bus, int src_core_id, int dst_core_id,
+                     OpTime op_time)
+{
+    if (!bus->net)
+        return corebus_access(bus, op_time);
+    return corebus_route(bus, corenet_core_node(bus->net, src_core_id),
+                         corenet_core_node(bus->net, dst_core_id), op_time);
+}
+
+
 i64
 corebus_sync_prepare(CoreBus *bus)
 {
@@ -505,6 +868,14 @@ corebus_sync_prepare(CoreBus *bus)
     // but that's not enough to prevent "small" coherence messages from
     // skipping past "big" data fills.)
     i64 sync_time;
+    if (bus->net) {
+        // Routes are independent, so there's no start time to push back;
+        // just hand out the latest delivery time seen on this network.
+        sync_time = MAX_SCALAR(cyc, bus->done_cyc);
+        bus->sync_wait_cyc += sync_time - cyc;
+        bus->syncs++;
+        return sync_time;
+    }
     if (bus->avail_cyc < cyc) {
         bus->total_idle_cyc += cyc - bus->avail_cyc;
         bus->avail_cyc = cyc;
@@ -520,7 +891,19 @@ corebus_sync_prepare(CoreBus *bus)
 
 
 int
-corebus_probe_avail(const CoreBus *bus, i64 test_time)
+corebus_probe_avail(const CoreBus *bus, int core_id, i64 test_time)
 {
+    if (bus->net) {
+        return corenet_probe_avail(bus->net,
+                                   corenet_core_node(bus->net, core_id),
+                                   test_time);
+    }
     return bus->avail_cyc <= test_time;
 }
+
+
+const CoreNet *
+corebus_net(const CoreBus *bus)
+{
+    return bus->net;
+}
@@ -34,6 +34,9 @@ struct TraceCache;
 struct TraceFillUnit;
 struct BranchBiasTable;
 struct MshrTable;
+struct CoreNet;
+struct WSM_ThreadCapture;
+struct StatsReg;
 
 
 typedef struct CoreParams CoreParams;
@@ -70,6 +73,7 @@ struct CoreParams {
     // core_destroy(), read_core_params()
 
     char *config_path;    // to core-specific, fully-populated tree (malloc'd)
+    char *core_type;      // "CoreTypes" entry applied, or "" (malloc'd)
 
     int inst_bytes;
     int page_bytes;
@@ -104,6 +108,9 @@ struct CoreParams {
 
     struct {
         int n_stages;
+        int fuse_cmp_branch;            // Flag: CMPxx + Bxx on its result
+        int fuse_ldah_lda;              // Flag: LDAH + LDA building a const
+        int fuse_scaled_load;           // Flag: S4/S8ADDQ + load from it
     } decode;
 
     struct {
@@ -173,18 +180,25 @@ struct CoreResources {
 
     struct {
         int priorityslot;
-        int *priority;  /* Thread indices within this core */
-        int *key;
     } sched;
+    struct FetchPolicy *fpol;   // thread fetch priority order / gating
+    struct LSQModel *lsqm;      // may be NULL; store->load ordering
+    struct Runahead *runahead;  // may be NULL
+    struct BranchCkpt *bckpt;   // may be NULL; mispredict recovery
+    struct ReconfCtl *reconf;   // may be NULL; resizes the above online
+    struct UopCache *uopc;      // may be NULL; bypasses decode on a hit
 
     // These register counts are for "renaming" registers; 
     // physical_regs = rename_regs + (contexts * arch_regs)
     int i_registers_used, f_registers_used;
     int i_registers_freed, f_registers_freed;
     i64 rs_hits, rs_misses;
+    int btb_l1_extra_lat;       // fetch bubble for targets from "btb" w/ L0
+    i64 btb_slow_redirects;     // ...taken redirects which paid it
   
     int lsq_used;
     int lsq_freed;
+    int fused_in_intq;          // fused tails in intq, not charged for space
     
     struct {
         i64 fetch_epoch;
@@ -209,6 +223,9 @@ struct CoreResources {
 
         i64 memconf;
 
+        // From decode.c
+        i64 fused_pairs;
+
         // Total non-issued, ready insts (when using OOO issue)
         i64 total_conf;
 
@@ -228,17 +245,21 @@ struct CoreResources {
     struct TLBArray *itlb;
     struct TLBArray *dtlb;
     struct BTBArray *btb;
+    struct BTBArray *btb_l0;            // may be NULL; zero-bubble L0 BTB
+    struct IttagePredict *ittage;       // may be NULL
     struct PHTPredict *pht;
+    struct TagePredict *tage;           // may be NULL; replaces "pht"
     struct TraceCache *tcache;
     struct BranchBiasTable *br_bias;
     struct TraceFillUnit *tfill;
     struct MultiBPredict *multi_bp;
     struct DeadBlockPred *i_dbp;        // may be NULL
     struct DeadBlockPred *d_dbp;        // may be NULL
+    struct WSM_ThreadCapture *wsm_capture;      // may be NULL
 
     // Links to possibly-shared structures
     CoreBus *request_bus;               // Uninspired interconnect model
-    CoreBus *reply_bus;                 //   (it's pretty lame)
+    CoreBus *reply_bus;                 //   (it's pretty lame, unless routed)
     struct CacheArray *l2cache;         // "owned" iff using private L2s
     struct CacheArray *l3cache;
     struct DeadBlockPred *l2_dbp;       // "owned" iff private; may be NULL
@@ -283,16 +304,41 @@ void core_dump_queues(const CoreResources *core);
 
 
 CoreBus *corebus_create(void);
+// Routed variant: "net" (owned by the bus from here on) replaces the single
+// shared resource, see core-net.h
+CoreBus *corebus_create_routed(struct CoreNet *net);
 void corebus_destroy(CoreBus *bus);
 void corebus_reset(CoreBus *bus);
+// Zero the counters (and a routed bus's CoreNet's) at the end of warmup
+void corebus_reset_stats(CoreBus *bus);
 void corebus_get_stats(const CoreBus *bus, CoreBusStats *stats_ret);
+// Register a provider for CoreBusStats at "path" (stats-reg.h); a routed
+// bus adds its CoreNet's, at "path/net"
+void corebus_register_stats(CoreBus *bus, struct StatsReg *sr,
+                            const char *path);
 // Returns request-done time
 i64 corebus_access(CoreBus *bus, OpTime op_time);
+// Endpoint-aware accesses; on a plain bus, these are just corebus_access().
+// (to_core: direction, toward the core vs. away from it.)  Use these when
+// the endpoints are known: a routed bus treats corebus_access() as a transfer
+// local to the memory controller's router, which crosses no links.  (All
+// current callers, including WSM's migration transfers, use these.)
+//   _home: between a core and the home slice of "base_addr"
+//   _mem: between a core and the memory controller
+//   _cores: core to core
+i64 corebus_access_home(CoreBus *bus, int core_id, LongAddr base_addr,
+                        int to_core, OpTime op_time);
+i64 corebus_access_mem(CoreBus *bus, int core_id, int to_core,
+                       OpTime op_time);
+i64 corebus_access_cores(CoreBus *bus, int src_core_id, int dst_core_id,
+                         OpTime op_time);
 // Wait for outstanding access (to force ordering for coherence ops)
 // (this is a dumb way to get exclusion, in retrospect)
 i64 corebus_sync_prepare(CoreBus *bus);
 // Be careful with this one, its answer is not a promise
-int corebus_probe_avail(const CoreBus *bus, i64 test_time);
+int corebus_probe_avail(const CoreBus *bus, int core_id, i64 test_time);
+// NULL for the plain shared bus
+const struct CoreNet *corebus_net(const CoreBus *bus);
 
 
 #ifdef __cplusplus
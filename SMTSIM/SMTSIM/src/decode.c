@@ -28,6 +28,11 @@
 #include "dyn-inst.h"
 #include "context.h"
 #include "inject-inst.h"
+#include "app-state.h"
+#include "stash.h"
+#include "inst.h"
+#include "reg-defs.h"
+#include "uop-cache.h"
 
 
 static inline void
@@ -43,6 +48,133 @@ detect_misfetches(const StageQueue * restrict stage)
 }
 
 
+static int
+is_int_compare(u32 inst)
+{
+    if (INST_OPCODE(inst) != INTA)
+        return 0;
+    switch (INST_INTOP_FUNC(inst)) {
+    case CMPEQ: case CMPLT: case CMPLE: case CMPULT: case CMPULE:
+        return 1;
+    }
+    return 0;
+}
+
+
+static int
+is_scaled_add(u32 inst)
+{
+    return (INST_OPCODE(inst) == INTA) &&
+        ((INST_INTOP_FUNC(inst) == S4ADDQ) ||
+         (INST_INTOP_FUNC(inst) == S8ADDQ));
+}
+
+
+static int
+is_plain_load(u32 inst)
+{
+    switch (INST_OPCODE(inst)) {
+    case LDBU: case LDWU: case LDQ_U: case LDF: case LDG: case LDS: case LDT:
+    case LDL: case LDQ:
+        return 1;
+    }
+    return 0;
+}
+
+
+// Can "tail", which immediately follows "head" in program order, be fused
+// with it?  Only pairs where the tail consumes the head's result are fused.
+static int
+can_fuse(const CoreResources * restrict core, const activelist *head,
+         const activelist *tail)
+{
+    const StashData *hs, *ts;
+    u32 hi, ti;
+    int h_dest;
+    if (!head->as || !tail->as || (tail->pc != head->pc + 4) ||
+        ((head->gen_flags | tail->gen_flags) & SGF_PipeExclusive))
+        return 0;
+    if (!(hs = stash_decode_inst(head->as->stash, head->pc)) ||
+        !(ts = stash_decode_inst(tail->as->stash, tail->pc)))
+        return 0;
+    hi = hs->inst;
+    ti = ts->inst;
+
+    if (core->params.decode.fuse_cmp_branch && is_int_compare(hi) &&
+        (INST_OPCODE(ti) >= BLBC) && (INST_OPCODE(ti) <= BGT)) {
+        // CMPxx Ra,Rb,Rc; Bxx Rc,disp
+        h_dest = INST_RC(hi);
+        return (h_dest != IZERO_REG) && (INST_RA(ti) == h_dest);
+    }
+    if (core->params.decode.fuse_ldah_lda && (INST_OPCODE(hi) == LDAH) &&
+        (INST_OPCODE(ti) == LDA)) {
+        // LDAH Ra,hi(Rb); LDA Ra,lo(Ra)
+        h_dest = INST_RA(hi);
+        return (h_dest != IZERO_REG) && (INST_RA(ti) == h_dest) &&
+            (INST_RB(ti) == h_dest);
+    }
+    if (core->params.decode.fuse_scaled_load && is_scaled_add(hi) &&
+        is_plain_load(ti)) {
+        // S4/S8ADDQ Ra,Rb,Rc; LDx Rd,disp(Rc)
+        h_dest = INST_RC(hi);
+        return (h_dest != IZERO_REG) && (INST_RB(ti) == h_dest);
+    }
+    return 0;
+}
+
+
+// Macro-op fusion over a group of decoded instructions: mark the second
+// inst of each eligible adjacent pair as "fused".  Both still execute and
+// commit on their own; a fused tail just isn't charged for a ROB entry, or
+// (without pooling) an IQ slot, at rename.
+static void
+fuse_decode_group(CoreResources * restrict core,
+                  const StageQueue * restrict stage)
+{
+    activelist *head = NULL;
+    if (!core->params.decode.fuse_cmp_branch &&
+        !core->params.decode.fuse_ldah_lda &&
+        !core->params.decode.fuse_scaled_load)
+        return;
+    for (activelist *tail = stageq_head(*stage); tail != NULL;
+         tail = tail->next) {
+        if (tail->status & (INVALID | SQUASHED)) {
+            head = NULL;
+            continue;
+        }
+        if (head && !head->fused && (tail->thread == head->thread) &&
+            (tail->id == alist_add(Contexts[tail->thread], head->id, 1)) &&
+            can_fuse(core, head, tail)) {
+            tail->fused = 1;
+            core->q_stats.fused_pairs++;
+        }
+        head = tail;
+    }
+}
+
+
+static void
+fill_uop_cache(CoreResources * restrict core,
+               const StageQueue * restrict stage)
+{
+    for (activelist *instrn = stageq_head(*stage); instrn != NULL;
+         instrn = instrn->next) {
+        if (instrn->as && !(instrn->status & (INVALID | SQUASHED)))
+            uopc_fill(core->uopc, instrn->as->app_master_id, instrn->pc);
+    }
+}
+
+
+// Decode-time work for instructions which fetch sent directly to rename1
+// from the uop cache, skipping the decode stages
+void
+decode_bypassed_group(CoreResources * restrict core, StageQueue *stage)
+{
+    detect_misfetches(stage);
+    fuse_decode_group(core, stage);
+}
+
+
 /* Pass on to the next stage, as long as it is empty */
 
 static void
@@ -61,8 +193,12 @@ decode_for_core(CoreResources * restrict core)
          src_stage--) {
         if (stageq_count(core->stage.s[src_stage + 1]) == 0) {
             // Detect misfetches in decode1
-            if (src_stage == decode1) 
+            if (src_stage == decode1) {
                 detect_misfetches(&core->stage.s[src_stage]);
+                fuse_decode_group(core, &core->stage.s[src_stage]);
+            }
+            if ((src_stage == rename1 - 1) && core->uopc)
+                fill_uop_cache(core, &core->stage.s[src_stage]);
             stageq_assign(core->stage.s[src_stage + 1], 
                           core->stage.s[src_stage]);
         } else {
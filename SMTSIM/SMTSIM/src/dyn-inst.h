@@ -47,6 +47,15 @@ typedef struct inst_undo_info {
     // Flag: set on undo_inst, to prevent double-undos
     int undone;
 
+    // Conditional branches: the branch predictor's own speculative history
+    // position before this branch was pushed (see bpred_hist_push()); like
+    // the "ghr" copy, used to roll back its history.
+    i64 bp_hist_pos;
+
+    // Branches: ctx->ind_hist before this branch (the indirect predictor's
+    // history); also used for indirect predictor training at commit.
+    u64 ind_hist;
+
     // Extra variables for checking in debug mode
 #ifdef DEBUG
     // A copy of the GHR as it was at fetch time, to ensure our GHR-rollback
@@ -112,6 +121,9 @@ struct activelist {
     MisPred mispredict;
     MisPred misfetch;
     int wp;
+    int ra_inv;                 // runahead mode: result is INV
+    int ckpt_id;                // branch checkpoint (branch-ckpt.h), or -1
+    int fused;                  // second of a macro-op fused pair
     mem_addr pc;
     i64 mb_epoch, wmb_epoch;
     struct CacheRequest *dmiss_cache_entry;
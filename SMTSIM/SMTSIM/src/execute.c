@@ -35,6 +35,10 @@ Copyright (C) Jack Lo
 #include "smt.h"
 #include "inst.h"
 #include "core-resources.h"
+#include "fetch-policy.h"
+#include "lsq-model.h"
+#include "runahead.h"
+#include "branch-ckpt.h"
 #include "dyn-inst.h"
 #include "context.h"
 #include "callback-queue.h"
@@ -61,12 +65,7 @@ initsched()
 {
     int core_id;
     for (core_id = 0; core_id < CoreCount; core_id++) {
-        CoreResources *core = Cores[core_id];
-        int i;
-        for (i=0;i<core->n_contexts;i++) {
-            core->sched.priority[i] = i;
-            core->sched.key[i] = 0;
-        }
+        fpol_reset(Cores[core_id]->fpol);
     }
 }
 
@@ -97,8 +96,10 @@ reset_nextpc(context * restrict ctx, mem_addr next_pc, int right_path_for_sure)
         clean_cache_queue_mispredict(ctx);
         ctx->stalled_for_prior_fetch = 0;        // don't skip doiaccess()
     }
-    if (right_path_for_sure)
+    if (right_path_for_sure) {
         ctx->wrong_path = ctx->misfetching = MisPred_None;
+        discard_misfetches(ctx);
+    }
 }
 
 
@@ -110,11 +111,9 @@ static void clean_up_misfetch(activelist * restrict brinst)
   reset_nextpc(current, calc_correct_nextpc(brinst),
                (brinst->misfetch == MisPred_CorrectPath));
   current->misfetching = 0;
-/* INVESTIGATE and fix -- only right for prio_inst_count */
-  current->core->sched.key[current->core_thread_id] -= current->num_misfetches;
   current->fetchcycle = cyc;
   current->stalled_for_prior_fetch = 0;
-  current->num_misfetches = 0;
+  discard_misfetches(current);
 
   if (0) {
       // If you make use of commit-group speculation, make sure that you
@@ -125,6 +124,35 @@ static void clean_up_misfetch(activelist * restrict brinst)
 }
 
 
+#define DEBUG_REGS_UNDO 0
+
+// Undo the memory write (if any) made by emulating this instruction.  This
+// is the one part of undo_inst() that recovery from a branch checkpoint
+// still has to do for each squashed instruction.
+static void
+undo_inst_store(context * restrict ctx, const activelist * restrict inst)
+{
+    if (CHECKPOINT_STORES && (inst->mem_flags & SMF_Write) &&
+        !(inst->gen_flags & SGF_SyncAtCommit)) {
+        // Checkpoint store: this seems all well and good, except for
+        // STL_C / STQ_C instructions, in which case we've got trouble.
+        // If the "uni" flavors are in-use, they write their outputs when
+        // emulated, so undo can proceed as usual.  If the non-"uni" flavors
+        // are in-use, SGF_SyncAtCommit will be set and the outputs are not
+        // written until commit/resim, so we shouldn't touch memory here.
+        const inst_undo_info *undo = &inst->undo;
+        int mem_width = SMF_GetWidth(inst->mem_flags);
+        mem_addr eff_addr = inst->destmem;
+        pmem_write_n(ctx->as->pmem, mem_width, eff_addr, undo->dest_mem_val,
+                     PMAF_NoExcept);
+        if (DEBUG_REGS_UNDO) {
+            DEBUGPRINTF(", destmem %s/%d -> %s", fmt_x64(inst->destmem), 
+                        mem_width, fmt_x64(undo->dest_mem_val));
+        }
+    }
+}
+
+
 // Undo the architecturally-visible changes made by this instruction, as
 // well as the speculatively updated branch predictor stuff.  This is the
 // complement to save_instundo_info(); it's in this file so that it at least
@@ -135,8 +163,6 @@ undo_inst(context * restrict ctx, activelist * restrict inst)
     inst_undo_info *undo = &inst->undo;
     int destreg = inst->dest;
 
-#define DEBUG_REGS_UNDO 0
-
     // Reverse the effect of emulating the given instruction; this
     // restores the state saved by save_instundo_info().
 
@@ -163,23 +189,7 @@ undo_inst(context * restrict ctx, activelist * restrict inst)
     }
     ctx->as->R[destreg].i = undo->dest_reg_val;
 
-    if (CHECKPOINT_STORES && (inst->mem_flags & SMF_Write) &&
-        !(inst->gen_flags & SGF_SyncAtCommit)) {
-        // Checkpoint store: this seems all well and good, except for
-        // STL_C / STQ_C instructions, in which case we've got trouble.
-        // If the "uni" flavors are in-use, they write their outputs when
-        // emulated, so undo can proceed as usual.  If the non-"uni" flavors
-        // are in-use, SGF_SyncAtCommit will be set and the outputs are not
-        // written until commit/resim, so we shouldn't touch memory here.
-        int mem_width = SMF_GetWidth(inst->mem_flags);
-        mem_addr eff_addr = inst->destmem;
-        pmem_write_n(ctx->as->pmem, mem_width, eff_addr, undo->dest_mem_val,
-                     PMAF_NoExcept);
-        if (DEBUG_REGS_UNDO) {
-            DEBUGPRINTF(", destmem %s/%d -> %s", fmt_x64(inst->destmem), 
-                        mem_width, fmt_x64(undo->dest_mem_val));
-        }
-    }
+    undo_inst_store(ctx, inst);
 
     if (DEBUG_REGS_UNDO) {
         DEBUGPRINTF("\n");
@@ -249,6 +259,9 @@ undo_inst(context * restrict ctx, activelist * restrict inst)
         }
     }
 
+    if (inst->br_flags && !(inst->gen_flags & SGF_SysCall))
+        ctx->ind_hist = undo->ind_hist;
+
     if (SBF_CondBranch(inst->br_flags)) {
         // We need to reverse the effects of conditional branches on the
         // thread's GHR.  "inst->ghr" was copied from the thread GHR
@@ -263,29 +276,49 @@ undo_inst(context * restrict ctx, activelist * restrict inst)
 #ifdef DEBUG    
         sim_assert(ctx->ghr == undo->undo_ghr);
 #endif
+        bpred_hist_restore(ctx, undo->bp_hist_pos);
     }
 }
 
 
-// Clean up after a squashed instruction, restoring the non-architecturally-
-// visible state to free up resources for future instructions, etc.  Optionally
-// updates "flushed" stats; the branch mispredict recovery code doesn't update
-// these, since wrong-path insts are already accounted for seperately.
+// Release rename-time resources held by squashed instructions on "ctx",
+// totalling "rsrc"; for one instruction, or a whole squashed range at once.
 static void
-cleanup_deadinst(CoreResources * restrict core, context * restrict ctx,
-                 activelist * restrict inst, int update_flushed)
+release_squashed_rsrc(CoreResources * restrict core, context * restrict ctx,
+                      const CtxRsrcTally *rsrc)
+{
+    core->i_registers_freed += rsrc->iregs;
+    core->f_registers_freed += rsrc->fregs;
+    core->lsq_freed += rsrc->lsq;
+    ctx->lsq_freed += rsrc->lsq; // We maintain this to keep stats per ctx
+    ctx->rob_freed_this_cyc += rsrc->rob;
+    if (ctx->as != NULL) {      // For stats, as update_acc_occ_per_inst()
+        ctx->as->extra->iregs_this_cyc -= rsrc->iregs;
+        ctx->as->extra->fregs_this_cyc -= rsrc->fregs;
+        ctx->as->extra->lsqsize_this_cyc -= rsrc->lsq;
+    }
+    update_adapt_mgr_dec_tentative(ctx, ROB, (int) rsrc->rob);
+    update_adapt_mgr_dec_tentative(ctx, LSQ, (int) rsrc->lsq); 
+    update_adapt_mgr_dec_tentative(ctx, IREG, (int) rsrc->iregs); 
+    update_adapt_mgr_dec_tentative(ctx, FREG, (int) rsrc->fregs); 
+    ctx->rsrc_squash_freed.iregs += rsrc->iregs;
+    ctx->rsrc_squash_freed.fregs += rsrc->fregs;
+    ctx->rsrc_squash_freed.lsq += rsrc->lsq;
+    ctx->rsrc_squash_freed.rob += rsrc->rob;
+}
+
+
+// The per-entry part of cleaning up after a squashed instruction, once its
+// resources have been accounted for by release_squashed_rsrc()
+static void
+squash_inst_entry(CoreResources * restrict core, context * restrict ctx,
+                  activelist * restrict inst, int update_flushed)
 {
     sim_assert(!(inst->status & (INVALID | SQUASHED)));
-    core->i_registers_freed += inst->iregs_used;
-    core->f_registers_freed += inst->fregs_used;
-    core->lsq_freed += inst->lsqentry;
-    ctx->lsq_freed += inst->lsqentry; // We maintain this to keep stats per ctx
-    ctx->rob_freed_this_cyc += inst->robentry;
-    update_acc_occ_per_inst(ctx, inst, 1, 2); // For stats
-    update_adapt_mgr_dec_tentative(ctx, ROB, inst->robentry);
-    update_adapt_mgr_dec_tentative(ctx, LSQ, inst->lsqentry); 
-    update_adapt_mgr_dec_tentative(ctx, IREG, inst->iregs_used); 
-    update_adapt_mgr_dec_tentative(ctx, FREG, inst->fregs_used); 
+    if (inst->lsqentry && core->lsqm)
+        lsqm_removed(core->lsqm, ctx, inst);
+    if (inst->ckpt_id >= 0)
+        bckpt_release(core->bckpt, ctx, inst);
     inst->robentry = 0;
     inst->deps = 0;
     inst->numwaiting = 0;
@@ -295,16 +328,9 @@ cleanup_deadinst(CoreResources * restrict core, context * restrict ctx,
     inst->lsqentry = 0;
     inst->regaccs = 0;
 
-    {
-        int is_key = 0;
-#if defined(PRIO_INST_COUNT)
-        is_key = inst->status & FETCHED;
-#elif defined(PRIO_BR_COUNT)
-        is_key = (inst->status & FETCHED) && inst->br_flags;
-#endif
-        if (is_key)
-            core->sched.key[ctx->core_thread_id]--;
-    }
+    if (inst->status & FETCHED)
+        fpol_inst_unfetched(core->fpol, ctx->core_thread_id,
+                            inst->br_flags != 0);
 
     if (update_flushed && !inst->wp) {
         if (!(inst->status & FETCHED))
@@ -324,6 +350,25 @@ cleanup_deadinst(CoreResources * restrict core, context * restrict ctx,
 }
 
 
+// Clean up after a squashed instruction, restoring the non-architecturally-
+// visible state to free up resources for future instructions, etc.  Optionally
+// updates "flushed" stats; the branch mispredict recovery code doesn't update
+// these, since wrong-path insts are already accounted for seperately.
+static void
+cleanup_deadinst(CoreResources * restrict core, context * restrict ctx,
+                 activelist * restrict inst, int update_flushed)
+{
+    CtxRsrcTally rsrc = { 0, 0, 0, 0 };
+    sim_assert(!(inst->status & (INVALID | SQUASHED)));
+    ctx_rsrc_tally_add(&rsrc, inst);
+    release_squashed_rsrc(core, ctx, &rsrc);
+    squash_inst_entry(core, ctx, inst, update_flushed);
+}
+
+
+static void roll_back_fixups(context * restrict ctx, int last_bad_id,
+                             int last_good_id);
+
 // Rolls back instruction emulation state from "last_bad_inst" back to
 // "last_good_inst".  If last_bad_inst == last_good_inst, no insts are flushed,
 // though some corner-case changes may be made.  (Use roll_back_allinsts()
@@ -353,6 +398,15 @@ roll_back_insts(context * restrict ctx,
         }
     }
 
+    roll_back_fixups(ctx, last_bad_id, last_good_id);
+}
+
+
+// Rolls back the state at "last_good_inst" which roll_back_insts() can't
+// get by undoing the instructions after it, once they've been undone
+static void
+roll_back_fixups(context * restrict ctx, int last_bad_id, int last_good_id)
+{
     const activelist * restrict last_good_inst = &ctx->alist[last_good_id];
 
     if (1) {
@@ -363,6 +417,16 @@ roll_back_insts(context * restrict ctx,
             // fix the GHR ourselves.
             ctx->ghr = (last_good_inst->ghr << 1) |
                 last_good_inst->taken_branch;
+            bpred_hist_repair(ctx, last_good_inst->undo.bp_hist_pos,
+                              last_good_inst->pc,
+                              last_good_inst->taken_branch);
+        }
+        if ((last_good_inst->status != INVALID) &&
+            last_good_inst->br_flags &&
+            !(last_good_inst->gen_flags & SGF_SysCall)) {
+            // Likewise for the indirect predictor's history, which all
+            // branches update
+            ind_hist_repair(ctx, last_good_inst);
         }
         if (last_bad_id == ctx->alisttop) {
             // Special case: noops may have been discarded after the most
@@ -395,6 +459,58 @@ roll_back_allinsts(context * restrict ctx,
 }
 
 
+// Roll back the instructions after mispredicted branch "brinst", which holds
+// a checkpoint: rather than undoing each instruction in turn, restore the
+// branch's checkpoint in one step, and release the resources held by the
+// younger instructions in one step (from the checkpoint's rename-time
+// tallies).  The instructions are still marked squashed, and their stores
+// undone; this is the equivalent of
+// roll_back_insts(ctx, ctx->alisttop, brinst->id, 1, 0).
+static void
+roll_back_to_checkpoint(context * restrict ctx, activelist * restrict brinst)
+{
+    CoreResources * restrict core = ctx->core;
+    CtxRsrcTally held;
+#ifdef DEBUG
+    CtxRsrcTally walked = { 0, 0, 0, 0 };
+#endif
+    DEBUGPRINTF("%s: T%d s%d back to checkpointed branch s%d\n",
+                __func__, ctx->id, ctx->alisttop, brinst->id);
+
+    bckpt_squashed_rsrc(core->bckpt, ctx, brinst, &held);
+
+    int wrap_mask = ctx->params.active_list_size - 1;
+    for (int inst_id = ctx->alisttop; inst_id != brinst->id;
+         inst_id = (inst_id - 1) & wrap_mask) {
+        activelist * restrict inst = &ctx->alist[inst_id];
+        if (!inst->undo.undone) {
+            sim_assert(inst->status != INVALID);
+            sim_assert(!(inst->gen_flags & SGF_PipeExclusive));
+            sim_assert(!inst->bmt.spillfill);
+            inst->undo.undone = 1;
+            // Youngest-first, as with undo_inst(), for overlapping stores
+            undo_inst_store(ctx, inst);
+#ifdef DEBUG
+            ctx_rsrc_tally_add(&walked, inst);
+#endif
+            squash_inst_entry(core, ctx, inst, 0);
+            ctx->as->stats.total_insts -= 1 + inst->insts_discarded_before;
+            sim_assert(ctx->as->stats.total_insts >= 0);
+        }
+    }
+#ifdef DEBUG
+    sim_assert(walked.iregs == held.iregs);
+    sim_assert(walked.fregs == held.fregs);
+    sim_assert(walked.lsq == held.lsq);
+    sim_assert(walked.rob == held.rob);
+#endif
+    release_squashed_rsrc(core, ctx, &held);
+
+    bckpt_restore(core->bckpt, ctx, brinst);
+    roll_back_fixups(ctx, ctx->alisttop, brinst->id);
+}
+
+
 // Clean up after a commit group that has had its speculative conditions
 // violated or which was started by mistake.  If "misspec_leader_id" is
 // non-negative, squash intructions back to the start of the group, reset the
@@ -690,8 +806,10 @@ should_flush_for_long_mem(const struct context * restrict ctx)
         inhibit_solo_flush = simcfg_get_bool("Hacking/inhibit_solo_flush");
     }
     sim_assert(ctx->long_mem_stat == LongMem_Detecting);
+    int policy_flush = fpol_flush_on_long_mem(ctx->core->fpol);
     do_flush = (oldest->status & MEMORY) && (ctx->core->n_contexts > 1) &&
-        (((oldest->mem_flags & SMF_Read) && flush_long_loads) ||
+        (((oldest->mem_flags & SMF_Read) &&
+          (flush_long_loads || policy_flush)) ||
          ((oldest->mem_flags & SMF_Write) && flush_long_stores));
     if (do_flush && inhibit_solo_flush) {
         const CoreResources * restrict core = ctx->core;
@@ -798,20 +916,134 @@ static void clean_up_mispredict(activelist *brinst)
               "still-wrong");
   current->fetchcycle = cyc;
   current->stalled_for_prior_fetch = 0;
+  current->cpi.refill = 1;
 
   /* restore from checkpoint */
 
+  BranchCkpt *bckpt = current->core->bckpt;
   if (0) {
       // If you make use of commit-group speculation, be sure to handle
       // mispredicts both before, beginning at, and after the start of your
       // speculative region.  You'll want to roll execution back to to the
       // earliest misspeculation, and call cleanup_commit_group().
+  } else if ((brinst->ckpt_id >= 0) && !bckpt_verify_enabled(bckpt)) {
+      roll_back_to_checkpoint(current, brinst);
+      bckpt_note_recovery(bckpt, 1);
   } else {
       roll_back_insts(current, current->alisttop, brinst->id, 1, 0);
+      if (bckpt)
+          bckpt_note_recovery(bckpt, 0);
+      if (brinst->ckpt_id >= 0)
+          bckpt_verify(bckpt, current, brinst);
   }
+  if (brinst->ckpt_id >= 0)
+      bckpt_release(bckpt, current, brinst);
 
 }
 
+// Squash a correct-path inst and everything after it, and re-fetch starting
+// with that inst.
+static void
+squash_and_refetch(context * restrict ctx, int inst_id)
+{
+    const activelist * restrict inst = &ctx->alist[inst_id];
+    const mem_addr restart_pc = inst->pc;
+    // As in flush_for_halt(): re-fetching the inst itself, so the insts
+    // discarded just before it aren't discarded again
+    const int discarded_insts_skipped_by_restart =
+        inst->insts_discarded_before;
+    int flush_to = alist_add(ctx, inst_id, -1);
+    const int before_oldest = alist_add(ctx, ctx->next_to_commit, -1);
+
+    sim_assert(!(inst->status & (INVALID | SQUASHED)));
+    sim_assert(!inst->wp);
+    // Skip back over squashed (but not yet reaped) entries, so the "last
+    // good" inst handed to roll_back_insts() is one still in flight, or
+    // already gone.
+    while ((flush_to != before_oldest) &&
+           (ctx->alist[flush_to].status & SQUASHED))
+        flush_to = alist_add(ctx, flush_to, -1);
+
+    if (flush_to == ctx->alisttop) {
+        // (the inst is the oldest of a full window)
+        roll_back_allinsts(ctx, 1, 1);
+    } else {
+        roll_back_insts(ctx, ctx->alisttop, flush_to, 1, 1);
+    }
+    reset_nextpc(ctx, restart_pc, 1);
+    ctx->as->stats.total_insts += discarded_insts_skipped_by_restart;
+    ctx->fetchcycle = cyc;
+    ctx->stalled_for_prior_fetch = 0;
+}
+
+
+// Recover from a memory-order violation found by the LSQ model: squash the
+// load which read too early and everything after it, and re-fetch from the
+// load.  (The store-set predictor has already been trained.)
+static void
+clean_up_mem_violation(context * restrict ctx, int load_id)
+{
+    DEBUGPRINTF("T%ds%d memory-order violation; re-fetching from %s\n",
+                ctx->id, load_id, fmt_x64(ctx->alist[load_id].pc));
+    squash_and_refetch(ctx, load_id);
+}
+
+
+// Start runahead mode on the load blocking commit: squash it (its miss
+// carries on without it), checkpoint, and re-fetch from it on the "wrong
+// path".  The app is registered as blocked on the miss, so the cache signals
+// the AppMgr when it returns, however the episode ends.  See runahead.h.
+static void
+enter_runahead(context * restrict ctx)
+{
+    const activelist * restrict load = &ctx->alist[ctx->next_to_commit];
+    const mem_addr load_pc = load->pc, load_addr = load->srcmem;
+
+    sim_assert(ctx->long_mem_stat == LongMem_Detecting);
+    DEBUGPRINTF("T%ds%d entering runahead at %s\n", ctx->id, load->id,
+                fmt_x64(load_pc));
+    if (cache_register_blocked_app(ctx, load->id)) {
+        abort_printf("T%ds%d: couldn't register blocked app for runahead\n",
+                     ctx->id, load->id);
+    }
+    // (by now, the miss has normally reached the level servicing it)
+    ctx->cpi.runahead_cause =
+        context_cpi_dmiss_cause(cache_dmiss_service_level(load));
+    squash_and_refetch(ctx, load->id);
+    runahead_enter(ctx->core->runahead, ctx, load_pc, load_addr);
+    ctx->wrong_path = 1;
+    ctx->long_mem_stat = LongMem_Runahead;
+}
+
+
+// Leave runahead mode: discard everything fetched since entering it, and
+// restart at the blocking load with the checkpointed state.
+static void
+exit_runahead(context * restrict ctx)
+{
+    const int alist_used = context_alist_used(ctx);
+
+    sim_assert(ctx->long_mem_stat == LongMem_Runahead);
+    if (alist_used == ctx->params.active_list_size) {
+        roll_back_allinsts(ctx, 1, 0);
+    } else if (alist_used > 0) {
+        roll_back_insts(ctx, ctx->alisttop,
+                        alist_add(ctx, ctx->next_to_commit, -1), 1, 0);
+    }
+    ctx->noop_discard_run_len = 0;
+    mem_addr restart_pc = runahead_exit(ctx->core->runahead, ctx);
+    DEBUGPRINTF("T%d leaving runahead, re-fetching from %s\n", ctx->id,
+                fmt_x64(restart_pc));
+    reset_nextpc(ctx, restart_pc, 1);
+    ctx->fetchcycle = cyc;
+    ctx->stalled_for_prior_fetch = 0;
+
+    // The AppMgr hears about the miss from the cache, when it returns (see
+    // enter_runahead()); this may be ahead of that, when halting.
+    ctx->long_mem_stat = LongMem_Completing;
+}
+
+
 static void
 clean_up_lock(activelist *syncinst) 
 {
@@ -876,6 +1108,7 @@ delete_squashed_insts(StageQueue *q, int need_to_update_stats_iq_or_fq)
              {
                 update_acc_occ_per_inst(Contexts[inst->thread], inst, 2, 0);
                 update_adapt_mgr_dec_tentative(Contexts[inst->thread], IQ, 1);
+                Contexts[inst->thread]->core->fused_in_intq -= inst->fused;
              }
             stageq_delete(*q, prev);
         }
@@ -915,6 +1148,20 @@ fix_pcs() {
       clean_up_lock(current->lock_failed);
       current->lock_failed = NULL;
     }
+    if (current->core->lsqm && !current->follow_sync &&
+        (current->halting == CtxHalt_NoHalt)) {
+      int viol_load_id = lsqm_take_violation(current->core->lsqm, current);
+      if (viol_load_id >= 0) {
+        mispredict_found = 1;
+        clean_up_mem_violation(current, viol_load_id);
+      }
+    }
+    if ((current->long_mem_stat == LongMem_Runahead) &&
+        ((current->halting != CtxHalt_NoHalt) ||
+         runahead_miss_done(current->core->runahead, current))) {
+      mispredict_found = 1;
+      exit_runahead(current);
+    }
     if ((current->halting == CtxHalt_FullSignaled) ||
         (current->halting == CtxHalt_FastSignaled)) {
         halting_found = 1;
@@ -923,7 +1170,11 @@ fix_pcs() {
         halting_found = 1;
         drain_for_halt(current);
     } else if (current->long_mem_stat == LongMem_Detecting) {
-        if (should_flush_for_long_mem(current)) {
+        if (current->core->runahead &&
+            runahead_should_enter(current->core->runahead, current)) {
+            mispredict_found = 1;
+            enter_runahead(current);
+        } else if (should_flush_for_long_mem(current)) {
             mispredict_found = 1;
             flush_for_long_mem(current);
         } else {
@@ -1052,6 +1303,9 @@ restore_from_sync_cp(activelist *syncinst) {
     const StashData *stash =
         stash_decode_inst(current->as->stash, current->as->npc);
     sim_assert(stash != NULL);
+    // (re-emulation makes any branch checkpoint stale)
+    if (nextinst->ckpt_id >= 0)
+      bckpt_release(current->core->bckpt, current, nextinst);
     emulate_inst_for_sim(current, stash, next);
 
     sim_assert(nextinst->br_flags == stash->br_flags);
@@ -1360,7 +1614,8 @@ execute_for_core(CoreResources *core)
             DEBUGPRINTF("T%ds%d completes execution%s, delay %d (%s)\n",
                         instrn->thread, instrn->id, instrn->wp ? " (wp)":"",
                         instrn->delay, fmt_i64(instrn->donecycle));
-            if ((instrn->mispredict != MisPred_None) &&
+            // (INV runahead branches can't be resolved)
+            if ((instrn->mispredict != MisPred_None) && !instrn->ra_inv &&
                 (!current->mispredict_discovered ||
                  mispredict_applies(current, instrn,
                                     current->mispredict_discovered))) {
@@ -1368,6 +1623,10 @@ execute_for_core(CoreResources *core)
                 DEBUGPRINTF("T%d mispredict(%s) discovered\n", instrn->thread,
                             MisPred_names[instrn->mispredict]);
             }
+            // Correctly-predicted branches don't need their checkpoints
+            if ((instrn->ckpt_id >= 0) &&
+                (instrn->mispredict == MisPred_None))
+                bckpt_release(current->core->bckpt, current, instrn);
             if (instrn->status == EXECUTING)
                 /* ensures that mispredict not recorded twice, in particular
                    by restore_from_sync_cp */
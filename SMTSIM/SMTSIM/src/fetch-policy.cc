@@ -0,0 +1,614 @@
+//
+// SMT fetch policies: per-core thread fetch priority and fetch gating
+//
+// $Id$
+//
+
+const char RCSid_1760000033[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "fetch-policy.h"
+#include "core-resources.h"
+#include "context.h"
+#include "mshr.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+
+
+using std::string;
+using std::vector;
+
+using SimCfg::conf_int;
+
+extern i64 cyc;
+
+
+const char *FetchPolicyType_names[] = {
+    "ICOUNT", "BRCOUNT", "MISSCOUNT", "STALL", "FLUSH", "DCRA", "HILL", NULL
+};
+
+
+namespace {
+
+const i64 MissKeyScale = 1 << 16;       // MISSCOUNT: misses, then ICOUNT
+
+
+struct FetchPolicyConfig {
+    FetchPolicyType policy;
+    int hill_epoch_cyc;
+    int hill_delta;
+
+    NoDefaultCopy nocopy;
+
+public:
+    FetchPolicyConfig(const string& cfg_path);
+    ~FetchPolicyConfig() { }
+};
+
+
+FetchPolicyConfig::FetchPolicyConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    policy = static_cast<FetchPolicyType>
+        (SimCfg::conf_enum(FetchPolicyType_names, cp + "policy"));
+    hill_epoch_cyc = conf_int(cp + "hill_epoch_cyc");
+    if (hill_epoch_cyc < 1) {
+        exit_printf("bad %shill_epoch_cyc (%d)\n", cp.c_str(),
+                    hill_epoch_cyc);
+    }
+    hill_delta = conf_int(cp + "hill_delta");
+    if (hill_delta < 1) {
+        exit_printf("bad %shill_delta (%d)\n", cp.c_str(), hill_delta);
+    }
+}
+
+
+struct ThreadState {
+    int icount;                 // fetched, not yet issued/squashed
+    int brcount;                // ...branches among those
+    int misses;                 // outstanding D-miss blocks (MISSCOUNT/DCRA)
+    int share;                  // DCRA/HILL: icount limit; <0: unlimited
+    bool gated;                 // fetch blocked by policy this cycle
+    bool dirty;                 // key changed since last re-sort
+    i64 gated_cyc;              // stats
+    i64 commits;                // (HILL) this epoch
+    ThreadState()
+        : icount(0), brcount(0), misses(0), share(-1), gated(false),
+          dirty(false), gated_cyc(0), commits(0) { }
+};
+
+} // Anonymous namespace close
+
+
+struct FetchPolicy {
+private:
+    string name_;
+    FetchPolicyConfig conf_;
+    CoreResources *core_;
+    vector<ThreadState> threads_;       // by core_thread_id
+    vector<int> order_;                 // core_thread_ids, by priority
+    vector<int> pos_;                   // inverse of order_
+    int pool_;                          // DCRA/HILL: shared IQ entries
+                                        //   (follows queue reconfiguration)
+
+    // Hill-climbing state
+    vector<int> hill_base_;             // current best partition
+    vector<i64> hill_trial_perf_;       // commits per trial thread
+    int hill_trial_;                    // thread whose share is +delta
+    i64 hill_epoch_end_;
+    i64 hill_rounds_;
+
+    i64 sifts_;                         // stats: priority swaps
+
+    ThreadState& thread(int tid) {
+        if (tid >= intsize(threads_))
+            grow(tid + 1);
+        return threads_[tid];
+    }
+    void grow(int n_threads);
+
+    i64 key(int tid) const {
+        const ThreadState& ts = threads_[tid];
+        switch (conf_.policy) {
+        case FPol_BrCount:
+            return ts.brcount;
+        case FPol_MissCount:
+            return ts.misses * MissKeyScale + ts.icount;
+        default:
+            return ts.icount;
+        }
+    }
+    void touch(int tid) { threads_[tid].dirty = true; }
+    bool sift(int tid);
+    void resort();
+
+    int current_pool() const {
+        return core_->params.queue.int_queue_size +
+            core_->params.queue.float_queue_size;
+    }
+    int running_count() const;
+    void update_gating();
+    void dcra_shares(int running);
+    void hill_fit_base();
+    void hill_set_shares();
+    void hill_epoch_done();
+
+public:
+    FetchPolicy(const char *name__, const char *config_path__,
+                CoreResources *core__);
+    ~FetchPolicy() { }
+
+    void reset();
+    FetchPolicyType policy() const { return conf_.policy; }
+
+    void inst_fetched(int tid, int is_branch) {
+        ThreadState& ts = thread(tid);
+        ts.icount++;
+        if (is_branch)
+            ts.brcount++;
+        touch(tid);
+    }
+    void inst_unfetched(int tid, int is_branch) {
+        insts_unfetched(tid, 1, (is_branch) ? 1 : 0);
+    }
+    void insts_unfetched(int tid, int count, int branch_count) {
+        ThreadState& ts = thread(tid);
+        ts.icount -= count;
+        ts.brcount -= branch_count;
+        sim_assert(ts.icount >= 0);
+        sim_assert(ts.brcount >= 0);
+        touch(tid);
+    }
+    void note_commits(int tid, int count) { thread(tid).commits += count; }
+
+    void cycle();
+
+    int thread_at(int slot) const {
+        // Threads we haven't heard from yet go last, in core order
+        return (slot < intsize(order_)) ? order_[slot] : slot;
+    }
+    bool fetch_ok(int tid) {
+        ThreadState& ts = thread(tid);
+        if (ts.gated)
+            ts.gated_cyc++;
+        return !ts.gated;
+    }
+
+    void reset_stats();
+    void print_stats(FILE *out, const char *pf) const;
+};
+
+
+FetchPolicy::FetchPolicy(const char *name__, const char *config_path__,
+                         CoreResources *core__)
+    : name_(name__), conf_(config_path__), core_(core__),
+      hill_trial_(0), hill_epoch_end_(0), hill_rounds_(0), sifts_(0)
+{
+    pool_ = current_pool();
+}
+
+
+void
+FetchPolicy::grow(int n_threads)
+{
+    int old_n = intsize(threads_);
+    threads_.resize(n_threads);
+    order_.resize(n_threads);
+    pos_.resize(n_threads);
+    for (int i = old_n; i < n_threads; i++) {
+        // New threads start at the lowest priority
+        order_[i] = i;
+        pos_[i] = i;
+        touch(i);
+    }
+    if (conf_.policy == FPol_HillClimb) {
+        hill_base_.assign(n_threads, 0);
+        hill_fit_base();
+        hill_trial_perf_.assign(n_threads, 0);
+        hill_trial_ = 0;
+        hill_epoch_end_ = cyc + conf_.hill_epoch_cyc;
+        hill_set_shares();
+    }
+}
+
+
+void
+FetchPolicy::reset()
+{
+    int n_threads = intsize(threads_);
+    threads_.clear();
+    order_.clear();
+    pos_.clear();
+    if (n_threads)
+        grow(n_threads);
+}
+
+
+// Move "tid" toward its sorted position: up past strictly-greater keys,
+// down past strictly-smaller ones, so equal keys keep their prior order
+// (as the old per-cycle bubble sort did).  Returns true if anything moved.
+bool
+FetchPolicy::sift(int tid)
+{
+    const i64 k = key(tid);
+    int p = pos_[tid];
+    bool moved = false;
+    while ((p > 0) && (key(order_[p - 1]) > k)) {
+        order_[p] = order_[p - 1];
+        pos_[order_[p]] = p;
+        p--;
+        moved = true;
+    }
+    while ((p < (intsize(order_) - 1)) && (k > key(order_[p + 1]))) {
+        order_[p] = order_[p + 1];
+        pos_[order_[p]] = p;
+        p++;
+        moved = true;
+    }
+    order_[p] = tid;
+    pos_[tid] = p;
+    if (moved)
+        sifts_++;
+    return moved;
+}
+
+
+void
+FetchPolicy::resort()
+{
+    // Usually just one or two threads changed, and not by much; repeat the
+    // (cheap) pass over changed threads in case two of them crossed.
+    bool again = true;
+    while (again) {
+        again = false;
+        for (int i = 0; i < intsize(threads_); i++) {
+            if (threads_[i].dirty && sift(i))
+                again = true;
+        }
+    }
+    for (int i = 0; i < intsize(threads_); i++)
+        threads_[i].dirty = false;
+#ifdef DEBUG
+    for (int p = 1; p < intsize(order_); p++)
+        sim_assert(key(order_[p - 1]) <= key(order_[p]));
+#endif
+}
+
+
+int
+FetchPolicy::running_count() const
+{
+    int running = 0;
+    for (int i = 0; i < core_->n_contexts; i++) {
+        if (core_->contexts[i]->running)
+            running++;
+    }
+    return running;
+}
+
+
+// DCRA: each "slow" thread (with pending D-misses) is entitled to its fair
+// share of the pool plus a cut of what the fast threads leave unused,
+// E = (R/T) * (1 + C*F/S), with C = 1/(T+4); fast threads are unlimited.
+void
+FetchPolicy::dcra_shares(int running)
+{
+    int slow = 0;
+    for (int i = 0; i < intsize(threads_); i++) {
+        if (threads_[i].misses > 0)
+            slow++;
+    }
+    int fast = running - slow;
+    double entitled = 0;
+    if (slow > 0) {
+        double c_share = 1.0 / (running + 4);
+        entitled = (static_cast<double>(pool_) / running) *
+            (1.0 + c_share * fast / slow);
+    }
+    for (int i = 0; i < intsize(threads_); i++) {
+        ThreadState& ts = threads_[i];
+        ts.share = (ts.misses > 0) ? static_cast<int>(entitled + 0.5) : -1;
+    }
+}
+
+
+// Scale the base partition to sum to exactly pool_, keeping each share at
+// least 1 (an all-zero base becomes an even split)
+void
+FetchPolicy::hill_fit_base()
+{
+    const int n = intsize(hill_base_);
+    if (n == 0)
+        return;
+    if (pool_ < n) {
+        abort_printf("FetchPolicy %s: IQ pool (%d) smaller than thread "
+                     "count (%d)\n", name_.c_str(), pool_, n);
+    }
+    i64 old_sum = 0;
+    for (int i = 0; i < n; i++)
+        old_sum += hill_base_[i];
+    int sum = 0;
+    for (int i = 0; i < n; i++) {
+        int scaled = (old_sum > 0) ?
+            static_cast<int>((i64) hill_base_[i] * pool_ / old_sum) :
+            pool_ / n;
+        hill_base_[i] = MAX_SCALAR(1, scaled);
+        sum += hill_base_[i];
+    }
+    // Rounding leftovers: shave the largest shares, or hand out round-robin
+    while (sum > pool_) {
+        int big = 0;
+        for (int i = 1; i < n; i++) {
+            if (hill_base_[i] > hill_base_[big])
+                big = i;
+        }
+        hill_base_[big]--;
+        sum--;
+    }
+    for (int i = 0; sum < pool_; i = (i + 1) % n) {
+        hill_base_[i]++;
+        sum++;
+    }
+}
+
+
+void
+FetchPolicy::hill_set_shares()
+{
+    const int n = intsize(threads_);
+    int surplus = 0;                    // entries others have above 1
+    for (int i = 0; i < n; i++) {
+        threads_[i].share = hill_base_[i];
+        if (i != hill_trial_)
+            surplus += hill_base_[i] - 1;
+    }
+    if (n > 1) {
+        // Trial: one thread gets up to +delta, taken one entry at a time
+        // round-robin from the others (never below 1 each), so the shares
+        // still sum to pool_
+        int give = MIN_SCALAR(conf_.hill_delta, surplus);
+        threads_[hill_trial_].share += give;
+        for (int i = (hill_trial_ + 1) % n; give > 0; i = (i + 1) % n) {
+            if ((i != hill_trial_) && (threads_[i].share > 1)) {
+                threads_[i].share--;
+                give--;
+            }
+        }
+    }
+    sim_assert(threads_[hill_trial_].share <= pool_ - (n - 1));
+}
+
+
+void
+FetchPolicy::hill_epoch_done()
+{
+    const int n = intsize(threads_);
+    i64 perf = 0;
+    for (int i = 0; i < n; i++) {
+        perf += threads_[i].commits;
+        threads_[i].commits = 0;
+    }
+    hill_trial_perf_[hill_trial_] = perf;
+    hill_trial_++;
+    if (hill_trial_ >= n) {
+        // End of a round: adopt the best trial partition
+        int best = 0;
+        for (int i = 1; i < n; i++) {
+            if (hill_trial_perf_[i] > hill_trial_perf_[best])
+                best = i;
+        }
+        hill_trial_ = best;
+        hill_set_shares();
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            hill_base_[i] = threads_[i].share;
+            sum += hill_base_[i];
+        }
+        if (sum != pool_) {
+            abort_printf("FetchPolicy %s: hill shares sum to %d, not pool "
+                         "%d\n", name_.c_str(), sum, pool_);
+        }
+        hill_trial_ = 0;
+        hill_rounds_++;
+    }
+    hill_set_shares();
+    hill_epoch_end_ = cyc + conf_.hill_epoch_cyc;
+}
+
+
+void
+FetchPolicy::update_gating()
+{
+    const int running = running_count();
+    for (int i = 0; i < intsize(threads_); i++)
+        threads_[i].gated = false;
+    if (running <= 1)
+        return;
+
+    switch (conf_.policy) {
+    case FPol_Stall:
+        for (int i = 0; i < intsize(threads_); i++) {
+            const context *ctx = core_->contexts[i];
+            threads_[i].gated = (ctx->long_mem_stat == LongMem_Detecting) ||
+                (ctx->long_mem_stat == LongMem_Ignored);
+        }
+        break;
+    case FPol_DCRA:
+        dcra_shares(running);
+        // fall through
+    case FPol_HillClimb:
+        for (int i = 0; i < intsize(threads_); i++) {
+            const ThreadState& ts = threads_[i];
+            threads_[i].gated = (ts.share >= 0) && (ts.icount >= ts.share);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+
+void
+FetchPolicy::cycle()
+{
+    if (intsize(threads_) < core_->n_contexts)
+        grow(core_->n_contexts);
+
+    if ((conf_.policy == FPol_MissCount) || (conf_.policy == FPol_DCRA)) {
+        for (int i = 0; i < intsize(threads_); i++) {
+            int misses = mshr_count_ctx_data_producers(core_->data_mshr,
+                                                       core_->contexts[i]->id);
+            if (misses != threads_[i].misses) {
+                threads_[i].misses = misses;
+                touch(i);
+            }
+        }
+    }
+    if (current_pool() != pool_) {
+        // Queues were resized (e.g. by the reconfiguration controller)
+        pool_ = current_pool();
+        if (conf_.policy == FPol_HillClimb) {
+            hill_fit_base();
+            hill_set_shares();
+        }
+    }
+    if ((conf_.policy == FPol_HillClimb) && (cyc >= hill_epoch_end_))
+        hill_epoch_done();
+
+    resort();
+    update_gating();
+}
+
+
+void
+FetchPolicy::reset_stats()
+{
+    for (int i = 0; i < intsize(threads_); i++)
+        threads_[i].gated_cyc = 0;
+    sifts_ = 0;
+    hill_rounds_ = 0;
+}
+
+
+void
+FetchPolicy::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%sFetch policy %s: priority moves %s", pf,
+            FetchPolicyType_names[conf_.policy], fmt_i64(sifts_));
+    if (conf_.policy == FPol_HillClimb)
+        fprintf(out, " hill rounds %s", fmt_i64(hill_rounds_));
+    fprintf(out, "\n%sFetch policy gated cyc: [", pf);
+    for (int i = 0; i < intsize(threads_); i++)
+        fprintf(out, " %s", fmt_i64(threads_[i].gated_cyc));
+    fprintf(out, " ]");
+    if ((conf_.policy == FPol_HillClimb) || (conf_.policy == FPol_DCRA)) {
+        fprintf(out, " shares (of %d): [", pool_);
+        for (int i = 0; i < intsize(threads_); i++)
+            fprintf(out, " %d", threads_[i].share);
+        fprintf(out, " ]");
+    }
+    fprintf(out, "\n");
+}
+
+
+
+//
+// C interface
+//
+
+FetchPolicy *
+fpol_create(const char *name, const char *config_path,
+            struct CoreResources *core)
+{
+    return new FetchPolicy(name, config_path, core);
+}
+
+void
+fpol_destroy(FetchPolicy *fp)
+{
+    delete fp;
+}
+
+void
+fpol_reset(FetchPolicy *fp)
+{
+    fp->reset();
+}
+
+FetchPolicyType
+fpol_type(const FetchPolicy *fp)
+{
+    return fp->policy();
+}
+
+void
+fpol_inst_fetched(FetchPolicy *fp, int core_thread_id, int is_branch)
+{
+    fp->inst_fetched(core_thread_id, is_branch);
+}
+
+void
+fpol_inst_unfetched(FetchPolicy *fp, int core_thread_id, int is_branch)
+{
+    fp->inst_unfetched(core_thread_id, is_branch);
+}
+
+void
+fpol_insts_unfetched(FetchPolicy *fp, int core_thread_id, int count,
+                     int branch_count)
+{
+    fp->insts_unfetched(core_thread_id, count, branch_count);
+}
+
+void
+fpol_note_commits(FetchPolicy *fp, int core_thread_id, int count)
+{
+    fp->note_commits(core_thread_id, count);
+}
+
+void
+fpol_cycle(FetchPolicy *fp)
+{
+    fp->cycle();
+}
+
+int
+fpol_thread_at(const FetchPolicy *fp, int priority_slot)
+{
+    return fp->thread_at(priority_slot);
+}
+
+int
+fpol_fetch_ok(FetchPolicy *fp, int core_thread_id)
+{
+    return fp->fetch_ok(core_thread_id);
+}
+
+int
+fpol_flush_on_long_mem(const FetchPolicy *fp)
+{
+    return fp->policy() == FPol_Flush;
+}
+
+void
+fpol_reset_stats(FetchPolicy *fp)
+{
+    fp->reset_stats();
+}
+
+void
+fpol_print_stats(const FetchPolicy *fp, void *c_FILE_out, const char *prefix)
+{
+    fp->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
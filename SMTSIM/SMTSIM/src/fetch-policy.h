@@ -0,0 +1,89 @@
+// -*- C++ -*-
+//
+// SMT fetch policies: per-core thread fetch priority and fetch gating
+//
+// $Id$
+//
+
+#ifndef FETCH_POLICY_H
+#define FETCH_POLICY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each core has one of these, selected by its "FetchPolicy" config block;
+// it replaces the old compile-time PRIO_INST_COUNT / PRIO_BR_COUNT switch.
+// The pipeline reports per-thread front-end occupancy through the
+// fpol_inst_*() hooks; once per cycle, fpol_cycle() re-sorts the threads
+// (lowest key first) and re-evaluates any per-thread fetch gating.  Sorting
+// is incremental: only threads whose keys changed are moved.
+//
+// Policies:
+//   ICOUNT     key: instructions fetched but not yet issued (ISCA '96)
+//   BRCOUNT    key: branches fetched but not yet issued
+//   MISSCOUNT  key: outstanding D-cache miss blocks, then ICOUNT
+//   STALL      ICOUNT, but gate a thread while commit is blocked on a
+//              long-latency memory op (see "long_mem_cyc")
+//   FLUSH      ICOUNT, and flush past long-latency memory ops (as
+//              Hacking/flush_past_long_loads), blocking fetch until done
+//   DCRA       ICOUNT, with threads with pending D-misses ("slow") limited
+//              to an entitled share of the issue queues, after Cazorla et
+//              al., MICRO 2004; fast threads are unlimited
+//   HILL       ICOUNT, with each thread limited to a learned share of the
+//              issue queues: each epoch trials one thread's share + delta,
+//              and after a round of trials the best-performing partition
+//              (by committed instructions) is kept; after Choi & Yeung,
+//              ISCA 2006
+// Gating only applies while more than one thread on the core is running.
+
+struct CoreResources;
+
+typedef struct FetchPolicy FetchPolicy;
+
+typedef enum {
+    FPol_ICount, FPol_BrCount, FPol_MissCount, FPol_Stall, FPol_Flush,
+    FPol_DCRA, FPol_HillClimb,
+    FetchPolicyType_last
+} FetchPolicyType;
+extern const char *FetchPolicyType_names[];
+
+
+FetchPolicy *fpol_create(const char *name, const char *config_path,
+                         struct CoreResources *core);
+void fpol_destroy(FetchPolicy *fp);
+
+// Forget all per-thread counts and return to the initial priority order
+void fpol_reset(FetchPolicy *fp);
+FetchPolicyType fpol_type(const FetchPolicy *fp);
+
+// Occupancy hooks (core_thread_id numbering): an instruction entered the
+// front end (fetch or injection), or left it (issue, or squashed unissued)
+void fpol_inst_fetched(FetchPolicy *fp, int core_thread_id, int is_branch);
+void fpol_inst_unfetched(FetchPolicy *fp, int core_thread_id, int is_branch);
+// Bulk form, for misfetch-path instructions (which never reach the active
+// list) leaving together
+void fpol_insts_unfetched(FetchPolicy *fp, int core_thread_id, int count,
+                          int branch_count);
+void fpol_note_commits(FetchPolicy *fp, int core_thread_id, int count);
+
+// Once per cycle, after fetch: update priority order and gating
+void fpol_cycle(FetchPolicy *fp);
+
+// core_thread_id of the thread with the given priority (0: highest)
+int fpol_thread_at(const FetchPolicy *fp, int priority_slot);
+// Whether the thread may fetch this cycle (counts gated cycles)
+int fpol_fetch_ok(FetchPolicy *fp, int core_thread_id);
+// Whether long-latency memory ops should trigger a flush (FLUSH policy)
+int fpol_flush_on_long_mem(const FetchPolicy *fp);
+
+void fpol_reset_stats(FetchPolicy *fp);
+void fpol_print_stats(const FetchPolicy *fp, void *c_FILE_out,
+                      const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FETCH_POLICY_H
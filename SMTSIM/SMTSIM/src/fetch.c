@@ -63,6 +63,11 @@ which contains the following copyright:
 #include "smt.h"
 #include "inst.h"
 #include "core-resources.h"
+#include "fetch-policy.h"
+#include "runahead.h"
+#include "branch-ckpt.h"
+#include "uop-cache.h"
+#include "inst-trace.h"
 #include "mem.h"
 #include "sign-extend.h"
 #include "quirks.h"
@@ -186,8 +191,14 @@ emulate_inst_for_sim(context * restrict ctx, const StashData * restrict st,
     if (CHECKPOINT_CP_INSTS | ctx->wrong_path | ctx->follow_sync)
         save_instundo_info(ctx, st, inst_id);
 
-    emulate_inst(ctx->as, st, &ctx->emu_inst, 
-                 ctx->wrong_path || ctx->follow_sync);
+    if (ctx->as->itrace_in) {
+        itrace_reader_emulate(ctx->as->itrace_in, ctx->as, st,
+                              &ctx->emu_inst, ctx->wrong_path,
+                              ctx->wrong_path || ctx->follow_sync);
+    } else {
+        emulate_inst(ctx->as, st, &ctx->emu_inst, 
+                     ctx->wrong_path || ctx->follow_sync);
+    }
 
     if (st->gen_flags & SGF_SysCall)
         ctx->stats.total_syscalls++;
@@ -207,14 +218,16 @@ get_next_thread(CoreResources *core)
 
     while (core->sched.priorityslot < core->n_contexts) {
         ctx = core->contexts[
-            core->sched.priority[core->sched.priorityslot++]];
+            fpol_thread_at(core->fpol, core->sched.priorityslot++)];
             
         /* this thread ok if it is running, not waiting for a cache miss,
-           not blocked for some reason, and will not cause a bank conflict
-           with a thread already accessed this cycle */
+           not blocked for some reason, not held back by the fetch policy,
+           and will not cause a bank conflict with a thread already
+           accessed this cycle */
             
         if (!ctx->running || ctx->sync_lock_blocked ||
-            (ctx->fetchcycle > cyc) || ctx->draining)
+            (ctx->fetchcycle > cyc) || ctx->draining ||
+            !fpol_fetch_ok(core->fpol, ctx->core_thread_id))
             continue;
         
         LongAddr fetch_addr;
@@ -404,6 +417,7 @@ sim_branch(context * restrict ctx, activelist * restrict inst)
     }
 
     mem_addr predict_target;
+    int targ_slow = 0;          // target from L1 BTB/ITTAGE: fetch bubble
     {
         if (is_from_tc) {
             // Always use the TC target, skip the BTB lookup for TC hits.
@@ -413,7 +427,7 @@ sim_branch(context * restrict ctx, activelist * restrict inst)
             int is_jump = !(br_flags & (SBF_Br_Cond | SBF_StaticTargDisp |
                                         SBF_RS_Pop | SBF_RS_PopPush));
             predict_target  = btblookup(ctx, ctx->pc, correct_target, 
-                                        correct_taken, is_jump);
+                                        correct_taken, is_jump, &targ_slow);
         } else {
             if (CONDBRANCH_WP_MAGIC_BTB && SBF_CondBranch(br_flags))
                 predict_target = correct_target;
@@ -423,7 +437,12 @@ sim_branch(context * restrict ctx, activelist * restrict inst)
                 // the BTB
                 predict_target = 1;
             else
-                predict_target = get_btblookup(ctx, ctx->pc);
+                predict_target = get_btblookup(ctx, ctx->pc, &targ_slow);
+        }
+        if (!is_from_tc && SBF_IndirectBranch(br_flags) &&
+            !SBF_ReadsRetStack(br_flags)) {
+            predict_target = indirect_predict(ctx, ctx->pc, predict_target,
+                                              &targ_slow);
         }
     }
 
@@ -487,6 +506,7 @@ sim_branch(context * restrict ctx, activelist * restrict inst)
         inst->ghr = ctx->ghr;
         // roll_back_insts() may also update ctx->ghr
         ctx->ghr = (ctx->ghr << 1) | ghr_taken;
+        inst->undo.bp_hist_pos = bpred_hist_push(ctx, ctx->pc, ghr_taken);
     } else {    
         sim_assert(!is_from_tc || tc_taken);    // If in TC, must be "taken"
         predict_taken = 1;
@@ -564,11 +584,22 @@ sim_branch(context * restrict ctx, activelist * restrict inst)
     }
 
     // We're re-steering the AppState here, possibly onto a wrong path!
-    if (tc_nextpc)
+    if (tc_nextpc) {
         ctx->as->npc = tc_nextpc;
-    else
+    } else {
         ctx->as->npc = (use_target_info & predict_taken &
                        (predict_target != 0)) ? predict_target : (ctx->pc + 4);
+        if (targ_slow && targ_present && (ctx->as->npc != ctx->pc + 4) &&
+            ctx->core->btb_l1_extra_lat) {
+            // Redirect waits on the L1 BTB (or ITTAGE): hold off the next
+            // fetch for this context.
+            i64 resume_cyc = cyc + 1 + ctx->core->btb_l1_extra_lat;
+            if (ctx->fetchcycle < resume_cyc)
+                ctx->fetchcycle = resume_cyc;
+            ctx->core->btb_slow_redirects++;
+        }
+    }
+    ind_hist_push(ctx, inst, predict_taken, ctx->as->npc);
 
     inst->taken_branch = ctx->emu_inst.taken_branch;
     inst->br_target = ctx->emu_inst.br_target;
@@ -628,9 +659,14 @@ resim_branch(context * restrict ctx, activelist * restrict inst)
     }
 
     // Re-do the undone branch effects
+    ind_hist_push(ctx, inst, inst->taken_predict,
+                  (inst->taken_predict && inst->target_predict) ?
+                  inst->target_predict : (inst->pc + 4));
     if (SBF_CondBranch(br_flags)) {
         inst->ghr = ctx->ghr;
         ctx->ghr = (ctx->ghr << 1) | inst->taken_predict;
+        inst->undo.bp_hist_pos = bpred_hist_push(ctx, inst->pc,
+                                                 inst->taken_predict);
     }
     if (SBF_ReadsRetStack(br_flags))
         (will_commit) ? rs_pop(ctx, ctx->emu_inst.br_target) : wp_rs_pop(ctx);
@@ -819,16 +855,6 @@ setup_instruction(context * restrict current, const StashData * restrict stash)
         return 0;
     }
 
-#ifdef PRIO_INST_COUNT
-    core->sched.key[current->core_thread_id]++;
-#else
-#ifdef PRIO_BR_COUNT
-    if (stash->branch || stash->cond_branch) {
-        core->sched.key[current->core_thread_id]++;
-    }
-#endif
-#endif
-
 /* A misfetch is a BTB miss that will be fixed (and predicted
     correctly) when the branch hits the decode stage.  We treat
     instructions after a misfetch differently than instructions
@@ -837,9 +863,14 @@ setup_instruction(context * restrict current, const StashData * restrict stash)
     don't really care what they are.
  */
 
+    fpol_inst_fetched(core->fpol, current->core_thread_id,
+                      stash->br_flags != 0);
+
     if (current->misfetching) {
         misfetchtotal++;
         current->num_misfetches++;
+        if (stash->br_flags)
+            current->num_misfetch_brs++;
         current->alisttop = (current->alisttop - 1) & 
             (current->params.active_list_size - 1);
         return 0;
@@ -878,6 +909,8 @@ setup_instruction(context * restrict current, const StashData * restrict stash)
     top->status = FETCHED;
     top->mispredict = MisPred_None;
     top->misfetch = MisPred_None;
+    top->ckpt_id = -1;
+    top->fused = 0;
     top->deps = 0;
     top->numwaiting = 0;
     top->wait_sync = 0;
@@ -947,9 +980,18 @@ setup_instruction(context * restrict current, const StashData * restrict stash)
         top->src2_waitingfor = NULL;
     }
 
+    if (current->long_mem_stat == LongMem_Runahead) {
+        runahead_inst_fetched(current->core->runahead, current, top);
+    } else {
+        top->ra_inv = 0;
+    }
+
     if (!IS_ZERO_REG(top->dest))
         current->last_writer[top->dest] = current->alisttop;
 
+    if (current->core->bckpt && top->br_flags)
+        bckpt_inst_fetched(current->core->bckpt, current, top);
+
     if (current->follow_sync) {
         if ((top->fu == INTLDST || top->fu == SYNCH))
             top->wait_sync = 1;
@@ -980,34 +1022,32 @@ setup_instruction(context * restrict current, const StashData * restrict stash)
 }
 
 
-/* The key[] structure is changed at various places in the code.
-   This mechanism implements the ICOUNT fetch mechanism from 
-   the ISCA96 smt paper, if PRIO_INST_COUNT defined.
+/* Misfetch-path instructions never reach the active list, but they count
+   toward the fetch policy's occupancy (as they always have for ICOUNT)
+   until the misfetch is resolved or abandoned; this drops them.
+   */
+void
+discard_misfetches(context *ctx)
+{
+    if (ctx->num_misfetches) {
+        fpol_insts_unfetched(ctx->core->fpol, ctx->core_thread_id,
+                             ctx->num_misfetches, ctx->num_misfetch_brs);
+    }
+    ctx->num_misfetches = 0;
+    ctx->num_misfetch_brs = 0;
+}
+
+
+/* Thread fetch priorities are kept by each core's FetchPolicy, from
+   counts updated at various places in the code; by default, this
+   implements the ICOUNT fetch mechanism from the ISCA96 smt paper.
    */
 
 void calculate_priority()
 {
     int core_id;
-    for (core_id = 0; core_id < CoreCount; core_id++) {
-        CoreResources *core = Cores[core_id];
-        const int * restrict key = core->sched.key;
-        int * restrict priority = core->sched.priority;
-        
-        int changing = 1, j;
-        for (j=1;j<core->n_contexts && changing;j++) {
-            int i;
-            changing = 0;
-            for (i=0;i<core->n_contexts-j;i++) {
-                if (key[priority[i]] > key[priority[i+1]]) {
-                    int temp;
-                    changing = 1;
-                    temp = priority[i];
-                    priority[i] = priority[i+1];
-                    priority[i+1] = temp;
-                }
-            }
-        }
-    }
+    for (core_id = 0; core_id < CoreCount; core_id++)
+        fpol_cycle(Cores[core_id]->fpol);
 }
 
 
@@ -1063,6 +1103,7 @@ fetch_for_core(CoreResources *core)
     int imemdelay;
     context *ctx;
     int tc_rename_bypass_clear;
+    int uopc_delivered_total = 0;
 
     // Shift instructions from fetch2...N to the next stage 
     // (fetch3...N, decode1), if clear.
@@ -1084,7 +1125,8 @@ fetch_for_core(CoreResources *core)
         return;
     }
 
-    if (tc_skip_to_rename) {
+    // (Also gates the uop cache, which likewise delivers to rename1.)
+    if (tc_skip_to_rename || core->uopc) {
         int ren1 = core->stage.rename1;
         int stage;
         for (stage = 0; stage <= ren1; stage++)
@@ -1105,6 +1147,8 @@ fetch_for_core(CoreResources *core)
         // new fetch operation, or 2) resuming fetch after a prior fetch stall
         // has completed; we use the stalled_for_prior_fetch flag to
         // distinguish.
+        int from_uopc = 0;
+        mem_addr uopc_line_pc = 0;
         if (!ctx->stalled_for_prior_fetch) {
             // note when we're starting a new fetch attempt
             ctx->last_fetch_begin = cyc;
@@ -1118,6 +1162,12 @@ fetch_for_core(CoreResources *core)
         } else if (ctx->tc.avail || 
                    (use_trace_cache && tcache_fetch(core, ctx))) {
             // Hit in trace cache
+        } else if (core->uopc && tc_rename_bypass_clear &&
+                   uopc_lookup(core->uopc, ctx->as->app_master_id,
+                               ctx->as->npc)) {
+            // Hit in uop cache: no I-cache access, and no decode
+            from_uopc = 1;
+            uopc_line_pc = ctx->as->npc;
         } else {
             imemdelay = doiaccess((mem_addr) ctx->as->npc, ctx);
             if (imemdelay == MEMDELAY_LONG) {
@@ -1172,13 +1222,22 @@ fetch_for_core(CoreResources *core)
                     abort_thread_fetch(ctx, old_pc);
                     break;
                 }
+            } else if (from_uopc &&
+                       !uopc_covers(core->uopc, ctx->as->app_master_id,
+                                    uopc_line_pc, pc)) {
+                // Past what the uop cache line holds; back to the I-cache
+                // next cycle
+                abort_thread_fetch(ctx, old_pc);
+                break;
             }
 
             const StashData * restrict stash = 
                 stash_decode_inst(ctx->as->stash, pc);
 
             if (!stash) {
-                if (context_alist_used(ctx) == 1) {
+                // (runahead mode may follow an INV branch anywhere)
+                if ((context_alist_used(ctx) == 1) &&
+                    (ctx->long_mem_stat != LongMem_Runahead)) {
                     err_printf("T%ds%d/A%d cyc %s: oh snap, invalid "
                                "fetch PC %s on an empty pipe!\n",
                                ctx->id, ctx->alisttop, ctx->as->app_id,
@@ -1203,7 +1262,16 @@ fetch_for_core(CoreResources *core)
                 }
             }
 
-            if (stash->gen_flags & SGF_PipeExclusive) {
+            if ((stash->gen_flags & SGF_PipeExclusive) &&
+                (ctx->long_mem_stat == LongMem_Runahead)) {
+                // Exclusive insts (e.g. syscalls) can't be undone, so
+                // runahead stops here until the episode ends.
+                DEBUGPRINTF("T%i runahead blocked at exclusive inst\n",
+                            ctx->id);
+                ctx->draining = 1;
+                abort_thread_fetch(ctx, old_pc);
+                break;
+            } else if (stash->gen_flags & SGF_PipeExclusive) {
                 /*
                  * We've clairvoyantly determined that the next instruction
                  * (not fetched yet) requires exclusive access to the
@@ -1226,6 +1294,16 @@ fetch_for_core(CoreResources *core)
                 }
             }
 
+            if (core->bckpt && stash->br_flags &&
+                bckpt_fetch_stall(core->bckpt, ctx, pc, stash->br_flags,
+                                  stash->gen_flags)) {
+                // Low-confidence branch, and no checkpoint free for it
+                DEBUGPRINTF("T%i waiting for a branch checkpoint\n",
+                            ctx->id);
+                abort_thread_fetch(ctx, old_pc);
+                break;
+            }
+
             SmtDISASSEMBLE(ctx->id, ctx->alisttop, pc, 1);
 
             /* instructions are emulated in the fetch stage instead of,
@@ -1246,6 +1324,10 @@ fetch_for_core(CoreResources *core)
                 activelist *inst = &ctx->alist[ctx->alisttop];
                 if (ctx->tc.avail && tc_skip_to_rename) {
                     stageq_enqueue(core->stage.s[core->stage.rename1], inst);
+                } else if (from_uopc) {
+                    stageq_enqueue(core->stage.s[core->stage.rename1], inst);
+                    uopc_delivered(core->uopc);
+                    uopc_delivered_total++;
                 } else {
                     stageq_enqueue(core->stage.s[0], inst);
                 }
@@ -1260,6 +1342,8 @@ fetch_for_core(CoreResources *core)
             ctx->fthiscycle++;
         }
     }
+    if (uopc_delivered_total)
+        decode_bypassed_group(core, &core->stage.s[core->stage.rename1]);
     core->sched.priorityslot = 0;
 }
 
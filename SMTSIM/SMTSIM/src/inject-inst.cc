@@ -16,6 +16,7 @@ const char RCSid_1113588013[] =
 #include "sys-types.h"
 #include "inject-inst.h"
 #include "core-resources.h"
+#include "fetch-policy.h"
 #include "app-state.h"
 #include "dyn-inst.h"
 #include "context.h"
@@ -62,6 +63,9 @@ inject_alloc(struct context * restrict ctx)
     top->app_inst_num = -1;
     top->insts_discarded_before = 0;
     top->wp = ctx->wrong_path;
+    top->ra_inv = 0;
+    top->ckpt_id = -1;
+    top->fused = 0;
 
     top->tc.base_pc = 0;
     handle_commit_group_fetch(ctx, top, NULL);
@@ -114,15 +118,7 @@ inject_inst_prep(context * restrict ctx, activelist * restrict inst)
     if (debug) 
         dump_inject_inst(ctx, inst);
 
-#ifdef PRIO_INST_COUNT
-    core->sched.key[ctx->core_thread_id]++;
-#else
-#ifdef PRIO_BR_COUNT
-    if (inst->br_flags) {
-        core->sched.key[ctx->core_thread_id]++;
-    }
-#endif
-#endif
+    fpol_inst_fetched(core->fpol, ctx->core_thread_id, inst->br_flags != 0);
 
     inst->fetchcycle = cyc;
 
@@ -0,0 +1,797 @@
+//
+// Committed-instruction trace capture and trace-driven replay
+//
+// $Id$
+//
+
+const char RCSid_1760000039[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <deque>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+
+#include "sim-assert.h"
+#include "hash-map.h"
+#include "sys-types.h"
+#include "inst-trace.h"
+#include "app-state.h"
+#include "prog-mem.h"
+#include "stash.h"
+#include "emulate.h"
+#include "dyn-inst.h"
+#include "inst.h"
+#include "sign-extend.h"
+#include "main.h"
+#include "work-queue.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "context.h"
+
+
+#define USE_HASHMAP_NOT_MAP             (1 && HAVE_HASHMAP)
+
+
+using std::deque;
+using std::set;
+using std::string;
+
+
+namespace {
+
+// File layout: TraceMagic, varint page size, then a sequence of records:
+//
+//   'C' <varint page#> <page bytes>    code page, before its first use
+//   0x80|flags [fields...]             one committed inst (RecFlags)
+//   'X' <zz pc delta> <zz exit code>   exit syscall; end of trace
+//
+// Inst fields, present as flagged, in this order: the PC (as a delta from
+// the previous inst's fall-through/taken target), the target of a taken
+// indirect branch (delta from its PC), then source and dest effective
+// addresses (each a delta from the last EA).  "zz" deltas and all other
+// integers are zigzag/unsigned LEB128 varints.
+const char TraceMagic[] = "SMTITRC1";
+const int TraceMagicLen = 8;
+const int PageBits = 12;
+const int PageBytes = 1 << PageBits;
+
+// Largest forward PC skip which may be a run of discarded static no-ops,
+// rather than a redirect; the writer includes the code pages for such gaps
+const int MaxNoopGapBytes = 256;
+
+enum {
+    Rec_CodePage = 'C',
+    Rec_Exit = 'X',
+    Rec_InstTag = 0x80
+};
+
+enum RecFlags {
+    RF_Taken = 0x1,
+    RF_Pc = 0x2,
+    RF_Target = 0x4,
+    RF_SrcMem = 0x8,
+    RF_DestMem = 0x10,
+    RF_All = 0x1f
+};
+
+
+u64
+zigzag(i64 val)
+{
+    return (static_cast<u64>(val) << 1) ^ static_cast<u64>(val >> 63);
+}
+
+i64
+unzigzag(u64 val)
+{
+    return static_cast<i64>(val >> 1) ^ -static_cast<i64>(val & 1);
+}
+
+void
+put_varint(std::ostream& out, u64 val)
+{
+    while (val >= 0x80) {
+        out.put(static_cast<char>((val & 0x7f) | 0x80));
+        val >>= 7;
+    }
+    out.put(static_cast<char>(val));
+}
+
+bool
+get_varint(std::istream& in, u64 *val_ret)
+{
+    u64 val = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int ch = in.get();
+        if (ch == EOF)
+            return false;
+        val |= static_cast<u64>(ch & 0x7f) << shift;
+        if (!(ch & 0x80)) {
+            *val_ret = val;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+mem_addr
+static_br_target(const StashData *st, mem_addr pc)
+{
+    // Same as calc_br_targ() in emulate_inst()
+    i32 disp = INST_BRANCH_DISP(st->inst);
+    disp = (SEXT_TO_i64(disp, 21) << 2) + 4;
+    return pc + disp;
+}
+
+
+struct TraceRec {
+    mem_addr pc;
+    mem_addr npc;               // Next correct-path PC
+    mem_addr br_target;         // Only valid if taken
+    mem_addr srcmem, destmem;
+    bool taken;
+    bool is_exit;
+    bool is_noop;               // Filled in for a discarded static no-op
+
+    TraceRec() : pc(0), npc(0), br_target(0), srcmem(0), destmem(0),
+                 taken(false), is_exit(false), is_noop(false) { }
+};
+
+
+// Most recent correct-path behavior at a PC, for wrong-path approximation
+struct PcHistory {
+    bool taken;
+    mem_addr br_target;
+    mem_addr ea;
+};
+
+#if USE_HASHMAP_NOT_MAP
+    typedef hash_map<mem_addr, PcHistory, StlHashMemAddr> PcHistMap;
+#else
+    typedef std::map<mem_addr, PcHistory> PcHistMap;
+#endif
+
+} // Anonymous namespace close
+
+
+struct InstTraceWriter {
+private:
+    string file_name_;
+    std::ostream *out_;
+    mem_addr expect_pc_;        // Where the previous inst went next
+    mem_addr last_ea_;
+    set<mem_addr> pages_written_;
+    mem_addr last_page_;        // Most recent page known to be written
+    InstTraceStats *stats_;     // (capture fields)
+
+    NoDefaultCopy nocopy;
+
+    void put_page(const AppState *as, mem_addr page);
+    void need_page(const AppState *as, mem_addr pc) {
+        mem_addr page = pc >> PageBits;
+        if (page != last_page_) {
+            if (!pages_written_.count(page))
+                put_page(as, page);
+            last_page_ = page;
+        }
+    }
+    void need_pc(const AppState *as, mem_addr pc);
+
+public:
+    InstTraceWriter(const string& file_name__, InstTraceStats *stats__);
+    ~InstTraceWriter();
+
+    void commit(const AppState *as, const activelist *inst);
+    void exit(const AppState *as, mem_addr pc, i64 exit_code);
+    void flush() { out_->flush(); }
+};
+
+
+InstTraceWriter::InstTraceWriter(const string& file_name__,
+                                 InstTraceStats *stats__)
+    : file_name_(file_name__), out_(0), expect_pc_(0), last_ea_(0),
+      last_page_(~U64_LIT(0)), stats_(stats__)
+{
+    if (!(out_ = open_ostream_auto_comp(file_name_.c_str()))) {
+        exit_printf("InstTrace: couldn't create trace file \"%s\"\n",
+                    file_name_.c_str());
+    }
+    out_->write(TraceMagic, TraceMagicLen);
+    put_varint(*out_, PageBytes);
+}
+
+
+InstTraceWriter::~InstTraceWriter()
+{
+    delete out_;
+}
+
+
+void
+InstTraceWriter::put_page(const AppState *as, mem_addr page)
+{
+    unsigned char bytes[PageBytes];
+    mem_addr base = page << PageBits;
+    for (int offs = 0; offs < PageBytes; offs += 4) {
+        u32 word = 0;
+        if (pmem_access_ok(as->pmem, base + offs, 4, PMAF_R))
+            word = pmem_read_32(as->pmem, base + offs, PMAF_NoExcept);
+        bytes[offs] = word & 0xff;
+        bytes[offs + 1] = (word >> 8) & 0xff;
+        bytes[offs + 2] = (word >> 16) & 0xff;
+        bytes[offs + 3] = (word >> 24) & 0xff;
+    }
+    out_->put(Rec_CodePage);
+    put_varint(*out_, page);
+    out_->write(reinterpret_cast<const char *>(bytes), PageBytes);
+    pages_written_.insert(page);
+    stats_->pages_written++;
+}
+
+
+// Make sure the code for "pc" is in the trace, along with any skipped-over
+// no-ops leading up to it
+void
+InstTraceWriter::need_pc(const AppState *as, mem_addr pc)
+{
+    if ((pc > expect_pc_) && ((pc - expect_pc_) <= MaxNoopGapBytes)) {
+        for (mem_addr gap_pc = expect_pc_; gap_pc < pc; gap_pc += 4)
+            need_page(as, gap_pc);
+    }
+    need_page(as, pc);
+}
+
+
+void
+InstTraceWriter::commit(const AppState *as, const activelist *inst)
+{
+    mem_addr pc = inst->pc;
+    int taken = inst->taken_branch;
+    unsigned flags = 0;
+
+    need_pc(as, pc);
+
+    if (taken)
+        flags |= RF_Taken;
+    if (pc != expect_pc_)
+        flags |= RF_Pc;
+    if (taken && !SBF_StaticTarget(inst->br_flags))
+        flags |= RF_Target;
+    if (inst->mem_flags & SMF_Read)
+        flags |= RF_SrcMem;
+    if (inst->mem_flags & SMF_Write)
+        flags |= RF_DestMem;
+
+    out_->put(static_cast<char>(Rec_InstTag | flags));
+    if (flags & RF_Pc)
+        put_varint(*out_, zigzag(pc - expect_pc_));
+    if (flags & RF_Target)
+        put_varint(*out_, zigzag(inst->br_target - pc));
+    if (flags & RF_SrcMem) {
+        put_varint(*out_, zigzag(inst->srcmem - last_ea_));
+        last_ea_ = inst->srcmem;
+    }
+    if (flags & RF_DestMem) {
+        put_varint(*out_, zigzag(inst->destmem - last_ea_));
+        last_ea_ = inst->destmem;
+    }
+
+    expect_pc_ = (taken) ? inst->br_target : (pc + 4);
+    stats_->insts_written++;
+}
+
+
+void
+InstTraceWriter::exit(const AppState *as, mem_addr pc, i64 exit_code)
+{
+    need_pc(as, pc);
+    out_->put(Rec_Exit);
+    put_varint(*out_, zigzag(pc - expect_pc_));
+    put_varint(*out_, zigzag(exit_code));
+    expect_pc_ = pc + 4;
+    stats_->insts_written++;
+    out_->flush();
+}
+
+
+
+struct InstTraceReader {
+private:
+    string file_name_;
+    std::istream *in_;
+    AppState *as_;
+
+    // One record of lookahead, so its code page is mapped before the fetch
+    // which needs it is decoded
+    bool have_next_;
+    TraceRec next_;
+    i64 exit_code_;             // Valid when next_.is_exit
+    mem_addr expect_pc_;
+    mem_addr last_ea_;
+    set<mem_addr> pages_mapped_;
+
+    // Correct-path records not yet committed, by inst number (AppState
+    // "total_insts" at fetch)
+    deque<TraceRec> window_;
+    i64 window_base_;           // Inst number of window_.front()
+
+    PcHistMap pc_hist_;
+    i64 records_read_;
+    i64 noops_filled_;
+    i64 wp_insts_;
+    bool warned_eof_;
+
+    NoDefaultCopy nocopy;
+
+    void corrupt(const char *what) const;
+    void diverged(mem_addr pc, const char *what) const;
+    void map_page(mem_addr page, const unsigned char *bytes);
+    void read_next();
+    bool is_noop_gap(mem_addr from_pc, mem_addr to_pc) const;
+    TraceRec take_next();
+    TraceRec fake_exit(mem_addr pc);
+    void note_history(const TraceRec& rec);
+    const TraceRec& correct_path_rec(mem_addr pc, const StashData *st);
+    void approx_wrong_path(mem_addr pc, const StashData *st,
+                           EmuInstState *emu_state);
+    void do_exit();
+
+public:
+    InstTraceReader(AppState *as__, const string& file_name__);
+    ~InstTraceReader();
+
+    void emulate(const StashData *st, EmuInstState *emu_state,
+                 int wrong_path, int speculative);
+    void skip(i64 inst_count);
+    void committed(i64 app_inst_num) {
+        while (!window_.empty() && (window_base_ <= app_inst_num)) {
+            window_.pop_front();
+            window_base_++;
+        }
+    }
+    void add_stats(InstTraceStats *dest) const {
+        dest->records_read += records_read_;
+        dest->noops_filled += noops_filled_;
+        dest->wp_insts += wp_insts_;
+    }
+};
+
+
+InstTraceReader::InstTraceReader(AppState *as__, const string& file_name__)
+    : file_name_(file_name__), in_(0), as_(as__), have_next_(false),
+      exit_code_(0), expect_pc_(0), last_ea_(0), window_base_(0),
+      records_read_(0), noops_filled_(0), wp_insts_(0), warned_eof_(false)
+{
+    if (!(in_ = open_istream_auto_decomp(file_name_.c_str()))) {
+        exit_printf("InstTrace: couldn't open trace file \"%s\"\n",
+                    file_name_.c_str());
+    }
+    char magic[TraceMagicLen];
+    u64 page_bytes;
+    if (!in_->read(magic, TraceMagicLen) ||
+        memcmp(magic, TraceMagic, TraceMagicLen)) {
+        exit_printf("InstTrace: \"%s\" is not an instruction trace\n",
+                    file_name_.c_str());
+    }
+    if (!get_varint(*in_, &page_bytes) || (page_bytes != PageBytes)) {
+        exit_printf("InstTrace: \"%s\": unsupported page size\n",
+                    file_name_.c_str());
+    }
+
+    window_base_ = as_->stats.total_insts;
+    read_next();
+    if (!have_next_) {
+        exit_printf("InstTrace: \"%s\" holds no instructions\n",
+                    file_name_.c_str());
+    }
+    as_->npc = next_.pc;
+    as_->seg_info.entry_point = next_.pc;
+}
+
+
+InstTraceReader::~InstTraceReader()
+{
+    delete in_;
+}
+
+
+void
+InstTraceReader::corrupt(const char *what) const
+{
+    exit_printf("InstTrace: \"%s\": corrupt trace (%s) after %s records\n",
+                file_name_.c_str(), what, fmt_i64(records_read_));
+}
+
+
+void
+InstTraceReader::diverged(mem_addr pc, const char *what) const
+{
+    abort_printf("InstTrace: A%d correct-path fetch diverged from trace "
+                 "\"%s\" at inst %s, PC %s: %s\n", as_->app_id,
+                 file_name_.c_str(), fmt_i64(as_->stats.total_insts),
+                 fmt_x64(pc), what);
+}
+
+
+void
+InstTraceReader::map_page(mem_addr page, const unsigned char *bytes)
+{
+    mem_addr base = page << PageBits;
+    if (pages_mapped_.count(page)) {
+        pmem_chmod(as_->pmem, base, PMAF_RW);
+    } else if (pmem_map_new(as_->pmem, PageBytes, base, PMAF_RW,
+                            PMCF_None)) {
+        exit_printf("InstTrace: couldn't map code page at %s\n",
+                    fmt_x64(base));
+    }
+    pmem_write_memcpy(as_->pmem, base, bytes, PageBytes, PMAF_None);
+    pmem_chmod(as_->pmem, base, PMAF_RX);
+    pages_mapped_.insert(page);
+}
+
+
+// Read up to the next inst (or exit) record, mapping any code pages along
+// the way; clears have_next_ at end-of-file.
+void
+InstTraceReader::read_next()
+{
+    have_next_ = false;
+    if (next_.is_exit)
+        return;                         // Nothing follows an exit
+
+    for (;;) {
+        int tag = in_->get();
+        u64 val = 0;
+        if (tag == EOF)
+            return;
+        if (tag == Rec_CodePage) {
+            unsigned char bytes[PageBytes];
+            if (!get_varint(*in_, &val) ||
+                !in_->read(reinterpret_cast<char *>(bytes), PageBytes))
+                corrupt("short code page");
+            map_page(val, bytes);
+            continue;
+        }
+
+        next_ = TraceRec();
+        if (tag == Rec_Exit) {
+            if (!get_varint(*in_, &val))
+                corrupt("short exit");
+            next_.pc = expect_pc_ + unzigzag(val);
+            if (!get_varint(*in_, &val))
+                corrupt("short exit");
+            exit_code_ = unzigzag(val);
+            next_.is_exit = true;
+        } else if ((tag & Rec_InstTag) && !(tag & ~(Rec_InstTag | RF_All))) {
+            unsigned flags = tag & RF_All;
+            next_.pc = expect_pc_;
+            if (flags & RF_Pc) {
+                if (!get_varint(*in_, &val))
+                    corrupt("short inst");
+                next_.pc += unzigzag(val);
+            }
+            next_.taken = (flags & RF_Taken) != 0;
+            if (flags & RF_Target) {
+                if (!get_varint(*in_, &val))
+                    corrupt("short inst");
+                next_.br_target = next_.pc + unzigzag(val);
+            } else if (next_.taken) {
+                const StashData *st = stash_decode_inst(as_->stash, next_.pc);
+                if (!st || !SBF_StaticTarget(st->br_flags))
+                    corrupt("taken inst without target");
+                next_.br_target = static_br_target(st, next_.pc);
+            }
+            if (flags & RF_SrcMem) {
+                if (!get_varint(*in_, &val))
+                    corrupt("short inst");
+                next_.srcmem = last_ea_ + unzigzag(val);
+                last_ea_ = next_.srcmem;
+            }
+            if (flags & RF_DestMem) {
+                if (!get_varint(*in_, &val))
+                    corrupt("short inst");
+                next_.destmem = last_ea_ + unzigzag(val);
+                last_ea_ = next_.destmem;
+            }
+        } else {
+            corrupt("unknown record type");
+        }
+        expect_pc_ = (next_.taken) ? next_.br_target : (next_.pc + 4);
+        have_next_ = true;
+        return;
+    }
+}
+
+
+bool
+InstTraceReader::is_noop_gap(mem_addr from_pc, mem_addr to_pc) const
+{
+    if ((to_pc <= from_pc) || ((to_pc - from_pc) > MaxNoopGapBytes))
+        return false;
+    for (mem_addr pc = from_pc; pc < to_pc; pc += 4) {
+        const StashData *st = stash_decode_inst(as_->stash, pc);
+        if (!st || !(st->gen_flags & SGF_StaticNoop))
+            return false;
+    }
+    return true;
+}
+
+
+// Consume the lookahead record, and fill in where it goes next: usually
+// its fall-through or target, but the next record's PC when the trace
+// jumps there (e.g. syscall redirects).
+TraceRec
+InstTraceReader::take_next()
+{
+    sim_assert(have_next_);
+    TraceRec rec = next_;
+    read_next();
+    records_read_++;
+    mem_addr fall_pc = (rec.taken) ? rec.br_target : (rec.pc + 4);
+    rec.npc = fall_pc;
+    if (have_next_ && (next_.pc != fall_pc) &&
+        !is_noop_gap(fall_pc, next_.pc))
+        rec.npc = next_.pc;
+    return rec;
+}
+
+
+TraceRec
+InstTraceReader::fake_exit(mem_addr pc)
+{
+    if (!next_.is_exit && !warned_eof_) {
+        printf("InstTrace: A%d reached end of trace \"%s\" without an "
+               "exit; treating as exit(0)\n", as_->app_id,
+               file_name_.c_str());
+        warned_eof_ = true;
+    }
+    TraceRec rec;
+    rec.pc = pc;
+    rec.npc = pc + 4;
+    rec.is_exit = true;
+    next_.is_exit = true;               // (no more reads)
+    exit_code_ = 0;
+    return rec;
+}
+
+
+void
+InstTraceReader::note_history(const TraceRec& rec)
+{
+    if (rec.is_noop)
+        return;
+    PcHistory& hist = pc_hist_[rec.pc];
+    hist.taken = rec.taken;
+    hist.br_target = (rec.taken) ? rec.br_target : (rec.pc + 4);
+    hist.ea = (rec.srcmem) ? rec.srcmem : rec.destmem;
+}
+
+
+const TraceRec&
+InstTraceReader::correct_path_rec(mem_addr pc, const StashData *st)
+{
+    i64 inst_num = as_->stats.total_insts;
+    if (inst_num < window_base_)
+        diverged(pc, "inst already committed");
+    i64 idx = inst_num - window_base_;
+    i64 size = window_.size();
+    if (idx > size)
+        diverged(pc, "skipped past the trace window");
+
+    // (Re-emulation after a sync rollback doesn't re-count discarded no-ops,
+    // so skip over those.)
+    while ((idx < size) && (window_[idx].pc != pc) && window_[idx].is_noop)
+        idx++;
+    if (idx < size) {
+        if (window_[idx].pc != pc)
+            diverged(pc, "re-fetch doesn't match buffered record");
+        as_->stats.total_insts = window_base_ + idx;
+        return window_[idx];
+    }
+
+    TraceRec rec;
+    if (!have_next_) {
+        rec = fake_exit(pc);
+    } else if (next_.pc == pc) {
+        rec = take_next();
+    } else if ((st->gen_flags & SGF_StaticNoop) &&
+               is_noop_gap(pc, next_.pc)) {
+        rec.pc = pc;
+        rec.npc = pc + 4;
+        rec.is_noop = true;
+        noops_filled_++;
+    } else {
+        diverged(pc, (string("trace expects PC ") +
+                      fmt_x64(next_.pc)).c_str());
+    }
+    note_history(rec);
+    as_->stats.total_insts = window_base_ + idx;
+    window_.push_back(rec);
+    return window_.back();
+}
+
+
+void
+InstTraceReader::approx_wrong_path(mem_addr pc, const StashData *st,
+                                   EmuInstState *emu_state)
+{
+    PcHistMap::const_iterator found = pc_hist_.find(pc);
+    const PcHistory *hist = (found != pc_hist_.end()) ? &found->second : 0;
+
+    if (st->br_flags && !(st->gen_flags & SGF_SysCall)) {
+        if (SBF_StaticTarget(st->br_flags)) {
+            emu_state->taken_branch = (SBF_CondBranch(st->br_flags)) ?
+                (hist && hist->taken) : 1;
+        } else {
+            emu_state->taken_branch = 1;
+            emu_state->br_target = (hist) ? hist->br_target : (pc + 4);
+        }
+    }
+    mem_addr ea = (hist) ? hist->ea : 0;
+    if (st->mem_flags & SMF_Read)
+        emu_state->srcmem = ea;
+    if (st->mem_flags & SMF_Write)
+        emu_state->destmem = ea;
+    wp_insts_++;
+}
+
+
+void
+InstTraceReader::do_exit()
+{
+    // As in emulate_call_pal_callsys()
+    sim_assert(!as_->exit.has_exit);
+    as_->exit.has_exit = 1;
+    as_->exit.exit_code = exit_code_;
+    workq_app_sysexit(GlobalWorkQueue, as_);
+}
+
+
+void
+InstTraceReader::emulate(const StashData *st, EmuInstState *emu_state,
+                         int wrong_path, int speculative)
+{
+    mem_addr pc = as_->npc;
+
+    sim_assert(!as_->exit.has_exit);
+    emu_state->taken_branch = 0;
+    if (st->br_flags) {
+        emu_state->br_target = (SBF_StaticTarget(st->br_flags)) ?
+            static_br_target(st, pc) : (pc + 4);
+    }
+
+    if (wrong_path) {
+        approx_wrong_path(pc, st, emu_state);
+        as_->npc = (emu_state->taken_branch) ? emu_state->br_target :
+            (pc + 4);
+    } else {
+        const TraceRec& rec = correct_path_rec(pc, st);
+        emu_state->taken_branch = rec.taken;
+        if (rec.taken)
+            emu_state->br_target = rec.br_target;
+        if (st->mem_flags & SMF_Read)
+            emu_state->srcmem = rec.srcmem;
+        if (st->mem_flags & SMF_Write)
+            emu_state->destmem = rec.destmem;
+        if (rec.is_exit && !speculative)
+            do_exit();
+        as_->npc = rec.npc;
+    }
+    as_->stats.total_insts++;
+}
+
+
+void
+InstTraceReader::skip(i64 inst_count)
+{
+    sim_assert(window_.empty());
+    for (i64 i = 0; i < inst_count; i++) {
+        TraceRec rec = (have_next_) ? take_next() : fake_exit(as_->npc);
+        note_history(rec);
+        if (rec.is_exit) {
+            do_exit();
+            as_->npc = rec.npc;
+            as_->stats.total_insts++;
+            break;
+        }
+        as_->npc = rec.npc;
+        as_->stats.total_insts++;
+    }
+    window_base_ = as_->stats.total_insts;
+}
+
+
+
+//
+// C interface
+//
+
+InstTraceWriter *
+itrace_writer_create(const char *file_name, InstTraceStats *stats)
+{
+    return new InstTraceWriter(file_name, stats);
+}
+
+void
+itrace_writer_destroy(InstTraceWriter *itw)
+{
+    delete itw;
+}
+
+void
+itrace_writer_commit(InstTraceWriter *itw, const AppState *as,
+                     const activelist *inst)
+{
+    itw->commit(as, inst);
+}
+
+void
+itrace_writer_exit(InstTraceWriter *itw, const AppState *as,
+                   mem_addr pc, i64 exit_code)
+{
+    itw->exit(as, pc, exit_code);
+}
+
+void
+itrace_writer_flush(InstTraceWriter *itw)
+{
+    itw->flush();
+}
+
+InstTraceReader *
+itrace_reader_create(AppState *as, const char *file_name)
+{
+    return new InstTraceReader(as, file_name);
+}
+
+void
+itrace_reader_destroy(InstTraceReader *itr)
+{
+    delete itr;
+}
+
+void
+itrace_reader_emulate(InstTraceReader *itr, AppState *as,
+                      const StashData *st, EmuInstState *emu_state,
+                      int wrong_path, int speculative)
+{
+    sim_assert(as->itrace_in == itr);
+    itr->emulate(st, emu_state, wrong_path, speculative);
+}
+
+void
+itrace_reader_skip(InstTraceReader *itr, AppState *as, i64 inst_count)
+{
+    sim_assert(as->itrace_in == itr);
+    itr->skip(inst_count);
+}
+
+void
+itrace_reader_committed(InstTraceReader *itr, i64 app_inst_num)
+{
+    itr->committed(app_inst_num);
+}
+
+int
+itrace_get_app_stats(const AppState *as, InstTraceStats *dest)
+{
+    memset(dest, 0, sizeof(*dest));
+    bool traced = false;
+    if (as->extra) {
+        *dest = as->extra->itrace_stats;
+        traced = (as->extra->itrace_out != NULL) ||
+            (dest->insts_written > 0) || (dest->pages_written > 0);
+    }
+    if (as->itrace_in) {
+        as->itrace_in->add_stats(dest);
+        traced = true;
+    }
+    return traced;
+}
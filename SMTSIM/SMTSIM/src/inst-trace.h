@@ -0,0 +1,102 @@
+// -*- C++ -*-
+//
+// Committed-instruction trace capture and trace-driven replay
+//
+// $Id$
+//
+
+#ifndef INST_TRACE_H
+#define INST_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capture: with "InstTrace/capture" set, each workload app gets a writer,
+// which records every committed instruction: its PC (only when it's not the
+// fall-through / taken-target of the previous one), its taken-branch
+// outcome and target, and its effective address (as a delta from the last
+// one).  The instruction bytes themselves aren't repeated per-record;
+// instead, each code page is written out once, just before the first
+// instruction committed from it.  Files ending in ".gz" are compressed.
+// Tracing starts after any fast-forwarding; the exit syscall, which never
+// commits, is recorded when the app exits.
+//
+// Replay: a workload with "replay_trace" set is built from a trace rather
+// than an executable.  Its AppState holds only the traced code pages (data
+// memory reads as zero, and stores are dropped), and fetch takes branch
+// outcomes and addresses from the trace in place of emulation; the timing
+// model is otherwise unchanged.  Correct-path records are buffered until
+// they commit, so rolled-back instructions re-fetch the same records.
+// Wrong-path instructions are approximated from their static decode plus
+// the most recent correct-path behavior seen at the same PC.  Static no-ops
+// (which are discarded at fetch, and so never committed) are filled in
+// where the trace skips over them.  Syscalls have no effect during replay,
+// and only single-threaded, non-sharing apps are supported.
+
+struct AppState;
+struct StashData;
+struct EmuInstState;
+struct activelist;
+
+typedef struct InstTraceWriter InstTraceWriter;
+typedef struct InstTraceReader InstTraceReader;
+typedef struct InstTraceStats InstTraceStats;
+
+// Reported with the per-app stats.  A writer counts into storage the caller
+// keeps (the app's AppStateExtras), so the totals outlive the writer.
+struct InstTraceStats {
+    i64 insts_written;          // capture
+    i64 pages_written;
+    i64 records_read;           // replay
+    i64 noops_filled;
+    i64 wp_insts;               // wrong-path insts approximated
+};
+
+
+// Exits on failure to create the file
+InstTraceWriter *itrace_writer_create(const char *file_name,
+                                      InstTraceStats *stats);
+void itrace_writer_destroy(InstTraceWriter *itw);
+
+// A correct-path instruction from "as" committed
+void itrace_writer_commit(InstTraceWriter *itw, const struct AppState *as,
+                          const struct activelist *inst);
+
+// "as" syscalled exit from "pc"; flushes the trace
+void itrace_writer_exit(InstTraceWriter *itw, const struct AppState *as,
+                        mem_addr pc, i64 exit_code);
+
+void itrace_writer_flush(InstTraceWriter *itw);
+
+
+// Maps the trace's first code page(s) into "as", and sets its starting PC;
+// exits on failure to open or parse the file
+InstTraceReader *itrace_reader_create(struct AppState *as,
+                                      const char *file_name);
+void itrace_reader_destroy(InstTraceReader *itr);
+
+// Stands in for emulate_inst(), for an app being replayed
+void itrace_reader_emulate(InstTraceReader *itr, struct AppState *as,
+                           const struct StashData *st,
+                           struct EmuInstState *emu_state,
+                           int wrong_path, int speculative);
+
+// Stands in for fast_forward_app(): skip "inst_count" trace records
+void itrace_reader_skip(InstTraceReader *itr, struct AppState *as,
+                        i64 inst_count);
+
+// The correct-path inst numbered "app_inst_num" committed; records up to it
+// are no longer needed
+void itrace_reader_committed(InstTraceReader *itr, i64 app_inst_num);
+
+// Capture and replay totals for "as"; returns 0 (and zeroes "dest") if it
+// neither is nor was traced
+int itrace_get_app_stats(const struct AppState *as, InstTraceStats *dest);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // INST_TRACE_H
@@ -0,0 +1,405 @@
+//
+// ITTAGE indirect branch target predictor
+//
+// $Id$
+//
+
+const char RCSid_1760000032[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "ittage-predict.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stats-reg.h"
+
+
+using std::string;
+using std::vector;
+
+using SimCfg::conf_int;
+
+
+namespace {
+
+typedef unsigned short u16;
+
+const int MaxTaggedTables = 16;
+const int MaxHistLen = 64;              // one u64 history register
+const int ConfMax = 3;
+
+
+int
+read_ranged(const string& path, int min_val, int max_val)
+{
+    int val = conf_int(path);
+    if ((val < min_val) || (val > max_val)) {
+        exit_printf("bad %s (%d), should be in [%d,%d]\n", path.c_str(),
+                    val, min_val, max_val);
+    }
+    return val;
+}
+
+
+struct IttageConfig {
+    int n_tables;
+    int table_log_entries;
+    int tag_bits;
+    int min_hist, max_hist;
+    int u_reset_period_lg;
+
+    NoDefaultCopy nocopy;
+
+public:
+    IttageConfig(const string& cfg_path);
+    ~IttageConfig() { }
+};
+
+
+IttageConfig::IttageConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    n_tables = read_ranged(cp + "n_tables", 1, MaxTaggedTables);
+    table_log_entries = read_ranged(cp + "table_log_entries", 1, 24);
+    tag_bits = read_ranged(cp + "tag_bits", 4, 15);
+    min_hist = read_ranged(cp + "min_hist", 1, MaxHistLen);
+    max_hist = read_ranged(cp + "max_hist", min_hist, MaxHistLen);
+    u_reset_period_lg = read_ranged(cp + "u_reset_period_lg", 4, 30);
+}
+
+
+struct TargetEntry {
+    u64 target;                 // 0: invalid
+    u16 tag;
+    u8 conf;                    // 0..ConfMax
+    u8 u;                       // useful bit
+    TargetEntry() : target(0), tag(0), conf(0), u(0) { }
+};
+
+
+// Table indices/tags and the matching tables, for one (pc, history)
+struct IttageLookup {
+    int idx[MaxTaggedTables];
+    u16 tag[MaxTaggedTables];
+    int provider;               // longest matching table, or -1
+    int alt;                    // next-longest, or -1
+    u64 pred;                   // predicted target, or 0
+};
+
+
+// XOR the low "len" bits of "hist" down to "out_bits" bits
+u32
+fold_hist(u64 hist, int len, int out_bits)
+{
+    if (len < 64)
+        hist &= (U64_LIT(1) << len) - 1;
+    const u64 out_mask = (U64_LIT(1) << out_bits) - 1;
+    u64 result = 0;
+    while (hist) {
+        result ^= hist & out_mask;
+        hist >>= out_bits;
+    }
+    return static_cast<u32>(result);
+}
+
+} // Anonymous namespace close
+
+
+struct IttagePredict {
+private:
+    string name_;
+    IttageConfig conf_;
+    int inst_bytes_lg_;
+    vector<int> hist_lens_;
+    vector<vector<TargetEntry> > tables_;
+    i64 u_tick_;
+    u32 lfsr_;
+    IttageStats stats_;
+
+    u32 rand_bits() {
+        // 32-bit Galois LFSR; deterministic, for allocation tie-breaking
+        lfsr_ = (lfsr_ >> 1) ^ (-(lfsr_ & 1) & 0xd0000001u);
+        return lfsr_;
+    }
+
+    u64 pc_word(u64 pc) const { return pc >> inst_bytes_lg_; }
+
+    void lookup(u64 pc, u64 hist, IttageLookup& lk) const;
+
+public:
+    IttagePredict(const char *name__, const char *config_path__,
+                  int inst_bytes__);
+    ~IttagePredict() { }
+
+    void reset_stats() { memset(&stats_, 0, sizeof(stats_)); }
+
+    u64 predict(u64 pc, u64 hist) const {
+        IttageLookup lk;
+        lookup(pc, hist, lk);
+        return lk.pred;
+    }
+
+    u64 hist_next(u64 hist, u64 pc, int is_cond, int taken,
+                  u64 target) const {
+        if (is_cond)
+            return (hist << 1) | (taken != 0);
+        u64 bits = pc_word(target) ^ (pc_word(target) >> 2) ^ pc_word(pc);
+        return (hist << 2) | (bits & 3);
+    }
+
+    void update(u64 pc, u64 hist, u64 target);
+
+    const IttageStats& get_stats() const { return stats_; }
+    void print_stats(FILE *out, const char *pf) const;
+};
+
+
+IttagePredict::IttagePredict(const char *name__, const char *config_path__,
+                             int inst_bytes__)
+    : name_(name__), conf_(config_path__), u_tick_(0), lfsr_(0x1badb002u)
+{
+    if ((inst_bytes_lg_ = log2_exact(inst_bytes__)) < 0) {
+        exit_printf("ITTAGE inst_bytes (%d) not a power of 2\n",
+                    inst_bytes__);
+    }
+
+    tables_.resize(conf_.n_tables);
+    for (int i = 0; i < conf_.n_tables; i++)
+        tables_[i].resize(1 << conf_.table_log_entries);
+
+    // Geometric series from min_hist to max_hist, as in TAGE
+    hist_lens_.resize(conf_.n_tables);
+    for (int i = 0; i < conf_.n_tables; i++) {
+        double ratio = (conf_.n_tables > 1) ?
+            (double) i / (conf_.n_tables - 1) : 0.0;
+        hist_lens_[i] = (int) (conf_.min_hist *
+                               pow((double) conf_.max_hist / conf_.min_hist,
+                                   ratio) + 0.5);
+        if ((i > 0) && (hist_lens_[i] <= hist_lens_[i - 1]))
+            hist_lens_[i] = hist_lens_[i - 1] + 1;
+        if (hist_lens_[i] > MaxHistLen) {
+            exit_printf("ITTAGE %s: too many tables (%d) for history lengths"
+                        " %d..%d\n", name_.c_str(), conf_.n_tables,
+                        conf_.min_hist, conf_.max_hist);
+        }
+    }
+
+    reset_stats();
+}
+
+
+void
+IttagePredict::lookup(u64 pc, u64 hist, IttageLookup& lk) const
+{
+    const u64 pcw = pc_word(pc);
+    const int log_ent = conf_.table_log_entries;
+    const u32 idx_mask = (U32_LIT(1) << log_ent) - 1;
+    const u32 tag_mask = (U32_LIT(1) << conf_.tag_bits) - 1;
+
+    lk.provider = -1;
+    lk.alt = -1;
+    for (int i = conf_.n_tables - 1; i >= 0; i--) {
+        const int len = hist_lens_[i];
+        u32 idx = static_cast<u32>(pcw ^ (pcw >> (log_ent - (i % log_ent))))
+            ^ fold_hist(hist, len, log_ent);
+        u32 tag = static_cast<u32>(pcw ^ (pcw >> 11)) ^
+            fold_hist(hist, len, conf_.tag_bits) ^
+            (fold_hist(hist, len, conf_.tag_bits - 1) << 1);
+        lk.idx[i] = static_cast<int>(idx & idx_mask);
+        lk.tag[i] = static_cast<u16>(tag & tag_mask);
+        const TargetEntry& ent = tables_[i][lk.idx[i]];
+        if (ent.target && (ent.tag == lk.tag[i])) {
+            if (lk.provider < 0)
+                lk.provider = i;
+            else if (lk.alt < 0)
+                lk.alt = i;
+        }
+    }
+
+    lk.pred = 0;
+    if (lk.provider >= 0) {
+        const TargetEntry& prov = tables_[lk.provider][lk.idx[lk.provider]];
+        // A newly-(re)allocated provider is less trustworthy than an
+        // established shorter-history one
+        if ((prov.conf == 0) && (lk.alt >= 0))
+            lk.pred = tables_[lk.alt][lk.idx[lk.alt]].target;
+        else
+            lk.pred = prov.target;
+    }
+}
+
+
+void
+IttagePredict::update(u64 pc, u64 hist, u64 target)
+{
+    IttageLookup lk;
+    lookup(pc, hist, lk);
+
+    stats_.updates++;
+    if (lk.pred) {
+        stats_.provided++;
+        if (lk.pred == target)
+            stats_.hits++;
+        else
+            stats_.misses++;
+    }
+
+    if (lk.provider >= 0) {
+        TargetEntry& prov = tables_[lk.provider][lk.idx[lk.provider]];
+        if (prov.target == target) {
+            if (prov.conf < ConfMax)
+                prov.conf++;
+            const u64 alt_targ = (lk.alt >= 0) ?
+                tables_[lk.alt][lk.idx[lk.alt]].target : 0;
+            if (alt_targ != target)
+                prov.u = 1;
+        } else if (prov.conf > 0) {
+            prov.conf--;
+        } else {
+            prov.target = target;
+            prov.u = 0;
+        }
+        if ((prov.target != target) && (lk.alt >= 0)) {
+            TargetEntry& alt = tables_[lk.alt][lk.idx[lk.alt]];
+            if ((alt.target == target) && (alt.conf < ConfMax))
+                alt.conf++;
+        }
+    }
+
+    if ((lk.pred != target) && (lk.provider < (conf_.n_tables - 1))) {
+        // Allocate one entry in a longer-history table, skipping ahead a
+        // table at random so allocations spread out
+        int start = lk.provider + 1;
+        if ((start < (conf_.n_tables - 1)) && (rand_bits() & 1))
+            start++;
+        bool allocated = false;
+        for (int i = start; i < conf_.n_tables; i++) {
+            TargetEntry& ent = tables_[i][lk.idx[i]];
+            if (!ent.u) {
+                ent.target = target;
+                ent.tag = lk.tag[i];
+                ent.conf = 0;
+                ent.u = 0;
+                allocated = true;
+                break;
+            }
+        }
+        if (allocated) {
+            stats_.allocs++;
+        } else {
+            stats_.alloc_fails++;
+            for (int i = start; i < conf_.n_tables; i++)
+                tables_[i][lk.idx[i]].u = 0;
+        }
+    }
+
+    u_tick_++;
+    if (!(u_tick_ & ((I64_LIT(1) << conf_.u_reset_period_lg) - 1))) {
+        for (int i = 0; i < conf_.n_tables; i++) {
+            for (int j = 0; j < intsize(tables_[i]); j++)
+                tables_[i][j].u = 0;
+        }
+    }
+}
+
+
+void
+IttagePredict::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%sITTAGE: %d tagged tables, hist", pf, conf_.n_tables);
+    for (int i = 0; i < conf_.n_tables; i++)
+        fprintf(out, " %d", hist_lens_[i]);
+    fprintf(out, "\n");
+    fprintf(out, "%sITTAGE: updates %s provided %s hits %s misses %s"
+            " hit rate = %.2f%% allocs %s alloc_fails %s\n", pf,
+            fmt_i64(stats_.updates), fmt_i64(stats_.provided),
+            fmt_i64(stats_.hits), fmt_i64(stats_.misses),
+            (stats_.provided) ?
+            (100.0 * stats_.hits / stats_.provided) : 0.0,
+            fmt_i64(stats_.allocs), fmt_i64(stats_.alloc_fails));
+}
+
+
+
+//
+// C interface
+//
+
+IttagePredict *
+ittage_create(const char *name, const char *config_path, int inst_bytes)
+{
+    return new IttagePredict(name, config_path, inst_bytes);
+}
+
+void
+ittage_destroy(IttagePredict *it)
+{
+    delete it;
+}
+
+void
+ittage_reset_stats(IttagePredict *it)
+{
+    it->reset_stats();
+}
+
+u64
+ittage_predict(const IttagePredict *it, u64 pc, u64 hist)
+{
+    return it->predict(pc, hist);
+}
+
+void
+ittage_update(IttagePredict *it, u64 pc, u64 hist, u64 target)
+{
+    it->update(pc, hist, target);
+}
+
+u64
+ittage_hist_next(const IttagePredict *it, u64 hist, u64 pc, int is_cond,
+                 int taken, u64 target)
+{
+    return it->hist_next(hist, pc, is_cond, taken, target);
+}
+
+void
+ittage_get_stats(const IttagePredict *it, IttageStats *dest)
+{
+    *dest = it->get_stats();
+}
+
+static void
+ittage_stats_provider(StatsEmitter *em, void *data)
+{
+    const IttageStats& st = static_cast<const IttagePredict *>(data)->get_stats();
+    statsemit_i64(em, "updates", st.updates);
+    statsemit_i64(em, "provided", st.provided);
+    statsemit_i64(em, "hits", st.hits);
+    statsemit_i64(em, "misses", st.misses);
+    statsemit_i64(em, "allocs", st.allocs);
+    statsemit_i64(em, "alloc_fails", st.alloc_fails);
+}
+
+void
+ittage_register_stats(IttagePredict *it, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, ittage_stats_provider, it);
+}
+
+void
+ittage_print_stats(const IttagePredict *it, void *c_FILE_out,
+                   const char *prefix)
+{
+    it->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
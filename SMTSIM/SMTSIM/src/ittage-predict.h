@@ -0,0 +1,69 @@
+// -*- C++ -*-
+//
+// ITTAGE indirect branch target predictor
+//
+// $Id$
+//
+
+#ifndef ITTAGE_PREDICT_H
+#define ITTAGE_PREDICT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// An ITTAGE-style target predictor (Seznec, "A 64-Kbytes ITTAGE indirect
+// branch predictor", JWAC-2 2011): tagged tables of full targets, indexed
+// with geometrically-increasing lengths of global history.  There's no base
+// table; when no tagged entry matches, callers fall back to the BTB.
+//
+// The history is a single 64-bit register, so callers can checkpoint it by
+// value (next to the GHR copy) rather than needing rollback support here:
+// conditional branches shift in their direction, other branches shift in
+// two bits of their target.  Lookups don't change predictor state; training
+// re-indexes with the branch's fetch-time history, at commit.
+
+typedef struct IttagePredict IttagePredict;
+typedef struct IttageStats IttageStats;
+struct StatsReg;
+
+struct IttageStats {
+    i64 updates;                // commit-time training
+    i64 provided;               // ...for which a tagged entry matched
+    i64 hits, misses;           // ...and whose target was right / wrong
+    i64 allocs, alloc_fails;
+};
+
+
+IttagePredict *ittage_create(const char *name, const char *config_path,
+                             int inst_bytes);
+void ittage_destroy(IttagePredict *it);
+
+void ittage_reset_stats(IttagePredict *it);
+
+// Predicted target for the indirect branch at "pc", given the history from
+// before that branch; 0 if no tagged entry matches
+u64 ittage_predict(const IttagePredict *it, u64 pc, u64 hist);
+
+// Train with the actual target of the branch at "pc", with the same
+// history value passed to ittage_predict() at fetch
+void ittage_update(IttagePredict *it, u64 pc, u64 hist, u64 target);
+
+// History value after the branch at "pc"; "target" is ignored for
+// conditional branches
+u64 ittage_hist_next(const IttagePredict *it, u64 hist, u64 pc,
+                     int is_cond, int taken, u64 target);
+
+void ittage_get_stats(const IttagePredict *it, IttageStats *dest);
+// Register a provider for IttageStats at "path" (stats-reg.h)
+void ittage_register_stats(IttagePredict *it, struct StatsReg *sr,
+                           const char *path);
+void ittage_print_stats(const IttagePredict *it, void *c_FILE_out,
+                        const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ITTAGE_PREDICT_H
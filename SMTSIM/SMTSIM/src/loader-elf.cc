@@ -300,7 +300,8 @@ err:
 
 
 int
-create_res_seg(AppState *dest, FILE *exec_file, const ResidentSeg& seg)
+create_res_seg(AppState *dest, int exec_fd, FILE *exec_file,
+               const ResidentSeg& seg)
 {
     const char *fname = "loader-elf.cc::create_res_seg";
     i64 file_readsize = MIN_SCALAR(seg.mem_bytes, seg.file_bytes);
@@ -308,6 +309,14 @@ create_res_seg(AppState *dest, FILE *exec_file, const ResidentSeg& seg)
                 fname, fmt_i64(seg.mem_bytes),
                 fmt_mem(seg.start_va), seg.access_flags,
                 seg.create_flags);
+    // Map file contents copy-on-write if the region allocator supports it
+    // (Global/Mem/mmap_exec_segments), rather than reading them in.  (This
+    // always fails for sparse segments.)
+    if (pmem_map_file(dest->pmem, seg.mem_bytes, seg.start_va,
+                      seg.access_flags, seg.create_flags, exec_fd,
+                      seg.file_offset, file_readsize) == 0) {
+        return 0;
+    }
     if (pmem_map_new(dest->pmem, seg.mem_bytes, seg.start_va,
                      PMAF_RW, seg.create_flags)) {
         fprintf(stderr, "%s: couldn't create segment (%s @ %s)\n", fname,
@@ -339,7 +348,9 @@ create_res_seg(AppState *dest, FILE *exec_file, const ResidentSeg& seg)
                 fname, fmt_i64(seg.mem_bytes), fmt_mem(seg.start_va));
         goto err;
     }
-    if (seg.mem_bytes > file_readsize) {
+    // (Untouched sparse chunks already read as zero)
+    if ((seg.mem_bytes > file_readsize) &&
+        !(seg.create_flags & PMCF_Sparse)) {
         mem_addr zero_start = seg.start_va + file_readsize;
         i64 zero_bytes = seg.mem_bytes - file_readsize;
         pmem_write_memset(dest->pmem, zero_start, 0, zero_bytes, 0);
@@ -398,8 +409,12 @@ loader_read_elf(AppState *dest, const char *filename)
 
     for (ResidentSegVec::const_iterator iter = hdr_summ->res_segs.begin();
          iter != hdr_summ->res_segs.end(); ++iter) {
-        const ResidentSeg& next_seg = *iter;
-        if (create_res_seg(dest, exec_file, next_seg) < 0)
+        ResidentSeg next_seg = *iter;
+        // The brk() segment is the heap, for Global/Mem/SparseSegs
+        if (GlobalParams.mem.sparse_heap &&
+            (next_seg.start_va == hdr_summ->data_seg_for_brk))
+            next_seg.create_flags |= PMCF_Sparse;
+        if (create_res_seg(dest, sys_fd, exec_file, next_seg) < 0)
             goto err;
     }
 
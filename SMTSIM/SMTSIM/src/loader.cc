@@ -49,6 +49,16 @@ enum {
 };
 
 
+static unsigned
+stack_create_flags(void)
+{
+    unsigned result = PMCF_AutoGrowDown;
+    if (GlobalParams.mem.sparse_stack)
+        result |= PMCF_Sparse;
+    return result;
+}
+
+
 int 
 loader_read_auto(AppState *dest, const char *filename) 
 {
@@ -118,7 +128,7 @@ loader_read_auto(AppState *dest, const char *filename)
         dest->seg_info.stack_upper_lim = stack_upper_lim;
 
         if (pmem_map_new(dest->pmem, stack_size, stack_start, PMAF_RW,
-                         PMCF_AutoGrowDown)) {
+                         stack_create_flags())) {
             fprintf(stderr, "%s: couldn't create stack segment (%s @ 0x%s)\n",
                     fname, fmt_i64(stack_size), fmt_x64(stack_start));
             goto err;
@@ -131,7 +141,9 @@ loader_read_auto(AppState *dest, const char *filename)
                             I64_LIT(1024));
         }
             
-        pmem_write_memset(dest->pmem, stack_start, 0, stack_size, 0);
+        // (Sparse chunks read as zero until touched)
+        if (!GlobalParams.mem.sparse_stack)
+            pmem_write_memset(dest->pmem, stack_start, 0, stack_size, 0);
         DEBUGPRINTF("%s: initial stack base %s, size %s (upper limit %s)\n",
                     fname, fmt_mem(stack_start), fmt_i64(stack_size),
                     fmt_mem(stack_upper_lim));
@@ -195,7 +207,7 @@ loader_share_memory(AppState *dest, AppState *src)
 
     // Give the new thread its own stack
     if (pmem_map_new(dest->pmem, stack_size, stack_start, PMAF_RW,
-                     PMCF_AutoGrowDown)) {
+                     stack_create_flags())) {
         fprintf(stderr, "Couldn't create stack segment (%s @ 0x%s)\n",
                 fmt_i64(stack_size), fmt_x64(stack_start));
         exit(1);
@@ -0,0 +1,592 @@
+//
+// Load/store queue model: store-to-load forwarding, store-set memory
+// dependence prediction, and memory-order violation detection
+//
+// $Id$
+//
+
+const char RCSid_1760000034[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "lsq-model.h"
+#include "core-resources.h"
+#include "context.h"
+#include "dyn-inst.h"
+#include "stash.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stats-reg.h"
+
+
+using std::deque;
+using std::string;
+using std::vector;
+
+using SimCfg::conf_bool;
+using SimCfg::conf_int;
+
+extern i64 cyc;
+
+
+namespace {
+
+struct LSQModelConfig {
+    int forward_lat;            // load addr-ready -> forwarded value ready
+    bool store_sets;
+    int ssit_log_entries;       // store set ID table, indexed by PC
+    int n_store_sets;           // last fetched store table entries
+    int ssit_clear_cyc;         // 0: never clear
+
+    NoDefaultCopy nocopy;
+
+public:
+    LSQModelConfig(const string& cfg_path);
+    ~LSQModelConfig() { }
+};
+
+
+LSQModelConfig::LSQModelConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    forward_lat = conf_int(cp + "forward_lat");
+    if (forward_lat < 0) {
+        exit_printf("bad %sforward_lat (%d)\n", cp.c_str(), forward_lat);
+    }
+    store_sets = conf_bool(cp + "store_sets");
+    ssit_log_entries = conf_int(cp + "ssit_log_entries");
+    if ((ssit_log_entries < 1) || (ssit_log_entries > 24)) {
+        exit_printf("bad %sssit_log_entries (%d)\n", cp.c_str(),
+                    ssit_log_entries);
+    }
+    n_store_sets = conf_int(cp + "n_store_sets");
+    if (n_store_sets < 1) {
+        exit_printf("bad %sn_store_sets (%d)\n", cp.c_str(), n_store_sets);
+    }
+    ssit_clear_cyc = conf_int(cp + "ssit_clear_cyc");
+    if (ssit_clear_cyc < 0) {
+        exit_printf("bad %sssit_clear_cyc (%d)\n", cp.c_str(),
+                    ssit_clear_cyc);
+    }
+}
+
+
+// Per-alist-entry state; "seq" orders memory instructions within a thread,
+// and identifies this particular use of the alist entry.
+struct MemInstInfo {
+    i64 seq;                    // -1: not in the LSQ
+    bool is_store;
+    bool issued;
+    i64 data_ready_cyc;         // stores: address & data known
+    i64 fwd_store_seq;          // loads: store forwarded from, or -1
+    int ssid;                   // stores: store set, or -1
+    int dep_id;                 // predicted predecessor store, or -1
+    i64 dep_seq;
+    MemInstInfo()
+        : seq(-1), is_store(false), issued(false), data_ready_cyc(0),
+          fwd_store_seq(-1), ssid(-1), dep_id(-1), dep_seq(-1) { }
+};
+
+
+struct StoreRef {
+    int id;                     // alist ID, or -1
+    i64 seq;
+    StoreRef() : id(-1), seq(-1) { }
+};
+
+
+struct PendingViolation {
+    int load_id;
+    i64 load_seq;
+    i64 due_cyc;
+    PendingViolation(int id, i64 seq, i64 due)
+        : load_id(id), load_seq(seq), due_cyc(due) { }
+};
+
+
+struct ThreadLSQ {
+    vector<MemInstInfo> info;   // by alist ID
+    deque<int> lq, sq;          // alist IDs, oldest first
+    i64 next_seq;
+    vector<StoreRef> lfst;      // by store set ID
+    vector<PendingViolation> viol;
+    ThreadLSQ() : next_seq(0) { }
+};
+
+
+inline bool
+mem_overlap(const activelist *a, mem_addr a_addr,
+            const activelist *b, mem_addr b_addr)
+{
+    int a_width = MAX_SCALAR(1, SMF_GetWidth(a->mem_flags));
+    int b_width = MAX_SCALAR(1, SMF_GetWidth(b->mem_flags));
+    return (a->as == b->as) && (a_addr < (b_addr + b_width)) &&
+        (b_addr < (a_addr + a_width));
+}
+
+
+// Whether store "st" supplies every byte read by load "ld"
+inline bool
+mem_covers(const activelist *st, const activelist *ld)
+{
+    int st_width = MAX_SCALAR(1, SMF_GetWidth(st->mem_flags));
+    int ld_width = MAX_SCALAR(1, SMF_GetWidth(ld->mem_flags));
+    return (st->destmem <= ld->srcmem) &&
+        ((ld->srcmem + ld_width) <= (st->destmem + st_width));
+}
+
+} // Anonymous namespace close
+
+
+struct LSQModel {
+private:
+    string name_;
+    LSQModelConfig conf_;
+    CoreResources *core_;
+    int inst_bytes_lg_;
+    vector<int> ssit_;                  // store set IDs, -1: none
+    vector<ThreadLSQ> threads_;         // by core_thread_id
+    i64 next_ssit_clear_;
+    LSQModelStats stats_;
+
+    ThreadLSQ& thread(const context *ctx) {
+        int tid = ctx->core_thread_id;
+        if (tid >= intsize(threads_))
+            threads_.resize(tid + 1);
+        ThreadLSQ& thr = threads_[tid];
+        if (thr.info.empty()) {
+            thr.info.resize(ctx->params.active_list_size);
+            thr.lfst.resize(conf_.n_store_sets);
+        }
+        return thr;
+    }
+
+    int ssit_index(mem_addr pc) const {
+        return static_cast<int>((pc >> inst_bytes_lg_) &
+                                ((U64_LIT(1) << conf_.ssit_log_entries) - 1));
+    }
+    bool store_pending(const ThreadLSQ& thr, int id, i64 seq) const {
+        return (id >= 0) && (thr.info[id].seq == seq) &&
+            !thr.info[id].issued;
+    }
+
+    // Youngest issued store older than "ld" which overlaps it, or NULL
+    const activelist *find_fwd_store(const context *ctx,
+                                     const ThreadLSQ& thr,
+                                     const activelist *ld) const;
+    void train(mem_addr load_pc, mem_addr store_pc);
+
+public:
+    LSQModel(const char *name__, const char *config_path__,
+             CoreResources *core__);
+    ~LSQModel() { }
+
+    void renamed(const context *ctx, const activelist *inst);
+    void removed(const context *ctx, const activelist *inst);
+    bool issue_wait(const context *ctx, const activelist *inst,
+                    bool allow_stats_update);
+    bool load_issued(const context *ctx, const activelist *inst,
+                     i64 addr_ready_cyc, bool may_forward,
+                     i64 *fwd_done_ret);
+    void store_issued(const context *ctx, const activelist *inst,
+                      i64 addr_ready_cyc);
+    int take_violation(const context *ctx);
+
+    void reset_stats() { memset(&stats_, 0, sizeof(stats_)); }
+    const LSQModelStats& get_stats() const { return stats_; }
+    void print_stats(FILE *out, const char *pf) const;
+};
+
+
+LSQModel::LSQModel(const char *name__, const char *config_path__,
+                   CoreResources *core__)
+    : name_(name__), conf_(config_path__), core_(core__),
+      next_ssit_clear_(0)
+{
+    if ((inst_bytes_lg_ = log2_exact(core_->params.inst_bytes)) < 0) {
+        exit_printf("LSQModel %s: inst_bytes (%d) not a power of 2\n",
+                    name_.c_str(), core_->params.inst_bytes);
+    }
+    ssit_.resize(1 << conf_.ssit_log_entries, -1);
+    if (conf_.ssit_clear_cyc)
+        next_ssit_clear_ = conf_.ssit_clear_cyc;
+    reset_stats();
+}
+
+
+void
+LSQModel::renamed(const context *ctx, const activelist *inst)
+{
+    ThreadLSQ& thr = thread(ctx);
+    MemInstInfo& mi = thr.info[inst->id];
+    sim_assert(mi.seq < 0);
+
+    if (conf_.ssit_clear_cyc && (cyc >= next_ssit_clear_)) {
+        // Periodic clearing keeps stale, over-merged sets from serializing
+        // independent accesses forever
+        for (int i = 0; i < intsize(ssit_); i++)
+            ssit_[i] = -1;
+        next_ssit_clear_ = cyc + conf_.ssit_clear_cyc;
+        stats_.ssit_clears++;
+    }
+
+    mi = MemInstInfo();
+    mi.seq = thr.next_seq++;
+    // (Loads first, as in resolve(): an op with both flags acts as a load)
+    mi.is_store = !(inst->mem_flags & SMF_Read);
+
+    if (conf_.store_sets) {
+        int ssid = ssit_[ssit_index(inst->pc)];
+        if (ssid >= 0) {
+            StoreRef& last = thr.lfst[ssid];
+            if (store_pending(thr, last.id, last.seq)) {
+                mi.dep_id = last.id;
+                mi.dep_seq = last.seq;
+            }
+            if (mi.is_store) {
+                mi.ssid = ssid;
+                last.id = inst->id;
+                last.seq = mi.seq;
+            }
+        }
+    }
+
+    if (mi.is_store)
+        thr.sq.push_back(inst->id);
+    else
+        thr.lq.push_back(inst->id);
+}
+
+
+void
+LSQModel::removed(const context *ctx, const activelist *inst)
+{
+    ThreadLSQ& thr = thread(ctx);
+    MemInstInfo& mi = thr.info[inst->id];
+    sim_assert(mi.seq >= 0);
+    deque<int>& q = (mi.is_store) ? thr.sq : thr.lq;
+    // Commit removes from the head, squashes from the tail
+    if (!q.empty() && (q.front() == inst->id)) {
+        q.pop_front();
+    } else if (!q.empty() && (q.back() == inst->id)) {
+        q.pop_back();
+    } else {
+        abort_printf("LSQModel %s: T%ds%d not at either end of its %s "
+                     "queue\n", name_.c_str(), ctx->id, inst->id,
+                     (mi.is_store) ? "store" : "load");
+    }
+    mi.seq = -1;
+}
+
+
+const activelist *
+LSQModel::find_fwd_store(const context *ctx, const ThreadLSQ& thr,
+                         const activelist *ld) const
+{
+    const i64 ld_seq = thr.info[ld->id].seq;
+    for (deque<int>::const_reverse_iterator iter = thr.sq.rbegin();
+         iter != thr.sq.rend(); ++iter) {
+        const MemInstInfo& st_info = thr.info[*iter];
+        if ((st_info.seq > ld_seq) || !st_info.issued)
+            continue;
+        const activelist *st = &ctx->alist[*iter];
+        if (mem_overlap(st, st->destmem, ld, ld->srcmem))
+            return st;
+    }
+    return NULL;
+}
+
+
+bool
+LSQModel::issue_wait(const context *ctx, const activelist *inst,
+                     bool allow_stats_update)
+{
+    ThreadLSQ& thr = thread(ctx);
+    const MemInstInfo& mi = thr.info[inst->id];
+    if (mi.seq < 0)             // not renamed through the LSQ
+        return false;
+
+    if (store_pending(thr, mi.dep_id, mi.dep_seq)) {
+        if (allow_stats_update)
+            stats_.ss_waits++;
+        return true;
+    }
+    if (!mi.is_store) {
+        const activelist *st = find_fwd_store(ctx, thr, inst);
+        if (st && !mem_covers(st, inst)) {
+            if (allow_stats_update)
+                stats_.partial_waits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool
+LSQModel::load_issued(const context *ctx, const activelist *inst,
+                      i64 addr_ready_cyc, bool may_forward,
+                      i64 *fwd_done_ret)
+{
+    ThreadLSQ& thr = thread(ctx);
+    MemInstInfo& mi = thr.info[inst->id];
+    if (mi.seq < 0)
+        return false;
+    sim_assert(!mi.is_store);
+    mi.issued = true;
+    stats_.loads++;
+
+    const activelist *st = (may_forward) ? find_fwd_store(ctx, thr, inst)
+        : NULL;
+    if (!st || !mem_covers(st, inst))
+        return false;
+    const MemInstInfo& st_info = thr.info[st->id];
+    mi.fwd_store_seq = st_info.seq;
+    *fwd_done_ret = MAX_SCALAR(addr_ready_cyc, st_info.data_ready_cyc) +
+        conf_.forward_lat;
+    stats_.forwarded++;
+    return true;
+}
+
+
+void
+LSQModel::train(mem_addr load_pc, mem_addr store_pc)
+{
+    // Store set assignment rules from Chrysos & Emer: create a set if
+    // neither has one, join the other's set if just one does, and merge
+    // into the lower-numbered set if both do
+    int& load_ss = ssit_[ssit_index(load_pc)];
+    int& store_ss = ssit_[ssit_index(store_pc)];
+    if ((load_ss < 0) && (store_ss < 0)) {
+        int ssid = static_cast<int>((store_pc >> inst_bytes_lg_) %
+                                    conf_.n_store_sets);
+        load_ss = ssid;
+        store_ss = ssid;
+    } else if (load_ss < 0) {
+        load_ss = store_ss;
+    } else if (store_ss < 0) {
+        store_ss = load_ss;
+    } else {
+        int ssid = MIN_SCALAR(load_ss, store_ss);
+        load_ss = ssid;
+        store_ss = ssid;
+    }
+}
+
+
+void
+LSQModel::store_issued(const context *ctx, const activelist *inst,
+                       i64 addr_ready_cyc)
+{
+    ThreadLSQ& thr = thread(ctx);
+    MemInstInfo& mi = thr.info[inst->id];
+    if (mi.seq < 0)
+        return;
+    sim_assert(mi.is_store);
+    mi.issued = true;
+    mi.data_ready_cyc = addr_ready_cyc;
+    stats_.stores++;
+
+    if (mi.ssid >= 0) {
+        StoreRef& last = thr.lfst[mi.ssid];
+        if ((last.id == inst->id) && (last.seq == mi.seq))
+            last.id = -1;
+    }
+
+    // Look for younger loads which have already issued, to an overlapping
+    // address, without getting their value from this store or a younger
+    // one; the oldest of those is where re-execution must start.
+    const activelist *victim = NULL;
+    i64 victim_seq = -1;
+    for (deque<int>::const_iterator iter = thr.lq.begin();
+         iter != thr.lq.end(); ++iter) {
+        const MemInstInfo& ld_info = thr.info[*iter];
+        if (ld_info.seq < mi.seq)
+            continue;
+        const activelist *ld = &ctx->alist[*iter];
+        if (ld_info.issued && !ld->wp && (ld_info.fwd_store_seq < mi.seq) &&
+            mem_overlap(inst, inst->destmem, ld, ld->srcmem)) {
+            victim = ld;
+            victim_seq = ld_info.seq;
+            break;
+        }
+    }
+    if (victim) {
+        stats_.violations++;
+        if (conf_.store_sets)
+            train(victim->pc, inst->pc);
+        thr.viol.push_back(PendingViolation(victim->id, victim_seq,
+                                            addr_ready_cyc));
+    }
+}
+
+
+int
+LSQModel::take_violation(const context *ctx)
+{
+    if ((ctx->core_thread_id >= intsize(threads_)) ||
+        threads_[ctx->core_thread_id].viol.empty())
+        return -1;
+    ThreadLSQ& thr = thread(ctx);
+
+    // Drop violations whose loads have since left, then pick the oldest
+    // load that's due
+    int best = -1;
+    for (int i = 0; i < intsize(thr.viol); ) {
+        const PendingViolation& pv = thr.viol[i];
+        if (thr.info[pv.load_id].seq != pv.load_seq) {
+            thr.viol[i] = thr.viol.back();
+            thr.viol.pop_back();
+            continue;
+        }
+        if ((pv.due_cyc <= cyc) &&
+            ((best < 0) || (pv.load_seq < thr.viol[best].load_seq)))
+            best = i;
+        i++;
+    }
+    if (best < 0)
+        return -1;
+
+    const int load_id = thr.viol[best].load_id;
+    const i64 load_seq = thr.viol[best].load_seq;
+    // Anything at or after the load will be squashed along with it
+    for (int i = 0; i < intsize(thr.viol); ) {
+        if (thr.viol[i].load_seq >= load_seq) {
+            thr.viol[i] = thr.viol.back();
+            thr.viol.pop_back();
+        } else {
+            i++;
+        }
+    }
+    stats_.squashes++;
+    return load_id;
+}
+
+
+void
+LSQModel::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%sLSQ model: loads %s stores %s forwarded %s (%.2f%%)"
+            " violations %s (%.4f%% of loads) squashes %s\n", pf,
+            fmt_i64(stats_.loads), fmt_i64(stats_.stores),
+            fmt_i64(stats_.forwarded),
+            (stats_.loads) ? (100.0 * stats_.forwarded / stats_.loads) : 0.0,
+            fmt_i64(stats_.violations),
+            (stats_.loads) ? (100.0 * stats_.violations / stats_.loads) : 0.0,
+            fmt_i64(stats_.squashes));
+    fprintf(out, "%sLSQ model: issue waits: store-set %s partial-overlap %s"
+            "; SSIT clears %s\n", pf, fmt_i64(stats_.ss_waits),
+            fmt_i64(stats_.partial_waits), fmt_i64(stats_.ssit_clears));
+}
+
+
+
+//
+// C interface
+//
+
+LSQModel *
+lsqm_create(const char *name, const char *config_path,
+            struct CoreResources *core)
+{
+    return new LSQModel(name, config_path, core);
+}
+
+void
+lsqm_destroy(LSQModel *lsqm)
+{
+    delete lsqm;
+}
+
+void
+lsqm_renamed(LSQModel *lsqm, const struct context *ctx,
+             const struct activelist *inst)
+{
+    lsqm->renamed(ctx, inst);
+}
+
+void
+lsqm_removed(LSQModel *lsqm, const struct context *ctx,
+             const struct activelist *inst)
+{
+    lsqm->removed(ctx, inst);
+}
+
+int
+lsqm_issue_wait(LSQModel *lsqm, const struct context *ctx,
+                const struct activelist *inst, int allow_stats_update)
+{
+    return lsqm->issue_wait(ctx, inst, allow_stats_update);
+}
+
+int
+lsqm_load_issued(LSQModel *lsqm, const struct context *ctx,
+                 const struct activelist *inst, i64 addr_ready_cyc,
+                 int may_forward, i64 *fwd_done_ret)
+{
+    return lsqm->load_issued(ctx, inst, addr_ready_cyc, may_forward,
+                             fwd_done_ret);
+}
+
+void
+lsqm_store_issued(LSQModel *lsqm, const struct context *ctx,
+                  const struct activelist *inst, i64 addr_ready_cyc)
+{
+    lsqm->store_issued(ctx, inst, addr_ready_cyc);
+}
+
+int
+lsqm_take_violation(LSQModel *lsqm, const struct context *ctx)
+{
+    return lsqm->take_violation(ctx);
+}
+
+void
+lsqm_reset_stats(LSQModel *lsqm)
+{
+    lsqm->reset_stats();
+}
+
+void
+lsqm_get_stats(const LSQModel *lsqm, LSQModelStats *dest)
+{
+    *dest = lsqm->get_stats();
+}
+
+static void
+lsqm_stats_provider(StatsEmitter *em, void *data)
+{
+    const LSQModelStats& st = static_cast<const LSQModel *>(data)->get_stats();
+    statsemit_i64(em, "loads", st.loads);
+    statsemit_i64(em, "stores", st.stores);
+    statsemit_i64(em, "forwarded", st.forwarded);
+    statsemit_i64(em, "partial_waits", st.partial_waits);
+    statsemit_i64(em, "ss_waits", st.ss_waits);
+    statsemit_i64(em, "violations", st.violations);
+    statsemit_i64(em, "squashes", st.squashes);
+    statsemit_i64(em, "ssit_clears", st.ssit_clears);
+}
+
+void
+lsqm_register_stats(LSQModel *lsqm, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, lsqm_stats_provider, lsqm);
+}
+
+void
+lsqm_print_stats(const LSQModel *lsqm, void *c_FILE_out,
+                 const char *prefix)
+{
+    lsqm->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
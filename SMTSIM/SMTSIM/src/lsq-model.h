@@ -0,0 +1,104 @@
+// -*- C++ -*-
+//
+// Load/store queue model: store-to-load forwarding, store-set memory
+// dependence prediction, and memory-order violation detection
+//
+// $Id$
+//
+
+#ifndef LSQ_MODEL_H
+#define LSQ_MODEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each core may have one of these, enabled by its "LSQModel" config block;
+// without it, load/store ordering falls back to the same-cycle
+// "last_store_hash" test in queue.c.
+//
+// Memory instructions enter the model in program order at rename (when they
+// get their "lsqentry"), and leave at commit or squash.  Since instructions
+// are emulated at fetch, addresses are known throughout; as with the cache
+// access in resolve(), we only act on them once the instruction issues.
+//
+// At issue, a load searches older issued stores (youngest first) for an
+// overlapping address: a store that covers the load forwards its data after
+// "forward_lat" cycles instead of the load accessing the D-cache, and one
+// that only partially covers it holds the load in the queue until the store
+// leaves the LSQ.  Older stores which haven't issued yet are ignored: if one
+// of them turns out to overlap, the load has violated memory order, which is
+// noticed when that store's address is ready.  The load and everything
+// after it are then squashed and re-fetched (see lsqm_take_violation()).
+//
+// The store-set predictor (Chrysos & Emer, ISCA 1998) learns from those
+// violations: loads (and stores) in a store set wait in the queue until the
+// most recently renamed store in the same set has issued.
+
+struct CoreResources;
+struct context;
+struct activelist;
+
+typedef struct LSQModel LSQModel;
+typedef struct LSQModelStats LSQModelStats;
+struct StatsReg;
+
+struct LSQModelStats {
+    i64 loads, stores;          // issued
+    i64 forwarded;              // loads satisfied by an older store
+    i64 partial_waits;          // issue-cycles loads held: partial overlap
+    i64 ss_waits;               // issue-cycles held by store-set prediction
+    i64 violations;             // memory-order violations detected
+    i64 squashes;               // ...which led to a squash (not superseded)
+    i64 ssit_clears;
+};
+
+
+LSQModel *lsqm_create(const char *name, const char *config_path,
+                      struct CoreResources *core);
+void lsqm_destroy(LSQModel *lsqm);
+
+// A memory instruction was renamed / left the LSQ (commit or squash)
+void lsqm_renamed(LSQModel *lsqm, const struct context *ctx,
+                  const struct activelist *inst);
+void lsqm_removed(LSQModel *lsqm, const struct context *ctx,
+                  const struct activelist *inst);
+
+// Whether a memory instruction must stay in the queue this cycle.  May be
+// called several times per instruction per cycle; "allow_stats_update" must
+// only be set on one of these calls.
+int lsqm_issue_wait(LSQModel *lsqm, const struct context *ctx,
+                    const struct activelist *inst, int allow_stats_update);
+
+// A load issued, with its address ready at "addr_ready_cyc".  Returns
+// nonzero iff it's satisfied by store-to-load forwarding, with the cycle its
+// value is ready written to "fwd_done_ret".  If "may_forward" is zero, the
+// load is only noted as issued.
+int lsqm_load_issued(LSQModel *lsqm, const struct context *ctx,
+                     const struct activelist *inst, i64 addr_ready_cyc,
+                     int may_forward, i64 *fwd_done_ret);
+
+// A store issued, with its address and data ready at "addr_ready_cyc";
+// checks younger loads for memory-order violations.
+void lsqm_store_issued(LSQModel *lsqm, const struct context *ctx,
+                       const struct activelist *inst, i64 addr_ready_cyc);
+
+// If a memory-order violation in "ctx" is due to be acted on this cycle,
+// returns the alist ID of the oldest violating load, which should be
+// squashed along with everything after it; otherwise returns -1.
+int lsqm_take_violation(LSQModel *lsqm, const struct context *ctx);
+
+void lsqm_reset_stats(LSQModel *lsqm);
+void lsqm_get_stats(const LSQModel *lsqm, LSQModelStats *dest);
+// Register a provider for LSQModelStats at "path" (stats-reg.h)
+void lsqm_register_stats(LSQModel *lsqm, struct StatsReg *sr,
+                         const char *path);
+void lsqm_print_stats(const LSQModel *lsqm, void *c_FILE_out,
+                      const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // LSQ_MODEL_H
@@ -70,6 +70,7 @@ which contains the following copyright:
 #include "sim-cfg.h"
 #include "jtimer.h"
 #include "region-alloc.h"
+#include "prog-mem.h"
 #include "syscalls.h"
 #include "sim-params.h"
 #include "context.h"
@@ -78,6 +79,8 @@ which contains the following copyright:
 #include "work-queue.h"
 #include "bbtracker.h"
 #include "adapt-mgr.h"
+#include "wsm.h"
+#include "stats-reg.h"
 
 int warmup = 0;
 i64 warmuptime;
@@ -101,6 +104,7 @@ struct JTimer *OverallTimer;    // Total SMTSIM run timer
 struct JTimer *SimTimer;        // Simulation timer
 
 struct RegionAlloc *GlobalAlloc;        // Segment allocation manager
+static int GlobalAllocStats = 0;        // Flag: report GlobalAlloc stats
 
 struct AppMgr *GlobalAppMgr;
 struct CallbackQueue *GlobalEventQueue;
@@ -471,10 +475,33 @@ main(int argc, char *argv[], char *mainenv[])
     // wrong-path execution which generates valid virtual addresses may read
     // uninitialized memory as returned from the region-allocator, altering
     // wrong-path execution and changing stats non-repeatably.
-    if (!(GlobalAlloc = ralloc_create(1))) {
+    {
+        int file_maps = simcfg_get_bool("Global/Mem/mmap_exec_segments");
+        RAHugePolicy huge_policy = (RAHugePolicy)
+            simcfg_get_enum(RAHugePolicy_names,
+                            "Global/Mem/HugePages/policy");
+        i64 huge_min_kb = simcfg_get_i64("Global/Mem/HugePages/min_region_kb");
+        if (huge_min_kb < 0) {
+            exit_printf("bad Global/Mem/HugePages/min_region_kb (%s)\n",
+                        fmt_i64(huge_min_kb));
+        }
+        if (file_maps || (huge_policy != RAHuge_None)) {
+            if (!(GlobalAlloc = ralloc_create_mmap(1, huge_policy,
+                                                   huge_min_kb * 1024,
+                                                   file_maps))) {
+                err_printf("%s: mmap region-allocator unavailable; "
+                           "no huge pages or file-mapped executables\n",
+                           fname);
+            }
+            GlobalAllocStats = (GlobalAlloc != NULL);
+        }
+    }
+    if (!GlobalAlloc && !(GlobalAlloc = ralloc_create(1))) {
         exit_printf("%s: couldn't create GlobalAlloc region-allocator\n",
                     fname);
     }
+    pmem_set_sparse_chunk_bytes(GlobalParams.mem.sparse_chunk_kb *
+                                I64_LIT(1024));
 
 
     FILE_DevNullIn = (void *) efopen("/dev/null", 0);
@@ -484,6 +511,14 @@ main(int argc, char *argv[], char *mainenv[])
         exit_printf("%s: couldn't create GlobalEventQueue\n", fname);
     }
 
+    if (simcfg_get_bool("StatsReport/enable")) {
+        // (must precede initcache() and init_cores(), whose modules
+        // register their stats providers as they're created)
+        if (!(GlobalStatsReg = statsreg_create("StatsReport"))) {
+            exit_printf("%s: couldn't create GlobalStatsReg\n", fname);
+        }
+    }
+
     {
         AppMgrParams app_mgr_params;
         simcfg_appmgr_params(&app_mgr_params);
@@ -495,6 +530,14 @@ main(int argc, char *argv[], char *mainenv[])
     }
 
 
+    if (simcfg_get_bool("WSM/enable")) {
+        // (must precede init_cores(), which creates per-core capture units)
+        if (!(GlobalWSMCoord = wsm_coord_create("WSM"))) {
+            exit_printf("%s: couldn't create GlobalWSMCoord.\n", fname);
+        }
+    }
+
+
     simcfg_bbv_params (&BBTrackerParams);
     
     if (!(GlobalWorkQueue = workq_create("WorkQueue",
@@ -509,6 +552,8 @@ main(int argc, char *argv[], char *mainenv[])
         init_coher();
         init_contexts();
         init_cores();
+        if (GlobalStatsReg)
+            appextra_register_stats(GlobalStatsReg, "apps");
         initsched();
         zero_pstats();
        
@@ -600,6 +645,15 @@ init_cores(void)
     int thread;
 
     create_cores();
+    if (GlobalWSMCoord) {
+        int core_id;
+        for (core_id = 0; core_id < CoreCount; core_id++) {
+            char name[40];
+            e_snprintf(name, sizeof(name), "C%d", core_id);
+            Cores[core_id]->wsm_capture =
+                wsm_coord_create_threadcap(GlobalWSMCoord, name);
+        }
+    }
     for (thread = 0; thread < CtxCount; thread++) {
         int core_id = GlobalParams.thread_core_map.map[thread];
         core_add_context(Cores[core_id], Contexts[thread]);
@@ -632,6 +686,8 @@ time_stats(void)
            (double) sim_cyc / (sim_times.user_msec / 1000.0),
            (double) total_insts / (sim_times.user_msec / 1000.0));
     printf("--Total run time: %s sec\n", fmt_times(&tot_times));
+    if (GlobalAllocStats)
+        ralloc_print_stats(GlobalAlloc, stdout, "--");
 }
 
 
@@ -58,6 +58,7 @@ struct CoreResources;
 struct activelist;
 struct context;
 struct StashData;
+struct StageQueue;
 struct TraceCacheInst;
 
 
@@ -69,8 +70,6 @@ struct TraceCacheInst;
 extern "C" {
 #endif
 
-#define PRIO_INST_COUNT
-
 #ifdef DEBUG
   #define SmtDISASSEMBLE(x, x2, y, z) if (!debug) { } else print(x, x2, y, z);
 #else
@@ -105,6 +104,8 @@ extern i64 DebugCommitNum;
 extern void *FILE_DumpCommitFile;
 /*decode.c*/
 void decode(void);
+void decode_bypassed_group(struct CoreResources * restrict core,
+                           struct StageQueue *stage);
 /*execute.c*/
 extern void initsched(void);
 extern void fix_pcs(void);
@@ -127,6 +128,7 @@ void emulate_inst_for_sim(struct context * restrict ctx,
 extern void resim_branch(struct context * restrict ctx, 
                          struct activelist * restrict inst);
 extern void calculate_priority(void);
+void discard_misfetches(struct context *ctx);
 extern void fetch(void);
 
 /* main.c */
@@ -157,9 +159,17 @@ extern void init_pht(void);
 extern void init_btb(void);
 extern int get_bpredict(struct context *, u64, int);
 extern int bpredict(struct context *, u64, int, int);
-extern void update_pht(struct context *, u64, int, int);
-extern u64 btblookup(struct context *, u64, u64, int, int);
-extern u64 get_btblookup(struct context *, u64);
+extern void update_pht(struct context *, u64, int, int, i64);
+extern i64 bpred_hist_push(struct context *, u64, int);
+extern i64 bpred_hist_pos(const struct context *);
+extern void bpred_hist_restore(struct context *, i64);
+extern void bpred_hist_repair(struct context *, i64, u64, int);
+extern u64 btblookup(struct context *, u64, u64, int, int, int *);
+extern u64 get_btblookup(struct context *, u64, int *);
+extern u64 indirect_predict(struct context *, u64, u64, int *);
+extern void ind_hist_push(struct context *, struct activelist *, int, u64);
+extern void ind_hist_repair(struct context *, const struct activelist *);
+extern void update_indirect(struct context *, const struct activelist *);
 extern void predict_stats(void);
 extern void zero_pstats(void);
 extern void rs_push(struct context *, u64);
@@ -0,0 +1,304 @@
+//
+// Memory-reference profiler: generates per-instruction memory access
+// samples at commit, for logging and for working-set capture
+//
+// $Id$
+//
+
+const char RCSid_1760000040[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "mem-profiler.h"
+#include "mem-ref-seq.h"
+#include "wsm.h"
+#include "app-state.h"
+#include "context.h"
+#include "core-resources.h"
+#include "dyn-inst.h"
+#include "stash.h"
+#include "prog-mem.h"
+#include "reg-defs.h"
+#include "inst.h"
+#include "sign-extend.h"
+#include "sim-params.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+
+
+using std::map;
+using std::ostream;
+using std::string;
+
+using SimCfg::conf_bool;
+using SimCfg::conf_str;
+
+
+const char *MemProfOp_names[] = {
+    "InstFetch", "DataLoad", "DataStore", NULL
+};
+
+MemProfiler *GlobalMemProfiler = NULL;
+
+
+namespace {
+
+struct MemProfConfig {
+    bool log_enable;
+    bool log_dstream;
+    bool log_istream;
+    string log_name;
+
+    NoDefaultCopy nocopy;
+
+public:
+    MemProfConfig(const string& cfg_path);
+    ~MemProfConfig() { }
+};
+
+
+MemProfConfig::MemProfConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    log_enable = conf_bool(cp + "enable");
+    log_dstream = conf_bool(cp + "log_dstream");
+    log_istream = conf_bool(cp + "log_istream");
+    if (log_enable && !conf_bool(cp + "log_at_commit")) {
+        exit_printf("%slog_at_commit: only commit-time profiling is "
+                    "supported\n", cp.c_str());
+    }
+    log_name = conf_str(cp + "log_name");
+}
+
+
+// Per-app state, created at an app's first commit
+struct AppProfState {
+    bool have_prev;             // prev_* valid
+    mem_addr prev_pc;           // last committed inst
+    bool prev_taken;            // ...was a taken branch
+    ostream *log_stream;        // NULL unless logging
+    MemRefSeq_Writer *log_writer;
+
+    AppProfState()
+        : have_prev(false), prev_pc(0), prev_taken(false), log_stream(NULL),
+          log_writer(NULL) { }
+};
+
+} // Anonymous namespace close
+
+
+struct MemProfiler {
+private:
+    typedef map<int, AppProfState *> AppStateMap;
+
+    MemProfConfig conf_;
+    int fetch_block_lg_;
+    AppStateMap apps_;          // app_id -> state (owned)
+
+    string log_file_name(int app_id) const;
+    AppProfState *get_app(const AppState *as);
+    void log_sample(AppProfState *ps, const AppState *as,
+                    const activelist *inst, const MemProfSample *samp);
+
+public:
+    MemProfiler(const string& config_path);
+    ~MemProfiler();
+
+    void inst_commit(context *ctx, const activelist *inst);
+    void flush();
+};
+
+
+MemProfiler::MemProfiler(const string& config_path)
+    : conf_(config_path),
+      fetch_block_lg_(GlobalParams.mem.cache_block_bytes_lg)
+{
+    sim_assert(fetch_block_lg_ > 0);
+}
+
+
+MemProfiler::~MemProfiler()
+{
+    FOR_ITER(AppStateMap, apps_, iter) {
+        AppProfState *ps = iter->second;
+        delete ps->log_writer;
+        delete ps->log_stream;          // (finishes any compression)
+        delete ps;
+    }
+}
+
+
+string
+MemProfiler::log_file_name(int app_id) const
+{
+    string name = conf_.log_name;
+    string suffix;
+    if ((name.size() > 3) && (name.compare(name.size() - 3, 3, ".gz") == 0)) {
+        suffix = ".gz";
+        name.erase(name.size() - 3);
+    }
+    return name + ".A" + fmt_i64(app_id) + suffix;
+}
+
+
+AppProfState *
+MemProfiler::get_app(const AppState *as)
+{
+    AppProfState *ps = map_at_default(apps_, as->app_id, NULL);
+    if (!ps) {
+        ps = new AppProfState();
+        if (conf_.log_enable) {
+            string file_name = log_file_name(as->app_id);
+            if (!(ps->log_stream =
+                  open_ostream_auto_comp(file_name.c_str()))) {
+                exit_printf("MemProfiler: couldn't create log file "
+                            "\"%s\"\n", file_name.c_str());
+            }
+            ps->log_writer = new MemRefSeq_Writer(ps->log_stream);
+        }
+        map_put_uniq(apps_, as->app_id, ps);
+    }
+    return ps;
+}
+
+
+void
+MemProfiler::log_sample(AppProfState *ps, const AppState *as,
+                        const activelist *inst, const MemProfSample *samp)
+{
+    bool want = (samp->op_type == MPO_InstFetch) ? conf_.log_istream :
+        conf_.log_dstream;
+    if (!want)
+        return;
+    ps->log_writer->write_rec(MemRefSeq_Record(inst->app_inst_num,
+                                               as->extra->total_commits,
+                                               samp->op_type, samp->pc,
+                                               samp->addr.a));
+}
+
+
+void
+MemProfiler::inst_commit(context *ctx, const activelist *inst)
+{
+    AppState *as = inst->as;
+    AppProfState *ps = get_app(as);
+    WSM_ThreadCapture *capture = ctx->core->wsm_capture;
+    bool to_wsm = capture &&
+        wsm_coord_wantsample(GlobalWSMCoord, ctx, as);
+    bool to_log = ps->log_writer != NULL;
+
+    bool new_fetch_block = !ps->have_prev || ps->prev_taken ||
+        ((inst->pc >> fetch_block_lg_) != (ps->prev_pc >> fetch_block_lg_));
+    mem_addr branch_pc = (ps->have_prev && ps->prev_taken) ? ps->prev_pc : 0;
+    ps->have_prev = true;
+    ps->prev_pc = inst->pc;
+    ps->prev_taken = inst->br_flags && inst->taken_branch;
+
+    if (!to_wsm && !to_log)
+        return;
+
+    MemProfSample samp;
+    samp.app_id = as->app_id;
+    samp.width = 0;
+    samp.offset = 0;
+    samp.addr_regnum = IZERO_REG;
+    samp.addr_regval = 0;
+    samp.data_regnum = IZERO_REG;
+    samp.data_regval = 0;
+
+    if (new_fetch_block) {
+        samp.op_type = MPO_InstFetch;
+        samp.addr.set(inst->pc, as->app_master_id);
+        samp.pc = branch_pc;
+        if (to_wsm)
+            wsm_threadcap_sample(capture, as, &samp);
+        if (to_log)
+            log_sample(ps, as, inst, &samp);
+    }
+
+    if (inst->mem_flags) {
+        const StashData *st = stash_decode_inst(as->stash, inst->pc);
+        bool is_store = !(inst->mem_flags & SMF_Read);
+        mem_addr ea = (is_store) ? inst->destmem : inst->srcmem;
+        samp.op_type = (is_store) ? MPO_DataStore : MPO_DataLoad;
+        samp.addr.set(ea, as->app_master_id);
+        samp.pc = inst->pc;
+        samp.width = SMF_GetWidth(inst->mem_flags);
+        samp.offset = (int) SEXT16_i64(INST_MEM_FUNC(st->inst));
+        samp.addr_regnum = st->src_b;
+        samp.addr_regval = ea - (i64) samp.offset;
+        samp.data_regnum = (is_store) ? st->src_a : st->dest;
+        samp.data_regval = pmem_read_n(as->pmem, samp.width, ea,
+                                       PMAF_NoExcept);
+        if (to_wsm)
+            wsm_threadcap_sample(capture, as, &samp);
+        if (to_log)
+            log_sample(ps, as, inst, &samp);
+    }
+}
+
+
+void
+MemProfiler::flush()
+{
+    FOR_ITER(AppStateMap, apps_, iter) {
+        if (iter->second->log_stream)
+            iter->second->log_stream->flush();
+    }
+}
+
+
+const char *
+fmt_memsamp_static(const MemProfSample *samp)
+{
+    static char buf[200];
+    e_snprintf(buf, sizeof(buf), "A%d %s addr %s pc %s width %d offset %d "
+               "r%d=%s r%d=%s", samp->app_id,
+               ENUM_STR(MemProfOp, samp->op_type), fmt_laddr(samp->addr),
+               fmt_x64(samp->pc), samp->width, samp->offset,
+               samp->addr_regnum, fmt_x64(samp->addr_regval),
+               samp->data_regnum, fmt_x64(samp->data_regval));
+    return buf;
+}
+
+
+
+//
+// C interface
+//
+
+MemProfiler *
+memprof_create(const char *config_path)
+{
+    return new MemProfiler(config_path);
+}
+
+void
+memprof_destroy(MemProfiler *mp)
+{
+    delete mp;
+}
+
+void
+memprof_inst_commit(MemProfiler *mp, struct context *ctx,
+                    const struct activelist *inst)
+{
+    mp->inst_commit(ctx, inst);
+}
+
+void
+memprof_flush(MemProfiler *mp)
+{
+    mp->flush();
+}
@@ -0,0 +1,83 @@
+// -*- C++ -*-
+//
+// Memory-reference profiler: generates per-instruction memory access
+// samples at commit, for logging and for working-set capture
+//
+// $Id$
+//
+
+#ifndef MEM_PROFILER_H
+#define MEM_PROFILER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One MemProfiler (GlobalMemProfiler) is created at startup if either
+// "GlobalMemProfiler/enable" or "WSM/enable" is set.  It's told about each
+// correct-path instruction as it commits, and turns that into zero or more
+// MemProfSamples: an MPO_InstFetch for the first instruction of each
+// fetch block (i.e. following a taken branch, or crossing into the next
+// I-cache block), and an MPO_DataLoad or MPO_DataStore for memory ops.
+//
+// Samples are sent to the committing core's WSM capture unit, when the WSM
+// coordinator wants them; with "GlobalMemProfiler/enable" set, they're
+// also logged as MemRefSeq records (see mem-ref-seq.h), one file per app,
+// named "<log_name>.A<app_id>" (before any ".gz" suffix on log_name).
+//
+// Since samples are taken at commit, register values which aren't evident
+// from the committed instruction itself are reconstructed: the base register
+// value is derived from the effective address, and the data value is read
+// back from memory, which may have since been overwritten by a younger,
+// already-emulated store.  No-ops which were discarded at fetch never
+// commit, and so never begin a fetch block.
+
+struct context;
+struct activelist;
+
+typedef enum {
+    MPO_InstFetch,
+    MPO_DataLoad,
+    MPO_DataStore,
+    MemProfOp_last
+} MemProfOp;
+extern const char *MemProfOp_names[];
+
+typedef struct MemProfSample MemProfSample;
+typedef struct MemProfiler MemProfiler;
+
+struct MemProfSample {
+    MemProfOp op_type;
+    int app_id;
+    LongAddr addr;              // fetch or effective address
+    mem_addr pc;                // InstFetch: PC of taken branch which led
+                                // here, or 0 for sequential; else inst PC
+    int width;                  // access size in bytes (0 for InstFetch)
+    int offset;                 // memory-format displacement
+    int addr_regnum;            // base register ("Rb")
+    u64 addr_regval;
+    int data_regnum;            // load dest / store source ("Ra")
+    u64 data_regval;
+};
+
+extern MemProfiler *GlobalMemProfiler;  // may be NULL
+
+
+MemProfiler *memprof_create(const char *config_path);
+void memprof_destroy(MemProfiler *mp);
+
+// A correct-path instruction from ctx->as is committing
+void memprof_inst_commit(MemProfiler *mp, struct context *ctx,
+                         const struct activelist *inst);
+
+void memprof_flush(MemProfiler *mp);
+
+// Format a sample for debug printing; returns a pointer to static storage
+const char *fmt_memsamp_static(const MemProfSample *samp);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MEM_PROFILER_H
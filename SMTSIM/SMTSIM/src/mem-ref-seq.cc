@@ -0,0 +1,154 @@
+//
+// Sequential memory-reference log ("MemRefSeq") records, with streaming
+// reader and writer
+//
+// $Id$
+//
+
+const char RCSid_1760000041[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "mem-ref-seq.h"
+#include "utils.h"
+#include "utils-cc.h"
+
+
+using std::istream;
+using std::ostream;
+using std::ostringstream;
+using std::string;
+
+
+namespace {
+
+const char HeaderLine[] = "# MemRefSeq";
+
+// One-letter record op codes, indexed by MemProfOp
+const char OpCodes[] = "ILS";
+
+} // Anonymous namespace close
+
+
+string
+MemRefSeq_Record::fmt() const
+{
+    ostringstream ostr;
+    ostr << "inst " << app_inst_num_ << " commit " << app_commit_num_
+         << " " << ENUM_STR(MemProfOp, op_type_)
+         << " pc " << fmt_x64(pc_) << " addr " << fmt_x64(addr_);
+    return ostr.str();
+}
+
+
+bool
+MemRefSeq_Record::parse(const string& line)
+{
+    long long inst_num, commit_num;
+    unsigned long long pc, addr;
+    char op_code, dummy;
+    if (sscanf(line.c_str(), "%lld %lld %c %llx %llx %c", &inst_num,
+               &commit_num, &op_code, &pc, &addr, &dummy) != 5)
+        return false;
+    const char *op_pos = strchr(OpCodes, op_code);
+    if (!op_code || !op_pos || (inst_num < 0) || (commit_num < 0))
+        return false;
+    app_inst_num_ = inst_num;
+    app_commit_num_ = commit_num;
+    op_type_ = MemProfOp(op_pos - OpCodes);
+    pc_ = pc;
+    addr_ = addr;
+    return true;
+}
+
+
+void
+MemRefSeq_Record::write(ostream& out) const
+{
+    sim_assert(ENUM_OK(MemProfOp, op_type_));
+    out << app_inst_num_ << ' ' << app_commit_num_ << ' '
+        << OpCodes[op_type_] << ' ' << fmt_x64(pc_) << ' '
+        << fmt_x64(addr_) << '\n';
+}
+
+
+MemRefSeq_Writer::MemRefSeq_Writer(ostream *out__)
+    : out_(out__), records_(0)
+{
+    *out_ << HeaderLine << '\n';
+}
+
+
+void
+MemRefSeq_Writer::write_rec(const MemRefSeq_Record& rec)
+{
+    rec.write(*out_);
+    records_++;
+}
+
+
+bool
+MemRefSeq_Writer::good() const
+{
+    return out_->good();
+}
+
+
+MemRefSeq_Reader::MemRefSeq_Reader(istream *in__)
+    : in_(in__), line_num_(0), header_read_(false), clean_eof_(false),
+      data_error_(false), good_(true)
+{
+}
+
+
+bool
+MemRefSeq_Reader::read_rec(MemRefSeq_Record *rec)
+{
+    const char *fname = "MemRefSeq_Reader::read_rec";
+    if (!header_read_) {
+        if (!std::getline(*in_, line_) ||
+            (line_.compare(0, strlen(HeaderLine), HeaderLine) != 0)) {
+            err_printf("%s: missing \"%s\" header line\n", fname,
+                       HeaderLine);
+            data_error_ = true;
+            good_ = false;
+            return false;
+        }
+        line_num_++;
+        header_read_ = true;
+    }
+    if (!std::getline(*in_, line_)) {
+        clean_eof_ = in_->eof() && !in_->bad();
+        good_ = false;
+        return false;
+    }
+    line_num_++;
+    if (!rec->parse(line_)) {
+        err_printf("%s: malformed record at line %s: \"%s\"\n", fname,
+                   fmt_i64(line_num_), line_.c_str());
+        data_error_ = true;
+        good_ = false;
+        return false;
+    }
+    return true;
+}
+
+
+bool
+MemRefSeq_Reader::scan_by_instnum(MemRefSeq_Record *rec, i64 inst_num)
+{
+    while (rec->app_inst_num() < inst_num) {
+        if (!read_rec(rec))
+            return false;
+    }
+    return true;
+}
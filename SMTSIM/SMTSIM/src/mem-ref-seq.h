@@ -0,0 +1,108 @@
+// -*- C++ -*-
+//
+// Sequential memory-reference log ("MemRefSeq") records, with streaming
+// reader and writer
+//
+// $Id$
+//
+
+#ifndef MEM_REF_SEQ_H
+#define MEM_REF_SEQ_H
+
+#include <iosfwd>
+#include <string>
+
+#include "sys-types.h"
+#include "utils-cc.h"
+#include "mem-profiler.h"
+
+
+// A MemRefSeq file holds the memory references made by one app, in commit
+// order, one text record per line after a "# MemRefSeq" header line:
+//
+//   <app_inst_num> <app_commit_num> <op> <pc> <addr>
+//
+// where <op> is one of "I" (InstFetch), "L" (DataLoad) or "S" (DataStore),
+// and <pc> and <addr> are hex.  app_commit_num is the app's commit count
+// before the instruction committed.  (See mem-profiler.h for what's
+// recorded; the files are typically gzip-compressed, and read with
+// open_istream_auto_decomp().)
+
+class MemRefSeq_Record {
+    i64 app_inst_num_;
+    i64 app_commit_num_;
+    MemProfOp op_type_;
+    mem_addr pc_;
+    mem_addr addr_;
+
+public:
+    MemRefSeq_Record()
+        : app_inst_num_(-1), app_commit_num_(-1), op_type_(MPO_InstFetch),
+          pc_(0), addr_(0) { }
+    MemRefSeq_Record(i64 app_inst_num__, i64 app_commit_num__,
+                     MemProfOp op_type__, mem_addr pc__, mem_addr addr__)
+        : app_inst_num_(app_inst_num__), app_commit_num_(app_commit_num__),
+          op_type_(op_type__), pc_(pc__), addr_(addr__) { }
+
+    i64 app_inst_num() const { return app_inst_num_; }
+    i64 app_commit_num() const { return app_commit_num_; }
+    MemProfOp op_type() const { return op_type_; }
+    mem_addr pc() const { return pc_; }
+    mem_addr addr() const { return addr_; }
+
+    std::string fmt() const;
+
+    // false <=> "line" is malformed; "this" is unchanged in that case
+    bool parse(const std::string& line);
+    void write(std::ostream& out) const;
+};
+
+
+class MemRefSeq_Writer {
+    std::ostream *out_;         // not owned
+    i64 records_;
+    NoDefaultCopy nocopy;
+
+public:
+    // Writes the header line immediately
+    MemRefSeq_Writer(std::ostream *out__);
+    ~MemRefSeq_Writer() { }
+
+    void write_rec(const MemRefSeq_Record& rec);
+    i64 records_written() const { return records_; }
+    // false <=> the underlying stream has failed
+    bool good() const;
+};
+
+
+class MemRefSeq_Reader {
+    std::istream *in_;          // not owned
+    i64 line_num_;
+    bool header_read_;
+    bool clean_eof_;            // hit end-of-file, with no errors
+    bool data_error_;           // malformed header or record
+    bool good_;                 // no read has failed yet
+    std::string line_;          // scratch
+    NoDefaultCopy nocopy;
+
+public:
+    MemRefSeq_Reader(std::istream *in__);
+    ~MemRefSeq_Reader() { }
+
+    // Read the next record into *rec; false <=> no more records (or a
+    // read/parse error; see clean_eof())
+    bool read_rec(MemRefSeq_Record *rec);
+
+    // Read forward until reaching the first record with app_inst_num >=
+    // "inst_num", leaving it in *rec.  If *rec already qualifies, nothing
+    // is read.  false <=> ran out of records first.
+    bool scan_by_instnum(MemRefSeq_Record *rec, i64 inst_num);
+
+    // false <=> some read_rec() has failed, for whatever reason
+    bool good() const { return good_; }
+    bool clean_eof() const { return clean_eof_; }
+    bool data_error() const { return data_error_; }
+};
+
+
+#endif  // MEM_REF_SEQ_H
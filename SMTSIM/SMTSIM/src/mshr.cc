@@ -145,6 +145,9 @@ public:
         return h((type_ << 30) ^ (ctx_or_cache_id_ << 16) ^ inst_id_);
     }
 
+    MshrConsumerType g_type() const { return type_; }
+    int g_ctx_or_cache_id() const { return ctx_or_cache_id_; }
+
     string fmt() const {
         ostringstream ostr;
         switch (type_) {
@@ -177,6 +180,7 @@ class MshrEntry {
     i64 alloc_time_;
     ConsumerSet consumers_;     // place-holder for more useful things, later?
     bool created_for_prefetch_;
+    map<int, int> data_cons_per_ctx_;   // ctx_id -> # of Data consumers
 
 public:
     MshrEntry(const MshrConfig *conf__, bool created_for_prefetch__) 
@@ -190,19 +194,34 @@ public:
     }
     int g_count() const { return int(consumers_.size()); }
     bool created_for_prefetch() const { return created_for_prefetch_; }
-    void add_consumer(const MshrConsumer& new_cons) {
+    // Returns true iff this is the first Data consumer from its context
+    bool add_consumer(const MshrConsumer& new_cons) {
         sim_assert(intsize(consumers_) < conf_->waiters_per_entry);
         if (!consumers_.insert(new_cons).second) {
             abort_printf("consumer (%s) added when already present\n",
                          new_cons.fmt().c_str());
         }
+        return (new_cons.g_type() == MshrCons_Data) &&
+            (++data_cons_per_ctx_[new_cons.g_ctx_or_cache_id()] == 1);
     }
-    void rem_consumer(const MshrConsumer& victim_cons) {
+    // Returns true iff this was the last Data consumer from its context
+    bool rem_consumer(const MshrConsumer& victim_cons) {
         sim_assert(consumers_.size() > 0);
         if (!consumers_.erase(victim_cons)) {
             abort_printf("consumer (%s) removed when not present\n",
                          victim_cons.fmt().c_str());
         }
+        if (victim_cons.g_type() != MshrCons_Data)
+            return false;
+        map<int, int>::iterator found =
+            data_cons_per_ctx_.find(victim_cons.g_ctx_or_cache_id());
+        sim_assert(found != data_cons_per_ctx_.end());
+        sim_assert(found->second > 0);
+        if (--found->second == 0) {
+            data_cons_per_ctx_.erase(found);
+            return true;
+        }
+        return false;
     }
 
     string fmt() const {
@@ -242,6 +261,31 @@ private:
     MshrAddrMap addr_to_ent_;   // block base addr -> entry
     int prefetch_producers_;    // # of current entries created for PFs
 
+    // Memory-level parallelism: a count of current entries with at least one
+    // Data consumer, and its integral over time, advanced only when the
+    // count changes (or is read).
+    struct MlpAccum {
+        int count;
+        i64 since_cyc;          // "count" unchanged since this cycle
+        i64 busy_cyc;           // cycles before since_cyc with count > 0
+        i64 outstanding_sum;    // "count" summed over those cycles
+        MlpAccum() : count(0), since_cyc(cyc), busy_cyc(0),
+                     outstanding_sum(0) { }
+        void get(i64 *busy_ret, i64 *sum_ret) const {
+            i64 elapsed = (count > 0) ? (cyc - since_cyc) : 0;
+            *busy_ret = busy_cyc + elapsed;
+            *sum_ret = outstanding_sum + elapsed * count;
+        }
+        void add(int delta) {
+            get(&busy_cyc, &outstanding_sum);
+            since_cyc = cyc;
+            count += delta;
+            sim_assert(count >= 0);
+        }
+    };
+    map<int, MlpAccum> ctx_mlp_;        // ctx_id -> that context's producers
+    MlpAccum table_mlp_;                // all contexts' (summed counts)
+
     // We'll count entries freed within a cycle, and pretend they are occupied
     // within the same cycle they're freed, to prevent unintentional
     // "shoot-through" re-use by competing structures in that cycle.  At any
@@ -291,6 +335,10 @@ private:
                 (cyc > last_alloc_.cyc)) ? false :
             (last_alloc_.count >= conf_.max_alloc_per_cyc);
     }
+    void note_ctx_producer(const MshrConsumer& cons, int delta) {
+        ctx_mlp_[cons.g_ctx_or_cache_id()].add(delta);
+        table_mlp_.add(delta);
+    }
     bool prod_table_full() const {
         sim_assert(prod_count() <= conf_.entry_count);
         return (prod_count() == conf_.entry_count);
@@ -328,7 +376,8 @@ public:
             if (ent->full()) {
                 result = MSHR_Full;
             } else {
-                ent->add_consumer(new_cons);
+                if (ent->add_consumer(new_cons))
+                    note_ctx_producer(new_cons, 1);
                 result = MSHR_ReuseOld;
             }
         } else if (prod_table_full()) {
@@ -338,7 +387,8 @@ public:
             // add new producer, add this consumer to it
             ent = &map_put_uniq(addr_to_ent_, base_addr,
                                 MshrEntry(&conf_, false));
-            ent->add_consumer(new_cons);
+            if (ent->add_consumer(new_cons))
+                note_ctx_producer(new_cons, 1);
             result = MSHR_AllocNew;
         }
         if (result != MSHR_Full)
@@ -402,7 +452,8 @@ public:
                    prod_count(),
                    (ent) ? fmt_i64(ent->g_count()) : "(undef)");
         if (ent) {
-            ent->rem_consumer(cons_id);
+            if (ent->rem_consumer(cons_id))
+                note_ctx_producer(cons_id, -1);
         } else {
             fflush(0);
             this->dump(stderr, "");
@@ -462,6 +513,31 @@ public:
         return prefetch_producers_;
     }
 
+    int count_ctx_data_producers(int ctx_id) const {
+        map<int, MlpAccum>::const_iterator found = ctx_mlp_.find(ctx_id);
+        return (found != ctx_mlp_.end()) ? found->second.count : 0;
+    }
+
+    void get_data_mlp(int ctx_id, i64 *busy_ret, i64 *sum_ret) const {
+        if (ctx_id < 0) {
+            table_mlp_.get(busy_ret, sum_ret);
+        } else {
+            map<int, MlpAccum>::const_iterator found = ctx_mlp_.find(ctx_id);
+            if (found != ctx_mlp_.end()) {
+                found->second.get(busy_ret, sum_ret);
+            } else {
+                *busy_ret = 0;
+                *sum_ret = 0;
+            }
+        }
+    }
+
+    void reset_table_mlp() {
+        table_mlp_.add(0);
+        table_mlp_.busy_cyc = 0;
+        table_mlp_.outstanding_sum = 0;
+    }
+
     void dump(FILE *out, const char *pf) const;
 };
 
@@ -606,6 +682,25 @@ mshr_count_prefetch_producers(const MshrTable *mshr)
     return mshr->count_prefetch_producers();
 }
 
+int
+mshr_count_ctx_data_producers(const MshrTable *mshr, int ctx_id)
+{
+    return mshr->count_ctx_data_producers(ctx_id);
+}
+
+void
+mshr_data_mlp(const MshrTable *mshr, int ctx_id, i64 *busy_cyc_ret,
+              i64 *outstanding_sum_ret)
+{
+    mshr->get_data_mlp(ctx_id, busy_cyc_ret, outstanding_sum_ret);
+}
+
+void
+mshr_reset_data_mlp(MshrTable *mshr)
+{
+    mshr->reset_table_mlp();
+}
+
 void
 mshr_dump(const MshrTable *mshr, void *c_FILE_out, const char *prefix)
 {
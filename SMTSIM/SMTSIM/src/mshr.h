@@ -137,6 +137,21 @@ int mshr_any_consumers(const MshrTable *mshr, LongAddr base_addr);
 // prefetches (mshr_alloc_prefetch())?
 int mshr_count_prefetch_producers(const MshrTable *mshr);
 
+// Non-modifying probe: how many current producer entries have at least one
+// data consumer (mshr_alloc_data()) from context "ctx_id"?  This is that
+// context's count of outstanding miss blocks, for MLP measurement.
+int mshr_count_ctx_data_producers(const MshrTable *mshr, int ctx_id);
+
+// Non-modifying probe: memory-level parallelism through the current cycle,
+// for context "ctx_id" (or with ctx_id < 0, all contexts together): the
+// number of cycles with mshr_count_ctx_data_producers() > 0, and that count
+// summed over those cycles.  Per-context values only ever grow, so callers
+// take differences; the all-contexts values restart at
+// mshr_reset_data_mlp().
+void mshr_data_mlp(const MshrTable *mshr, int ctx_id, i64 *busy_cyc_ret,
+                   i64 *outstanding_sum_ret);
+void mshr_reset_data_mlp(MshrTable *mshr);
+
 
 void mshr_dump(const MshrTable *mshr, void *c_FILE_out, const char *prefix);
 
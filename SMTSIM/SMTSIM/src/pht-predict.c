@@ -16,6 +16,7 @@ const char RCSid_1035872632[] =
 #include "sys-types.h"
 #include "pht-predict.h"
 #include "utils.h"
+#include "stats-reg.h"
 
 
 struct PHTPredict {
@@ -160,3 +161,19 @@ pht_get_stats(const PHTPredict *pht, PHTStats *dest)
 {
     memcpy(dest, &pht->stats, sizeof(*dest));
 }
+
+
+static void
+pht_stats_provider(StatsEmitter *em, void *data)
+{
+    const PHTPredict *pht = (const PHTPredict *) data;
+    statsemit_i64(em, "hits", pht->stats.hits);
+    statsemit_i64(em, "misses", pht->stats.misses);
+}
+
+
+void
+pht_register_stats(PHTPredict *pht, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, pht_stats_provider, pht);
+}
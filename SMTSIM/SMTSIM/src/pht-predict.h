@@ -15,6 +15,7 @@ extern "C" {
 
 typedef struct PHTPredict PHTPredict;
 typedef struct PHTStats PHTStats;
+struct StatsReg;
 
 
 struct PHTStats {
@@ -38,6 +39,9 @@ int pht_probe(const PHTPredict *pht, u64 addr, unsigned ghr);
 void pht_update(PHTPredict *pht, u64 addr, int taken, unsigned ghr);
 
 void pht_get_stats(const PHTPredict *pht, PHTStats *dest);
+/* Register a provider for this PHT's PHTStats at "path" (stats-reg.h) */
+void pht_register_stats(PHTPredict *pht, struct StatsReg *sr,
+                        const char *path);
 
 
 #ifdef __cplusplus
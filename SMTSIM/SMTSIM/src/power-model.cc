@@ -0,0 +1,547 @@
+//
+// Activity-based power model: per-structure dynamic energy per access and
+// leakage per cycle, scaled from configured structure sizes
+//
+// $Id$
+//
+
+const char RCSid_1760000042[] =
+"$Id$";
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "power-model.h"
+#include "app-state.h"
+#include "context.h"
+#include "core-resources.h"
+#include "cache-params.h"
+#include "callback-queue.h"
+#include "main.h"
+#include "sim-params.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stats-reg.h"
+
+
+using std::map;
+using std::string;
+using std::vector;
+
+using SimCfg::conf_bool;
+using SimCfg::conf_double;
+using SimCfg::conf_i64;
+using SimCfg::conf_str;
+
+
+PowerModel *GlobalPowerModel = NULL;
+
+
+namespace {
+
+enum PowerStruct {
+    PS_ITLB, PS_DTLB, PS_ICache, PS_DCache, PS_L2Cache, PS_L3Cache,
+    PS_BPred, PS_IntALU, PS_FpALU, PS_LdSt, PS_IQ, PS_FQ, PS_IReg, PS_FReg,
+    PS_IRen, PS_FRen, PS_LSQ, PS_ROB, PowerStruct_last
+};
+
+struct StructInfo {
+    const char *name;                   // config and stats name
+    i64 AppStateExtras::*acc_counter;   // per-app access count
+    bool is_cache;                      // has size in KB, and assoc
+};
+
+// (Indexed by PowerStruct)
+const StructInfo StructTable[] = {
+    { "itlb", &AppStateExtras::itlb_acc, false },
+    { "dtlb", &AppStateExtras::dtlb_acc, false },
+    { "icache", &AppStateExtras::icache_acc, true },
+    { "dcache", &AppStateExtras::dcache_acc, true },
+    { "l2cache", &AppStateExtras::l2cache_acc, true },
+    { "l3cache", &AppStateExtras::l3cache_acc, true },
+    { "bpred", &AppStateExtras::bpred_acc, false },
+    { "intalu", &AppStateExtras::intalu_acc, false },
+    { "fpalu", &AppStateExtras::fpalu_acc, false },
+    { "ldst", &AppStateExtras::ldst_acc, false },
+    { "iq", &AppStateExtras::iq_acc, false },
+    { "fq", &AppStateExtras::fq_acc, false },
+    { "ireg", &AppStateExtras::ireg_acc, false },
+    { "freg", &AppStateExtras::freg_acc, false },
+    { "iren", &AppStateExtras::iren_acc, false },
+    { "fren", &AppStateExtras::fren_acc, false },
+    { "lsq", &AppStateExtras::lsq_acc, false },
+    { "rob", &AppStateExtras::rob_acc, false },
+};
+
+
+struct StructCoeffs {
+    double acc_pj;              // dynamic energy per access, at ref_size
+    double leak_mw;             // leakage power, at ref_size
+    double ref_size;
+    double ref_assoc;           // caches only
+};
+
+
+struct PowerConfig {
+    double clock_hz;
+    i64 interval_cyc;
+    string log_name;            // empty: no interval log
+    double dyn_size_exp;
+    double assoc_exp;
+    StructCoeffs coeffs[PowerStruct_last];
+
+    NoDefaultCopy nocopy;
+
+public:
+    PowerConfig(const string& cfg_path);
+    ~PowerConfig() { }
+};
+
+
+PowerConfig::PowerConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";         // short-hand for config-path
+
+    double clock_ghz = conf_double(cp + "clock_ghz");
+    if (clock_ghz <= 0) {
+        exit_printf("bad %sclock_ghz (%g)\n", cp.c_str(), clock_ghz);
+    }
+    clock_hz = clock_ghz * 1e9;
+    interval_cyc = conf_i64(cp + "interval_cyc");
+    if (interval_cyc < 1) {
+        exit_printf("bad %sinterval_cyc (%s)\n", cp.c_str(),
+                    fmt_i64(interval_cyc));
+    }
+    log_name = conf_str(cp + "log_name");
+    dyn_size_exp = conf_double(cp + "dyn_size_exp");
+    assoc_exp = conf_double(cp + "assoc_exp");
+    for (int i = 0; i < PowerStruct_last; i++) {
+        string sp = cp + "Structs/" + StructTable[i].name + "/";
+        StructCoeffs& co = coeffs[i];
+        co.acc_pj = conf_double(sp + "acc_pj");
+        co.leak_mw = conf_double(sp + "leak_mw");
+        co.ref_size = conf_double(sp + "ref_size");
+        co.ref_assoc = (StructTable[i].is_cache) ?
+            conf_double(sp + "ref_assoc") : 1.0;
+        if ((co.acc_pj < 0) || (co.leak_mw < 0) || (co.ref_size <= 0) ||
+            (co.ref_assoc <= 0)) {
+            exit_printf("%s: energies must be non-negative, and reference "
+                        "sizes positive\n", sp.c_str());
+        }
+    }
+}
+
+
+// A core, or the shared caches below the cores ("uncore")
+struct PowerDomain {
+    string name;
+    double acc_j[PowerStruct_last];     // energy per access, scaled (J)
+    double leak_w;                      // total leakage (W)
+    double dyn_j[PowerStruct_last];     // dynamic energy so far
+    double leak_j;
+    double j_at_last_log;
+
+    PowerDomain(const string& name_) : name(name_), leak_w(0), leak_j(0),
+                                       j_at_last_log(0) {
+        for (int i = 0; i < PowerStruct_last; i++)
+            acc_j[i] = dyn_j[i] = 0;
+    }
+    void clear_coeffs() {
+        for (int i = 0; i < PowerStruct_last; i++)
+            acc_j[i] = 0;
+        leak_w = 0;
+    }
+    void reset_energy() {
+        for (int i = 0; i < PowerStruct_last; i++)
+            dyn_j[i] = 0;
+        leak_j = 0;
+        j_at_last_log = 0;
+    }
+    double total_dyn_j() const {
+        double sum = 0;
+        for (int i = 0; i < PowerStruct_last; i++)
+            sum += dyn_j[i];
+        return sum;
+    }
+    double total_j() const { return total_dyn_j() + leak_j; }
+};
+
+
+// Access counts as of the last sample, per app
+struct AppSnapshot {
+    i64 acc[PowerStruct_last];
+    AppSnapshot() {
+        for (int i = 0; i < PowerStruct_last; i++)
+            acc[i] = 0;
+    }
+};
+
+} // Anonymous namespace close
+
+
+struct PowerModel {
+private:
+    class IntervalCB;
+    typedef map<int, AppSnapshot> AppSnapshotMap;
+
+    PowerConfig conf_;
+    vector<PowerDomain> domains_;       // [0..CoreCount-1]: cores; then uncore
+    int uncore_;                        // index of uncore domain
+    bool shared_l2_;
+    AppSnapshotMap apps_;
+    i64 start_cyc_;
+    i64 commits_at_start_;              // all apps' total_commits
+    i64 last_sample_cyc_;
+    i64 last_log_cyc_;
+    FILE *log_file_;
+    IntervalCB *interval_cb_;
+
+    void setup_struct(PowerDomain& dom, PowerStruct which, double size,
+                      double assoc);
+    void setup_cache(PowerDomain& dom, PowerStruct which,
+                     const CacheGeometry *geom);
+    void setup_core(PowerDomain& dom, const CoreResources *core);
+    i64 sys_commits() const;
+    int app_domain(const AppState *as) const;
+    double secs(i64 n_cyc) const { return n_cyc / conf_.clock_hz; }
+    void log_interval();
+
+public:
+    PowerModel(const string& config_path);
+    ~PowerModel();
+
+    void sample();
+    void interval_tick() {
+        sample();
+        if (log_file_)
+            log_interval();
+    }
+    i64 interval_cyc() const { return conf_.interval_cyc; }
+    void reset_stats();
+    void printstats(FILE *out, const char *pf) const;
+    void emit_stats(StatsEmitter *em);
+};
+
+
+class PowerModel::IntervalCB : public CBQ_Callback {
+    PowerModel& pm;
+public:
+    IntervalCB(PowerModel& pm_) : pm(pm_) { }
+    i64 invoke(CBQ_Args *args) {
+        pm.interval_tick();
+        return cyc + pm.interval_cyc();
+    }
+};
+
+
+PowerModel::PowerModel(const string& config_path)
+    : conf_(config_path), uncore_(CoreCount),
+      shared_l2_(!GlobalParams.mem.private_l2caches), start_cyc_(cyc),
+      commits_at_start_(0), last_sample_cyc_(cyc), last_log_cyc_(cyc), log_file_(NULL),
+      interval_cb_(NULL)
+{
+    for (int core_id = 0; core_id < CoreCount; core_id++) {
+        domains_.push_back(PowerDomain("C" + string(fmt_i64(core_id))));
+        setup_core(domains_.back(), Cores[core_id]);
+    }
+    domains_.push_back(PowerDomain("uncore"));
+    if (shared_l2_)
+        setup_cache(domains_[uncore_], PS_L2Cache,
+                    GlobalParams.mem.l2cache_geom);
+    if (GlobalParams.mem.use_l3cache)
+        setup_cache(domains_[uncore_], PS_L3Cache,
+                    GlobalParams.mem.l3cache_geom);
+
+    if (!conf_.log_name.empty()) {
+        log_file_ = static_cast<FILE *>(efopen(conf_.log_name.c_str(), 1));
+        fprintf(log_file_, "# power log, %.3f GHz, interval %s cyc\n"
+                "# fields: cyc", conf_.clock_hz / 1e9,
+                fmt_i64(conf_.interval_cyc));
+        for (size_t i = 0; i < domains_.size(); i++)
+            fprintf(log_file_, " %s_W", domains_[i].name.c_str());
+        fprintf(log_file_, " total_W\n");
+    }
+
+    interval_cb_ = new IntervalCB(*this);
+    callbackq_enqueue(GlobalEventQueue, cyc + conf_.interval_cyc,
+                      interval_cb_);
+}
+
+
+PowerModel::~PowerModel()
+{
+    if (interval_cb_)
+        callbackq_cancel(GlobalEventQueue, interval_cb_);
+    if (log_file_)
+        fclose(log_file_);
+}
+
+
+void
+PowerModel::setup_struct(PowerDomain& dom, PowerStruct which, double size,
+                         double assoc)
+{
+    const StructCoeffs& co = conf_.coeffs[which];
+    if (size <= 0)
+        return;                         // structure not present
+    double scale = pow(size / co.ref_size, conf_.dyn_size_exp);
+    if (StructTable[which].is_cache)
+        scale *= pow(assoc / co.ref_assoc, conf_.assoc_exp);
+    dom.acc_j[which] = co.acc_pj * 1e-12 * scale;
+    dom.leak_w += co.leak_mw * 1e-3 * (size / co.ref_size);
+}
+
+
+void
+PowerModel::setup_cache(PowerDomain& dom, PowerStruct which,
+                        const CacheGeometry *geom)
+{
+    if (geom)
+        setup_struct(dom, which, geom->size_kb, geom->assoc);
+}
+
+
+void
+PowerModel::setup_core(PowerDomain& dom, const CoreResources *core)
+{
+    const CoreParams& p = core->params;
+    int rob_entries = 0;
+    for (int i = 0; i < core->n_contexts; i++)
+        rob_entries += core->contexts[i]->params.reorder_buffer_size;
+
+    setup_struct(dom, PS_ITLB, p.itlb_entries, 1);
+    setup_struct(dom, PS_DTLB, p.dtlb_entries, 1);
+    setup_cache(dom, PS_ICache, p.icache.geom);
+    setup_cache(dom, PS_DCache, p.dcache.geom);
+    if (!shared_l2_)
+        setup_cache(dom, PS_L2Cache, p.private_l2cache.geom);
+    setup_struct(dom, PS_BPred, p.pht_entries, 1);
+    setup_struct(dom, PS_IntALU, p.queue.max_int_issue, 1);
+    setup_struct(dom, PS_FpALU, p.queue.max_float_issue, 1);
+    setup_struct(dom, PS_LdSt, p.queue.max_ldst_issue, 1);
+    setup_struct(dom, PS_IQ, p.queue.int_queue_size, 1);
+    setup_struct(dom, PS_FQ, p.queue.float_queue_size, 1);
+    setup_struct(dom, PS_IReg, p.rename.int_rename_regs, 1);
+    setup_struct(dom, PS_FReg, p.rename.float_rename_regs, 1);
+    setup_struct(dom, PS_IRen, p.rename.int_rename_regs, 1);
+    setup_struct(dom, PS_FRen, p.rename.float_rename_regs, 1);
+    setup_struct(dom, PS_LSQ, p.loadstore_queue_size, 1);
+    setup_struct(dom, PS_ROB, rob_entries, 1);
+}
+
+
+// Core domain an app's activity is charged to: where it's running now, or
+// else where it last ran; -1 if it hasn't run yet
+int
+PowerModel::app_domain(const AppState *as) const
+{
+    for (int i = 0; i < CtxCount; i++) {
+        const context *ctx = Contexts[i];
+        if (ctx && (ctx->as == as))
+            return ctx->core->core_id;
+    }
+    int last_ctx = as->extra->last_go_ctx_id;
+    return (last_ctx >= 0) ? Contexts[last_ctx]->core->core_id : -1;
+}
+
+
+void
+PowerModel::sample()
+{
+    if (cyc == last_sample_cyc_)
+        return;
+
+    // Dynamic: new accesses since the last sample, by app
+    const AppState *as;
+    appstate_global_iter_reset();
+    while ((as = appstate_global_iter_next()) != NULL) {
+        AppSnapshot& snap = apps_[as->app_id];
+        int core_dom = app_domain(as);
+        for (int i = 0; i < PowerStruct_last; i++) {
+            i64 now_acc = as->extra->*(StructTable[i].acc_counter);
+            i64 delta = now_acc - snap.acc[i];
+            snap.acc[i] = now_acc;
+            if ((delta <= 0) || (core_dom < 0))
+                continue;
+            bool to_uncore = (i == PS_L3Cache) ||
+                ((i == PS_L2Cache) && shared_l2_);
+            PowerDomain& dom = domains_[(to_uncore) ? uncore_ : core_dom];
+            dom.dyn_j[i] += delta * dom.acc_j[i];
+        }
+    }
+
+    // Static: leakage over the whole period
+    double period_s = secs(cyc - last_sample_cyc_);
+    for (size_t d = 0; d < domains_.size(); d++)
+        domains_[d].leak_j += domains_[d].leak_w * period_s;
+    last_sample_cyc_ = cyc;
+
+    // Core structure sizes may have been changed (e.g. by reconf-ctl); the
+    // next period is charged at the sizes in effect now.
+    for (int core_id = 0; core_id < CoreCount; core_id++) {
+        domains_[core_id].clear_coeffs();
+        setup_core(domains_[core_id], Cores[core_id]);
+    }
+}
+
+
+i64
+PowerModel::sys_commits() const
+{
+    i64 result = 0;
+    const AppState *as;
+    appstate_global_iter_reset();
+    while ((as = appstate_global_iter_next()) != NULL)
+        result += as->extra->total_commits;
+    return result;
+}
+
+
+// Start measuring afresh (end of warmup): activity so far is absorbed into
+// the per-app snapshots, and not charged
+void
+PowerModel::reset_stats()
+{
+    sample();
+    for (size_t d = 0; d < domains_.size(); d++)
+        domains_[d].reset_energy();
+    start_cyc_ = cyc;
+    last_log_cyc_ = cyc;
+    commits_at_start_ = sys_commits();
+}
+
+
+void
+PowerModel::log_interval()
+{
+    double period_s = secs(cyc - last_log_cyc_);
+    double total_w = 0;
+    fputs(fmt_i64(cyc), log_file_);
+    for (size_t d = 0; d < domains_.size(); d++) {
+        PowerDomain& dom = domains_[d];
+        double now_j = dom.total_j();
+        double watts = (period_s > 0) ?
+            ((now_j - dom.j_at_last_log) / period_s) : 0.0;
+        dom.j_at_last_log = now_j;
+        total_w += watts;
+        fprintf(log_file_, " %.4f", watts);
+    }
+    fprintf(log_file_, " %.4f\n", total_w);
+    last_log_cyc_ = cyc;
+}
+
+
+void
+PowerModel::printstats(FILE *out, const char *pf) const
+{
+    double time_s = secs(last_sample_cyc_ - start_cyc_);
+    double sys_j = 0;
+    i64 commits = sys_commits() - commits_at_start_;
+
+    fprintf(out, "%sclock_ghz %.3f time_s %.6g\n", pf,
+            conf_.clock_hz / 1e9, time_s);
+    for (size_t d = 0; d < domains_.size(); d++) {
+        const PowerDomain& dom = domains_[d];
+        double dom_j = dom.total_j();
+        sys_j += dom_j;
+        fprintf(out, "%s%s: energy_j %.6g (dyn %.6g leak %.6g) avg_w %.4f "
+                "edp %.6g ed2p %.6g\n", pf, dom.name.c_str(), dom_j,
+                dom.total_dyn_j(), dom.leak_j,
+                (time_s > 0) ? (dom_j / time_s) : 0.0,
+                dom_j * time_s, dom_j * time_s * time_s);
+        fprintf(out, "%s%s dyn_j: [", pf, dom.name.c_str());
+        for (int i = 0; i < PowerStruct_last; i++) {
+            if (dom.acc_j[i] > 0)
+                fprintf(out, " %s %.4g", StructTable[i].name, dom.dyn_j[i]);
+        }
+        fprintf(out, " ]\n");
+    }
+    fprintf(out, "%stotal: energy_j %.6g avg_w %.4f edp %.6g ed2p %.6g "
+            "commits_per_j %.6g\n", pf, sys_j,
+            (time_s > 0) ? (sys_j / time_s) : 0.0, sys_j * time_s,
+            sys_j * time_s * time_s,
+            (sys_j > 0) ? (commits / sys_j) : 0.0);
+}
+
+
+// Samples first, so interval snapshots are current; one group per domain
+void
+PowerModel::emit_stats(StatsEmitter *em)
+{
+    sample();
+    double time_s = secs(last_sample_cyc_ - start_cyc_);
+    double sys_j = 0;
+    statsemit_double(em, "time_s", time_s);
+    for (size_t d = 0; d < domains_.size(); d++) {
+        const PowerDomain& dom = domains_[d];
+        double dom_j = dom.total_j();
+        sys_j += dom_j;
+        statsemit_group_begin(em, dom.name.c_str());
+        statsemit_double(em, "energy_j", dom_j);
+        statsemit_double(em, "dyn_j", dom.total_dyn_j());
+        statsemit_double(em, "leak_j", dom.leak_j);
+        statsemit_double(em, "avg_w", (time_s > 0) ? (dom_j / time_s) : 0.0);
+        statsemit_group_end(em);
+    }
+    statsemit_double(em, "energy_j", sys_j);
+    statsemit_double(em, "avg_w", (time_s > 0) ? (sys_j / time_s) : 0.0);
+    statsemit_i64(em, "commits", sys_commits() - commits_at_start_);
+}
+
+
+
+//
+// C interface
+//
+
+PowerModel *
+power_create(const char *config_path)
+{
+    return new PowerModel(config_path);
+}
+
+void
+power_destroy(PowerModel *pm)
+{
+    delete pm;
+}
+
+void
+power_sample(PowerModel *pm)
+{
+    pm->sample();
+}
+
+void
+power_reset_stats(PowerModel *pm)
+{
+    pm->reset_stats();
+}
+
+void
+power_printstats(const PowerModel *pm, void *FILE_out, const char *prefix)
+{
+    FILE *out = static_cast<FILE *>(FILE_out);
+    pm->printstats(out, prefix);
+}
+
+static void
+power_stats_provider(StatsEmitter *em, void *data)
+{
+    static_cast<PowerModel *>(data)->emit_stats(em);
+}
+
+void
+power_register_stats(PowerModel *pm, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, power_stats_provider, pm);
+}
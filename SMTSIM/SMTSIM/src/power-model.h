@@ -0,0 +1,63 @@
+//
+// Activity-based power model: per-structure dynamic energy per access and
+// leakage per cycle, scaled from configured structure sizes
+//
+// $Id$
+//
+
+#ifndef POWER_MODEL_H
+#define POWER_MODEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// With "Power/enable" set, one PowerModel (GlobalPowerModel) is created at
+// startup, after the cores.  Every "Power/interval_cyc" cycles, it reads
+// each app's per-structure access counters from AppStateExtras (itlb_acc,
+// dcache_acc, iq_acc, rob_acc, ...), and charges the new accesses to the
+// core the app is on (or last ran on); accesses to a shared L2 or L3 are
+// charged to the "uncore" domain instead.  Each domain also leaks power
+// every cycle, for every structure it contains.
+//
+// Energy per access for each structure is "acc_pj" at the structure's
+// "ref_size", scaled by (size / ref_size)^dyn_size_exp, and for caches
+// also by (assoc / ref_assoc)^assoc_exp; leakage is "leak_mw" at
+// "ref_size", scaled linearly with size.  Sizes come from each core's
+// configuration: entries for TLBs, queues and the predictor, KB for caches,
+// registers for the register files and rename tables, and issue width for
+// functional units.  Core sizes are re-read at every sample, so a core
+// resized by its Reconfig block (reconf-ctl.h) is charged at its new sizes
+// from the next interval on.
+//
+// Final stats give energy, average watts, EDP and ED^2P per domain and for
+// the whole system; with "Power/log_name" set, per-interval watts are also
+// logged, one line per interval.
+
+typedef struct PowerModel PowerModel;
+struct StatsReg;
+
+extern PowerModel *GlobalPowerModel;    // NULL unless Power/enable
+
+
+PowerModel *power_create(const char *config_path);
+void power_destroy(PowerModel *pm);
+
+// Account for activity up to the current cycle (also done every interval)
+void power_sample(PowerModel *pm);
+// Discard energy so far, and restart the measurement period (warmup end)
+void power_reset_stats(PowerModel *pm);
+
+void power_printstats(const PowerModel *pm, void *FILE_out,
+                      const char *prefix);
+// Register a provider for per-domain and total energy at "path"
+// (stats-reg.h); it samples first, so each snapshot is current
+void power_register_stats(PowerModel *pm, struct StatsReg *sr,
+                          const char *path);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // POWER_MODEL_H
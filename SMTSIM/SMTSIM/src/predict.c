@@ -54,13 +54,17 @@ which contains the following copyright:
 
 #include "sim-assert.h"
 #include "main.h"
+#include "stash.h"
 #include "context.h"
+#include "dyn-inst.h"
 #include "btb-array.h"
 #include "pht-predict.h"
 #include "core-resources.h"
 #include "multi-bpredict.h"
 #include "branch-bias-table.h"
 #include "app-state.h"
+#include "tage-predict.h"
+#include "ittage-predict.h"
 
 
 #if defined(DEBUG)
@@ -80,7 +84,9 @@ which contains the following copyright:
 int
 get_bpredict(context *ctx, u64 pc, int ghr)
 {
-    int result = pht_probe(ctx->core->pht, pc, ghr);
+    TagePredict *tage = ctx->core->tage;
+    int result = (tage) ? tage_probe(tage, ctx->core_thread_id, pc) :
+        pht_probe(ctx->core->pht, pc, ghr);
 
     if (DEBUG_PHT && debug) {
         printf("pht: %s probe pc %s ghr %s -> %s\n", fmt_i64(cyc), fmt_x64(pc),
@@ -94,14 +100,16 @@ get_bpredict(context *ctx, u64 pc, int ghr)
 /*  This get's the branch prediction, but does not
  *    update the pht, which is not updated until the
  *    instruction retires.
- *  Uses the gshare predictor.
+ *  Uses the gshare predictor, or TAGE-SC-L if the core has one.
  */
 
 // returns predicted taken/not-taken
 int
 bpredict(context *ctx, u64 pc, int taken, int ghr)
 {
-    int result = pht_lookup(ctx->core->pht, pc, taken, ghr);
+    TagePredict *tage = ctx->core->tage;
+    int result = (tage) ? tage_lookup(tage, ctx->core_thread_id, pc, taken) :
+        pht_lookup(ctx->core->pht, pc, taken, ghr);
 
     if (DEBUG_PHT && debug) {
         printf("pht: %s lookup pc %s taken %i ghr %s -> %s\n", fmt_i64(cyc),
@@ -118,13 +126,18 @@ bpredict(context *ctx, u64 pc, int taken, int ghr)
 
 
 /* Committing instructions update the pht with
- *   their taken/not taken status.
+ *   their taken/not taken status.  "hist_pos" is the branch's
+ *   bpred_hist_push() result, for TAGE.
  */
 
 void
-update_pht(context *ctx, u64 pc, int taken, int ghr)
+update_pht(context *ctx, u64 pc, int taken, int ghr, i64 hist_pos)
 {
-    pht_update(ctx->core->pht, pc, taken, ghr);
+    if (ctx->core->tage)
+        tage_update(ctx->core->tage, ctx->core_thread_id, pc, taken,
+                    hist_pos);
+    else
+        pht_update(ctx->core->pht, pc, taken, ghr);
 
     if (DEBUG_PHT && debug) {
         printf("pht: %s update pc %s taken %i ghr %s\n", fmt_i64(cyc),
@@ -133,17 +146,71 @@ update_pht(context *ctx, u64 pc, int taken, int ghr)
 }
 
 
+/*  The TAGE predictor keeps its own (long) speculative history alongside
+ *   ctx->ghr; these track the GHR updates done in sim_branch() and their
+ *   rollbacks.  Without TAGE, they do nothing.
+ */
+
+// Returns the history checkpoint to save in the branch's undo info
+i64
+bpred_hist_push(context *ctx, u64 pc, int taken)
+{
+    TagePredict *tage = ctx->core->tage;
+    i64 pos = 0;
+    if (tage) {
+        pos = tage_hist_pos(tage, ctx->core_thread_id);
+        tage_hist_push(tage, ctx->core_thread_id, pc, taken);
+    }
+    return pos;
+}
+
+
+// The position the next branch would be pushed at, for checkpointing the
+// history as it stands (see branch-ckpt.cc)
+i64
+bpred_hist_pos(const context *ctx)
+{
+    const TagePredict *tage = ctx->core->tage;
+    return (tage) ? tage_hist_pos(tage, ctx->core_thread_id) : 0;
+}
+
+
+// Discard the branch pushed at "hist_pos", and everything younger
+void
+bpred_hist_restore(context *ctx, i64 hist_pos)
+{
+    if (ctx->core->tage)
+        tage_hist_restore(ctx->core->tage, ctx->core_thread_id, hist_pos);
+}
+
+
+// As bpred_hist_restore(), but re-push the branch with its actual outcome
+void
+bpred_hist_repair(context *ctx, i64 hist_pos, u64 pc, int taken)
+{
+    if (ctx->core->tage)
+        tage_hist_repair(ctx->core->tage, ctx->core_thread_id, hist_pos, pc,
+                         taken);
+}
+
+
 /*  Does the btb lookup.  This routine updates the btb immediately,
  *   which is optimistic.  This really should be decoupled, like the
  *   pht routines.
+ *  With an L0 BTB, it is checked first; on an L0 miss the main BTB acts as
+ *   the L1, and taken branches found there are copied into the L0.
  */
 
-// Returns the predicted target of this branch, or 0 if there was no entry
+// Returns the predicted target of this branch, or 0 if there was no entry.
+// "slow_ret" is set iff the target came from the main BTB behind an L0 miss
+// (and so costs a fetch bubble); it's always cleared without an L0.
 u64
-btblookup(context *ctx, u64 pc, u64 nextpc, int taken, int is_jump)
+btblookup(context *ctx, u64 pc, u64 nextpc, int taken, int is_jump,
+          int *slow_ret)
 {
     int thread = ctx->as->app_master_id;
     BTBArray *btb = ctx->core->btb;
+    BTBArray *btb_l0 = ctx->core->btb_l0;
     BTBLookupInfo l_info;
 
     sim_assert(nextpc != 0);
@@ -152,19 +219,30 @@ btblookup(context *ctx, u64 pc, u64 nextpc, int taken, int is_jump)
     l_info.dest = nextpc;
     l_info.taken = taken;
     l_info.is_jump = is_jump;
+    *slow_ret = 0;
+
+    if (btb_l0) {
+        btb_lookup(btb_l0, pc, thread, &l_info, &btb_dest);
+        if ((btb_dest != nextpc) && taken)
+            btb_update(btb_l0, pc, thread, nextpc);
+    }
 
-    // overwrites btb_dest with nonzero on a hit
-    btb_lookup(btb, pc, thread, &l_info, &btb_dest);
+    if (!btb_dest) {
+        // overwrites btb_dest with nonzero on a hit
+        btb_lookup(btb, pc, thread, &l_info, &btb_dest);
 
-    if ((btb_dest != nextpc) && taken) {
-        // only put taken branches in the btb
-        btb_update(btb, pc, thread, nextpc);
+        if ((btb_dest != nextpc) && taken) {
+            // only put taken branches in the btb
+            btb_update(btb, pc, thread, nextpc);
+        }
+        *slow_ret = (btb_l0 != NULL) && (btb_dest != 0);
     }
 
     if (DEBUG_BTB && debug) {
         printf("btb: %s access pc %s nextpc %s masterid %i taken %i "
-               "is_jump %i -> targ %s\n", fmt_i64(cyc), fmt_x64(pc),
-               fmt_x64(nextpc), thread, taken, is_jump, fmt_x64(btb_dest));
+               "is_jump %i -> targ %s%s\n", fmt_i64(cyc), fmt_x64(pc),
+               fmt_x64(nextpc), thread, taken, is_jump, fmt_x64(btb_dest),
+               (*slow_ret) ? " (L1)" : "");
     }
 
     return btb_dest;
@@ -175,22 +253,104 @@ btblookup(context *ctx, u64 pc, u64 nextpc, int taken, int is_jump)
  */
 
 u64
-get_btblookup(context *ctx, u64 pc)
+get_btblookup(context *ctx, u64 pc, int *slow_ret)
 {
     int thread = ctx->as->app_master_id;
     u64 btb_dest = 0;
 
-    btb_probe(ctx->core->btb, pc, thread, &btb_dest);
+    *slow_ret = 0;
+    if (ctx->core->btb_l0)
+        btb_probe(ctx->core->btb_l0, pc, thread, &btb_dest);
+    if (!btb_dest) {
+        btb_probe(ctx->core->btb, pc, thread, &btb_dest);
+        *slow_ret = (ctx->core->btb_l0 != NULL) && (btb_dest != 0);
+    }
 
     if (DEBUG_BTB && debug) {
-        printf("btb: %s probe pc %s masterid %i -> %s\n", 
-               fmt_i64(cyc), fmt_x64(pc), thread, fmt_x64(btb_dest));
+        printf("btb: %s probe pc %s masterid %i -> %s%s\n", 
+               fmt_i64(cyc), fmt_x64(pc), thread, fmt_x64(btb_dest),
+               (*slow_ret) ? " (L1)" : "");
     }
 
     return btb_dest;
 }
 
 
+/*  Indirect target prediction: if the core has an ITTAGE predictor and it
+ *   has an entry for this branch, its target overrides the BTB's.  An
+ *   override arrives with the L1 BTB latency, so "slow_io" is set unless
+ *   it agrees with the (fast) BTB target.  Not for returns.
+ */
+
+u64
+indirect_predict(context *ctx, u64 pc, u64 btb_target, int *slow_io)
+{
+    IttagePredict *ittage = ctx->core->ittage;
+    u64 result = btb_target;
+
+    if (ittage) {
+        u64 it_target = ittage_predict(ittage, pc, ctx->ind_hist);
+        if (it_target && (it_target != btb_target)) {
+            result = it_target;
+            *slow_io = 1;
+        }
+        if (DEBUG_BTB && debug) {
+            printf("ittage: %s predict pc %s hist %s -> %s\n", fmt_i64(cyc),
+                   fmt_x64(pc), fmt_x64(ctx->ind_hist), fmt_x64(it_target));
+        }
+    }
+
+    return result;
+}
+
+
+/*  Shift a fetched branch into the indirect predictor's history, saving the
+ *   prior history in the branch's undo info; undo_inst() restores it from
+ *   there, as with the GHR.  Without ITTAGE, the history stays zero.
+ */
+
+void
+ind_hist_push(context *ctx, activelist *inst, int taken, u64 target)
+{
+    inst->undo.ind_hist = ctx->ind_hist;
+    if (ctx->core->ittage) {
+        ctx->ind_hist =
+            ittage_hist_next(ctx->core->ittage, ctx->ind_hist, inst->pc,
+                             SBF_CondBranch(inst->br_flags) != 0, taken,
+                             target);
+    }
+}
+
+
+// Recompute the history after a (not undone) branch from its actual outcome
+void
+ind_hist_repair(context *ctx, const activelist *inst)
+{
+    if (ctx->core->ittage) {
+        ctx->ind_hist =
+            ittage_hist_next(ctx->core->ittage, inst->undo.ind_hist, inst->pc,
+                             SBF_CondBranch(inst->br_flags) != 0,
+                             inst->taken_branch,
+                             (inst->taken_branch) ? inst->br_target :
+                             (inst->pc + 4));
+    }
+}
+
+
+/* Committing indirect jumps (other than returns) train the indirect
+ *   predictor with their actual target.
+ */
+
+void
+update_indirect(context *ctx, const activelist *inst)
+{
+    if (ctx->core->ittage) {
+        ittage_update(ctx->core->ittage, inst->pc, inst->undo.ind_hist,
+                      inst->br_target);
+    }
+}
+
+
 static void
 predict_stats_core(const CoreResources *core)
 {
@@ -199,6 +359,13 @@ predict_stats_core(const CoreResources *core)
 
     btb_get_stats(core->btb, &btb_stats);
     pht_get_stats(core->pht, &pht_stats);
+    if (core->tage) {
+        // Report TAGE's hit/miss counts in place of the unused PHT's
+        TageStats tage_stats;
+        tage_get_stats(core->tage, &tage_stats);
+        pht_stats.hits = tage_stats.hits;
+        pht_stats.misses = tage_stats.misses;
+    }
 
     printf("Core %i:\n", core->core_id);
     printf("  branch prediction, hits = %s, misses = %s, hit rate = %.2f%%\n",
@@ -212,9 +379,23 @@ predict_stats_core(const CoreResources *core)
            "hit rate = %.2f%%\n",
            fmt_i64(core->rs_hits), fmt_i64(core->rs_misses),
            (float) (100.0*core->rs_hits/(core->rs_hits+core->rs_misses)));
+    if (core->btb_l0) {
+        BTBStats l0_stats;
+        btb_get_stats(core->btb_l0, &l0_stats);
+        printf("  L0 BTB, hits = %s, misses = %s, hit rate = %.2f%%; "
+               "L1 redirects = %s (%d bubble cyc each)\n",
+               fmt_i64(l0_stats.eff_hits), fmt_i64(l0_stats.eff_misses),
+               (float) (100.0*l0_stats.eff_hits/
+                        (l0_stats.eff_hits+l0_stats.eff_misses)),
+               fmt_i64(core->btb_slow_redirects), core->btb_l1_extra_lat);
+    }
+    if (core->ittage)
+        ittage_print_stats(core->ittage, stdout, "  ");
     if (core->tcache)
         // Don't bother printing multi_bp stats if we're not using it
         mbp_print_stats(core->multi_bp, stdout, "  multi_bp, ");
+    if (core->tage)
+        tage_print_stats(core->tage, stdout, "  ");
 }
 
 
@@ -231,7 +412,14 @@ void zero_pstats()
     for (i = 0; i < CoreCount; i++) {
         CoreResources *core = Cores[i];
         pht_reset_stats(core->pht);
+        if (core->tage)
+            tage_reset_stats(core->tage);
         btb_reset_stats(core->btb);
+        if (core->btb_l0)
+            btb_reset_stats(core->btb_l0);
+        core->btb_slow_redirects = 0;
+        if (core->ittage)
+            ittage_reset_stats(core->ittage);
         mbp_reset_stats(core->multi_bp);
         bbt_reset_stats(core->br_bias);
     }
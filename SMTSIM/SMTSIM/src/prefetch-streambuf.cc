@@ -1484,7 +1484,8 @@ core_prefetch_is_quiet(const CoreResources *core,
     bool result;
     if (core->params.shared_l2cache) {
         // shared L2s: test bus ready-time
-        result = corebus_probe_avail(core->request_bus, cyc);
+        result = corebus_probe_avail(core->request_bus, core->core_id,
+                                     cyc);
     } else {
         // private L2s: test ready-time on L2 request port
         result = cache_probebank_avail(core->l2cache, pf_base_addr, cyc,
@@ -17,6 +17,7 @@ const char RCSid_1062110501[] =
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "sys-types.h"
 #include "prog-mem.h"
@@ -61,6 +62,36 @@ const mem_addr kMinGrowDownVA = 0x1000;
 // to honor kMinGrowDownVA.
 const unsigned kGrowAlignBytes = 8192;
 
+// AutoGrowDown size changes are always a multiple of this (the widest
+// access), even when the limits above override kGrowAlignBytes.  Sparse
+// segments rely on it: their chunk boundaries then stay this-aligned in VA
+// space, so aligned accesses never straddle chunks.
+const unsigned kGrowDownDeltaAlign = 8;
+
+// Internal xlate() flag, outside PMAF_RWX: the caller may write through the
+// result even without PMAF_W, so sparse chunks must be allocated.
+const unsigned kXlateHostWrite = 0x80000000U;
+
+// Chunk size for new PMCF_Sparse segments; see pmem_set_sparse_chunk_bytes()
+i64 SparseChunkBytes = 64 * 1024;
+
+// Stand-in for never-written sparse chunks, on reads.  Grown (and the old
+// one leaked) if a bigger chunk size shows up, so earlier pointers to it
+// stay valid.
+const unsigned char *SparseZeroChunk = NULL;
+i64 SparseZeroChunkBytes = 0;
+
+const unsigned char *
+sparse_zero_chunk(i64 chunk_bytes)
+{
+    if (chunk_bytes > SparseZeroChunkBytes) {
+        SparseZeroChunk = static_cast<const unsigned char *>
+            (emalloc_zero(chunk_bytes));
+        SparseZeroChunkBytes = chunk_bytes;
+    }
+    return SparseZeroChunk;
+}
+
 
 // Hack-y check that should probably get integrated into sys-types: does
 // the given value overflow a size_t?
@@ -100,10 +131,31 @@ private:
     bool is_private_;           // Flag: may not be shared
     unsigned char *base_ptr_;   // Owned, allocated via region_alloc_
 
+    // Sparse segments (PMCF_Sparse) have no base_ptr_; instead, segment
+    // offset "o" lives at byte (o + sparse_pad_) of the chunk sequence, and
+    // chunks are allocated (zero-filled) on first write.  sparse_pad_ lets
+    // grow-down prepend whole chunks without moving any data.
+    i64 chunk_bytes_;           // 0 <=> not sparse
+    int chunk_bits_;
+    i64 sparse_pad_;            // 0 <= sparse_pad_ < chunk_bytes_
+    std::vector<unsigned char *> chunks_;       // Owned; NULL: untouched
+    i64 chunks_alloced_;
+
+    i64 sparse_chunk_count(i64 size) const {
+        return (sparse_pad_ + size + chunk_bytes_ - 1) >> chunk_bits_;
+    }
+    void sparse_free_chunks(size_t first_idx);
+    int sparse_resize(i64 new_size, bool at_start);
+
     NoDefaultCopy nocopy;
 
 public:
     ProgMemSegment(RegionAlloc *ra__, i64 size__, bool is_private__);
+    // Sparse, with chunk_bytes-sized (power of 2) chunks
+    ProgMemSegment(i64 size__, bool is_private__, i64 chunk_bytes);
+    // File-backed (see ralloc_alloc_file); check g_baseptr() for failure
+    ProgMemSegment(RegionAlloc *ra__, i64 size__, bool is_private__,
+                   int fd, i64 file_offset, i64 file_bytes);
     ~ProgMemSegment();
 
     // false <=> segment is private with nonzero ref count
@@ -124,7 +176,14 @@ public:
     }
 
     i64 g_size() const { return size_; }
+    // NULL for sparse segments; use host_ptr() for access
     unsigned char *g_baseptr() const { return base_ptr_; }
+    bool is_sparse() const { return chunk_bytes_ != 0; }
+    // Host memory backing this segment
+    i64 resident_bytes() const {
+        return (is_sparse()) ? (chunks_alloced_ << chunk_bits_) : size_;
+    }
+    unsigned char *host_ptr(i64 offset, bool for_write, i64 *contig_ret);
     void query(ProgMemSegmentInfo& ret) const;
     i64 get_maxsize(void) const { return max_size_; }
     void set_maxsize(i64 new_max_size);
@@ -135,7 +194,8 @@ public:
 ProgMemSegment::ProgMemSegment(RegionAlloc *ra__, i64 size__,
                                bool is_private__) 
     : region_alloc_(ra__), ref_count_(0), size_(size__), max_size_(I64_MAX),
-      is_private_(is_private__), base_ptr_(NULL)
+      is_private_(is_private__), base_ptr_(NULL), chunk_bytes_(0),
+      chunk_bits_(0), sparse_pad_(0), chunks_alloced_(0)
 {
     sim_assert(size_ > 0);
     base_ptr_ = static_cast<unsigned char *>
@@ -143,9 +203,88 @@ ProgMemSegment::ProgMemSegment(RegionAlloc *ra__, i64 size__,
 }
 
 
+ProgMemSegment::ProgMemSegment(i64 size__, bool is_private__,
+                               i64 chunk_bytes)
+    : region_alloc_(NULL), ref_count_(0), size_(size__), max_size_(I64_MAX),
+      is_private_(is_private__), base_ptr_(NULL), chunk_bytes_(chunk_bytes),
+      chunk_bits_(log2_exact(chunk_bytes)), sparse_pad_(0),
+      chunks_alloced_(0)
+{
+    sim_assert(size_ > 0);
+    sim_assert(chunk_bits_ >= 0);
+    sparse_zero_chunk(chunk_bytes_);
+    chunks_.resize(sparse_chunk_count(size_), NULL);
+}
+
+
+ProgMemSegment::ProgMemSegment(RegionAlloc *ra__, i64 size__,
+                               bool is_private__, int fd, i64 file_offset,
+                               i64 file_bytes)
+    : region_alloc_(ra__), ref_count_(0), size_(size__), max_size_(I64_MAX),
+      is_private_(is_private__), base_ptr_(NULL), chunk_bytes_(0),
+      chunk_bits_(0), sparse_pad_(0), chunks_alloced_(0)
+{
+    sim_assert(size_ > 0);
+    sim_assert((file_bytes >= 0) && (file_bytes <= size_));
+    base_ptr_ = static_cast<unsigned char *>
+        (ralloc_alloc_file(region_alloc_, size_, fd, file_offset,
+                           file_bytes));
+}
+
+
 ProgMemSegment::~ProgMemSegment() {
     if (base_ptr_)
         ralloc_dealloc(region_alloc_, base_ptr_);
+    sparse_free_chunks(0);
+}
+
+
+void
+ProgMemSegment::sparse_free_chunks(size_t first_idx)
+{
+    for (size_t i = first_idx; i < chunks_.size(); i++) {
+        if (chunks_[i]) {
+            free(chunks_[i]);
+            chunks_[i] = NULL;
+            --chunks_alloced_;
+        }
+    }
+    if (first_idx < chunks_.size())
+        chunks_.resize(first_idx);
+}
+
+
+// Host pointer to the byte at "offset"; *contig_ret gets the number of bytes
+// from there which are host-contiguous (to the end of the chunk, or of the
+// segment).  An untouched sparse chunk is allocated if "for_write", or
+// else read through the shared zero chunk; callers must not write through
+// a pointer they didn't ask for_write.
+unsigned char *
+ProgMemSegment::host_ptr(i64 offset, bool for_write, i64 *contig_ret)
+{
+    sim_assert((offset >= 0) && (offset < size_));
+    if (!is_sparse()) {
+        *contig_ret = size_ - offset;
+        return base_ptr_ + offset;
+    }
+    i64 pos = offset + sparse_pad_;
+    i64 chunk_idx = pos >> chunk_bits_;
+    i64 chunk_offset = pos & (chunk_bytes_ - 1);
+    i64 seg_left = size_ - offset;
+    *contig_ret = chunk_bytes_ - chunk_offset;
+    if (*contig_ret > seg_left)
+        *contig_ret = seg_left;
+    unsigned char *chunk = chunks_[chunk_idx];
+    if (!chunk) {
+        if (!for_write) {
+            return const_cast<unsigned char *>(SparseZeroChunk) +
+                chunk_offset;
+        }
+        chunk = static_cast<unsigned char *>(emalloc_zero(chunk_bytes_));
+        chunks_[chunk_idx] = chunk;
+        ++chunks_alloced_;
+    }
+    return chunk + chunk_offset;
 }
 
 
@@ -155,6 +294,8 @@ ProgMemSegment::query(ProgMemSegmentInfo& ret) const {
     ret.max_size = max_size_;
     ret.is_private = is_private_;
     ret.ref_count = ref_count_;
+    ret.is_sparse = is_sparse();
+    ret.resident_bytes = resident_bytes();
 }
 
 
@@ -188,6 +329,9 @@ ProgMemSegment::resize(i64 new_size, bool at_start)
     if ((new_size <= 0) || (new_size > max_size_) || sizet_overflow(new_size))
         return -1;
 
+    if (is_sparse())
+        return sparse_resize(new_size, at_start);
+
     void *new_mem = ralloc_resize(region_alloc_, base_ptr_, new_size);
     if (!new_mem)
         return -1;
@@ -205,6 +349,46 @@ ProgMemSegment::resize(i64 new_size, bool at_start)
 }
 
 
+// No data moves: growth just adds untouched chunk slots, and shrinking
+// frees whole chunks past the new end (zeroing the tail of a partial one,
+// in case it's grown back later).
+int
+ProgMemSegment::sparse_resize(i64 new_size, bool at_start)
+{
+    i64 size_delta = new_size - size_;
+
+    if (at_start) {
+        sim_assert(size_delta >= 0);
+        sim_assert((size_delta & (kGrowDownDeltaAlign - 1)) == 0);
+        if (size_delta > sparse_pad_) {
+            i64 new_chunks = (size_delta - sparse_pad_ + chunk_bytes_ - 1) >>
+                chunk_bits_;
+            chunks_.insert(chunks_.begin(), new_chunks,
+                           static_cast<unsigned char *>(NULL));
+            sparse_pad_ += new_chunks << chunk_bits_;
+        }
+        sparse_pad_ -= size_delta;
+        sim_assert((sparse_pad_ & (kGrowDownDeltaAlign - 1)) == 0);
+        size_ = new_size;
+        sim_assert(sparse_chunk_count(size_) == (i64) chunks_.size());
+        return 0;
+    }
+
+    i64 new_count = sparse_chunk_count(new_size);
+    if (size_delta < 0) {
+        i64 new_end = (sparse_pad_ + new_size) & (chunk_bytes_ - 1);
+        unsigned char *last = chunks_[new_count - 1];
+        if (new_end && last)
+            memset(last + new_end, 0, chunk_bytes_ - new_end);
+        sparse_free_chunks(new_count);
+    } else {
+        chunks_.resize(new_count, NULL);
+    }
+    size_ = new_size;
+    return 0;
+}
+
+
 struct ProgMem {
 private:
     struct SegTarget {
@@ -236,7 +420,13 @@ private:
 
     NoDefaultCopy nocopy;
 
-    unsigned char *xlate(mem_addr va, int width, unsigned flags);
+    // contig_ret: if non-NULL, gets the host-contiguous byte count from the
+    // result (which may be less than "width", for sparse segments)
+    unsigned char *xlate(mem_addr va, i64 width, unsigned flags,
+                         i64 *contig_ret);
+    unsigned char *xlate(mem_addr va, int width, unsigned flags) {
+        return xlate(va, width, flags, NULL);
+    }
     unsigned char *xlate_probe(mem_addr va, int width, unsigned flags) const;
 
     bool access_allowed(unsigned seg_access_flags,
@@ -252,6 +442,9 @@ public:
 
     int map_new(i64 size, mem_addr base_va, 
                 unsigned access_flags, unsigned create_flags);
+    int map_file(i64 size, mem_addr base_va, unsigned access_flags,
+                 unsigned create_flags, int fd, i64 file_offset,
+                 i64 file_bytes);
     int map_seg(ProgMemSegment *seg, mem_addr base_va,
                 unsigned access_flags,
                 unsigned create_flags);
@@ -267,6 +460,8 @@ public:
     bool access_ok(mem_addr va, int bytes, unsigned access_flags) const {
         return xlate_probe(va, bytes, access_flags) != NULL;
     }
+    unsigned char *host_span(mem_addr va, u64 len, unsigned access_flags,
+                             u64 *span_len_ret);
 
     unsigned read_8(mem_addr va, unsigned flags) {
         flags |= PMAF_R;
@@ -388,9 +583,12 @@ public:
     size_t write_fromfile(mem_addr dest_va, void *FILE_src,
                           size_t len, unsigned flags);
     void dump_map(void *FILE_dst, const char *prefix) const;
+    void get_stats(ProgMemStats& dest) const;
 
     void *xlate_hack(mem_addr va, int width, unsigned flags) {
-        return xlate(va, width, flags);
+        // Callers may write through this regardless of "flags", or use the
+        // host address as a unique ID; either way, no shared zero chunks.
+        return xlate(va, width, flags | kXlateHostWrite);
     }
 };
 
@@ -431,7 +629,9 @@ ProgMem::map_new(i64 size, mem_addr base_va,
                fmt_x64(base_va), access_flags, create_flags);
     if ((size <= 0) || (sizet_overflow(size)))
         return -1;
-    ProgMemSegment *seg = new ProgMemSegment(ra_, size, is_private);
+    ProgMemSegment *seg = (create_flags & PMCF_Sparse) ?
+        new ProgMemSegment(size, is_private, SparseChunkBytes) :
+        new ProgMemSegment(ra_, size, is_private);
     PMDEBUG(1)("(seg at %s) \n", fmt_x64(u64_from_ptr(seg)));
     // map_seg will print the rest of the debug info for this request.
     int stat = map_seg(seg, base_va, access_flags, create_flags);
@@ -441,6 +641,40 @@ ProgMem::map_new(i64 size, mem_addr base_va,
 }
 
 
+int
+ProgMem::map_file(i64 size, mem_addr base_va, unsigned access_flags,
+                  unsigned create_flags, int fd, i64 file_offset,
+                  i64 file_bytes)
+{
+    bool is_private = (create_flags & PMCF_AutoGrowDown);
+    PMDEBUG(1)("pmem_map_file: pmem %s size %s base_va %s access_flags 0x%x "
+               "create_flags 0x%x fd %d offset %s file_bytes %s: ",
+               pmem_name_.c_str(), fmt_i64(size), fmt_x64(base_va),
+               access_flags, create_flags, fd, fmt_i64(file_offset),
+               fmt_i64(file_bytes));
+    if ((size <= 0) || (sizet_overflow(size)) || (file_bytes < 0) ||
+        (file_bytes > size))
+        return -1;
+    if (create_flags & PMCF_Sparse) {
+        // File maps are already demand-paged by the host
+        PMDEBUG(1)("failed; can't file-map a sparse segment\n");
+        return -1;
+    }
+    ProgMemSegment *seg = new ProgMemSegment(ra_, size, is_private, fd,
+                                             file_offset, file_bytes);
+    if (!seg->g_baseptr()) {
+        PMDEBUG(1)("failed; allocator can't map file\n");
+        delete seg;
+        return -1;
+    }
+    PMDEBUG(1)("(seg at %s) \n", fmt_x64(u64_from_ptr(seg)));
+    int stat = map_seg(seg, base_va, access_flags, create_flags);
+    if (stat)
+        delete seg;
+    return stat;
+}
+
+
 int 
 ProgMem::map_seg(ProgMemSegment *seg, mem_addr base_va, unsigned access_flags,
                  unsigned create_flags)
@@ -569,7 +803,7 @@ ProgMem::get_seg(mem_addr base_va)
 
 
 unsigned char *
-ProgMem::xlate(mem_addr va, int width, unsigned flags) 
+ProgMem::xlate(mem_addr va, i64 width, unsigned flags, i64 *contig_ret)
 {
     const char *fname = "ProgMem::xlate";
     unsigned char *result = NULL;
@@ -664,6 +898,12 @@ ProgMem::xlate(mem_addr va, int width, unsigned flags)
                     new_size = limit_va - new_base_va;
                 }
             }
+            if (new_base_va < base_va) {
+                // Round the growth down, after the clamps above
+                new_base_va += (base_va - new_base_va) &
+                    (kGrowDownDeltaAlign - 1);
+                new_size = limit_va - new_base_va;
+            }
 
             // Grow segment "down", reset base_va / limit va
             // Make sure new base >= old limit
@@ -701,7 +941,16 @@ ProgMem::xlate(mem_addr va, int width, unsigned flags)
             // Mode not allowed
             err_code = PMEC_Prot;
         } else {
-            result = targ->seg->g_baseptr() + (va - base_va);
+            i64 contig;
+            result = targ->seg->host_ptr(va - base_va,
+                                         flags & (PMAF_W | kXlateHostWrite),
+                                         &contig);
+            if (contig_ret) {
+                *contig_ret = contig;
+            } else {
+                // Aligned accesses never straddle sparse chunks
+                sim_assert(contig >= width);
+            }
         }
     } else if (!err_code) {
         // No target, yet no other error -> not mapped
@@ -712,15 +961,17 @@ ProgMem::xlate(mem_addr va, int width, unsigned flags)
         if (flags & PMAF_NoExcept) {
             return NULL;
         } else if (err_handler_ &&
-                   (err_handler_(this, va, width, flags, err_code, 
+                   (err_handler_(this, va, static_cast<int>(width), flags,
+                                 err_code, 
                                  err_data_) == 0)) {
             // Handler "caught" error, we're happy
             return NULL;
         } else {
             // No error handler callback, or error handler didn't "catch" this
             // error
-            fprintf(stderr, "%s: illegal memory access, va 0x%s width %d "
-                    "flags 0x%x: %s\n", fname, fmt_x64(va), width, flags,
+            fprintf(stderr, "%s: illegal memory access, va 0x%s width %s "
+                    "flags 0x%x: %s\n", fname, fmt_x64(va), fmt_i64(width),
+                    flags,
                     pmem_errcode_msg(this, err_code));
             sim_abort();
         }
@@ -759,7 +1010,9 @@ ProgMem::xlate_probe(mem_addr va, int width, unsigned flags) const
         } else if (!access_allowed(targ->access_flags, flags)) {
             // Mode not allowed
         } else {
-            result = targ->seg->g_baseptr() + (va - base_va);
+            // (Read-only view; never allocates sparse chunks)
+            i64 contig;
+            result = targ->seg->host_ptr(va - base_va, false, &contig);
         }
     } else {
         // No target, yet no other error -> not mapped
@@ -769,6 +1022,28 @@ ProgMem::xlate_probe(mem_addr va, int width, unsigned flags) const
 }
 
 
+// Like xlate_probe(), but for the longest host-contiguous prefix of a range
+unsigned char *
+ProgMem::host_span(mem_addr va, u64 len, unsigned access_flags,
+                   u64 *span_len_ret)
+{
+    SegMap::iterator targ_iter = seg_map_.upper_bound(va);
+    if (targ_iter == seg_map_.begin())
+        return NULL;
+    --targ_iter;
+    const SegTarget& targ = targ_iter->second;
+    mem_addr base_va = targ_iter->first;
+    mem_addr limit_va = base_va + targ.seg->g_size();
+    if ((va >= limit_va) || !access_allowed(targ.access_flags, access_flags))
+        return NULL;
+    i64 contig;
+    unsigned char *result =
+        targ.seg->host_ptr(va - base_va, access_flags & PMAF_W, &contig);
+    *span_len_ret = (len < (u64) contig) ? len : contig;
+    return result;
+}
+
+
 void 
 ProgMem::read_memcpy(void *dest, mem_addr src_va,
                      size_t len, unsigned flags)
@@ -813,13 +1088,23 @@ ProgMem::read_tofile(void *FILE_dest, mem_addr src_va,
 {
     size_t result = 0;
     FILE *dest_file = static_cast<FILE *>(FILE_dest);
-    const unsigned char *src_mem = xlate(src_va, len, PMAF_R | flags);
     PMDEBUG(2)("pmem_read_tofile: pmem %s FILE_dest %s src_va %s len %s "
                "flags 0x%x\n", pmem_name_.c_str(),
                fmt_x64(u64_from_ptr(FILE_dest)), fmt_x64(src_va), fmt_i64(len),
                flags);
-    if (src_mem)
-        result = fwrite(src_mem, 1, len, dest_file);
+    // One fwrite per host-contiguous span (more than one only when sparse)
+    while (result < len) {
+        i64 contig;
+        const unsigned char *src_mem = xlate(src_va + result, len - result,
+                                             PMAF_R | flags, &contig);
+        if (!src_mem)
+            break;
+        size_t span = MIN_SCALAR((size_t) contig, len - result);
+        size_t wrote = fwrite(src_mem, 1, span, dest_file);
+        result += wrote;
+        if (wrote != span)
+            break;
+    }
     return result;
 }
 
@@ -859,13 +1144,22 @@ ProgMem::write_fromfile(mem_addr dest_va, void *FILE_src,
 {
     size_t result = 0;
     FILE *src_file = static_cast<FILE *>(FILE_src);
-    unsigned char *dest_mem = xlate(dest_va, len, PMAF_W | flags);
     PMDEBUG(2)("pmem_write_fromfile: pmem %s dest_va %s FILE_src %s len %s "
                "flags 0x%x\n", pmem_name_.c_str(),
                fmt_x64(dest_va), fmt_x64(u64_from_ptr(FILE_src)), fmt_i64(len),
                flags);
-    if (dest_mem)
-        result = fread(dest_mem, 1, len, src_file);
+    while (result < len) {
+        i64 contig;
+        unsigned char *dest_mem = xlate(dest_va + result, len - result,
+                                        PMAF_W | flags, &contig);
+        if (!dest_mem)
+            break;
+        size_t span = MIN_SCALAR((size_t) contig, len - result);
+        size_t got = fread(dest_mem, 1, span, src_file);
+        result += got;
+        if (got != span)
+            break;
+    }
     return result;
 }
 
@@ -880,11 +1174,33 @@ ProgMem::dump_map(void *FILE_dst, const char *prefix) const
         ProgMemSegmentInfo seg_info;
         pms_query(seg, &seg_info);
         fprintf(dst_file, "%sbase_va 0x%s: size %s private %i refs %i; "
-                "create 0x%x, access 0x%x at %p\n", prefix,
+                "create 0x%x, access 0x%x at %p", prefix,
                 fmt_x64(base_va), fmt_i64(seg_info.size), seg_info.is_private,
                 seg_info.ref_count,
                 targ.create_flags, targ.access_flags,
                 seg->g_baseptr());
+        if (seg_info.is_sparse)
+            fprintf(dst_file, " (sparse, %s resident)",
+                    fmt_i64(seg_info.resident_bytes));
+        fprintf(dst_file, "\n");
+    }
+}
+
+
+void
+ProgMem::get_stats(ProgMemStats& dest) const
+{
+    memset(&dest, 0, sizeof(dest));
+    FOR_CONST_ITER(SegMap, seg_map_, iter) {
+        const ProgMemSegment *seg = iter->second.seg;
+        dest.segs++;
+        dest.reserved_bytes += seg->g_size();
+        dest.touched_bytes += seg->resident_bytes();
+        if (seg->is_sparse()) {
+            dest.sparse_segs++;
+            dest.sparse_reserved_bytes += seg->g_size();
+            dest.sparse_touched_bytes += seg->resident_bytes();
+        }
     }
 }
 
@@ -914,6 +1230,15 @@ pmem_map_new(ProgMem *pmem, i64 size, mem_addr base_va,
     return pmem->map_new(size, base_va, access_flags, create_flags);
 }
 
+int
+pmem_map_file(ProgMem *pmem, i64 size, mem_addr base_va,
+              unsigned access_flags, unsigned create_flags,
+              int fd, i64 file_offset, i64 file_bytes)
+{
+    return pmem->map_file(size, base_va, access_flags, create_flags,
+                          fd, file_offset, file_bytes);
+}
+
 int 
 pmem_map_seg(ProgMem *pmem, ProgMemSegment *seg, mem_addr base_va,
              unsigned access_flags,
@@ -954,6 +1279,13 @@ pmem_access_ok(const ProgMem *pmem, mem_addr va, int bytes,
     return pmem->access_ok(va, bytes, access_flags);
 }
 
+void *
+pmem_host_span(ProgMem *pmem, mem_addr va, u64 len,
+               unsigned access_flags, u64 *span_len_ret)
+{
+    return pmem->host_span(va, len, access_flags, span_len_ret);
+}
+
 void 
 pmem_chmod(ProgMem *pmem, mem_addr base_va, unsigned new_access_flags)
 {
@@ -1082,6 +1414,22 @@ pmem_dump_map(const ProgMem *pmem, void *FILE_dst, const char *prefix)
     pmem->dump_map(FILE_dst, prefix);
 }
 
+void
+pmem_get_stats(const ProgMem *pmem, ProgMemStats *dest)
+{
+    pmem->get_stats(*dest);
+}
+
+void
+pmem_set_sparse_chunk_bytes(i64 chunk_bytes)
+{
+    if ((chunk_bytes <= 0) || (log2_exact(chunk_bytes) < 0)) {
+        abort_printf("pmem_set_sparse_chunk_bytes: bad chunk size %s\n",
+                     fmt_i64(chunk_bytes));
+    }
+    SparseChunkBytes = chunk_bytes;
+}
+
 void *
 pmem_xlate_hack(ProgMem *pmem, mem_addr va, int width, 
                  unsigned flags)
@@ -18,6 +18,7 @@ struct RegionAlloc;
 typedef struct ProgMem ProgMem;
 typedef struct ProgMemSegment ProgMemSegment;
 typedef struct ProgMemSegmentInfo ProgMemSegmentInfo;
+typedef struct ProgMemStats ProgMemStats;
 
 // Zero return <=> error "caught"
 typedef int (*pmem_errfunc_p)(ProgMem *pmem, mem_addr va, int width, 
@@ -29,6 +30,19 @@ struct ProgMemSegmentInfo {
     i64 max_size;
     int is_private;
     int ref_count;
+    int is_sparse;
+    i64 resident_bytes;         // host memory in use (sparse: touched chunks)
+};
+
+// Totals over the segments mapped by one ProgMem (shared segments are
+// counted by each holder)
+struct ProgMemStats {
+    int segs;
+    int sparse_segs;
+    i64 reserved_bytes;         // sum of segment sizes
+    i64 touched_bytes;          // sum of resident_bytes
+    i64 sparse_reserved_bytes;  // ...just for sparse segments
+    i64 sparse_touched_bytes;
 };
 
 // Access flags
@@ -47,7 +61,8 @@ enum {
 // Creation flags
 enum {
     PMCF_None = 0,
-    PMCF_AutoGrowDown = 0x1     // see AUTO_GROW_THRESH notes in prog-mem.cc
+    PMCF_AutoGrowDown = 0x1,    // see AUTO_GROW_THRESH notes in prog-mem.cc
+    PMCF_Sparse = 0x2           // backed by chunks allocated on first write
 };
 
 // Error codes
@@ -71,6 +86,14 @@ void pmem_destroy(ProgMem *pmem);
 int pmem_map_new(ProgMem *pmem, i64 size, mem_addr base_va, 
                  unsigned access_flags, unsigned create_flags);
 
+// Like pmem_map_new(), but the first "file_bytes" come from open file "fd"
+// at "file_offset", mapped copy-on-write (see ralloc_alloc_file()).
+// Nonzero return if that fails, including when this ProgMem's RegionAlloc
+// can't map files; callers may then fall back to pmem_map_new() and copying.
+int pmem_map_file(ProgMem *pmem, i64 size, mem_addr base_va,
+                  unsigned access_flags, unsigned create_flags,
+                  int fd, i64 file_offset, i64 file_bytes);
+
 int pmem_map_seg(ProgMem *pmem, ProgMemSegment *seg, mem_addr base_va,
                  unsigned access_flags,
                  unsigned create_flags);
@@ -118,8 +141,27 @@ void pmem_write_memset(ProgMem *pmem, mem_addr dest_va, int ch,
 size_t pmem_write_fromfile(ProgMem *pmem, mem_addr dest_va, void *FILE_src,
                            size_t len, unsigned flags);
 
+// Host-memory view of simulated memory, for bulk transfers (e.g. syscall
+// I/O) which would otherwise go through a bounce buffer.  Returns a pointer
+// to the simulator's copy of the byte at "va", and sets *span_len_ret to the
+// number of bytes from there (at most "len") which are contiguous in host
+// memory; that is, up to the end of the containing segment (or chunk, for
+// PMCF_Sparse segments; writable spans allocate the chunk).  Returns NULL
+// if "va" isn't mapped with "access_flags".  Like pmem_access_ok(), this
+// never auto-grows or calls the error handler.  The pointer is only valid
+// until the next map/unmap/resize of this ProgMem.
+void *pmem_host_span(ProgMem *pmem, mem_addr va, u64 len,
+                     unsigned access_flags, u64 *span_len_ret);
+
 const char *pmem_errcode_msg(const ProgMem *pmem, unsigned err_code);
 void pmem_dump_map(const ProgMem *pmem, void *FILE_dst, const char *prefix);
+void pmem_get_stats(const ProgMem *pmem, ProgMemStats *dest);
+
+// Chunk size (a power of 2) for PMCF_Sparse segments created after this.
+// Untouched chunks read as zero, from one shared zero chunk; a chunk is
+// allocated (zero-filled) by its first write, or pmem_xlate_hack().
+// Sparse segments are never file-mapped (pmem_map_file() fails).
+void pmem_set_sparse_chunk_bytes(i64 chunk_bytes);
 
 
 // This is crufty: it may go away some day, so you shouldn't use it.
@@ -57,6 +57,13 @@ which contains the following copyright:
 #include "main.h"
 #include "stash.h"
 #include "core-resources.h"
+#include "fetch-policy.h"
+#include "lsq-model.h"
+#include "runahead.h"
+#include "branch-ckpt.h"
+#include "reconf-ctl.h"
+#include "uop-cache.h"
+#include "power-model.h"
 #include "context.h"
 #include "dyn-inst.h"
 #include "cache.h"
@@ -178,6 +185,13 @@ schedstats_for_core(const CoreResources *core, i64 run_cyc, const char *pref)
            (double) core->q_stats.wmb_conf/run_cyc,
            fmt_i64(core->q_stats.memconf),
            (double) core->q_stats.memconf/run_cyc);
+    if (core->params.decode.fuse_cmp_branch ||
+        core->params.decode.fuse_ldah_lda ||
+        core->params.decode.fuse_scaled_load) {
+        printf("%sMacro-op fused pairs: %s (%.2f/cyc)\n", pref,
+               fmt_i64(core->q_stats.fused_pairs),
+               (double) core->q_stats.fused_pairs/run_cyc);
+    }
 
 
     //TODO: Add stats for I-Cache, D-Cache, fetch, commit
@@ -191,6 +205,17 @@ schedstats_for_core(const CoreResources *core, i64 run_cyc, const char *pref)
             printf(" %s", fmt_i64(core->q_stats.totalconf_lg_cyc[i]));
     }
     printf("\n");
+    fpol_print_stats(core->fpol, stdout, pref);
+    if (core->lsqm)
+        lsqm_print_stats(core->lsqm, stdout, pref);
+    if (core->runahead)
+        runahead_print_stats(core->runahead, stdout, pref);
+    if (core->bckpt)
+        bckpt_print_stats(core->bckpt, stdout, pref);
+    if (core->reconf)
+        reconf_print_stats(core->reconf, stdout, pref);
+    if (core->uopc)
+        uopc_print_stats(core->uopc, stdout, pref);
 }
 
 void
@@ -316,7 +341,20 @@ zero_pipe_stats(void)
         CoreResources *core = Cores[i];
         // Lazy
         memset(&core->q_stats, 0, sizeof(core->q_stats));
+        fpol_reset_stats(core->fpol);
+        if (core->lsqm)
+            lsqm_reset_stats(core->lsqm);
+        if (core->runahead)
+            runahead_reset_stats(core->runahead);
+        if (core->bckpt)
+            bckpt_reset_stats(core->bckpt);
+        if (core->reconf)
+            reconf_reset_stats(core->reconf);
+        if (core->uopc)
+            uopc_reset_stats(core->uopc);
     }
+    if (GlobalPowerModel)
+        power_reset_stats(GlobalPowerModel);
     misfetchtotal = flushed = 0;
     warmupcyc = cyc;
     wpexec = execflushed = 0;
@@ -378,6 +416,8 @@ release_waiters(struct activelist * restrict inst)
         inst->waiter[i] = 0;
         // Squashed instructions may be left in waiter[], but have deps == 0
         if (waitinst->deps > 0) {
+            if (inst->ra_inv)
+                waitinst->ra_inv = 1;
             if (waitinst->readycycle < inst->donecycle)
                 waitinst->readycycle = inst->donecycle;
             waitinst->deps--;
@@ -483,7 +523,25 @@ static void resolve(CoreResources * restrict core, struct activelist *exinst)
     DEBUGPRINTF("T%ds%d mem read issued at %s, va %s, addr ready at %s\n",
                 current->id, exinst->id, fmt_now(), fmt_x64(exinst->srcmem),
                 fmt_i64(addr_ready_cyc));
-    dmemdelay = dodaccess(exinst->srcmem, 0, current, exinst, addr_ready_cyc);
+    i64 fwd_done_cyc;
+    if (exinst->ra_inv) {
+        // Runahead, with an INV address: nothing to fetch
+        dmemdelay = 0;
+        exinst->addrcycle = addr_ready_cyc;
+        exinst->dcache_sim.latency = 0;
+    } else if (core->lsqm &&
+        lsqm_load_issued(core->lsqm, current, exinst, addr_ready_cyc, 1,
+                         &fwd_done_cyc)) {
+        // Satisfied from an older store in the LSQ; no D-cache access
+        dmemdelay = (int) (fwd_done_cyc - addr_ready_cyc);
+        exinst->addrcycle = addr_ready_cyc;
+        exinst->dcache_sim.latency = dmemdelay;
+        DEBUGPRINTF("T%ds%d load forwarded from store queue, %d cycles\n",
+                    current->id, exinst->id, dmemdelay);
+    } else {
+        dmemdelay = dodaccess(exinst->srcmem, 0, current, exinst,
+                              addr_ready_cyc);
+    }
 #ifdef DEBUG
     if (dmemdelay == MEMDELAY_LONG) {
         DEBUGPRINTF("T%ds%d data cache/dtlb miss, R%d, read 0x%s\n",
@@ -499,15 +557,25 @@ static void resolve(CoreResources * restrict core, struct activelist *exinst)
     DEBUGPRINTF("T%ds%d mem write issued at %s, va %s, addr ready at %s\n",
                 current->id, exinst->id, fmt_now(), fmt_x64(exinst->destmem),
                 fmt_i64(addr_ready_cyc));
-    dmemdelay = dodaccess(exinst->destmem, 1, current, exinst, addr_ready_cyc);
+    if (core->lsqm)
+        lsqm_store_issued(core->lsqm, current, exinst, addr_ready_cyc);
+    if (exinst->ra_inv) {
+        dmemdelay = 0;
+        exinst->addrcycle = addr_ready_cyc;
+        exinst->dcache_sim.latency = 0;
+    } else {
+        dmemdelay = dodaccess(exinst->destmem, 1, current, exinst,
+                              addr_ready_cyc);
+    }
   } else if (exinst->bmt.spillfill) {
       dmemdelay = 0;
       if (exinst->bmt.spillfill & BmtSF_BlockMarker) {
           i64 ready_time = cyc;
           if (!(exinst->bmt.spillfill & BmtSF_FreeTransfer)) {
               ready_time =
-                  corebus_access(core->reply_bus,
-                                 GlobalParams.mem.bus_transfer_time);
+                  corebus_access_mem(core->reply_bus, core->core_id,
+                                     (exinst->bmt.spillfill & BmtSF_Fill) != 0,
+                                     GlobalParams.mem.bus_transfer_time);
           }
           current->bmt_spillfill_blockready = ready_time;
           DEBUGPRINTF("T%ds%d BMT %s, block ready at %s\n",
@@ -532,6 +600,22 @@ static void resolve(CoreResources * restrict core, struct activelist *exinst)
     dmemdelay = 0;
   }
 
+  // Runahead-mode misses don't wait: the request carries on as a prefetch,
+  // and loads go on with INV results.
+  if ((dmemdelay == MEMDELAY_LONG) &&
+      (current->long_mem_stat == LongMem_Runahead) &&
+      cache_detach_dmiss(exinst)) {
+      DEBUGPRINTF("T%ds%d runahead miss, continuing\n", current->id,
+                  exinst->id);
+      runahead_mem_miss(core->runahead, current, exinst);
+      if ((exinst->mem_flags & SMF_Read) &&
+          runahead_track_inv(core->runahead))
+          exinst->ra_inv = 1;
+      exinst->status = EXECUTING;
+      exinst->dcache_sim.latency = 0;
+      dmemdelay = 0;
+  }
+
   // If dmemdelay is MEMDELAY_LONG, the memory request was placed in the
   // memory simulator and will be handed to mem_resolve() when it's completed
   // at some unknown future time.  Otherwise, we have a definite completion
@@ -590,6 +674,12 @@ static void synchresolve(CoreResources * restrict core,
     // SMT_HW_LOCK, LDL_L, LDQ_L
     sim_assert((syncop == SMT_HW_LOCK) || (syncop == LDL_L) ||
                (syncop == LDQ_L));
+    if (core->lsqm) {
+        // (no forwarding: these must reach the cache to set the lock)
+        i64 fwd_done_ignored;
+        lsqm_load_issued(core->lsqm, current, exinst, cyc + ex_stage_delay,
+                         0, &fwd_done_ignored);
+    }
     dmemdelay = dodaccess(exinst->srcmem, 0, current, exinst,
                           cyc + ex_stage_delay);
 #ifdef DEBUG
@@ -609,6 +699,8 @@ static void synchresolve(CoreResources * restrict core,
     // STL_C, STQ_C, SMT_RELEASE
     sim_assert((syncop == SMT_RELEASE) || (syncop == STL_C) ||
                (syncop == STQ_C));
+    if (core->lsqm)
+        lsqm_store_issued(core->lsqm, current, exinst, cyc + ex_stage_delay);
     dmemdelay = dodaccess(exinst->destmem, 1, current, exinst,
                           cyc + ex_stage_delay);
   } else {
@@ -747,7 +839,12 @@ mem_conflict_wait(CoreResources * restrict core, int core_thread_id,
                   int allow_stats_update)
 {
     int stall_issue;
-    if (meminst->mem_flags & SMF_Read) {
+    if (core->lsqm) {
+        // The LSQ model tracks store->load ordering across cycles
+        stall_issue = meminst->mem_flags &&
+            lsqm_issue_wait(core->lsqm, Contexts[meminst->thread], meminst,
+                            allow_stats_update);
+    } else if (meminst->mem_flags & SMF_Read) {
         int hash_idx = (meminst->srcmem >> 2) % NELEM(core->last_store_hash);
         u32 thread_bit = SET_BIT_32(core_thread_id % 32);
         // stall issue of this load, if this thread MAY have already issued a
@@ -850,15 +947,8 @@ queue_for_core(CoreResources * restrict core)
                 ldstissue++;
             if (new->fu == SYNCH)
                 synchissue++;
-#ifdef PRIO_INST_COUNT
-            core->sched.key[new_ctx->core_thread_id]--;
-#else
-#ifdef PRIO_BR_COUNT
-            if (new->branch || new->cond_branch) {
-                core->sched.key[new_ctx->core_thread_id]--;
-            }
-#endif
-#endif
+            fpol_inst_unfetched(core->fpol, new_ctx->core_thread_id,
+                                new->br_flags != 0);
             if (new->wp) wpexec++;
             if (new->br_flags)
                 brresolve(core, new);
@@ -888,7 +978,7 @@ queue_for_core(CoreResources * restrict core)
           if (new->mem_flags)
               mem_acc_in_q[new->thread] = 1;
 
-          if (new->mem_flags & SMF_Write) {
+          if ((new->mem_flags & SMF_Write) && !core->lsqm) {
               mem_conflict_write_issued(core, new_ctx->core_thread_id, new);
           }
         }
@@ -896,6 +986,7 @@ queue_for_core(CoreResources * restrict core)
         if (new_issued) {
             update_acc_occ_per_inst(new_ctx, new, 2, 0);  
             update_adapt_mgr_dec_tentative(new_ctx, IQ, 1);
+            core->fused_in_intq -= new->fused;
             new->issuecycle = cyc;
             stageq_delete(core->stage.intq, prev);
             stageq_enqueue(core->stage.s[rread1], new);
@@ -926,15 +1017,8 @@ queue_for_core(CoreResources * restrict core)
             new_ready) {
           new_issued = 1;
           fpissue++;
-#ifdef PRIO_INST_COUNT
-          core->sched.key[new_ctx->core_thread_id]--;
-#else
-#ifdef PRIO_BR_COUNT
-          if (new->branch || new->cond_branch) {
-              core->sched.key[new_ctx->core_thread_id]--;
-          }
-#endif
-#endif
+          fpol_inst_unfetched(core->fpol, new_ctx->core_thread_id,
+                              new->br_flags != 0);
           if (new->wp) wpexec++;
           if (new->br_flags)
             brresolve(core, new);
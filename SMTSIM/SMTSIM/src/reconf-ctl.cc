@@ -0,0 +1,618 @@
+//
+// Per-phase dynamic core reconfiguration
+//
+// $Id$
+//
+
+const char RCSid_1760000037[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "reconf-ctl.h"
+#include "core-resources.h"
+#include "context.h"
+#include "dyn-inst.h"
+#include "stage-queue.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stats-reg.h"
+
+
+using std::pair;
+using std::string;
+using std::vector;
+
+using SimCfg::conf_bool;
+using SimCfg::conf_double;
+using SimCfg::conf_int;
+using SimCfg::conf_str;
+
+extern i64 cyc;
+
+
+namespace {
+
+enum ReconfRes {
+    Res_IQ, Res_FQ, Res_ROB, Res_LSQ, Res_IReg, Res_FReg, Res_last
+};
+
+const char *ReconfResNames[] = {
+    "IQ", "FQ", "ROB", "LSQ", "IREG", "FREG", NULL
+};
+
+// Config names of the per-resource enable flags
+const char *ReconfResEnableNames[] = {
+    "resize_iq", "resize_fq", "resize_rob", "resize_lsq", "resize_iregs",
+    "resize_fregs", NULL
+};
+
+
+struct ReconfConfig {
+    int interval_cyc;
+    int n_levels;               // size steps: full, (n-1)/n, ..., 1/n
+    bool resize[Res_last];
+    bool use_bbv;
+    int bbv_buckets;
+    double bbv_threshold;       // Manhattan distance, normalized BBVs (0..2)
+    double ipc_delta;           // relative IPC change => re-explore phase
+    double ipc_tolerance;       // IPC loss accepted for a smaller size
+    int max_trials;             // exploration budget per phase (intervals)
+    int max_phases;             // phase table size
+    bool log;
+    string log_base_name;
+
+    NoDefaultCopy nocopy;
+
+public:
+    ReconfConfig(const string& cfg_path);
+    ~ReconfConfig() { }
+};
+
+
+ReconfConfig::ReconfConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    interval_cyc = conf_int(cp + "interval_cyc");
+    if (interval_cyc < 1) {
+        exit_printf("bad %sinterval_cyc (%d)\n", cp.c_str(), interval_cyc);
+    }
+    n_levels = conf_int(cp + "n_levels");
+    if (n_levels < 1) {
+        exit_printf("bad %sn_levels (%d)\n", cp.c_str(), n_levels);
+    }
+    for (int r = 0; r < Res_last; r++)
+        resize[r] = conf_bool(cp + ReconfResEnableNames[r]);
+    use_bbv = conf_bool(cp + "use_bbv");
+    bbv_buckets = conf_int(cp + "bbv_buckets");
+    if (bbv_buckets < 1) {
+        exit_printf("bad %sbbv_buckets (%d)\n", cp.c_str(), bbv_buckets);
+    }
+    bbv_threshold = conf_double(cp + "bbv_threshold");
+    ipc_delta = conf_double(cp + "ipc_delta");
+    ipc_tolerance = conf_double(cp + "ipc_tolerance");
+    if ((ipc_tolerance < 0) || (ipc_tolerance >= 1)) {
+        exit_printf("bad %sipc_tolerance (%g)\n", cp.c_str(), ipc_tolerance);
+    }
+    max_trials = conf_int(cp + "max_trials");
+    max_phases = conf_int(cp + "max_phases");
+    if (max_phases < 1) {
+        exit_printf("bad %smax_phases (%d)\n", cp.c_str(), max_phases);
+    }
+    log = conf_bool(cp + "log");
+    log_base_name = conf_str(cp + "log_base_name");
+}
+
+
+enum ExploreStage { Explore_Baseline, Explore_Trial, Explore_Settled };
+
+
+struct Phase {
+    int id;                     // for the log
+    vector<double> sig;         // normalized BBV
+    int level[Res_last];        // 0: full size
+    ExploreStage stage;
+    double base_ipc;            // at full size
+    double settled_ipc;         // < 0: not measured yet
+    i64 last_used;              // interval number
+
+    Phase(int id_, const vector<double>& sig_)
+        : id(id_), sig(sig_), stage(Explore_Baseline), base_ipc(0),
+          settled_ipc(-1), last_used(0) {
+        for (int r = 0; r < Res_last; r++)
+            level[r] = 0;
+    }
+};
+
+
+double
+sig_distance(const vector<double>& a, const vector<double>& b)
+{
+    sim_assert(a.size() == b.size());
+    double dist = 0;
+    for (int i = 0; i < intsize(a); i++)
+        dist += fabs(a[i] - b[i]);
+    return dist;
+}
+
+} // Anonymous namespace close
+
+
+struct ReconfCtl {
+private:
+    string name_;
+    ReconfConfig conf_;
+    CoreResources *core_;
+    int inst_bytes_lg_;
+    FILE *log_;
+
+    bool have_max_;             // max sizes captured yet?
+    int max_size_[Res_last];    // configured sizes (ROB: per-context max)
+    vector<int> max_rob_;       // per core context
+    int cur_level_[Res_last];
+
+    vector<Phase> phases_;
+    int cur_phase_;             // index in phases_, or -1
+    int next_phase_id_;
+    i64 interval_num_;
+
+    // Exploration of the current phase
+    vector<int> order_;         // resources, least-utilized first
+    int order_pos_;
+    int trials_left_;
+
+    // Current interval
+    i64 interval_start_;
+    i64 insts_;
+    i64 insts_since_br_;
+    vector<i64> bbv_;
+    i64 occ_sum_[Res_last];
+    double last_ipc_;
+
+    ReconfCtlStats stats_;
+
+    void capture_max_sizes();
+    int size_at(int res, int level) const {
+        int size = (max_size_[res] * (conf_.n_levels - level)) /
+            conf_.n_levels;
+        return (size < 1) ? 1 : size;
+    }
+    void apply_levels(const int *level);
+    void log_event(const char *what) const;
+    int find_phase(const vector<double>& sig) const;
+    int new_phase(const vector<double>& sig);
+    void enter_phase(int phase_idx);
+    void start_exploring(Phase& ph);
+    void next_trial(Phase& ph);
+    void interval_done();
+
+public:
+    ReconfCtl(const char *name__, const char *config_path__,
+              CoreResources *core__);
+    ~ReconfCtl();
+
+    void cycle();
+    void inst_committed(const context *ctx, const activelist *inst);
+
+    void reset_stats() { memset(&stats_, 0, sizeof(stats_)); }
+    const ReconfCtlStats& get_stats() const { return stats_; }
+    void print_stats(FILE *out, const char *pf) const;
+};
+
+
+ReconfCtl::ReconfCtl(const char *name__, const char *config_path__,
+                     CoreResources *core__)
+    : name_(name__), conf_(config_path__), core_(core__), log_(0),
+      have_max_(false), cur_phase_(-1), next_phase_id_(0),
+      interval_num_(0), order_pos_(0), trials_left_(0), interval_start_(0),
+      insts_(0), insts_since_br_(0), last_ipc_(0)
+{
+    if ((inst_bytes_lg_ = log2_exact(core_->params.inst_bytes)) < 0) {
+        exit_printf("ReconfCtl %s: inst_bytes (%d) not a power of 2\n",
+                    name_.c_str(), core_->params.inst_bytes);
+    }
+    for (int r = 0; r < Res_last; r++) {
+        max_size_[r] = 0;
+        cur_level_[r] = 0;
+        occ_sum_[r] = 0;
+    }
+    bbv_.resize(conf_.bbv_buckets, 0);
+    if (conf_.log) {
+        string file_name = conf_.log_base_name + ".C" +
+            fmt_i64(core_->core_id);
+        log_ = (FILE *) efopen(file_name.c_str(), 1);
+        fprintf(log_, "# reconfiguration log for core %d\n"
+                "# <cyc> <event> <phase> <last_ipc>", core_->core_id);
+        for (int r = 0; r < Res_last; r++)
+            fprintf(log_, " %s", ReconfResNames[r]);
+        fprintf(log_, "\n");
+    }
+    reset_stats();
+}
+
+
+ReconfCtl::~ReconfCtl()
+{
+    if (log_)
+        fclose(log_);
+}
+
+
+// The core's contexts aren't attached when it's created, so this waits for
+// the first cycle.
+void
+ReconfCtl::capture_max_sizes()
+{
+    const CoreParams& p = core_->params;
+    max_size_[Res_IQ] = p.queue.int_queue_size;
+    max_size_[Res_FQ] = p.queue.float_queue_size;
+    max_size_[Res_LSQ] = p.loadstore_queue_size;
+    max_size_[Res_IReg] = p.rename.int_rename_regs;
+    max_size_[Res_FReg] = p.rename.float_rename_regs;
+    max_rob_.resize(core_->n_contexts);
+    max_size_[Res_ROB] = 0;
+    for (int i = 0; i < core_->n_contexts; i++) {
+        max_rob_[i] = core_->contexts[i]->params.reorder_buffer_size;
+        if (max_rob_[i] > max_size_[Res_ROB])
+            max_size_[Res_ROB] = max_rob_[i];
+    }
+    have_max_ = true;
+}
+
+
+void
+ReconfCtl::apply_levels(const int *level)
+{
+    CoreParams& p = core_->params;
+    bool changed = false;
+    for (int r = 0; r < Res_last; r++) {
+        int lev = (conf_.resize[r]) ? level[r] : 0;
+        if (lev != cur_level_[r]) {
+            cur_level_[r] = lev;
+            changed = true;
+        }
+    }
+    if (!changed)
+        return;
+    p.queue.int_queue_size = size_at(Res_IQ, cur_level_[Res_IQ]);
+    p.queue.float_queue_size = size_at(Res_FQ, cur_level_[Res_FQ]);
+    p.loadstore_queue_size = size_at(Res_LSQ, cur_level_[Res_LSQ]);
+    p.rename.int_rename_regs = size_at(Res_IReg, cur_level_[Res_IReg]);
+    p.rename.float_rename_regs = size_at(Res_FReg, cur_level_[Res_FReg]);
+    for (int i = 0; i < core_->n_contexts; i++) {
+        int rob = (max_rob_[i] * (conf_.n_levels - cur_level_[Res_ROB])) /
+            conf_.n_levels;
+        core_->contexts[i]->params.reorder_buffer_size = (rob < 1) ? 1 : rob;
+    }
+    stats_.reconfigs++;
+}
+
+
+void
+ReconfCtl::log_event(const char *what) const
+{
+    if (!log_)
+        return;
+    int phase_id = (cur_phase_ >= 0) ? phases_[cur_phase_].id : -1;
+    fprintf(log_, "%s %s %d %.4f", fmt_i64(cyc), what, phase_id, last_ipc_);
+    for (int r = 0; r < Res_last; r++)
+        fprintf(log_, " %d", size_at(r, cur_level_[r]));
+    fprintf(log_, "\n");
+}
+
+
+int
+ReconfCtl::find_phase(const vector<double>& sig) const
+{
+    int best = -1;
+    double best_dist = 0;
+    for (int i = 0; i < intsize(phases_); i++) {
+        double dist = sig_distance(sig, phases_[i].sig);
+        if ((dist <= conf_.bbv_threshold) &&
+            ((best < 0) || (dist < best_dist))) {
+            best = i;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+
+int
+ReconfCtl::new_phase(const vector<double>& sig)
+{
+    stats_.new_phases++;
+    Phase ph(next_phase_id_++, sig);
+    if (intsize(phases_) < conf_.max_phases) {
+        phases_.push_back(ph);
+        return intsize(phases_) - 1;
+    }
+    // Replace the least-recently-used one
+    int victim = 0;
+    for (int i = 1; i < intsize(phases_); i++) {
+        if (phases_[i].last_used < phases_[victim].last_used)
+            victim = i;
+    }
+    phases_[victim] = ph;
+    return victim;
+}
+
+
+void
+ReconfCtl::enter_phase(int phase_idx)
+{
+    cur_phase_ = phase_idx;
+    Phase& ph = phases_[phase_idx];
+    ph.last_used = interval_num_;
+    if (ph.stage == Explore_Settled) {
+        apply_levels(ph.level);
+        log_event("resume");
+    } else {
+        start_exploring(ph);
+    }
+}
+
+
+// Measure the phase at full size next interval, then hill-climb from there
+void
+ReconfCtl::start_exploring(Phase& ph)
+{
+    for (int r = 0; r < Res_last; r++)
+        ph.level[r] = 0;
+    ph.stage = Explore_Baseline;
+    ph.settled_ipc = -1;
+    apply_levels(ph.level);
+    log_event("baseline");
+}
+
+
+void
+ReconfCtl::next_trial(Phase& ph)
+{
+    while ((order_pos_ < intsize(order_)) &&
+           (ph.level[order_[order_pos_]] + 1 >= conf_.n_levels))
+        order_pos_++;
+    if ((order_pos_ >= intsize(order_)) || (trials_left_ <= 0)) {
+        ph.stage = Explore_Settled;
+        ph.settled_ipc = -1;    // measured next interval
+        apply_levels(ph.level);
+        log_event("settle");
+    } else {
+        ph.stage = Explore_Trial;
+        ph.level[order_[order_pos_]]++;
+        apply_levels(ph.level);
+        log_event("trial");
+    }
+}
+
+
+void
+ReconfCtl::interval_done()
+{
+    const i64 cycles = cyc + 1 - interval_start_;
+    sim_assert(cycles > 0);
+    const double ipc = (double) insts_ / cycles;
+    last_ipc_ = ipc;
+    stats_.intervals++;
+
+    vector<double> sig(conf_.bbv_buckets, 0.0);
+    i64 bbv_total = 0;
+    for (int i = 0; i < conf_.bbv_buckets; i++)
+        bbv_total += bbv_[i];
+    if (bbv_total > 0) {
+        for (int i = 0; i < conf_.bbv_buckets; i++)
+            sig[i] = (double) bbv_[i] / bbv_total;
+    }
+
+    if (cur_phase_ < 0) {
+        enter_phase(new_phase(sig));
+    } else if (conf_.use_bbv &&
+               (sig_distance(sig, phases_[cur_phase_].sig) >
+                conf_.bbv_threshold)) {
+        // This interval ran with the old phase's sizes, so it's no good as
+        // a measurement for the new one; start over next interval.
+        stats_.phase_changes++;
+        int found = find_phase(sig);
+        enter_phase((found >= 0) ? found : new_phase(sig));
+    } else {
+        Phase& ph = phases_[cur_phase_];
+        ph.last_used = interval_num_;
+        // Track slow drift within the phase
+        for (int i = 0; i < conf_.bbv_buckets; i++)
+            ph.sig[i] = 0.75 * ph.sig[i] + 0.25 * sig[i];
+
+        switch (ph.stage) {
+        case Explore_Baseline: {
+            ph.base_ipc = ipc;
+            vector<pair<double, int> > util;
+            for (int r = 0; r < Res_last; r++) {
+                if (conf_.resize[r]) {
+                    double size = size_at(r, cur_level_[r]);
+                    util.push_back(pair<double, int>(
+                        (double) occ_sum_[r] / cycles / size, r));
+                }
+            }
+            std::sort(util.begin(), util.end());
+            order_.clear();
+            for (int i = 0; i < intsize(util); i++)
+                order_.push_back(util[i].second);
+            order_pos_ = 0;
+            trials_left_ = conf_.max_trials;
+            next_trial(ph);
+            break;
+        }
+        case Explore_Trial: {
+            int res = order_[order_pos_];
+            stats_.trials++;
+            trials_left_--;
+            if (ipc >= (1.0 - conf_.ipc_tolerance) * ph.base_ipc) {
+                stats_.trials_kept++;
+                log_event("keep");
+            } else {
+                ph.level[res]--;
+                order_pos_++;
+                apply_levels(ph.level);
+                log_event("revert");
+            }
+            next_trial(ph);
+            break;
+        }
+        case Explore_Settled:
+            stats_.settled_cyc += cycles;
+            if (ph.settled_ipc < 0) {
+                ph.settled_ipc = ipc;
+            } else if ((ph.settled_ipc > 0) &&
+                       (fabs(ipc - ph.settled_ipc) / ph.settled_ipc >
+                        conf_.ipc_delta)) {
+                stats_.ipc_changes++;
+                start_exploring(ph);
+            }
+            break;
+        }
+    }
+
+    interval_num_++;
+    interval_start_ = cyc + 1;
+    insts_ = 0;
+    std::fill(bbv_.begin(), bbv_.end(), 0);
+    for (int r = 0; r < Res_last; r++)
+        occ_sum_[r] = 0;
+}
+
+
+void
+ReconfCtl::cycle()
+{
+    if (!have_max_) {
+        capture_max_sizes();
+        interval_start_ = cyc;
+    }
+
+    occ_sum_[Res_IQ] += stageq_count(core_->stage.intq);
+    occ_sum_[Res_FQ] += stageq_count(core_->stage.floatq);
+    occ_sum_[Res_LSQ] += core_->lsq_used;
+    occ_sum_[Res_IReg] += core_->i_registers_used;
+    occ_sum_[Res_FReg] += core_->f_registers_used;
+    for (int i = 0; i < core_->n_contexts; i++)
+        occ_sum_[Res_ROB] += core_->contexts[i]->rob_used;
+
+    // (this cycle is included in the interval)
+    if ((cyc + 1 - interval_start_) >= conf_.interval_cyc)
+        interval_done();
+}
+
+
+void
+ReconfCtl::inst_committed(const context *ctx, const activelist *inst)
+{
+    insts_++;
+    insts_since_br_++;
+    if (inst->br_flags) {
+        u64 h = inst->pc >> inst_bytes_lg_;
+        h ^= h >> 11;
+        bbv_[static_cast<int>(h % conf_.bbv_buckets)] += insts_since_br_;
+        insts_since_br_ = 0;
+    }
+}
+
+
+void
+ReconfCtl::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%sReconfig: intervals %s phase changes %s (new %s)"
+            " IPC changes %s phases live %d\n", pf,
+            fmt_i64(stats_.intervals), fmt_i64(stats_.phase_changes),
+            fmt_i64(stats_.new_phases), fmt_i64(stats_.ipc_changes),
+            intsize(phases_));
+    fprintf(out, "%sReconfig: trials %s kept %s reconfigs %s"
+            " settled_cyc %s\n", pf,
+            fmt_i64(stats_.trials), fmt_i64(stats_.trials_kept),
+            fmt_i64(stats_.reconfigs), fmt_i64(stats_.settled_cyc));
+    fprintf(out, "%sReconfig: current sizes:", pf);
+    for (int r = 0; r < Res_last; r++)
+        fprintf(out, " %s %d", ReconfResNames[r], size_at(r, cur_level_[r]));
+    fprintf(out, "\n");
+}
+
+
+
+//
+// C interface
+//
+
+ReconfCtl *
+reconf_create(const char *name, const char *config_path,
+              struct CoreResources *core)
+{
+    return new ReconfCtl(name, config_path, core);
+}
+
+void
+reconf_destroy(ReconfCtl *rc)
+{
+    delete rc;
+}
+
+void
+reconf_cycle(ReconfCtl *rc)
+{
+    rc->cycle();
+}
+
+void
+reconf_inst_committed(ReconfCtl *rc, const struct context *ctx,
+                      const struct activelist *inst)
+{
+    rc->inst_committed(ctx, inst);
+}
+
+void
+reconf_reset_stats(ReconfCtl *rc)
+{
+    rc->reset_stats();
+}
+
+void
+reconf_get_stats(const ReconfCtl *rc, ReconfCtlStats *dest)
+{
+    *dest = rc->get_stats();
+}
+
+static void
+reconf_stats_provider(StatsEmitter *em, void *data)
+{
+    const ReconfCtlStats& st = static_cast<const ReconfCtl *>(data)->get_stats();
+    statsemit_i64(em, "intervals", st.intervals);
+    statsemit_i64(em, "phase_changes", st.phase_changes);
+    statsemit_i64(em, "new_phases", st.new_phases);
+    statsemit_i64(em, "ipc_changes", st.ipc_changes);
+    statsemit_i64(em, "trials", st.trials);
+    statsemit_i64(em, "trials_kept", st.trials_kept);
+    statsemit_i64(em, "reconfigs", st.reconfigs);
+    statsemit_i64(em, "settled_cyc", st.settled_cyc);
+}
+
+void
+reconf_register_stats(ReconfCtl *rc, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, reconf_stats_provider, rc);
+}
+
+void
+reconf_print_stats(const ReconfCtl *rc, void *c_FILE_out,
+                   const char *prefix)
+{
+    rc->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
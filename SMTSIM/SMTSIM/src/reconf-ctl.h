@@ -0,0 +1,85 @@
+// -*- C++ -*-
+//
+// Per-phase dynamic core reconfiguration
+//
+// $Id$
+//
+
+#ifndef RECONF_CTL_H
+#define RECONF_CTL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each core may have one of these, enabled by its "Reconfig" config block;
+// it's the online counterpart of sweeping the queue / ROB / LSQ / rename
+// register sizes across many static runs.
+//
+// Execution is divided into fixed intervals ("interval_cyc").  Each interval
+// gets a phase signature: a small basic-block vector, built from committed
+// branches weighted by the length of the block they end.  An interval whose
+// signature is far from the current phase's starts a new phase (or returns
+// to a previously-seen one).  Once a phase has settled (below), an interval
+// whose IPC differs from the settled IPC by more than "ipc_delta" makes it
+// re-explore, from full size.  Without signatures ("use_bbv" off), all
+// intervals are one phase, and only that settled-stage IPC check applies;
+// IPC shifts during exploration are expected and aren't checked.
+//
+// On entering a new phase the core runs an interval at its full configured
+// sizes for a baseline IPC, then hill-climbs: resources are tried one size
+// step smaller at a time, least-utilized first, keeping each step which
+// costs at most "ipc_tolerance" of the baseline IPC.  After "max_trials"
+// intervals, or when nothing more can shrink, the phase settles on the
+// smallest sizes found, which are re-applied whenever the phase recurs.
+//
+// Sizes are applied by rewriting the core's (and its contexts') params,
+// which the pipeline checks every cycle; the configured values are the
+// upper limit.  (With ResourcePooling enabled, AdaptMgr's pooled limits are
+// used in place of those params, and resizing has no effect.)
+
+struct CoreResources;
+struct context;
+struct activelist;
+
+typedef struct ReconfCtl ReconfCtl;
+typedef struct ReconfCtlStats ReconfCtlStats;
+struct StatsReg;
+
+struct ReconfCtlStats {
+    i64 intervals;
+    i64 phase_changes;          // ...starting a different phase
+    i64 new_phases;             // ...never seen before (or evicted)
+    i64 ipc_changes;            // same phase, re-explored for an IPC change
+    i64 trials;                 // intervals spent exploring
+    i64 trials_kept;            // ...whose smaller setting was kept
+    i64 reconfigs;              // size changes applied
+    i64 settled_cyc;            // cycles run at a phase's settled sizes
+};
+
+
+ReconfCtl *reconf_create(const char *name, const char *config_path,
+                         struct CoreResources *core);
+void reconf_destroy(ReconfCtl *rc);
+
+// Called once per cycle, for interval bookkeeping and occupancy sampling
+void reconf_cycle(ReconfCtl *rc);
+
+// A correct-path instruction committed on this core
+void reconf_inst_committed(ReconfCtl *rc, const struct context *ctx,
+                           const struct activelist *inst);
+
+void reconf_reset_stats(ReconfCtl *rc);
+void reconf_get_stats(const ReconfCtl *rc, ReconfCtlStats *dest);
+// Register a provider for ReconfCtlStats at "path" (stats-reg.h)
+void reconf_register_stats(ReconfCtl *rc, struct StatsReg *sr,
+                           const char *path);
+void reconf_print_stats(const ReconfCtl *rc, void *c_FILE_out,
+                        const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RECONF_CTL_H
@@ -20,8 +20,8 @@ const char RCSid_1047457375[] =
 #include <map>
 #include <vector>
 
-#include "region-alloc.h"
 #include "sys-types.h"          // for types used in utils.h declarations
+#include "region-alloc.h"
 #include "utils.h"              // for e.g. exit_printf()
 #include "sim-assert.h"         // for e.g. sim_assert(), sim_abort()
 
@@ -30,6 +30,11 @@ using std::map;
 using std::vector;
 
 
+const char *RAHugePolicy_names[] = {
+    "None", "Advise", "HugeTLB", NULL
+};
+
+
 #ifdef __linux__
     #define HAVE_MREMAP 1
 #else
@@ -69,6 +74,7 @@ using std::vector;
 namespace {
 
 size_t PageSize = 0;
+const size_t kHugePageBytes = 2 << 20;  // x86-64 / aarch64 (4K base) PMD size
 
 inline size_t
 roundup_pagesize(size_t size)
@@ -176,6 +182,44 @@ mmap_resize(void *mem, size_t old_size, size_t new_size)
     return result;
 }
 
+// As mmap_resize(), but never moves the map: NULL if it can't grow in place
+void *
+mmap_resize_inplace(void *mem, size_t old_size, size_t new_size)
+{
+    void *result;
+#if HAVE_MREMAP
+    result = mremap(mem, old_size, new_size, 0);
+    if (result == MAP_FAILED) 
+        result = NULL;
+#else
+    result = NULL;
+#endif
+    MDEBUG(2)("MDEBUG: mmap_resize_inplace(%p, %lu, %lu) -> %p\n", mem, 
+              (unsigned long) old_size, (unsigned long) new_size,
+              result);
+    return result;
+}
+
+// Move (and resize) a map to "dest", replacing whatever the caller has
+// mapped there; NULL on failure, or without MREMAP_FIXED support
+void *
+mmap_resize_to(void *mem, size_t old_size, size_t new_size, void *dest)
+{
+    void *result;
+#if HAVE_MREMAP && defined(MREMAP_FIXED)
+    result = mremap(mem, old_size, new_size, MREMAP_MAYMOVE | MREMAP_FIXED,
+                    dest);
+    if (result == MAP_FAILED) 
+        result = NULL;
+#else
+    result = NULL;
+#endif
+    MDEBUG(2)("MDEBUG: mmap_resize_to(%p, %lu, %lu, %p) -> %p\n", mem, 
+              (unsigned long) old_size, (unsigned long) new_size, dest,
+              result);
+    return result;
+}
+
 }
 
 
@@ -186,15 +230,20 @@ struct RegionAlloc {
 protected:
     bool zero_fill_new_mem;
     VoidSizeMap mem_sizes;
+    RegionAllocStats stats;     // (only "regions" is maintained here)
 
     RegionAlloc(bool zero_fill_new_mem_)
-        : zero_fill_new_mem(zero_fill_new_mem_) { }
+        : zero_fill_new_mem(zero_fill_new_mem_) {
+        memset(&stats, 0, sizeof(stats));
+    }
 
     virtual void *do_alloc(size_t size) = 0;
     virtual void do_dealloc(void *mem, size_t size) = 0;
     virtual bool have_resize() const { return false; }
     virtual void *do_resize(void *mem, size_t old_size, 
                             size_t new_size) { sim_abort(); return NULL; }
+    virtual void *do_alloc_file(size_t size, int fd, i64 file_offset,
+                                size_t file_bytes) { return NULL; }
 
     // Zero out new memory, if zero_fill_new_mem is set.
     void base_zero_new(void *mem, size_t old_size, size_t new_size) {
@@ -247,6 +296,11 @@ protected:
 public:
     virtual ~RegionAlloc() { }
 
+    void get_stats(RegionAllocStats& dest) const {
+        dest = stats;
+        dest.regions = static_cast<i64>(mem_sizes.size());
+    }
+
     void *alloc(size_t size) {
         sim_assert(size > 0);
         void *result = do_alloc(size);
@@ -260,6 +314,23 @@ public:
         return result;
     }
 
+    void *alloc_file(size_t size, int fd, i64 file_offset,
+                     size_t file_bytes) {
+        sim_assert(size > 0);
+        sim_assert(file_bytes <= size);
+        void *result = do_alloc_file(size, fd, file_offset, file_bytes);
+        if (result) {
+            sim_assert(mem_sizes.count(result) == 0);
+            mem_sizes[result] = size;
+            if (DEBUG_VERIFY_ZERO_FILL)
+                verify_zero_new(result, file_bytes, size);
+        }
+        MDEBUG(1)("MDEBUG: alloc_file(%lu, %d, %s, %lu) -> %p\n",
+                  (unsigned long) size, fd, fmt_i64(file_offset),
+                  (unsigned long) file_bytes, result);
+        return result;
+    }
+
     void *resize(void *mem, size_t new_size) {
         sim_assert(new_size > 0);
         void *result;
@@ -408,6 +479,292 @@ public:
 };
 
 
+// As RA_MremapSingle, but regions of at least "min_bytes" are placed on
+// huge pages: either MAP_HUGETLB (from the host's reserved pool), or
+// 2MB-aligned anonymous maps with madvise(MADV_HUGEPAGE), for the kernel's
+// transparent huge pages.  A failed MAP_HUGETLB falls back to the latter, and
+// a failed madvise to plain pages.  Mapped sizes are kept huge-page-rounded
+// with some slack, so repeated small grows (e.g. brk) rarely remap or copy.
+class RA_HugeMmap : public RA_MremapSingle {
+    enum Backing { HB_Advised, HB_HugeTLB, HB_Plain };
+    struct HugeRegion {
+        Backing backing;
+        size_t mapped;          // bytes mapped at the region pointer
+        HugeRegion(Backing backing_, size_t mapped_)
+            : backing(backing_), mapped(mapped_) { }
+    };
+    typedef map<void *, HugeRegion> HugeRegionMap;
+
+    RAHugePolicy policy;
+    size_t min_bytes;
+    HugeRegionMap huge_regions;
+
+    static size_t roundup_huge(size_t size) {
+        size_t extra = size % kHugePageBytes;
+        return (extra) ? (size + (kHugePageBytes - extra)) : size;
+    }
+
+    void account(const HugeRegion& hr, bool adding) {
+        i64 delta = static_cast<i64>(hr.mapped) * ((adding) ? 1 : -1);
+        if (hr.backing == HB_HugeTLB)
+            stats.hugetlb_bytes += delta;
+        else if (hr.backing == HB_Advised)
+            stats.advised_bytes += delta;
+    }
+
+    bool advise(void *mem, size_t size) {
+#ifdef MADV_HUGEPAGE
+        if (madvise(mem, size, MADV_HUGEPAGE) == 0)
+            return true;
+#endif
+        stats.advise_fails++;
+        return false;
+    }
+
+    // Anonymous map of "mapped" bytes (huge-page multiple) at a 2MB-aligned
+    // address: over-map by one huge page, then trim
+    void *aligned_map(size_t mapped) {
+        sim_assert((mapped % kHugePageBytes) == 0);
+        size_t raw_size = mapped + kHugePageBytes;
+        void *raw = mmap_alloc(0, raw_size);
+        if (!raw)
+            return NULL;
+        size_t misalign = static_cast<size_t>
+            (u64_from_ptr(raw) % kHugePageBytes);
+        size_t head = (misalign) ? (kHugePageBytes - misalign) : 0;
+        void *mem = void_boffset(raw, head);
+        if (head)
+            mmap_free(raw, head);
+        if (raw_size - head - mapped)
+            mmap_free(void_boffset(mem, mapped), raw_size - head - mapped);
+        return mem;
+    }
+
+    // Map "mapped" bytes (huge-page multiple) per the policy
+    void *huge_map(size_t mapped, Backing *backing_ret) {
+        sim_assert((mapped % kHugePageBytes) == 0);
+        if (policy == RAHuge_HugeTLB) {
+#ifdef MAP_HUGETLB
+            void *mem = wrap_mmap(0, mapped, PROT_READ | PROT_WRITE,
+                                  MAP_PRIVATE | MAP_ANON | MAP_HUGETLB,
+                                  -1, 0);
+            if (mem) {
+                *backing_ret = HB_HugeTLB;
+                return mem;
+            }
+#endif
+            stats.hugetlb_fallbacks++;
+        }
+        void *mem = aligned_map(mapped);
+        if (!mem)
+            return NULL;
+        *backing_ret = (advise(mem, mapped)) ? HB_Advised : HB_Plain;
+        return mem;
+    }
+
+    void *huge_alloc(size_t size) {
+        Backing backing;
+        size_t mapped = roundup_huge(size);
+        void *mem = huge_map(mapped, &backing);
+        if (mem) {
+            HugeRegion hr(backing, mapped);
+            huge_regions.insert(std::make_pair(mem, hr));
+            account(hr, true);
+        }
+        return mem;
+    }
+
+    void huge_free(HugeRegionMap::iterator found) {
+        account(found->second, false);
+        mmap_free(found->first, found->second.mapped);
+        huge_regions.erase(found);
+    }
+
+protected:
+    // Move a region's contents into a new huge region
+    void *copy_to_huge(void *mem, size_t old_size, size_t new_size) {
+        void *result = huge_alloc(new_size);
+        if (result) {
+            memcpy(result, mem, RA_MIN(old_size, new_size));
+            stats.huge_copies++;
+        }
+        return result;
+    }
+
+    bool wants_huge(size_t size) const {
+        return (policy != RAHuge_None) && (size >= min_bytes);
+    }
+
+public:
+    RA_HugeMmap(bool zero_fill_new_mem_, RAHugePolicy policy_,
+                size_t min_bytes_)
+        : RA_MremapSingle(zero_fill_new_mem_), policy(policy_),
+          min_bytes(min_bytes_) { }
+    ~RA_HugeMmap() { base_cleanup(); }
+
+    void *do_alloc(size_t size) {
+        return (wants_huge(size)) ? huge_alloc(size) :
+            RA_MremapSingle::do_alloc(size);
+    }
+
+    void do_dealloc(void *mem, size_t size) {
+        HugeRegionMap::iterator found = huge_regions.find(mem);
+        if (found != huge_regions.end()) {
+            huge_free(found);
+        } else {
+            RA_MremapSingle::do_dealloc(mem, size);
+        }
+    }
+
+    bool have_resize() const { return HAVE_MREMAP; }
+
+    void *do_resize(void *mem, size_t old_size, size_t new_size) {
+        HugeRegionMap::iterator found = huge_regions.find(mem);
+        if (found == huge_regions.end()) {
+            if (!wants_huge(new_size))
+                return RA_MremapSingle::do_resize(mem, old_size, new_size);
+            // Grown past min_bytes: move to huge pages, once
+            void *result = copy_to_huge(mem, old_size, new_size);
+            if (result)
+                RA_MremapSingle::do_dealloc(mem, old_size);
+            return result;
+        }
+        HugeRegion& hr = found->second;
+        if (new_size <= hr.mapped) {
+            // Fits; the bytes past old_size may hold data from a shrink
+            if (new_size > old_size)
+                base_zero_new(mem, old_size, new_size);
+            return mem;
+        }
+        // Grow with 25% slack, so a run of small grows is amortized
+        size_t new_mapped = roundup_huge(new_size + new_size / 4);
+        void *result = NULL;
+        if (HAVE_MREMAP && (hr.backing != HB_HugeTLB)) {
+            // Grow in place, or else move the pages (without copying) into a
+            // fresh 2MB-aligned reservation; a plain MREMAP_MAYMOVE could
+            // land anywhere, losing the alignment THP backing needs.
+            result = mmap_resize_inplace(mem, hr.mapped, new_mapped);
+            if (!result) {
+                void *dest = aligned_map(new_mapped);
+                if (dest) {
+                    result = mmap_resize_to(mem, hr.mapped, new_mapped, dest);
+                    if (!result)
+                        mmap_free(dest, new_mapped);
+                }
+            }
+        }
+        if (result) {
+            HugeRegion new_hr(hr.backing, new_mapped);
+            if ((hr.backing == HB_Advised) &&
+                !advise(result, new_mapped))
+                new_hr.backing = HB_Plain;
+            account(hr, false);
+            base_zero_new(result, old_size, hr.mapped);
+            huge_regions.erase(found);
+            huge_regions.insert(std::make_pair(result, new_hr));
+            account(new_hr, true);
+        } else {
+            result = copy_to_huge(mem, old_size, new_mapped);
+            if (result)
+                huge_free(found);
+        }
+        return result;
+    }
+};
+
+
+// As RA_HugeMmap (or RA_MremapSingle, with no huge-page policy), plus
+// file-backed regions: an anonymous reservation for the whole region, with
+// the file's pages mapped MAP_PRIVATE over its start.  The region pointer
+// need not be page-aligned, since file offsets needn't be.  File-backed
+// regions always use base pages (they're page-cache pages).
+class RA_MmapFile : public RA_HugeMmap {
+    struct FileMap {
+        void *map_base;         // page-aligned start of the mmap'd pages
+        size_t map_size;
+        FileMap(void *map_base_, size_t map_size_)
+            : map_base(map_base_), map_size(map_size_) { }
+    };
+    typedef map<void *, FileMap> FileMapMap;
+
+    FileMapMap file_maps;
+
+    void free_filemap(FileMapMap::iterator found) {
+        stats.file_bytes -= static_cast<i64>(found->second.map_size);
+        mmap_free(found->second.map_base, found->second.map_size);
+        file_maps.erase(found);
+    }
+
+public:
+    RA_MmapFile(bool zero_fill_new_mem_, RAHugePolicy policy_,
+                size_t min_bytes_)
+        : RA_HugeMmap(zero_fill_new_mem_, policy_, min_bytes_) { }
+    ~RA_MmapFile() { base_cleanup(); }
+
+    void do_dealloc(void *mem, size_t size) {
+        FileMapMap::iterator found = file_maps.find(mem);
+        if (found != file_maps.end()) {
+            free_filemap(found);
+        } else {
+            RA_HugeMmap::do_dealloc(mem, size);
+        }
+    }
+
+    void *do_resize(void *mem, size_t old_size, size_t new_size) {
+        FileMapMap::iterator found = file_maps.find(mem);
+        if (found == file_maps.end())
+            return RA_HugeMmap::do_resize(mem, old_size, new_size);
+        // Growing the file mapping could expose pages past EOF (SIGBUS), so
+        // move the contents to anonymous memory; they've likely been
+        // written to by now anyway.
+        void *result = (wants_huge(new_size)) ?
+            copy_to_huge(mem, old_size, new_size) : NULL;
+        if (!result) {
+            result = mmap_alloc(0, roundup_pagesize(new_size));
+            if (result)
+                memcpy(result, mem, RA_MIN(old_size, new_size));
+        }
+        if (result)
+            free_filemap(found);
+        return result;
+    }
+
+    void *do_alloc_file(size_t size, int fd, i64 file_offset,
+                        size_t file_bytes) {
+        size_t page_skew = static_cast<size_t>(file_offset % PageSize);
+        size_t map_size = roundup_pagesize(page_skew + size);
+        void *map_base = mmap_alloc(0, map_size);
+        if (!map_base)
+            return NULL;
+        void *result = void_boffset(map_base, page_skew);
+        if (file_bytes > 0) {
+            // MAP_FIXED is safe here: it only replaces our own reservation
+            size_t file_map_size = roundup_pagesize(page_skew + file_bytes);
+            if (!wrap_mmap(map_base, file_map_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_FIXED, fd,
+                           static_cast<off_t>(file_offset - page_skew))) {
+                MDEBUG(1)("MDEBUG: RA_MmapFile: file mmap failed: %s\n",
+                          strerror(errno));
+                mmap_free(map_base, map_size);
+                return NULL;
+            }
+            // The last file page may hold bytes past the end of this
+            // region's file data; those must read as zero.  (This copies
+            // just that one page.)
+            size_t file_tail = RA_MIN(file_map_size - page_skew, size);
+            if (file_tail > file_bytes) {
+                memset(void_boffset(result, file_bytes), 0,
+                       file_tail - file_bytes);
+            }
+        }
+        sim_assert(file_maps.count(result) == 0);
+        file_maps.insert(std::make_pair(result, FileMap(map_base, map_size)));
+        stats.file_bytes += static_cast<i64>(map_size);
+        return result;
+    }
+};
+
+
 // Use POSIX mmap, and multiple maps per region to avoid memcpy-ing.
 class RA_MmapMulti : public RegionAlloc {
     struct SubRegion {
@@ -601,6 +958,35 @@ ralloc_create(int zero_fill_new_mem)
     return result;
 }
 
+RegionAlloc *
+ralloc_create_mmap(int zero_fill_new_mem, RAHugePolicy huge_policy,
+                   size_t huge_min_bytes, int allow_file_maps)
+{
+    RegionAlloc *result = NULL;
+
+    if (!PageSize) {
+        PageSize = getpagesize();
+        if (PageSize <= 0) {
+            abort_printf("RegionAlloc: couldn't get page size!\n");
+        }
+    }
+    sim_assert(ENUM_OK(RAHugePolicy, huge_policy));
+
+    if (!ALLOW_MMAP) {
+        // No mmap, no extras
+    } else if (allow_file_maps) {
+        result = new RA_MmapFile(zero_fill_new_mem, huge_policy,
+                                 huge_min_bytes);
+    } else if (huge_policy != RAHuge_None) {
+        result = new RA_HugeMmap(zero_fill_new_mem, huge_policy,
+                                 huge_min_bytes);
+    } else {
+        result = new RA_MremapSingle(zero_fill_new_mem);
+    }
+
+    return result;
+}
+
 void 
 ralloc_destroy(RegionAlloc *ra)
 {
@@ -626,6 +1012,53 @@ ralloc_dealloc(RegionAlloc *ra, void *mem)
     ra->dealloc(mem);
 }
 
+void *
+ralloc_alloc_file(RegionAlloc *ra, size_t size, int fd, i64 file_offset,
+                  size_t file_bytes)
+{
+    return ra->alloc_file(size, fd, file_offset, file_bytes);
+}
+
+void
+ralloc_get_stats(const RegionAlloc *ra, RegionAllocStats *dest)
+{
+    ra->get_stats(*dest);
+}
+
+void
+ralloc_print_stats(const RegionAlloc *ra, void *c_FILE_out,
+                   const char *prefix)
+{
+    FILE *out = static_cast<FILE *>(c_FILE_out);
+    RegionAllocStats st;
+    ra->get_stats(st);
+    fprintf(out, "%sRegionAlloc: regions %s hugetlb %s MB advised %s MB "
+            "file %s MB\n", prefix, fmt_i64(st.regions),
+            fmt_i64(st.hugetlb_bytes >> 20), fmt_i64(st.advised_bytes >> 20),
+            fmt_i64(st.file_bytes >> 20));
+    fprintf(out, "%sRegionAlloc: hugetlb_fallbacks %s advise_fails %s "
+            "huge_copies %s\n", prefix, fmt_i64(st.hugetlb_fallbacks),
+            fmt_i64(st.advise_fails), fmt_i64(st.huge_copies));
+#ifdef __linux__
+    {
+        // What the kernel actually gave us, process-wide (THP only)
+        FILE *smaps = fopen("/proc/self/smaps_rollup", "r");
+        if (smaps) {
+            char line[256];
+            long long kb;
+            while (fgets(line, sizeof(line), smaps)) {
+                if (sscanf(line, "AnonHugePages: %lld kB", &kb) == 1) {
+                    fprintf(out, "%sRegionAlloc: host AnonHugePages %lld MB"
+                            "\n", prefix, kb >> 10);
+                    break;
+                }
+            }
+            fclose(smaps);
+        }
+    }
+#endif
+}
+
 
 //
 // Error-catching wrappers for the wrappers (whee!)
@@ -13,6 +13,28 @@ extern "C" {
 #endif
 
 typedef struct RegionAlloc RegionAlloc;
+typedef struct RegionAllocStats RegionAllocStats;
+
+// Huge-page policies, for ralloc_create_mmap()
+typedef enum {
+    RAHuge_None,                // Base pages only
+    RAHuge_Advise,              // 2MB-aligned regions, madvise(MADV_HUGEPAGE)
+    RAHuge_HugeTLB,             // MAP_HUGETLB; falls back to RAHuge_Advise
+    RAHugePolicy_last
+} RAHugePolicy;
+
+extern const char *RAHugePolicy_names[];        // NULL-terminated
+
+// Current totals, in bytes mapped (not bytes requested)
+struct RegionAllocStats {
+    i64 regions;                // live regions
+    i64 hugetlb_bytes;          // ...backed by MAP_HUGETLB
+    i64 advised_bytes;          // ...madvise'd MADV_HUGEPAGE
+    i64 file_bytes;             // ...file-backed (ralloc_alloc_file)
+    i64 hugetlb_fallbacks;      // (cumulative) MAP_HUGETLB attempts failed
+    i64 advise_fails;           // (cumulative) madvise() failures
+    i64 huge_copies;            // (cumulative) regions copied to resize
+};
 
 
 //
@@ -30,6 +52,21 @@ typedef struct RegionAlloc RegionAlloc;
 // "resize" operations will be zero-filled.
 RegionAlloc *ralloc_create(int zero_fill_new_mem);
 
+// Create an mmap-based allocation manager with optional extras:
+//
+// "huge_policy" applies to regions of at least "huge_min_bytes", which are
+// placed on huge pages (see RAHugePolicy) to cut host TLB misses on
+// simulated memory; smaller regions use base pages until they grow past
+// that size.  Whether THP actually backs an advised region is up to the
+// host kernel; see ralloc_print_stats().
+//
+// If "allow_file_maps" is set, ralloc_alloc_file() is supported.
+//
+// Returns NULL if mmap isn't available.
+RegionAlloc *ralloc_create_mmap(int zero_fill_new_mem,
+                                RAHugePolicy huge_policy,
+                                size_t huge_min_bytes, int allow_file_maps);
+
 // Destroy an allocation manager and release all of its managed memory
 void ralloc_destroy(RegionAlloc *ra);
 
@@ -51,6 +88,21 @@ void ralloc_dealloc(RegionAlloc *ra, void *mem);
 void *ralloc_alloc_e(RegionAlloc *ra, size_t size);
 void *ralloc_resize_e(RegionAlloc *ra, void *mem, size_t new_size);
 
+// Allocate "size" bytes whose first "file_bytes" are the contents of open
+// file "fd" starting at "file_offset", mapped copy-on-write instead of read
+// in: pages are faulted in lazily, and shared through the host page cache
+// until written.  Bytes past "file_bytes" read as zero.  The file may be
+// closed afterward.  Returns NULL on failure, or if "ra" wasn't made by
+// ralloc_create_mmap() with "allow_file_maps"; the region is then used like
+// any other, though resizing it falls back to a copy.
+void *ralloc_alloc_file(RegionAlloc *ra, size_t size, int fd,
+                        i64 file_offset, size_t file_bytes);
+
+void ralloc_get_stats(const RegionAlloc *ra, RegionAllocStats *dest);
+// Also reports the host's AnonHugePages total, where available
+void ralloc_print_stats(const RegionAlloc *ra, void *c_FILE_out,
+                        const char *prefix);
+
 
 #ifdef __cplusplus
 }
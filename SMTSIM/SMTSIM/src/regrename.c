@@ -25,6 +25,8 @@
 #include "sim-assert.h"
 #include "main.h"
 #include "core-resources.h"
+#include "lsq-model.h"
+#include "branch-ckpt.h"
 #include "dyn-inst.h"
 #include "context.h"
 #include "app-state.h"
@@ -77,6 +79,15 @@ log_apps_qconf_cyc(const StageQueue * restrict stalled)
 
 
 
+// Remember why rename stalled, for CPI-stack attribution at commit
+static inline void
+note_rename_stall(context * restrict ctx, CpiCause cause)
+{
+    ctx->cpi.rename_stall = cause;
+    ctx->cpi.rename_stall_cyc = cyc;
+}
+
+
 /* Here, instructions get stalled if there is no room in the instruction
  * queues, or if there is not space in the load-store queue, or if there are no
  * renaming registers available.  Load Store Queue is not accurately modeled.
@@ -110,15 +121,20 @@ regrename_for_core(CoreResources *core)
         }
 
         /* ROB space available? */
-        if (is_shared(ROB)){ //Resource Pooling
+        if (instrn->fused) {
+            // Fused tail: shares its head's ROB entry
+        }
+        else if (is_shared(ROB)){ //Resource Pooling
             if (space_available(ROB,current) < 1){
                 current->stats.robconf_cyc++;
+                note_rename_stall(current, Cpi_ROBFull);
                 break;
             }
         }
         else { //No Resource Pooling
             if (current->rob_used >= current->params.reorder_buffer_size) {
                 current->stats.robconf_cyc++;
+                note_rename_stall(current, Cpi_ROBFull);
                 break;
             }
         }
@@ -128,6 +144,7 @@ regrename_for_core(CoreResources *core)
             if (is_shared(LSQ)){ //Resource Pooling
                 if (space_available(LSQ,current) < 1){
                     core->q_stats.lsqconf_cyc++;
+                    note_rename_stall(current, Cpi_LSQFull);
                     DEBUGPRINTF("C%i: LSQ full\n", core->core_id);
                     break;
                 }
@@ -135,6 +152,7 @@ regrename_for_core(CoreResources *core)
             else { //No Resource Pooling
                 if (core->lsq_used >= core->params.loadstore_queue_size) {
                     core->q_stats.lsqconf_cyc++;
+                    note_rename_stall(current, Cpi_LSQFull);
                     DEBUGPRINTF("C%i: LSQ full\n", core->core_id);
                     break;
                 }
@@ -147,6 +165,7 @@ regrename_for_core(CoreResources *core)
                 if (is_shared(IREG)){ //Resource Pooling
                     if (space_available(IREG,current) < 1){
                         core->q_stats.iregconf_cyc++;
+                        note_rename_stall(current, Cpi_RenameFull);
                         break;
                     }
                     else {
@@ -158,6 +177,7 @@ regrename_for_core(CoreResources *core)
                     if (core->i_registers_used >= 
                             core->params.rename.int_rename_regs) {
                         core->q_stats.iregconf_cyc++;
+                        note_rename_stall(current, Cpi_RenameFull);
                         break;
                     }
                     else {
@@ -169,6 +189,7 @@ regrename_for_core(CoreResources *core)
                 if (is_shared(FREG)){ //Resource Pooling
                     if (space_available(FREG,current) < 1){
                         core->q_stats.fregconf_cyc++;
+                        note_rename_stall(current, Cpi_RenameFull);
                         break;
                     }
                     else {
@@ -180,6 +201,7 @@ regrename_for_core(CoreResources *core)
                     if (core->f_registers_used >=
                             core->params.rename.float_rename_regs) {
                         core->q_stats.fregconf_cyc++;
+                        note_rename_stall(current, Cpi_RenameFull);
                         break;
                     } 
                     else {
@@ -196,6 +218,7 @@ regrename_for_core(CoreResources *core)
                 if (space_available(FQ,current) < 1){
                     DEBUGPRINTF("C%i: FQ full\n", core->core_id);
                     core->q_stats.fqconf_cyc++;
+                    note_rename_stall(current, Cpi_FQFull);
                     core->i_registers_used -= instrn->iregs_used;
                     core->f_registers_used -= instrn->fregs_used;
                     instrn->iregs_used = instrn->fregs_used = 0;
@@ -203,10 +226,10 @@ regrename_for_core(CoreResources *core)
                     break;
                 } /* space available */
                 else {
-                    instrn->robentry = 1;
-                    current->rob_used++;
+                    instrn->robentry = !instrn->fused;
+                    current->rob_used += instrn->robentry;
                     update_acc_occ_per_inst(current, instrn, 0, 1);
-                    update_adapt_mgr_incr(current, ROB, 1);
+                    update_adapt_mgr_incr(current, ROB, instrn->robentry);
                     update_adapt_mgr_incr(current, FQ, 1);
                     update_adapt_mgr_incr(current, IREG, instrn->iregs_used);
                     update_adapt_mgr_incr(current, FREG, instrn->fregs_used);
@@ -224,16 +247,17 @@ regrename_for_core(CoreResources *core)
                 if (stageq_count(core->stage.floatq) >= core->params.queue.float_queue_size) {
                     DEBUGPRINTF("C%i: FQ full\n", core->core_id);
                     core->q_stats.fqconf_cyc++;
+                    note_rename_stall(current, Cpi_FQFull);
                     core->i_registers_used -= instrn->iregs_used;
                     core->f_registers_used -= instrn->fregs_used;
                     instrn->iregs_used = instrn->fregs_used = 0;
                     log_apps_qconf_cyc(rename_src);
                     break;
                 } /* space available */
-                instrn->robentry = 1;
-                current->rob_used++;
+                instrn->robentry = !instrn->fused;
+                current->rob_used += instrn->robentry;
                 update_acc_occ_per_inst(current, instrn, 0, 1);
-                update_adapt_mgr_incr(current, ROB, 1);
+                update_adapt_mgr_incr(current, ROB, instrn->robentry);
                 update_adapt_mgr_incr(current, FQ, 1);
                 update_adapt_mgr_incr(current, IREG, instrn->iregs_used);
                 update_adapt_mgr_incr(current, FREG, instrn->fregs_used);
@@ -251,6 +275,7 @@ regrename_for_core(CoreResources *core)
                 if (space_available(IQ,current) < 1){
                     DEBUGPRINTF("C%i: IQ full\n", core->core_id);
                     core->q_stats.iqconf_cyc++;
+                    note_rename_stall(current, Cpi_IQFull);
                     core->i_registers_used -= instrn->iregs_used;
                     core->f_registers_used -= instrn->fregs_used;
                     instrn->iregs_used = instrn->fregs_used = 0;
@@ -258,10 +283,10 @@ regrename_for_core(CoreResources *core)
                     break;
                 } /* space available */
                 else {
-                    instrn->robentry = 1;
-                    current->rob_used++;
+                    instrn->robentry = !instrn->fused;
+                    current->rob_used += instrn->robentry;
                     update_acc_occ_per_inst(current, instrn, 0, 0);
-                    update_adapt_mgr_incr(current, ROB, 1);
+                    update_adapt_mgr_incr(current, ROB, instrn->robentry);
                     update_adapt_mgr_incr(current, IQ, 1);
                     update_adapt_mgr_incr(current, IREG, instrn->iregs_used);
                     update_adapt_mgr_incr(current, FREG, instrn->fregs_used);
@@ -271,14 +296,18 @@ regrename_for_core(CoreResources *core)
                         update_adapt_mgr_incr(current, LSQ, instrn->lsqentry);
                     }
                         
+                    core->fused_in_intq += instrn->fused;
                     stageq_dequeue(*rename_src);
                     stageq_enqueue(core->stage.intq, instrn);
                 }
             }
             else { //No Resource Pooling
-                if (stageq_count(core->stage.intq) >= core->params.queue.int_queue_size) {
+                if (!instrn->fused &&
+                    (stageq_count(core->stage.intq) - core->fused_in_intq >=
+                     core->params.queue.int_queue_size)) {
                     DEBUGPRINTF("C%i: IQ full\n", core->core_id);
                     core->q_stats.iqconf_cyc++;
+                    note_rename_stall(current, Cpi_IQFull);
                     core->i_registers_used -= instrn->iregs_used;
                     core->f_registers_used -= instrn->fregs_used;
                     instrn->iregs_used = instrn->fregs_used = 0;
@@ -286,10 +315,10 @@ regrename_for_core(CoreResources *core)
                     break;
                 } 
                 /* space available */
-                instrn->robentry = 1;
-                current->rob_used++;
+                instrn->robentry = !instrn->fused;
+                current->rob_used += instrn->robentry;
                 update_acc_occ_per_inst(current, instrn, 0, 0);
-                update_adapt_mgr_incr(current, ROB, 1);
+                update_adapt_mgr_incr(current, ROB, instrn->robentry);
                 update_adapt_mgr_incr(current, IQ, 1);
                 update_adapt_mgr_incr(current, IREG, instrn->iregs_used);
                 update_adapt_mgr_incr(current, FREG, instrn->fregs_used);
@@ -299,11 +328,17 @@ regrename_for_core(CoreResources *core)
                     update_adapt_mgr_incr(current, LSQ, instrn->lsqentry);
                 }
 
+                core->fused_in_intq += instrn->fused;
                 stageq_dequeue(*rename_src);
                 stageq_enqueue(core->stage.intq, instrn);
             }
         }
         instrn->renamecycle = cyc;
+        ctx_rsrc_tally_add(&current->rsrc_alloced, instrn);
+        if (instrn->ckpt_id >= 0)
+            bckpt_inst_renamed(core->bckpt, current, instrn);
+        if (instrn->lsqentry && core->lsqm)
+            lsqm_renamed(core->lsqm, current, instrn);
     }
 
     // Update Context Occupancy stats
@@ -44,6 +44,12 @@
 #include "work-queue.h"
 #include "debug-coverage.h"
 #include "adapt-mgr.h"
+#include "app-mem-stats.h"
+#include "inst-trace.h"
+#include "mem-profiler.h"
+#include "wsm.h"
+#include "power-model.h"
+#include "stats-reg.h"
 
 i64 cyc;
 i64 allinstructions;
@@ -69,6 +75,32 @@ static int DebugShowStages = 0;
 static void appstate_instcount_check(void);
 
 
+// The WSM capture units are fed by the profiler, so it's needed whenever
+// WSM is in use, even with its own logging disabled.
+static void
+init_mem_profiler(void)
+{
+    if (!simcfg_get_bool("GlobalMemProfiler/enable") && !GlobalWSMCoord)
+        return;
+    if (!(GlobalMemProfiler = memprof_create("GlobalMemProfiler"))) {
+        exit_printf("couldn't create GlobalMemProfiler\n");
+    }
+}
+
+
+static void
+init_power_model(void)
+{
+    if (!simcfg_get_bool("Power/enable"))
+        return;
+    if (!(GlobalPowerModel = power_create("Power"))) {
+        exit_printf("couldn't create GlobalPowerModel\n");
+    }
+    if (GlobalStatsReg)
+        power_register_stats(GlobalPowerModel, GlobalStatsReg, "power");
+}
+
+
 static void
 init_long_mem_log(void)
 {
@@ -106,8 +138,21 @@ cleanup_dynamic_globals(void)
         return;
     }
     DEBUGPRINTF("cleanup_dynamic_globals(), time %s\n", fmt_i64(cyc));
+    // (first: its providers point into the objects destroyed below)
+    if (GlobalStatsReg) {
+        statsreg_destroy(GlobalStatsReg);
+        GlobalStatsReg = NULL;
+    }
     longmem_destroy(GlobalLongMemLogger);
     GlobalLongMemLogger = NULL;
+    if (GlobalMemProfiler) {
+        memprof_destroy(GlobalMemProfiler);
+        GlobalMemProfiler = NULL;
+    }
+    if (GlobalPowerModel) {
+        power_destroy(GlobalPowerModel);
+        GlobalPowerModel = NULL;
+    }
     debug_coverage_destroy(EmulateDebugCoverage);
     EmulateDebugCoverage = NULL;
     debug_coverage_destroy(FltiRoundDebugCoverage);
@@ -155,6 +200,8 @@ int run(void)
         if (simcfg_have_val(key6))
             DebugExitCycle = simcfg_get_i64(key6);
         init_long_mem_log();
+        init_mem_profiler();
+        init_power_model();
     }
     if (atexit(cleanup_dynamic_globals)) {
         exit_printf("can't register cleanup_dynamic_globals() callback");
@@ -358,6 +405,27 @@ fmt_missrate(const ASE_HitRate * restrict hr)
 }
 
 
+// Print an app's CPI stack: its CPI (over scheduled cycles), split by each
+// category's share of its commit slots
+static void
+print_app_cpi_stack(const AppState *as, FILE *out, const char *pref)
+{
+    const i64 *slots = as->extra->cpi_slots;
+    i64 total_slots = 0;
+    for (int i = 0; i < CpiCause_last; i++)
+        total_slots += slots[i];
+    double cpi = (as->extra->total_commits) ?
+        (double) app_sched_cyc(as) / as->extra->total_commits : 0.0;
+    fprintf(out, "%sA%d cpi_stack: cpi %.3f slots %s [", pref, as->app_id,
+            cpi, fmt_i64(total_slots));
+    for (int i = 0; i < CpiCause_last; i++) {
+        fprintf(out, " %s %.3f", CpiCause_names[i],
+                (total_slots) ? (cpi * slots[i] / total_slots) : 0.0);
+    }
+    fprintf(out, " ]\n");
+}
+
+
 static void
 appstate_progress(FILE *out)
 {
@@ -516,6 +584,34 @@ appstate_progress(FILE *out)
                 as->extra->mem_delay.sample_count);
     printf(" ]\n");
 
+    cache_credit_all_app_mlp();
+    appstate_global_iter_reset();
+    printf("%smlp: [", pref);
+    while ((as = appstate_global_iter_next()) != NULL)
+        fprintf(out, " %.3f", appmemstats_mlp(as->extra->mem_stats));
+    printf(" ]\n");
+
+    appstate_global_iter_reset();
+    while ((as = appstate_global_iter_next()) != NULL) {
+        char app_pref[80];
+        e_snprintf(app_pref, sizeof(app_pref), "%sA%d mem ", pref,
+                   as->app_id);
+        appmemstats_print(as->extra->mem_stats, out, app_pref);
+    }
+
+    appstate_global_iter_reset();
+    while ((as = appstate_global_iter_next()) != NULL) {
+        InstTraceStats its;
+        if (!itrace_get_app_stats(as, &its))
+            continue;
+        fprintf(out, "%sA%d itrace: wrote %s insts, %s code pages; "
+                "replayed %s records, %s no-ops filled, %s wrong-path "
+                "approximated\n", pref, as->app_id,
+                fmt_i64(its.insts_written), fmt_i64(its.pages_written),
+                fmt_i64(its.records_read), fmt_i64(its.noops_filled),
+                fmt_i64(its.wp_insts));
+    }
+
     appstate_global_iter_reset();
     printf("%sinstq_conf_cyc/schedcyc_pct: [", pref);
     while ((as = appstate_global_iter_next()) != NULL)
@@ -534,6 +630,12 @@ appstate_progress(FILE *out)
     while ((as = appstate_global_iter_next()) != NULL)
         fprintf(out, " %s", fmt_i64(as->extra->long_mem_flushed));
     printf(" ]\n");
+
+    if (GlobalParams.cpi_stack) {
+        appstate_global_iter_reset();
+        while ((as = appstate_global_iter_next()) != NULL)
+            print_app_cpi_stack(as, out, pref);
+    }
 }
 
 
@@ -587,6 +689,23 @@ print_sim_stats(int final_stats)
     }
     if (GlobalLongMemLogger)
         longmem_flush(GlobalLongMemLogger);
+    if (GlobalMemProfiler)
+        memprof_flush(GlobalMemProfiler);
+    if (GlobalWSMCoord) {
+        int core_id;
+        printf("WSM stats:\n");
+        for (core_id = 0; core_id < CoreCount; core_id++) {
+            if (Cores[core_id]->wsm_capture)
+                wsm_threadcap_printstats(Cores[core_id]->wsm_capture, stdout,
+                                         "  ");
+        }
+    }
+
+    if (GlobalPowerModel) {
+        power_sample(GlobalPowerModel);
+        printf("Power stats:\n");
+        power_printstats(GlobalPowerModel, stdout, "  ");
+    }
 
     print_adaptmgr_stats();
     
@@ -595,6 +714,8 @@ print_sim_stats(int final_stats)
         printed_final = 1;
         finalstats();
         workq_gen_final_stats(GlobalWorkQueue);
+        if (GlobalStatsReg)
+            statsreg_emit(GlobalStatsReg, 1);
     }
     printf("\n");
     if (final_stats)
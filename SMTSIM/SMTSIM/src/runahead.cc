@@ -0,0 +1,446 @@
+//
+// Runahead execution past long-latency loads
+//
+// $Id$
+//
+
+const char RCSid_1760000035[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "main.h"
+#include "runahead.h"
+#include "core-resources.h"
+#include "context.h"
+#include "dyn-inst.h"
+#include "app-state.h"
+#include "prog-mem.h"
+#include "cache-array.h"
+#include "mshr.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stats-reg.h"
+
+
+using std::set;
+using std::string;
+using std::vector;
+
+using SimCfg::conf_bool;
+
+extern i64 cyc;
+
+
+namespace {
+
+struct RunaheadConfig {
+    bool track_inv;             // f: runahead loads see their real values
+
+    NoDefaultCopy nocopy;
+
+public:
+    RunaheadConfig(const string& cfg_path);
+    ~RunaheadConfig() { }
+};
+
+
+RunaheadConfig::RunaheadConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    track_inv = conf_bool(cp + "track_inv");
+}
+
+
+// Memory overwritten by a pseudo-retired store
+struct StoreLogEnt {
+    mem_addr addr;
+    int width;
+    u64 old_val;
+    StoreLogEnt(mem_addr addr_, int width_, u64 old_val_)
+        : addr(addr_), width(width_), old_val(old_val_) { }
+};
+
+
+struct ThreadRunahead {
+    bool active;
+    LongAddr block;             // blocking load's D-cache block
+    mem_addr restart_pc;
+    i64 start_cyc;
+
+    // Checkpoint of state which pseudo-retired insts can change
+    vector<reg_u> regs;
+    vector<i64> retstack;
+    int rs_size, rs_start;
+    unsigned ghr;
+    u64 ind_hist;
+    i64 total_insts;
+
+    vector<StoreLogEnt> store_log;
+    vector<char> inv_reg;       // INV dests of pseudo-retired insts
+    set<LongAddr> pf_blocks;    // prefetched, not yet read at commit
+
+    ThreadRunahead()
+        : active(false), restart_pc(0), start_cyc(0), rs_size(0),
+          rs_start(0), ghr(0), ind_hist(0), total_insts(0) {
+        laddr_set(block, 0, 0);
+    }
+};
+
+} // Anonymous namespace close
+
+
+struct Runahead {
+private:
+    string name_;
+    RunaheadConfig conf_;
+    CoreResources *core_;
+    vector<ThreadRunahead> threads_;    // by core_thread_id
+    RunaheadStats stats_;
+
+    ThreadRunahead& thread(const context *ctx) {
+        int tid = ctx->core_thread_id;
+        if (tid >= intsize(threads_))
+            threads_.resize(tid + 1);
+        return threads_[tid];
+    }
+    const ThreadRunahead *thread_if(const context *ctx) const {
+        int tid = ctx->core_thread_id;
+        return (tid < intsize(threads_)) ? &threads_[tid] : NULL;
+    }
+    LongAddr block_of(const context *ctx, mem_addr addr) const {
+        LongAddr result;
+        laddr_set(result, addr, ctx->as->app_master_id);
+        cache_align_addr(core_->dcache, &result);
+        return result;
+    }
+    bool src_inv(const context *ctx, const ThreadRunahead& thr,
+                 int reg) const;
+
+public:
+    Runahead(const char *name__, const char *config_path__,
+             CoreResources *core__);
+    ~Runahead() { }
+
+    bool should_enter(const context *ctx) const;
+    void enter(context *ctx, mem_addr load_pc, mem_addr load_addr);
+    bool miss_done(const context *ctx) const;
+    mem_addr exit(context *ctx);
+    void inst_fetched(const context *ctx, activelist *inst);
+    void inst_retired(const context *ctx, const activelist *inst);
+    void mem_miss(const context *ctx, const activelist *inst);
+    void load_committed(const context *ctx, const activelist *inst);
+    bool track_inv() const { return conf_.track_inv; }
+
+    void reset_stats() { memset(&stats_, 0, sizeof(stats_)); }
+    const RunaheadStats& get_stats() const { return stats_; }
+    void print_stats(FILE *out, const char *pf) const;
+};
+
+
+Runahead::Runahead(const char *name__, const char *config_path__,
+                   CoreResources *core__)
+    : name_(name__), conf_(config_path__), core_(core__)
+{
+    reset_stats();
+}
+
+
+bool
+Runahead::should_enter(const context *ctx) const
+{
+    const activelist *load = &ctx->alist[ctx->next_to_commit];
+    const ThreadRunahead *thr = thread_if(ctx);
+    sim_assert(!thr || !thr->active);
+    if (!ctx->as || ctx->follow_sync || (ctx->halting != CtxHalt_NoHalt) ||
+        !(load->status & MEMORY) || !(load->mem_flags & SMF_Read) ||
+        !load->dmiss_cache_entry || load->wp || (load->fu == SYNCH) || load->bmt.spillfill ||
+        (load->gen_flags & SGF_PipeExclusive))
+        return false;
+    // Only worth it while the block is still on its way
+    return mshr_any_producer(core_->data_mshr, block_of(ctx, load->srcmem));
+}
+
+
+void
+Runahead::enter(context *ctx, mem_addr load_pc, mem_addr load_addr)
+{
+    ThreadRunahead& thr = thread(ctx);
+    const AppState *as = ctx->as;
+    sim_assert(!thr.active);
+    thr.active = true;
+    thr.block = block_of(ctx, load_addr);
+    thr.restart_pc = load_pc;
+    thr.start_cyc = cyc;
+
+    thr.regs.assign(as->R, as->R + MAXREG);
+    thr.retstack.assign(ctx->return_stack,
+                        ctx->return_stack + ctx->params.retstack_entries);
+    thr.rs_size = ctx->rs_size;
+    thr.rs_start = ctx->rs_start;
+    thr.ghr = ctx->ghr;
+    thr.ind_hist = ctx->ind_hist;
+    thr.total_insts = as->stats.total_insts;
+
+    thr.store_log.clear();
+    thr.inv_reg.assign(MAXREG, 0);
+    // Blocks from the previous episode which haven't been read by now are
+    // counted as useless
+    thr.pf_blocks.clear();
+    stats_.episodes++;
+}
+
+
+bool
+Runahead::miss_done(const context *ctx) const
+{
+    const ThreadRunahead *thr = thread_if(ctx);
+    sim_assert(thr && thr->active);
+    return !mshr_any_producer(core_->data_mshr, thr->block);
+}
+
+
+mem_addr
+Runahead::exit(context *ctx)
+{
+    ThreadRunahead& thr = thread(ctx);
+    AppState *as = ctx->as;
+    sim_assert(thr.active);
+    thr.active = false;
+
+    // Undo pseudo-retired stores, youngest first
+    for (int i = intsize(thr.store_log) - 1; i >= 0; i--) {
+        const StoreLogEnt& ent = thr.store_log[i];
+        pmem_write_n(as->pmem, ent.width, ent.addr, ent.old_val,
+                     PMAF_NoExcept);
+    }
+    thr.store_log.clear();
+
+    std::copy(thr.regs.begin(), thr.regs.end(), as->R);
+    std::copy(thr.retstack.begin(), thr.retstack.end(), ctx->return_stack);
+    ctx->rs_size = thr.rs_size;
+    ctx->rs_start = thr.rs_start;
+    ctx->ghr = thr.ghr;
+    ctx->ind_hist = thr.ind_hist;
+    as->stats.total_insts = thr.total_insts;
+
+    stats_.cycles += cyc - thr.start_cyc;
+    return thr.restart_pc;
+}
+
+
+bool
+Runahead::src_inv(const context *ctx, const ThreadRunahead& thr,
+                  int reg) const
+{
+    if (IS_ZERO_REG2(reg))
+        return false;
+    int writer = ctx->last_writer[reg];
+    return (writer != NONE) ? (ctx->alist[writer].ra_inv != 0) :
+        (thr.inv_reg[reg] != 0);
+}
+
+
+void
+Runahead::inst_fetched(const context *ctx, activelist *inst)
+{
+    const ThreadRunahead& thr = thread(ctx);
+    sim_assert(thr.active);
+    inst->ra_inv = conf_.track_inv &&
+        (src_inv(ctx, thr, inst->src1) || src_inv(ctx, thr, inst->src2));
+    stats_.insts++;
+    if (inst->ra_inv)
+        stats_.inv_insts++;
+}
+
+
+void
+Runahead::inst_retired(const context *ctx, const activelist *inst)
+{
+    ThreadRunahead& thr = thread(ctx);
+    sim_assert(thr.active);
+    if (!IS_ZERO_REG2(inst->dest))
+        thr.inv_reg[inst->dest] = (inst->ra_inv != 0);
+    if ((inst->mem_flags & SMF_Write) &&
+        !(inst->gen_flags & SGF_SyncAtCommit)) {
+        thr.store_log.push_back(StoreLogEnt(inst->destmem,
+                                            SMF_GetWidth(inst->mem_flags),
+                                            inst->undo.dest_mem_val));
+    }
+    stats_.pseudo_retired++;
+}
+
+
+void
+Runahead::mem_miss(const context *ctx, const activelist *inst)
+{
+    ThreadRunahead& thr = thread(ctx);
+    sim_assert(thr.active);
+    mem_addr addr = (inst->mem_flags & SMF_Read) ? inst->srcmem :
+        inst->destmem;
+    LongAddr block = block_of(ctx, addr);
+    if (!(block == thr.block))
+        thr.pf_blocks.insert(block);
+    stats_.prefetches++;
+}
+
+
+void
+Runahead::load_committed(const context *ctx, const activelist *inst)
+{
+    ThreadRunahead& thr = thread(ctx);
+    if (thr.pf_blocks.empty())
+        return;
+    set<LongAddr>::iterator found =
+        thr.pf_blocks.find(block_of(ctx, inst->srcmem));
+    if (found != thr.pf_blocks.end()) {
+        thr.pf_blocks.erase(found);
+        stats_.useful++;
+    }
+}
+
+
+void
+Runahead::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%sRunahead: episodes %s cycles %s (%.1f/episode)"
+            " insts %s (%.1f/episode) pseudo-retired %s INV %s\n", pf,
+            fmt_i64(stats_.episodes), fmt_i64(stats_.cycles),
+            (stats_.episodes) ?
+            ((double) stats_.cycles / stats_.episodes) : 0.0,
+            fmt_i64(stats_.insts),
+            (stats_.episodes) ?
+            ((double) stats_.insts / stats_.episodes) : 0.0,
+            fmt_i64(stats_.pseudo_retired), fmt_i64(stats_.inv_insts));
+    fprintf(out, "%sRunahead: prefetches %s useful %s (%.2f%%)\n", pf,
+            fmt_i64(stats_.prefetches), fmt_i64(stats_.useful),
+            (stats_.prefetches) ?
+            (100.0 * stats_.useful / stats_.prefetches) : 0.0);
+}
+
+
+
+//
+// C interface
+//
+
+Runahead *
+runahead_create(const char *name, const char *config_path,
+                struct CoreResources *core)
+{
+    return new Runahead(name, config_path, core);
+}
+
+void
+runahead_destroy(Runahead *ra)
+{
+    delete ra;
+}
+
+int
+runahead_should_enter(const Runahead *ra, const struct context *ctx)
+{
+    return ra->should_enter(ctx);
+}
+
+void
+runahead_enter(Runahead *ra, struct context *ctx, mem_addr load_pc,
+               mem_addr load_addr)
+{
+    ra->enter(ctx, load_pc, load_addr);
+}
+
+int
+runahead_miss_done(const Runahead *ra, const struct context *ctx)
+{
+    return ra->miss_done(ctx);
+}
+
+mem_addr
+runahead_exit(Runahead *ra, struct context *ctx)
+{
+    return ra->exit(ctx);
+}
+
+void
+runahead_inst_fetched(Runahead *ra, const struct context *ctx,
+                      struct activelist *inst)
+{
+    ra->inst_fetched(ctx, inst);
+}
+
+void
+runahead_inst_retired(Runahead *ra, const struct context *ctx,
+                      const struct activelist *inst)
+{
+    ra->inst_retired(ctx, inst);
+}
+
+void
+runahead_mem_miss(Runahead *ra, const struct context *ctx,
+                  const struct activelist *inst)
+{
+    ra->mem_miss(ctx, inst);
+}
+
+int
+runahead_track_inv(const Runahead *ra)
+{
+    return ra->track_inv();
+}
+
+void
+runahead_load_committed(Runahead *ra, const struct context *ctx,
+                        const struct activelist *inst)
+{
+    ra->load_committed(ctx, inst);
+}
+
+void
+runahead_reset_stats(Runahead *ra)
+{
+    ra->reset_stats();
+}
+
+void
+runahead_get_stats(const Runahead *ra, RunaheadStats *dest)
+{
+    *dest = ra->get_stats();
+}
+
+static void
+runahead_stats_provider(StatsEmitter *em, void *data)
+{
+    const RunaheadStats& st = static_cast<const Runahead *>(data)->get_stats();
+    statsemit_i64(em, "episodes", st.episodes);
+    statsemit_i64(em, "cycles", st.cycles);
+    statsemit_i64(em, "insts", st.insts);
+    statsemit_i64(em, "pseudo_retired", st.pseudo_retired);
+    statsemit_i64(em, "inv_insts", st.inv_insts);
+    statsemit_i64(em, "prefetches", st.prefetches);
+    statsemit_i64(em, "useful", st.useful);
+}
+
+void
+runahead_register_stats(Runahead *ra, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, runahead_stats_provider, ra);
+}
+
+void
+runahead_print_stats(const Runahead *ra, void *c_FILE_out,
+                     const char *prefix)
+{
+    ra->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
@@ -0,0 +1,110 @@
+// -*- C++ -*-
+//
+// Runahead execution past long-latency loads
+//
+// $Id$
+//
+
+#ifndef RUNAHEAD_H
+#define RUNAHEAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each core may have one of these, enabled by its "Runahead" config block.
+//
+// When a correct-path load blocks commit on a D-cache miss long enough to be
+// flagged by long_mem_detect() (GlobalParams.long_mem_cyc), and its miss is
+// still outstanding, the thread enters runahead mode instead of being
+// flushed/stalled: the load and everything after it are squashed, the
+// architectural state as of just before the load is checkpointed here, and
+// fetch restarts at the load on the "wrong path".  Runahead instructions are
+// emulated speculatively like any other wrong-path instructions, but they
+// also pseudo-retire from the head of the window, so the thread can keep
+// running arbitrarily far ahead.  Their loads and stores which miss are
+// detached from the cache request (which carries on as a prefetch) and
+// complete at once, with loads marking their results INV; instructions
+// depending on INV values are INV themselves, INV memory operations don't
+// access the cache, and INV branches don't redirect fetch.
+//
+// When the blocking load's block returns, everything in the window is
+// squashed, the checkpoint is restored (including memory written by
+// pseudo-retired stores), and fetch restarts at the load.  See
+// enter_runahead() / exit_runahead() in execute.c.
+
+struct CoreResources;
+struct context;
+struct activelist;
+
+typedef struct Runahead Runahead;
+typedef struct RunaheadStats RunaheadStats;
+struct StatsReg;
+
+struct RunaheadStats {
+    i64 episodes;
+    i64 cycles;                 // spent in runahead mode
+    i64 insts;                  // fetched in runahead mode (all discarded)
+    i64 pseudo_retired;         // ...which reached the head of the window
+    i64 inv_insts;              // ...which were INV at fetch
+    i64 prefetches;             // runahead load/store misses sent on
+    i64 useful;                 // ...whose block a committed load later read
+};
+
+
+Runahead *runahead_create(const char *name, const char *config_path,
+                          struct CoreResources *core);
+void runahead_destroy(Runahead *ra);
+
+// Whether "ctx", whose oldest instruction has just been flagged as a
+// long-latency memory op, should enter runahead mode.  (Only if that load's
+// own cache request is still in flight.)
+int runahead_should_enter(const Runahead *ra, const struct context *ctx);
+
+// Checkpoint "ctx", which has just squashed the blocking load (at
+// "load_pc", reading "load_addr") and will re-fetch from it.
+void runahead_enter(Runahead *ra, struct context *ctx, mem_addr load_pc,
+                    mem_addr load_addr);
+
+// Probe: has the miss which started the current episode completed?
+int runahead_miss_done(const Runahead *ra, const struct context *ctx);
+
+// End the episode: "ctx" must have already squashed its whole window.
+// Restores the checkpoint, and returns the PC to restart fetch from.
+mem_addr runahead_exit(Runahead *ra, struct context *ctx);
+
+// A runahead-mode instruction was fetched (call before it's recorded as
+// last_writer of its dest); sets its "ra_inv" flag from its sources.
+void runahead_inst_fetched(Runahead *ra, const struct context *ctx,
+                           struct activelist *inst);
+
+// A runahead-mode instruction pseudo-retired
+void runahead_inst_retired(Runahead *ra, const struct context *ctx,
+                           const struct activelist *inst);
+
+// A runahead-mode memory instruction missed and was sent on as a prefetch
+void runahead_mem_miss(Runahead *ra, const struct context *ctx,
+                       const struct activelist *inst);
+
+// Whether runahead-mode memory instructions with INV sources should skip
+// the cache (config "track_inv")
+int runahead_track_inv(const Runahead *ra);
+
+// A (normal mode) load committed; checks for prefetch usefulness
+void runahead_load_committed(Runahead *ra, const struct context *ctx,
+                             const struct activelist *inst);
+
+void runahead_reset_stats(Runahead *ra);
+void runahead_get_stats(const Runahead *ra, RunaheadStats *dest);
+// Register a provider for RunaheadStats at "path" (stats-reg.h)
+void runahead_register_stats(Runahead *ra, struct StatsReg *sr,
+                             const char *path);
+void runahead_print_stats(const Runahead *ra, void *c_FILE_out,
+                          const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RUNAHEAD_H
@@ -448,6 +448,7 @@ read_core_params()
     CoreParams *dest = static_cast<CoreParams *>(emalloc_zero(sizeof(*dest)));
 
     dest->config_path = e_strdup(Config.tree->full_path("").c_str());
+    dest->core_type = e_strdup(t_get_str("core_type").c_str());
 
     dest->itlb_entries = t_get_posint("itlb_entries");
     dest->dtlb_entries = t_get_posint("dtlb_entries");
@@ -505,6 +506,9 @@ read_core_params()
 
     t_push("Decode");
     dest->decode.n_stages = t_get_posint("n_stages");
+    dest->decode.fuse_cmp_branch = t_get_bool("fuse_cmp_branch");
+    dest->decode.fuse_ldah_lda = t_get_bool("fuse_ldah_lda");
+    dest->decode.fuse_scaled_load = t_get_bool("fuse_scaled_load");
     t_pop();
 
     t_push("Rename");
@@ -865,6 +869,7 @@ simcfg_sim_params(struct SimParams *dest)
     dest->disable_coredump = t_get_bool("disable_coredump");
     dest->reap_alist_at_squash = t_get_bool("reap_alist_at_squash");
     dest->abort_on_alist_full = t_get_bool("abort_on_alist_full");
+    dest->cpi_stack = t_get_bool("cpi_stack");
 
     dest->long_mem_cyc = t_get_nnint("/Hacking/long_mem_cyc");
     dest->long_mem_at_commit = t_get_bool("/Hacking/long_mem_at_commit");
@@ -894,8 +899,18 @@ simcfg_sim_params(struct SimParams *dest)
     dest->mem.split_bus = t_get_bool("split_bus");
     read_op_time(dest->mem.bus_request_time, "bus_request_time");
     read_op_time(dest->mem.bus_transfer_time, "bus_transfer_time");
+    dest->mem.interconnect = static_cast<CoreNetTopology>
+        (t_get_enum(CoreNetTopology_names, "Interconnect/topology"));
     dest->mem.stack_initial_kb = t_get_posint("stack_initial_kb");
     dest->mem.stack_max_kb = t_get_posint("stack_max_kb");
+    dest->mem.sparse_chunk_kb = t_get_posint("SparseSegs/chunk_kb");
+    if (log2_exact(dest->mem.sparse_chunk_kb) < 0) {
+        exit_printf("SparseSegs/chunk_kb (%d) must be a power of 2\n",
+                    dest->mem.sparse_chunk_kb);
+    }
+    dest->mem.sparse_heap = t_get_bool("SparseSegs/heap");
+    dest->mem.sparse_stack = t_get_bool("SparseSegs/stack");
+    dest->mem.sparse_mmap = t_get_bool("SparseSegs/mmap");
     dest->mem.use_coherence = t_get_bool("use_coherence");
     dest->mem.use_l3cache = t_get_bool("use_l3cache");
     dest->mem.private_l2caches = t_get_bool("private_l2caches");
@@ -916,6 +931,8 @@ simcfg_sim_params(struct SimParams *dest)
     dest->mem.l3cache_geom = cachegeom_create();
     read_cache_geom(dest->mem.l3cache_geom, dest->mem.cache_block_bytes);
     read_cache_timing(&dest->mem.l3cache_timing);
+    dest->mem.l3cache_inclusion = static_cast<L3InclusionPolicy>
+        (t_get_enum(L3InclusionPolicy_names, "inclusion"));
     t_pop();    // L3Cache
 
     t_push("MainMem");
@@ -956,6 +973,23 @@ simcfg_core_params(int core_id)
         Config.tree->set(specific_name, new KVTree(), false);
     }
 
+    {
+        // A named core type fills in values not set for this specific core,
+        // ahead of the defaults
+        string type_key = specific_name + "/core_type";
+        string core_type = (t_get_ifexist(type_key)) ? t_get_str(type_key) :
+            t_get_str(default_name + "/core_type");
+        if (!core_type.empty()) {
+            string type_name = "CoreTypes/" + core_type;
+            if (!t_get_ifexist(type_name)) {
+                exit_printf("Core_%d: unknown core_type \"%s\"\n", core_id,
+                            core_type.c_str());
+            }
+            Config.tree->overlay(specific_name,
+                                 t_get_tree(type_name)->copy(), true);
+        }
+    }
+
     {
         // Use default values to fill in any which aren't set in the
         // more specific trees
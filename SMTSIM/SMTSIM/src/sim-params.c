@@ -27,6 +27,16 @@ static const char *TCPNames[TCP_last] = {
 };
 
 
+const char *L3InclusionPolicy_names[] = {
+    "NonInclusive", "Inclusive", "Exclusive", NULL
+};
+
+
+const char *CoreNetTopology_names[] = {
+    "Bus", "Ring", "Mesh", NULL
+};
+
+
 SimParams GlobalParams;
 
 struct context **Contexts;                      // [CtxCount]
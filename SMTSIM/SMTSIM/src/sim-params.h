@@ -24,6 +24,28 @@ typedef enum {
 } ThreadCorePolicy;
 
 
+// How the shared L3 relates to the (L1+)L2 contents above it
+// (Be sure to update L3InclusionPolicy_names[] in sim-params.c)
+typedef enum {
+    L3Incl_NonInclusive,        // fill at each level, no back-invalidation
+    L3Incl_Inclusive,           // L3 evictions back-invalidate upper levels
+    L3Incl_Exclusive,           // L3 is a victim cache for L2 evictions
+    L3InclusionPolicy_last
+} L3InclusionPolicy;
+extern const char *L3InclusionPolicy_names[];
+
+
+// Interconnect between the cores and the shared level below them
+// (Be sure to update CoreNetTopology_names[] in sim-params.c)
+typedef enum {
+    CoreNet_Bus,                // single shared bus (CoreBus only)
+    CoreNet_Ring,               // bidirectional ring of routers
+    CoreNet_Mesh,               // 2D mesh of routers
+    CoreNetTopology_last
+} CoreNetTopology;
+extern const char *CoreNetTopology_names[];
+
+
 typedef struct SimParams {
     i64 thread_length;
     i64 allinstructions;        // <0: unset
@@ -37,6 +59,7 @@ typedef struct SimParams {
     int long_mem_cyc;
     int long_mem_at_commit;
     int print_appmgr_stats;
+    int cpi_stack;              // per-app CPI-stack accounting at commit
 
     struct {
         ThreadCorePolicy policy;
@@ -51,8 +74,11 @@ typedef struct SimParams {
         int split_bus;
         OpTime bus_request_time;
         OpTime bus_transfer_time;
+        CoreNetTopology interconnect;           // (details: core-net.h)
         int stack_initial_kb;
         int stack_max_kb;
+        int sparse_chunk_kb;
+        int sparse_heap, sparse_stack, sparse_mmap;     // use PMCF_Sparse
         int use_coherence;
         int use_l3cache;
         int private_l2caches;
@@ -60,6 +86,7 @@ typedef struct SimParams {
         CacheTiming l2cache_timing;             // Only for shared L2
         CacheGeometry *l3cache_geom;
         CacheTiming l3cache_timing;
+        L3InclusionPolicy l3cache_inclusion;
         MemUnitParams main_mem;
     } mem;
 } SimParams;
@@ -0,0 +1,432 @@
+//
+// Stats registry: machine-readable (JSON / CSV) snapshots of named counters,
+// collected from registered providers
+//
+// $Id$
+//
+
+const char RCSid_1760000043[] =
+"$Id$";
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "stats-reg.h"
+#include "callback-queue.h"
+#include "main.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+
+
+using std::string;
+using std::vector;
+
+using SimCfg::conf_i64;
+using SimCfg::conf_str;
+
+
+StatsReg *GlobalStatsReg = NULL;
+
+
+namespace {
+
+enum StatsFormat { SF_JSON, SF_CSV, StatsFormat_last };
+const char *StatsFormat_names[] = { "json", "csv", NULL };
+
+
+struct StatsRegConfig {
+    StatsFormat format;
+    string file_name;
+    i64 interval_cyc;           // <= 0: final snapshot only
+
+    NoDefaultCopy nocopy;
+
+public:
+    StatsRegConfig(const string& cfg_path);
+    ~StatsRegConfig() { }
+};
+
+
+StatsRegConfig::StatsRegConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";         // short-hand for config-path
+
+    string format_name = conf_str(cp + "format");
+    int fmt_idx = ENUM_FROMSTR(StatsFormat, format_name.c_str());
+    if (fmt_idx < 0) {
+        exit_printf("%sformat: unknown format \"%s\" (want \"json\" or "
+                    "\"csv\")\n", cp.c_str(), format_name.c_str());
+    }
+    format = StatsFormat(fmt_idx);
+    file_name = conf_str(cp + "file_name");
+    if (file_name.empty()) {
+        exit_printf("%sfile_name: empty\n", cp.c_str());
+    }
+    interval_cyc = conf_i64(cp + "interval_cyc");
+}
+
+
+// One node of the provider tree: a group named by one component of a
+// provider path, with at most one provider of its own
+struct ProviderNode {
+    string name;
+    StatsRegProviderFunc func;          // NULL: group only holds children
+    void *data;
+    vector<ProviderNode *> kids;        // in first-registration order
+
+    NoDefaultCopy nocopy;
+
+public:
+    ProviderNode(const string& name_)
+        : name(name_), func(NULL), data(NULL) { }
+    ~ProviderNode() {
+        for (size_t i = 0; i < kids.size(); i++)
+            delete kids[i];
+    }
+    ProviderNode *kid(const string& kid_name);
+};
+
+
+ProviderNode *
+ProviderNode::kid(const string& kid_name)
+{
+    for (size_t i = 0; i < kids.size(); i++) {
+        if (kids[i]->name == kid_name)
+            return kids[i];
+    }
+    kids.push_back(new ProviderNode(kid_name));
+    return kids.back();
+}
+
+
+string
+json_quote(const string& str)
+{
+    string result("\"");
+    for (size_t i = 0; i < str.size(); i++) {
+        char c = str[i];
+        if ((c == '"') || (c == '\\')) {
+            result += '\\';
+            result += c;
+        } else if ((unsigned char) c < 0x20) {
+            char buf[8];
+            e_snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char) c);
+            result += buf;
+        } else {
+            result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+
+string
+csv_quote(const string& str)
+{
+    if (str.find_first_of(",\"\n") == string::npos)
+        return str;
+    string result("\"");
+    for (size_t i = 0; i < str.size(); i++) {
+        if (str[i] == '"')
+            result += '"';
+        result += str[i];
+    }
+    result += '"';
+    return result;
+}
+
+} // Anonymous namespace close
+
+
+// Formats one snapshot into a string, in either output format
+struct StatsEmitter {
+private:
+    StatsFormat format_;
+    string row_prefix_;         // CSV: "cyc,final,"
+    vector<string> path_;       // open group names
+    vector<bool> group_empty_;  // JSON: per open group, no members yet
+    string out_;
+
+    void json_key(const string& name);
+    void value(const string& name, const string& val_text);
+
+public:
+    StatsEmitter(StatsFormat format, i64 now, bool is_final);
+
+    int depth() const { return static_cast<int>(path_.size()); }
+    void group_begin(const string& name);
+    void group_end();
+    void emit_i64(const string& name, i64 val) { value(name, fmt_i64(val)); }
+    void emit_double(const string& name, double val);
+    const string& finish();
+};
+
+
+StatsEmitter::StatsEmitter(StatsFormat format, i64 now, bool is_final)
+    : format_(format)
+{
+    if (format_ == SF_JSON) {
+        out_ = "{";
+        group_empty_.push_back(true);
+        emit_i64("cyc", now);
+        value("final", (is_final) ? "true" : "false");
+    } else {
+        row_prefix_ = string(fmt_i64(now)) + "," +
+            ((is_final) ? "1" : "0") + ",";
+    }
+}
+
+
+void
+StatsEmitter::json_key(const string& name)
+{
+    if (!group_empty_.back())
+        out_ += ',';
+    group_empty_.back() = false;
+    out_ += json_quote(name);
+    out_ += ':';
+}
+
+
+void
+StatsEmitter::value(const string& name, const string& val_text)
+{
+    if (format_ == SF_JSON) {
+        json_key(name);
+        out_ += val_text;
+    } else {
+        string full_name;
+        for (size_t i = 0; i < path_.size(); i++)
+            full_name += path_[i] + ".";
+        full_name += name;
+        out_ += row_prefix_ + csv_quote(full_name) + "," + val_text + "\n";
+    }
+}
+
+
+void
+StatsEmitter::emit_double(const string& name, double val)
+{
+    if (!isfinite(val) && (format_ == SF_JSON)) {
+        value(name, "null");            // JSON has no NaN/Inf
+    } else {
+        char buf[40];
+        e_snprintf(buf, sizeof(buf), "%.10g", val);
+        value(name, buf);
+    }
+}
+
+
+void
+StatsEmitter::group_begin(const string& name)
+{
+    if (format_ == SF_JSON) {
+        json_key(name);
+        out_ += '{';
+        group_empty_.push_back(true);
+    }
+    path_.push_back(name);
+}
+
+
+void
+StatsEmitter::group_end()
+{
+    if (path_.empty()) {
+        abort_printf("StatsEmitter::group_end: no group open\n");
+    }
+    if (format_ == SF_JSON) {
+        out_ += '}';
+        group_empty_.pop_back();
+    }
+    path_.pop_back();
+}
+
+
+const string&
+StatsEmitter::finish()
+{
+    sim_assert(path_.empty());
+    if (format_ == SF_JSON)
+        out_ += "}\n";
+    return out_;
+}
+
+
+struct StatsReg {
+private:
+    class IntervalCB;
+
+    StatsRegConfig conf_;
+    ProviderNode root_;                 // unnamed; never has a provider
+    FILE *out_;
+    IntervalCB *interval_cb_;
+
+    void emit_node(StatsEmitter& em, const ProviderNode& node) const;
+
+public:
+    StatsReg(const string& config_path);
+    ~StatsReg();
+
+    void add_provider(const string& name, StatsRegProviderFunc func,
+                      void *data);
+    void emit(bool is_final);
+    i64 interval_cyc() const { return conf_.interval_cyc; }
+};
+
+
+class StatsReg::IntervalCB : public CBQ_Callback {
+    StatsReg& sr;
+public:
+    IntervalCB(StatsReg& sr_) : sr(sr_) { }
+    i64 invoke(CBQ_Args *args) {
+        sr.emit(false);
+        return cyc + sr.interval_cyc();
+    }
+};
+
+
+StatsReg::StatsReg(const string& config_path)
+    : conf_(config_path), root_(""), out_(NULL), interval_cb_(NULL)
+{
+    out_ = static_cast<FILE *>(efopen(conf_.file_name.c_str(), 1));
+    if (conf_.format == SF_CSV)
+        fprintf(out_, "cyc,final,name,value\n");
+    if (conf_.interval_cyc > 0) {
+        interval_cb_ = new IntervalCB(*this);
+        callbackq_enqueue(GlobalEventQueue, cyc + conf_.interval_cyc,
+                          interval_cb_);
+    }
+}
+
+
+StatsReg::~StatsReg()
+{
+    if (interval_cb_)
+        callbackq_cancel(GlobalEventQueue, interval_cb_);
+    if (out_)
+        fclose(out_);
+}
+
+
+void
+StatsReg::add_provider(const string& name, StatsRegProviderFunc func,
+                       void *data)
+{
+    ProviderNode *node = &root_;
+    size_t start = 0;
+    for (;;) {
+        size_t slash = name.find('/', start);
+        string comp = name.substr(start, (slash == string::npos) ?
+                                  string::npos : (slash - start));
+        if (comp.empty()) {
+            abort_printf("StatsReg: bad provider path \"%s\"\n",
+                         name.c_str());
+        }
+        node = node->kid(comp);
+        if (slash == string::npos)
+            break;
+        start = slash + 1;
+    }
+    if (node->func) {
+        abort_printf("StatsReg: duplicate provider \"%s\"\n", name.c_str());
+    }
+    node->func = func;
+    node->data = data;
+}
+
+
+// A node's own provider is emitted first, then its children
+void
+StatsReg::emit_node(StatsEmitter& em, const ProviderNode& node) const
+{
+    em.group_begin(node.name);
+    if (node.func) {
+        int depth = em.depth();
+        node.func(&em, node.data);
+        if (em.depth() != depth) {
+            abort_printf("StatsReg: provider for group \"%s\" left group "
+                         "nesting unbalanced (depth %d, want %d)\n",
+                         node.name.c_str(), em.depth(), depth);
+        }
+    }
+    for (size_t i = 0; i < node.kids.size(); i++)
+        emit_node(em, *node.kids[i]);
+    em.group_end();
+}
+
+
+void
+StatsReg::emit(bool is_final)
+{
+    StatsEmitter em(conf_.format, cyc, is_final);
+    for (size_t i = 0; i < root_.kids.size(); i++)
+        emit_node(em, *root_.kids[i]);
+    const string& text = em.finish();
+    fwrite(text.data(), 1, text.size(), out_);
+    fflush(out_);
+}
+
+
+
+//
+// C interface
+//
+
+StatsReg *
+statsreg_create(const char *config_path)
+{
+    return new StatsReg(config_path);
+}
+
+void
+statsreg_destroy(StatsReg *sr)
+{
+    delete sr;
+}
+
+void
+statsreg_add_provider(StatsReg *sr, const char *name,
+                      StatsRegProviderFunc func, void *data)
+{
+    sr->add_provider(name, func, data);
+}
+
+void
+statsreg_emit(StatsReg *sr, int is_final)
+{
+    sr->emit(is_final);
+}
+
+void
+statsemit_group_begin(StatsEmitter *em, const char *name)
+{
+    em->group_begin(name);
+}
+
+void
+statsemit_group_end(StatsEmitter *em)
+{
+    em->group_end();
+}
+
+void
+statsemit_i64(StatsEmitter *em, const char *name, i64 val)
+{
+    em->emit_i64(name, val);
+}
+
+void
+statsemit_double(StatsEmitter *em, const char *name, double val)
+{
+    em->emit_double(name, val);
+}
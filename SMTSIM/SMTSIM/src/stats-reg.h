@@ -0,0 +1,71 @@
+//
+// Stats registry: machine-readable (JSON / CSV) snapshots of named counters,
+// collected from registered providers
+//
+// $Id$
+//
+
+#ifndef STATS_REG_H
+#define STATS_REG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// With "StatsReport/enable" set, one StatsReg (GlobalStatsReg) is created at
+// startup, before the cores and memory system.  Modules register
+// "providers": named callbacks which, when invoked, emit their current
+// counter values through a StatsEmitter, using nested named groups.  A
+// snapshot -- every provider -- is written with the final stats, and also
+// every "StatsReport/interval_cyc" cycles if that's positive.  This is
+// intended as a companion to the text printed by print_sim_stats(), for
+// scripts.
+//
+// Provider names are '/'-separated group paths, e.g. "cores/C0/dcache";
+// providers sharing a path prefix are emitted inside the same groups, with
+// groups in first-registration order, and a group's own provider (if any)
+// ahead of its sub-groups.  Each module supplies a *_register_stats()
+// function which registers its provider at a path chosen by its creator:
+// per-core structures under "cores/C<n>" (core_create()), the shared
+// caches, buses or CoreNet networks, coherence directory and L3 inclusion
+// traffic under "mem" (initcache(), init_coher()), per-app counters under
+// "apps", and the power model under "power".
+//
+// Output formats ("StatsReport/format"):
+//   "json": one JSON object per line per snapshot, e.g.
+//     {"cyc":1000,"final":false,"cores":{"C0":{"dcache":{"hits":...}}}}
+//   "csv": "cyc,final,name,value" rows, one per counter, with the group
+//     path in "name" dot-separated (e.g. "cores.C0.dcache.hits")
+
+typedef struct StatsReg StatsReg;
+typedef struct StatsEmitter StatsEmitter;
+
+typedef void (*StatsRegProviderFunc)(StatsEmitter *em, void *data);
+
+extern StatsReg *GlobalStatsReg;        // NULL unless StatsReport/enable
+
+
+StatsReg *statsreg_create(const char *config_path);
+void statsreg_destroy(StatsReg *sr);
+
+// Providers are invoked inside the group(s) named by path "name"; each path
+// may have only one provider
+void statsreg_add_provider(StatsReg *sr, const char *name,
+                           StatsRegProviderFunc func, void *data);
+
+// Write one snapshot of all providers, now
+void statsreg_emit(StatsReg *sr, int is_final);
+
+
+// For use by providers
+void statsemit_group_begin(StatsEmitter *em, const char *name);
+void statsemit_group_end(StatsEmitter *em);
+void statsemit_i64(StatsEmitter *em, const char *name, i64 val);
+void statsemit_double(StatsEmitter *em, const char *name, double val);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // STATS_REG_H
@@ -36,6 +36,7 @@
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/fcntl.h>
 #include <sys/mount.h>
 
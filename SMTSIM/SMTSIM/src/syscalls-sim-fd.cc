@@ -59,10 +59,12 @@ namespace {
         "sim_lseek.on_dir.nz", 
         "sim_open", 
         "sim_read", 
+        "sim_readv", 
         "sim_select_exceptfd",
         "sim_select_readfd",
         "sim_select_writefd",
         "sim_write", 
+        "sim_writev", 
         NULL
     };
     DebugCoverageTracker FDCoverage("SimulatedFD", FDCoverageNames, true);
@@ -112,6 +114,161 @@ read_system_errno()
 }
 
 
+// read/write/readv/writev go directly between the host file and simulated
+// memory: the simulated range is split into host-contiguous spans (at
+// segment boundaries, and every kIoChunkBytes).  Writes hand those to the
+// host's writev(2) at most kIovBatch at a time.  Reads go one span at a
+// time instead, stopping at a short count: a writable span of a sparse
+// segment allocates its chunk, so only the spans data actually lands in
+// (plus at most the one where EOF is found) are mapped.
+const u64 kIoChunkBytes = U64_LIT(1) << 30;     // well within ssize_t
+const int kIovBatch = 64;                       // well within any IOV_MAX
+
+// Alpha OSF/1 "struct iovec": 64-bit base, 32-bit length, 32-bit pad
+const int kAlphaIovecBytes = 16;
+const int kAlphaUioMaxIov = 1024;
+
+typedef vector<struct iovec> HostIovVec;
+
+struct SimIovec {
+    mem_addr base_va;
+    u64 len;
+    SimIovec(mem_addr base_va_, u64 len_) : base_va(base_va_), len(len_) { }
+};
+typedef vector<SimIovec> SimIovVec;
+
+
+// Append host spans covering [va, va+len) to "iov"; returns false if any
+// of it isn't mapped with "access_flags".
+bool
+append_host_spans(HostIovVec& iov, ProgMem *pmem, mem_addr va,
+                  u64 len, unsigned access_flags)
+{
+    while (len > 0) {
+        u64 span_len;
+        void *host_mem = pmem_host_span(pmem, va, len, access_flags,
+                                        &span_len);
+        if (!host_mem)
+            return false;
+        if (span_len > kIoChunkBytes)
+            span_len = kIoChunkBytes;
+        struct iovec ent;
+        ent.iov_base = host_mem;
+        ent.iov_len = span_len;
+        iov.push_back(ent);
+        va += span_len;
+        len -= span_len;
+    }
+    return true;
+}
+
+
+// Transfer all of "iov", stopping early at a short count as a single
+// readv/writev would; returns #bytes, or -1 (with errno) if nothing moved.
+i64
+host_iov_xfer(int host_fd, const HostIovVec& iov, bool is_write)
+{
+    if (iov.empty()) {
+        // Still make the call, for its error checking (e.g. EBADF)
+        ssize_t stat = (is_write) ? write(host_fd, NULL, 0) :
+            read(host_fd, NULL, 0);
+        return stat;
+    }
+    i64 total = 0;
+    size_t next = 0;
+    while (next < iov.size()) {
+        int batch = static_cast<int>(MIN_SCALAR(iov.size() - next,
+                                                (size_t) kIovBatch));
+        u64 batch_bytes = 0;
+        for (int i = 0; i < batch; i++)
+            batch_bytes += iov[next + i].iov_len;
+        ssize_t stat = (is_write) ? writev(host_fd, &iov[next], batch) :
+            readv(host_fd, &iov[next], batch);
+        if (stat < 0)
+            return (total > 0) ? total : -1;
+        total += stat;
+        if (static_cast<u64>(stat) < batch_bytes)
+            break;
+        next += batch;
+    }
+    return total;
+}
+
+
+// Read "len" bytes from host_fd to simulated [va, va+len), one host span
+// at a time (see above); returns #bytes, or -1 if nothing moved, with
+// *errno_ret set: EFAULT if "va" isn't writable, else the host's errno.
+i64
+host_read_spans(int host_fd, ProgMem *pmem, mem_addr va, u64 len,
+                int *errno_ret)
+{
+    i64 total = 0;
+    while (len > 0) {
+        u64 span_len;
+        void *host_mem = pmem_host_span(pmem, va, len, PMAF_W, &span_len);
+        if (!host_mem) {
+            if (total == 0)
+                *errno_ret = EFAULT;
+            break;
+        }
+        if (span_len > kIoChunkBytes)
+            span_len = kIoChunkBytes;
+        ssize_t stat = read(host_fd, host_mem, span_len);
+        if (stat < 0) {
+            if (total == 0)
+                *errno_ret = read_system_errno();
+            break;
+        }
+        total += stat;
+        if (static_cast<u64>(stat) < span_len)
+            break;
+        va += span_len;
+        len -= span_len;
+    }
+    if ((total == 0) && (*errno_ret != 0))
+        return -1;
+    return total;
+}
+
+
+// Read an Alpha iovec array; returns 0, or an errno value
+int
+read_alpha_iovecs(SimIovVec& ents, ProgMem *pmem, mem_addr iov_va,
+                  i64 iovcnt)
+{
+    if ((iovcnt < 0) || (iovcnt > kAlphaUioMaxIov))
+        return EINVAL;
+    if ((iovcnt > 0) &&
+        !pmem_access_ok(pmem, iov_va, iovcnt * kAlphaIovecBytes, PMAF_R))
+        return EFAULT;
+    for (i64 i = 0; i < iovcnt; i++) {
+        mem_addr ent_va = iov_va + i * kAlphaIovecBytes;
+        mem_addr base_va = pmem_read_64(pmem, ent_va, PMAF_R);
+        u32 len = pmem_read_32(pmem, ent_va + 8, PMAF_R);
+        ents.push_back(SimIovec(base_va, len));
+    }
+    return 0;
+}
+
+
+// Gather host spans for an Alpha iovec array; returns 0, or an errno value
+int
+gather_alpha_iovecs(HostIovVec& iov, ProgMem *pmem, mem_addr iov_va,
+                    i64 iovcnt, unsigned access_flags)
+{
+    SimIovVec ents;
+    int err = read_alpha_iovecs(ents, pmem, iov_va, iovcnt);
+    if (err != 0)
+        return err;
+    for (size_t i = 0; i < ents.size(); i++) {
+        if (!append_host_spans(iov, pmem, ents[i].base_va, ents[i].len,
+                               access_flags))
+            return EFAULT;
+    }
+    return 0;
+}
+
+
 // Extract static size/in/out info encoded in the ioctl request number
 void
 decode_alpha_ioctl(u64 alpha_request, u64 *command_ret,
@@ -315,58 +472,115 @@ SimulatedFD::sim_read(ProgMem *pmem, mem_addr dst_va, u64 nbytes)
     COVERAGE_FD("sim_read");
     sim_assert(this->is_open());
 
+    if (doing_dir_io())
+        dir_teardown();
+
+    errno_ = 0;
+    if (nbytes == 0) {
+        // Still make the call, for its error checking (e.g. EBADF)
+        ssize_t stat = read(host_fd_, NULL, 0);
+        if (stat < 0)
+            errno_ = read_system_errno();
+        return stat;
+    }
+    i64 result = host_read_spans(host_fd_, pmem, dst_va, nbytes, &errno_);
+    assert_ifthen(result < 0, errno_ != 0);
+    return result;
+}
+
+
+i64
+SimulatedFD::sim_readv(ProgMem *pmem, mem_addr iov_va, i64 iovcnt)
+{
+    COVERAGE_FD("sim_readv");
+    sim_assert(this->is_open());
+
+    if (doing_dir_io())
+        dir_teardown();
+
+    SimIovVec ents;
+    errno_ = read_alpha_iovecs(ents, pmem, iov_va, iovcnt);
+    if (errno_ != 0)
+        return -1;
+    // Entry by entry, as sim_read(), stopping at the first short count
+    i64 total = 0;
+    bool any_read = false;
+    for (size_t i = 0; i < ents.size(); i++) {
+        if (ents[i].len == 0)
+            continue;
+        any_read = true;
+        int ent_errno = 0;
+        i64 stat = host_read_spans(host_fd_, pmem, ents[i].base_va,
+                                   ents[i].len, &ent_errno);
+        if (stat < 0) {
+            if (total == 0) {
+                errno_ = ent_errno;
+                return -1;
+            }
+            break;
+        }
+        total += stat;
+        if (static_cast<u64>(stat) < ents[i].len)
+            break;
+    }
+    if (!any_read) {
+        // Still make the call, for its error checking (e.g. EBADF)
+        ssize_t stat = read(host_fd_, NULL, 0);
+        if (stat < 0)
+            errno_ = read_system_errno();
+        return stat;
+    }
+    return total;
+}
+
+
+i64
+SimulatedFD::sim_write(ProgMem *pmem, mem_addr src_va, u64 nbytes)
+{
+    COVERAGE_FD("sim_write");
+    sim_assert(this->is_open());
+
     if (doing_dir_io())
         dir_teardown();
 
     i64 result;
     errno_ = 0;
 
-    if (!pmem_access_ok(pmem, dst_va, nbytes, PMAF_W)) {
+    HostIovVec iov;
+    if (!append_host_spans(iov, pmem, src_va, nbytes, PMAF_R)) {
         errno_ = EFAULT;
         result = -1;
     } else {
-        vector<char> buffer;
-        buffer.resize(nbytes);     // zero-fills
-        ssize_t read_stat = read(host_fd_, &buffer[0], nbytes);
-        if (read_stat < 0) {
+        result = host_iov_xfer(host_fd_, iov, true);
+        if (result < 0) {
             errno_ = read_system_errno();
             sim_assert(errno_ != 0);
-        } else if (read_stat > 0) {
-            pmem_write_memcpy(pmem, dst_va, &buffer[0], read_stat, PMAF_W);
         }
-        result = read_stat;
     }
     return result;
 }
 
 
 i64
-SimulatedFD::sim_write(ProgMem *pmem, mem_addr src_va, u64 nbytes)
+SimulatedFD::sim_writev(ProgMem *pmem, mem_addr iov_va, i64 iovcnt)
 {
-    COVERAGE_FD("sim_write");
+    COVERAGE_FD("sim_writev");
     sim_assert(this->is_open());
 
     if (doing_dir_io())
         dir_teardown();
 
     i64 result;
-    errno_ = 0;
-
-    if (!pmem_access_ok(pmem, src_va, nbytes, PMAF_R)) {
-        errno_ = EFAULT;
+    HostIovVec iov;
+    errno_ = gather_alpha_iovecs(iov, pmem, iov_va, iovcnt, PMAF_R);
+    if (errno_ != 0) {
         result = -1;
     } else {
-        vector<char> buffer;
-        buffer.resize(nbytes);     // zero-fills
-        pmem_read_memcpy(pmem, &buffer[0], src_va, nbytes, PMAF_R);
-//        fprintf(stderr,"Output: %s\n",buffer[0]);
-        ssize_t write_stat = write(host_fd_, &buffer[0], nbytes);
-//        ssize_t write_stat = write(1, &buffer[0], nbytes);
-                if (write_stat < 0) {
+        result = host_iov_xfer(host_fd_, iov, true);
+        if (result < 0) {
             errno_ = read_system_errno();
             sim_assert(errno_ != 0);
         }
-        result = write_stat;
     }
     return result;
 }
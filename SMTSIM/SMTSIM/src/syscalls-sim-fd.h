@@ -114,6 +114,11 @@ public:
     // returns #bytes written to file, -1 on error
     i64 sim_write(ProgMem *pmem, mem_addr src_va, u64 nbytes);
 
+    // As above, scattering/gathering through an array of "iovcnt" Alpha
+    // "struct iovec"s at "iov_va"
+    i64 sim_readv(ProgMem *pmem, mem_addr iov_va, i64 iovcnt);
+    i64 sim_writev(ProgMem *pmem, mem_addr iov_va, i64 iovcnt);
+
     // returns offset, -1 on error
     i64 sim_lseek(i64 offset, i64 alpha_whence);
 
@@ -149,8 +154,6 @@ public:
     //   dup
     //   dup2
     //   old_fstat
-    //   readv
-    //   writev
     //   fchown
     //   fchmod
 };
@@ -130,6 +130,7 @@ namespace {
         "obreak",
         "open",
         "read",
+        "readv",
         "rename",
         "sbrk",
         "select",
@@ -149,6 +150,7 @@ namespace {
         "unlink",
         "uswitch",
         "write",
+        "writev",
         "out-of-range",
         "bad",
         "unimplemented-unix",
@@ -561,6 +563,14 @@ dosigreturn(AppState *as)
 }
 
 
+// Anonymous mmap() regions are sparse-backed under Global/Mem/SparseSegs/mmap
+static unsigned
+mmap_create_flags(void)
+{
+    return (GlobalParams.mem.sparse_mmap) ? PMCF_Sparse : PMCF_None;
+}
+
+
 int
 resize_seg(AppState *astate, mem_addr start_addr,
            i64 delta)
@@ -1998,6 +2008,36 @@ syscalls_dosyscall(struct AppState * as, i64 local_clock)
             }
             break;
         }
+        case a_SYS_writev: {
+            COVERAGE_SYSCALL("writev");
+            SimulatedFD *fd = sst->fd_lookup(arg0);
+            if (fd == NULL) {
+                syscall_retval = -1;
+                syscall_errno = EBADF;
+            } else {
+                syscall_retval = fd->sim_writev(as->pmem, arg1, arg2);
+                if (fd->error()) {
+                    syscall_retval = -1;
+                    syscall_errno = fd->host_errno();
+                }
+            }
+            break;
+        }
+        case a_SYS_readv: {
+            COVERAGE_SYSCALL("readv");
+            SimulatedFD *fd = sst->fd_lookup(arg0);
+            if (fd == NULL) {
+                syscall_retval = -1;
+                syscall_errno = EBADF;
+            } else {
+                syscall_retval = fd->sim_readv(as->pmem, arg1, arg2);
+                if (fd->error()) {
+                    syscall_retval = -1;
+                    syscall_errno = fd->host_errno();
+                }
+            }
+            break;
+        }
         case a_SYS_unlink: {
             COVERAGE_SYSCALL("unlink");
             ret = unlink((const char *) u64_to_ptr(arg0));
@@ -2273,7 +2313,8 @@ syscalls_dosyscall(struct AppState * as, i64 local_clock)
             LOG_MEM_USE(mmap_end, as->R[REG_A1].u);
             traceout("[mmap: start_addr: %s length: %s]",fmt_x64(mmap_end),fmt_i64(length));
 //            fprintf(stderr,"[mmap: start_addr: %s length: %s]\n",fmt_x64(mmap_end),fmt_i64(length));
-            if(pmem_map_new(as->pmem, length, mmap_end, PMAF_RW,PMCF_None))
+            if(pmem_map_new(as->pmem, length, mmap_end, PMAF_RW,
+                            mmap_create_flags()))
             {
               printf("Cannot create mmap\n");
               fprintf(stderr,"[Cannot create mmap]\n");
@@ -2313,7 +2354,8 @@ syscalls_dosyscall(struct AppState * as, i64 local_clock)
               pmem_unmap(as->pmem,start); //
               traceout("[mremap: start_addr: %s length: %s]",fmt_x64(mmap_end),fmt_i64(length));
               //fprintf(stderr,"[mremap: start_addr: %s length: %s]\n",fmt_x64(mmap_end),fmt_i64(length));
-              if(pmem_map_new(as->pmem, length, mmap_end, PMAF_RW,PMCF_None))
+              if(pmem_map_new(as->pmem, length, mmap_end, PMAF_RW,
+                              mmap_create_flags()))
               {
                 traceout("[Cannot create mmap]");
                 syscall_retval = u64_from_ptr(MAP_FAILED);
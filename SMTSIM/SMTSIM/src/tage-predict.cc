@@ -0,0 +1,1038 @@
+//
+// TAGE-SC-L conditional branch predictor
+//
+// $Id$
+//
+
+const char RCSid_1760000031[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "tage-predict.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stats-reg.h"
+
+
+using std::string;
+using std::vector;
+
+using SimCfg::conf_bool;
+using SimCfg::conf_int;
+
+
+namespace {
+
+// narrow counter/tag storage; sys-types.h has no i8/u16
+typedef signed char i8;
+typedef unsigned short u16;
+
+const int MaxTaggedTables = 16;
+const int SCTableCount = 4;             // bias + three global-history GEHL
+const int SCHistLens[SCTableCount] = { 0, 6, 12, 24 };
+const int SCCtrMax = 31, SCCtrMin = -32;
+const int SCThreshMin = 8, SCThreshMax = 120;
+const int LoopAssoc = 4;
+const int LoopIterMax = 0x3fff;
+const int LoopConfMax = 3;
+const int LoopAgeMax = 255, LoopAgeAlloc = 64;
+const int PathHistBits = 16;
+
+
+int
+read_ranged(const string& path, int min_val, int max_val)
+{
+    int val = conf_int(path);
+    if ((val < min_val) || (val > max_val)) {
+        exit_printf("bad %s (%d), should be in [%d,%d]\n", path.c_str(),
+                    val, min_val, max_val);
+    }
+    return val;
+}
+
+
+struct TageConfig {
+    bool shared_history;
+    int base_log_entries;
+    int n_tables;
+    int table_log_entries;
+    int tag_bits;
+    int min_hist, max_hist;
+    int u_reset_period_lg;
+    bool sc_enable;
+    int sc_log_entries;
+    bool loop_enable;
+    int loop_log_entries;
+    int inflight_slots;
+
+    NoDefaultCopy nocopy;
+
+public:
+    TageConfig(const string& cfg_path);
+    ~TageConfig() { }
+};
+
+
+TageConfig::TageConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    shared_history = conf_bool(cp + "shared_history");
+    base_log_entries = read_ranged(cp + "base_log_entries", 1, 24);
+    n_tables = read_ranged(cp + "n_tables", 1, MaxTaggedTables);
+    table_log_entries = read_ranged(cp + "table_log_entries", 1, 24);
+    tag_bits = read_ranged(cp + "tag_bits", 4, 15);
+    min_hist = read_ranged(cp + "min_hist", 1, 4096);
+    max_hist = read_ranged(cp + "max_hist", min_hist, 4096);
+    u_reset_period_lg = read_ranged(cp + "u_reset_period_lg", 4, 30);
+    sc_enable = conf_bool(cp + "sc_enable");
+    sc_log_entries = read_ranged(cp + "sc_log_entries", 1, 24);
+    loop_enable = conf_bool(cp + "loop_enable");
+    loop_log_entries = read_ranged(cp + "loop_log_entries",
+                                   log2_exact(LoopAssoc), 16);
+    inflight_slots = read_ranged(cp + "inflight_slots", 16, 1 << 20);
+    if (log2_exact(inflight_slots) < 0) {
+        exit_printf("%sinflight_slots (%d) not a power of 2\n", cp.c_str(),
+                    inflight_slots);
+    }
+}
+
+
+// Global history of "orig_len" bits, folded (XORed) down to "comp_len" bits,
+// maintained incrementally as bits are shifted in
+struct FoldedHist {
+    u32 comp;
+    int orig_len, comp_len, outpoint;
+
+    FoldedHist() : comp(0), orig_len(0), comp_len(1), outpoint(0) { }
+    void init(int orig_len_, int comp_len_) {
+        comp = 0;
+        orig_len = orig_len_;
+        comp_len = comp_len_;
+        outpoint = orig_len % comp_len;
+    }
+    void shift_in(int new_bit, int out_bit) {
+        comp = (comp << 1) | new_bit;
+        comp ^= static_cast<u32>(out_bit) << outpoint;
+        comp ^= comp >> comp_len;
+        comp &= (U32_LIT(1) << comp_len) - 1;
+    }
+    // From-scratch version, for rebuilding after a history rollback
+    void shift_in_fresh(int new_bit) {
+        comp = (comp << 1) | new_bit;
+        comp ^= comp >> comp_len;
+        comp &= (U32_LIT(1) << comp_len) - 1;
+    }
+};
+
+
+struct TaggedEntry {
+    i8 ctr;                     // 3-bit signed: [-4,3], >= 0 predicts taken
+    u8 u;                       // 2-bit useful counter
+    u16 tag;
+    TaggedEntry() : ctr(0), u(0), tag(0) { }
+};
+
+
+struct LoopEntry {
+    u16 tag;                    // 0: invalid
+    u16 past_iter;              // learned trip count (0: not yet known)
+    u16 commit_iter;            // current iteration, at commit
+    u16 spec_iter;              // current iteration, at fetch
+    u8 conf;
+    u8 age;
+    u8 dir;                     // direction taken while looping
+    LoopEntry() : tag(0), past_iter(0), commit_iter(0), spec_iter(0),
+                  conf(0), age(0), dir(0) { }
+};
+
+
+// Everything learned at lookup time that training needs
+struct BranchSlot {
+    i64 pos;                    // history position; -1: invalid
+    i64 phys;                   // index of its bit in HistState::bits, once
+                                // pushed (differs from "pos" only in a
+                                // shared history, after a squash)
+    int hist_id;                // pusher; selects a shared history's squash
+    u64 pc;
+    u32 idx[MaxTaggedTables];
+    u16 tag[MaxTaggedTables];
+    u32 base_idx;
+    u32 sc_idx[SCTableCount];
+    int sc_sum;
+    int loop_way;               // -1: loop predictor miss
+    i8 provider, alt;           // table numbers; -1: base table
+    u8 provider_pred, alt_pred, provider_new;
+    u8 tage_pred;               // TAGE proper (incl. use-alt-on-new)
+    u8 sc_pred, nonloop_pred;   // after SC; nonloop_pred is TAGE-SC
+    u8 loop_valid, loop_pred;
+    u8 final_pred;
+    u8 pushed;                  // outcome shifted into history
+    BranchSlot() : pos(-1), phys(-1), hist_id(-1), pc(0) { }
+};
+
+
+struct HistState {
+    vector<u8> bits;            // direction history, circular
+    vector<u8> path_bits;       // one PC bit per branch, for path history
+    i64 head;                   // next position to hand out
+    i64 phys_head;              // next index to write in bits/path_bits
+    vector<FoldedHist> idx_fold, tag_fold0, tag_fold1;
+    u64 recent;                 // last 64 direction bits, newest in bit 0
+    u32 path;                   // last PathHistBits path bits
+    bool dirty;                 // folds/loop state need rebuild after restore
+    i64 commit_pos;             // position of the last trained branch
+    vector<BranchSlot> slots;
+
+    NoDefaultCopy nocopy;
+
+    HistState(int buf_len, int n_slots)
+        : bits(buf_len, 0), path_bits(buf_len, 0), head(0), phys_head(0),
+          recent(0), path(0), dirty(false), commit_pos(-1),
+          slots(n_slots) { }
+
+    // (bits and path bits are indexed by BranchSlot::phys, not "pos")
+    int bit_at(i64 phys) const {
+        return (phys < 0) ? 0 : bits[phys & (intsize(bits) - 1)];
+    }
+    int path_bit_at(i64 phys) const {
+        return (phys < 0) ? 0 : path_bits[phys & (intsize(path_bits) - 1)];
+    }
+    BranchSlot& slot_at(i64 pos) {
+        return slots[pos & (intsize(slots) - 1)];
+    }
+};
+
+} // Anonymous namespace close
+
+
+struct TagePredict {
+private:
+    const string name_;
+    const TageConfig conf_;
+    int inst_bytes_lg_;
+
+    vector<u8> base_;           // 2-bit counters, >= 2 predicts taken
+    vector<vector<TaggedEntry> > tables_;
+    vector<int> hist_lens_;
+    int use_alt_on_new_;        // 4-bit signed: >= 0 trusts alt on new entries
+    i64 u_tick_;
+    u32 lfsr_;
+
+    vector<vector<i8> > sc_tables_;
+    int sc_thresh_;
+
+    vector<LoopEntry> loop_;
+    int loop_sets_lg_;
+    int loop_use_;              // 4-bit signed: >= 0 lets loop override
+
+    vector<HistState *> hists_;
+    TageStats stats_;
+
+    int hist_buf_len() const {
+        int len = 1;
+        while (len < (conf_.max_hist + conf_.inflight_slots + 64))
+            len *= 2;
+        return len;
+    }
+
+    HistState& hist(int hist_id) {
+        sim_assert(hist_id >= 0);
+        if (conf_.shared_history)
+            hist_id = 0;
+        if (hist_id >= intsize(hists_))
+            hists_.resize(hist_id + 1, NULL);
+        if (!hists_[hist_id])
+            hists_[hist_id] = new_hist();
+        return *hists_[hist_id];
+    }
+    const HistState *hist_if_present(int hist_id) const {
+        if (conf_.shared_history)
+            hist_id = 0;
+        return (hist_id < intsize(hists_)) ? hists_[hist_id] : NULL;
+    }
+
+    HistState *new_hist() const {
+        HistState *h = new HistState(hist_buf_len(), conf_.inflight_slots);
+        h->idx_fold.resize(conf_.n_tables);
+        h->tag_fold0.resize(conf_.n_tables);
+        h->tag_fold1.resize(conf_.n_tables);
+        for (int i = 0; i < conf_.n_tables; i++) {
+            h->idx_fold[i].init(hist_lens_[i], conf_.table_log_entries);
+            h->tag_fold0[i].init(hist_lens_[i], conf_.tag_bits);
+            h->tag_fold1[i].init(hist_lens_[i], conf_.tag_bits - 1);
+        }
+        return h;
+    }
+
+    u32 rand_bits() {
+        // 32-bit Galois LFSR; deterministic, for allocation tie-breaking
+        lfsr_ = (lfsr_ >> 1) ^ (-(lfsr_ & 1) & 0xd0000001u);
+        return lfsr_;
+    }
+
+    u64 pc_word(u64 pc) const { return pc >> inst_bytes_lg_; }
+
+    u32 fold_path(const HistState& h, int table) const {
+        int len = MIN_SCALAR(hist_lens_[table], PathHistBits);
+        u32 p = h.path & ((U32_LIT(1) << len) - 1);
+        int width = conf_.table_log_entries;
+        u32 result = 0;
+        for (int shift = table % width; p; p >>= width)
+            result ^= (p << shift) | (p >> (width - shift));
+        return result;
+    }
+
+    u32 sc_fold(const HistState& h, int len) const {
+        u64 hbits = (len >= 64) ? h.recent :
+            (h.recent & ((U64_LIT(1) << len) - 1));
+        u32 result = 0;
+        for (; hbits; hbits >>= conf_.sc_log_entries)
+            result ^= static_cast<u32>(hbits);
+        return result;
+    }
+
+    int loop_find(u64 pcw, u16 *tag_ret) const {
+        int set = static_cast<int>(pcw & ((1 << loop_sets_lg_) - 1));
+        u16 tag = static_cast<u16>(((pcw >> loop_sets_lg_) & 0x3fff) | 1);
+        if (tag_ret)
+            *tag_ret = tag;
+        for (int w = 0; w < LoopAssoc; w++) {
+            if (loop_[set * LoopAssoc + w].tag == tag)
+                return set * LoopAssoc + w;
+        }
+        return -1;
+    }
+
+    static void loop_spec_advance(LoopEntry& ent, int taken) {
+        if ((taken != 0) == (ent.dir != 0)) {
+            if (ent.spec_iter < LoopIterMax)
+                ent.spec_iter++;
+        } else {
+            ent.spec_iter = 0;
+        }
+    }
+
+    void rebuild(HistState& h);
+    void do_predict(HistState& h, u64 pc, BranchSlot& slot);
+    void do_push(HistState& h, int hist_id, u64 pc, int taken);
+    void squash(HistState& h, int hist_id, i64 pos);
+    void update_loop(const BranchSlot& slot, int taken);
+    void update_sc(const BranchSlot& slot, int taken);
+    void update_tage(const BranchSlot& slot, int taken);
+
+public:
+    TagePredict(const char *name__, const char *config_path__,
+                int inst_bytes__);
+    ~TagePredict();
+
+    void reset_stats() { memset(&stats_, 0, sizeof(stats_)); }
+
+    int predict(int hist_id, u64 pc) {
+        HistState& h = hist(hist_id);
+        if (h.dirty)
+            rebuild(h);
+        BranchSlot& slot = h.slot_at(h.head);
+        do_predict(h, pc, slot);
+        return slot.final_pred;
+    }
+    int lookup(int hist_id, u64 pc, int taken) {
+        int pred = predict(hist_id, pc);
+        if ((taken != 0) == (pred != 0))
+            stats_.hits++;
+        else
+            stats_.misses++;
+        return pred;
+    }
+
+    i64 hist_pos(int hist_id) const {
+        const HistState *h = hist_if_present(hist_id);
+        return (h) ? h->head : 0;
+    }
+
+    void push(int hist_id, u64 pc, int taken) {
+        do_push(hist(hist_id), hist_id, pc, taken);
+    }
+
+    void check_rollback(const HistState& h, i64 pos) const {
+        if ((h.head - pos) > intsize(h.slots)) {
+            abort_printf("TAGE %s: history rollback of %s branches exceeds"
+                         " inflight_slots (%d)\n", name_.c_str(),
+                         fmt_i64(h.head - pos), intsize(h.slots));
+        }
+    }
+
+    void restore(int hist_id, i64 pos) {
+        HistState& h = hist(hist_id);
+        sim_assert(pos <= h.head);
+        check_rollback(h, pos);
+        squash(h, hist_id, pos);
+        stats_.restores++;
+    }
+
+    void repair(int hist_id, i64 pos, u64 pc, int taken) {
+        HistState& h = hist(hist_id);
+        sim_assert(pos < h.head);
+        if (h.slot_at(pos).pos != pos) {
+            // Already squashed by an older restore; just push at the head
+            do_push(h, hist_id, pc, taken);
+            return;
+        }
+        check_rollback(h, pos);
+        BranchSlot& slot = h.slot_at(pos);
+        sim_assert(slot.pc == pc);
+        sim_assert(slot.hist_id == hist_id);
+        squash(h, hist_id, pos + 1);
+        // Correct the outcome in place; any younger branches of other
+        // threads keep their positions
+        slot.pushed = (taken != 0);
+        h.bits[slot.phys & (intsize(h.bits) - 1)] = slot.pushed;
+        h.dirty = true;
+        stats_.restores++;
+    }
+
+    void update(int hist_id, u64 pc, int taken, i64 pos);
+
+    const TageStats& get_stats() const { return stats_; }
+    void print_stats(FILE *out, const char *pf) const;
+};
+
+
+TagePredict::TagePredict(const char *name__, const char *config_path__,
+                         int inst_bytes__)
+    : name_(name__), conf_(config_path__),
+      use_alt_on_new_(0), u_tick_(0), lfsr_(0xace1u),
+      sc_thresh_(20), loop_sets_lg_(0), loop_use_(0)
+{
+    if ((inst_bytes_lg_ = log2_exact(inst_bytes__)) < 0) {
+        exit_printf("TAGE inst_bytes (%d) not a power of 2\n", inst_bytes__);
+    }
+
+    base_.assign(1 << conf_.base_log_entries, 2);       // weakly taken
+    tables_.resize(conf_.n_tables);
+    for (int i = 0; i < conf_.n_tables; i++)
+        tables_[i].resize(1 << conf_.table_log_entries);
+
+    // Geometric series from min_hist to max_hist
+    hist_lens_.resize(conf_.n_tables);
+    for (int i = 0; i < conf_.n_tables; i++) {
+        double ratio = (conf_.n_tables > 1) ?
+            (double) i / (conf_.n_tables - 1) : 0.0;
+        hist_lens_[i] = (int) (conf_.min_hist *
+                               pow((double) conf_.max_hist / conf_.min_hist,
+                                   ratio) + 0.5);
+        if ((i > 0) && (hist_lens_[i] <= hist_lens_[i - 1]))
+            hist_lens_[i] = hist_lens_[i - 1] + 1;
+    }
+
+    if (conf_.sc_enable) {
+        sc_tables_.resize(SCTableCount);
+        for (int i = 0; i < SCTableCount; i++)
+            sc_tables_[i].assign(1 << conf_.sc_log_entries, 0);
+    }
+    if (conf_.loop_enable) {
+        loop_.resize(1 << conf_.loop_log_entries);
+        loop_sets_lg_ = conf_.loop_log_entries - log2_exact(LoopAssoc);
+    }
+
+    reset_stats();
+}
+
+
+TagePredict::~TagePredict()
+{
+    for (int i = 0; i < intsize(hists_); i++)
+        delete hists_[i];
+}
+
+
+// Rebuild the folded histories (and the fetch-time loop iteration counts)
+// from the raw history, after the head has been moved back.
+void
+TagePredict::rebuild(HistState& h)
+{
+    for (int i = 0; i < conf_.n_tables; i++) {
+        FoldedHist& f_idx = h.idx_fold[i];
+        FoldedHist& f_t0 = h.tag_fold0[i];
+        FoldedHist& f_t1 = h.tag_fold1[i];
+        f_idx.comp = f_t0.comp = f_t1.comp = 0;
+        for (i64 phys = h.phys_head - hist_lens_[i]; phys < h.phys_head;
+             phys++) {
+            int b = h.bit_at(phys);
+            f_idx.shift_in_fresh(b);
+            f_t0.shift_in_fresh(b);
+            f_t1.shift_in_fresh(b);
+        }
+    }
+    h.recent = 0;
+    for (i64 phys = h.phys_head - 64; phys < h.phys_head; phys++)
+        h.recent = (h.recent << 1) | h.bit_at(phys);
+    h.path = 0;
+    for (i64 phys = h.phys_head - PathHistBits; phys < h.phys_head; phys++)
+        h.path = (h.path << 1) | h.path_bit_at(phys);
+
+    if (conf_.loop_enable) {
+        // Fetch-time iteration counts restart from the committed ones, then
+        // replay the surviving in-flight branches of this history.
+        for (int i = 0; i < intsize(loop_); i++)
+            loop_[i].spec_iter = loop_[i].commit_iter;
+        i64 start = MAX_SCALAR(h.commit_pos + 1,
+                               h.head - intsize(h.slots));
+        for (i64 pos = start; pos < h.head; pos++) {
+            const BranchSlot& slot = h.slot_at(pos);
+            if (slot.pos != pos)
+                continue;
+            int way = loop_find(pc_word(slot.pc), NULL);
+            if (way >= 0)
+                loop_spec_advance(loop_[way], slot.pushed);
+        }
+    }
+    h.dirty = false;
+}
+
+
+void
+TagePredict::do_predict(HistState& h, u64 pc, BranchSlot& slot)
+{
+    const u64 pcw = pc_word(pc);
+    const u32 idx_mask = (U32_LIT(1) << conf_.table_log_entries) - 1;
+    const u32 tag_mask = (U32_LIT(1) << conf_.tag_bits) - 1;
+
+    slot.pos = h.head;
+    slot.pc = pc;
+    slot.pushed = 0;
+    slot.base_idx = static_cast<u32>(pcw & (base_.size() - 1));
+
+    slot.provider = slot.alt = -1;
+    for (int i = 0; i < conf_.n_tables; i++) {
+        int pc_shift = abs(conf_.table_log_entries - i) + 1;
+        slot.idx[i] = static_cast<u32>(pcw ^ (pcw >> pc_shift) ^
+                                       h.idx_fold[i].comp ^
+                                       fold_path(h, i)) & idx_mask;
+        slot.tag[i] = static_cast<u16>((pcw ^ h.tag_fold0[i].comp ^
+                                        (h.tag_fold1[i].comp << 1)) &
+                                       tag_mask);
+    }
+    for (int i = conf_.n_tables - 1; i >= 0; i--) {
+        if (tables_[i][slot.idx[i]].tag == slot.tag[i]) {
+            if (slot.provider < 0) {
+                slot.provider = i;
+            } else {
+                slot.alt = i;
+                break;
+            }
+        }
+    }
+
+    const int base_pred = base_[slot.base_idx] >= 2;
+    slot.alt_pred = (slot.alt >= 0) ?
+        (tables_[slot.alt][slot.idx[slot.alt]].ctr >= 0) : base_pred;
+    bool high_conf;
+    if (slot.provider >= 0) {
+        const TaggedEntry& ent = tables_[slot.provider][slot.idx[slot.provider]];
+        slot.provider_pred = ent.ctr >= 0;
+        slot.provider_new = (ent.u == 0) &&
+            ((ent.ctr == 0) || (ent.ctr == -1));
+        slot.tage_pred = (slot.provider_new && (use_alt_on_new_ >= 0)) ?
+            slot.alt_pred : slot.provider_pred;
+        high_conf = (ent.ctr >= 2) || (ent.ctr <= -3);
+    } else {
+        slot.provider_pred = slot.alt_pred = base_pred;
+        slot.provider_new = 0;
+        slot.tage_pred = base_pred;
+        high_conf = (base_[slot.base_idx] == 0) || (base_[slot.base_idx] == 3);
+    }
+
+    // Statistical corrector: sums signed counters from a bias table (keyed
+    // by the TAGE prediction) and short-history tables; it overrides TAGE
+    // only when TAGE is unsure and the sum clears an adaptive threshold.
+    slot.sc_pred = slot.tage_pred;
+    slot.sc_sum = 0;
+    slot.nonloop_pred = slot.tage_pred;
+    if (conf_.sc_enable) {
+        const u32 sc_mask = (U32_LIT(1) << conf_.sc_log_entries) - 1;
+        for (int t = 0; t < SCTableCount; t++) {
+            u32 idx = (SCHistLens[t] == 0) ?
+                static_cast<u32>((pcw << 1) | slot.tage_pred) :
+                static_cast<u32>(pcw ^ (pcw >> (t + 2))) ^
+                    sc_fold(h, SCHistLens[t]);
+            slot.sc_idx[t] = idx & sc_mask;
+            slot.sc_sum += 2 * sc_tables_[t][slot.sc_idx[t]] + 1;
+        }
+        slot.sc_pred = slot.sc_sum >= 0;
+        if (!high_conf && (slot.sc_pred != slot.tage_pred) &&
+            (abs(slot.sc_sum) >= sc_thresh_))
+            slot.nonloop_pred = slot.sc_pred;
+    }
+
+    slot.loop_way = -1;
+    slot.loop_valid = 0;
+    slot.loop_pred = 0;
+    if (conf_.loop_enable) {
+        slot.loop_way = loop_find(pcw, NULL);
+        if (slot.loop_way >= 0) {
+            const LoopEntry& ent = loop_[slot.loop_way];
+            slot.loop_valid = (ent.conf == LoopConfMax) && (ent.past_iter > 0);
+            slot.loop_pred = (ent.spec_iter >= ent.past_iter) ?
+                !ent.dir : ent.dir;
+        }
+    }
+
+    slot.final_pred = (slot.loop_valid && (loop_use_ >= 0)) ?
+        slot.loop_pred : slot.nonloop_pred;
+}
+
+
+void
+TagePredict::do_push(HistState& h, int hist_id, u64 pc, int taken)
+{
+    if (h.dirty)
+        rebuild(h);
+    BranchSlot& slot = h.slot_at(h.head);
+    if ((slot.pos != h.head) || (slot.pc != pc))
+        do_predict(h, pc, slot);
+    taken = (taken != 0);
+    slot.pushed = taken;
+    slot.phys = h.phys_head;
+    slot.hist_id = hist_id;
+
+    if (conf_.loop_enable) {
+        int way = loop_find(pc_word(pc), NULL);
+        if (way >= 0)
+            loop_spec_advance(loop_[way], taken);
+    }
+
+    const int path_bit = static_cast<int>(pc_word(pc) & 1);
+    const int buf_mask = intsize(h.bits) - 1;
+    h.bits[h.phys_head & buf_mask] = taken;
+    h.path_bits[h.phys_head & buf_mask] = path_bit;
+    for (int i = 0; i < conf_.n_tables; i++) {
+        int out_bit = h.bit_at(h.phys_head - hist_lens_[i]);
+        h.idx_fold[i].shift_in(taken, out_bit);
+        h.tag_fold0[i].shift_in(taken, out_bit);
+        h.tag_fold1[i].shift_in(taken, out_bit);
+    }
+    h.recent = (h.recent << 1) | taken;
+    h.path = ((h.path << 1) | path_bit) & ((U32_LIT(1) << PathHistBits) - 1);
+    h.head++;
+    h.phys_head++;
+}
+
+
+// Discard the branches "hist_id" pushed at "pos" or later.  In a shared
+// history, other threads' younger branches survive: their bits slide down
+// over the gaps, keeping their order, while their positions (which callers
+// hold as checkpoints) stay put.  A shared history's head never retreats,
+// since another thread may hold a checkpoint at it: squashed positions are
+// just left unused, and count against inflight_slots until they age out.
+void
+TagePredict::squash(HistState& h, int hist_id, i64 pos)
+{
+    const int buf_mask = intsize(h.bits) - 1;
+    i64 dst = -1;               // next bits index to fill; -1: no gap yet
+    BranchSlot& pending = h.slot_at(h.head);    // looked up, not yet pushed
+    if (pending.pos == h.head)
+        pending.pos = -1;
+    for (i64 p = pos; p < h.head; p++) {
+        BranchSlot& slot = h.slot_at(p);
+        if (slot.pos != p)
+            continue;
+        if (slot.hist_id == hist_id) {
+            if (dst < 0)
+                dst = slot.phys;
+            slot.pos = -1;
+        } else {
+            sim_assert(conf_.shared_history);
+            if (dst >= 0) {
+                h.bits[dst & buf_mask] = h.bits[slot.phys & buf_mask];
+                h.path_bits[dst & buf_mask] =
+                    h.path_bits[slot.phys & buf_mask];
+                slot.phys = dst++;
+            }
+        }
+    }
+    if (dst >= 0)
+        h.phys_head = dst;
+    if (!conf_.shared_history)
+        h.head = pos;
+    h.dirty = true;
+}
+
+
+void
+TagePredict::update_loop(const BranchSlot& slot, int taken)
+{
+    u16 tag;
+    int way = loop_find(pc_word(slot.pc), &tag);
+
+    if (slot.loop_valid && (slot.loop_pred != slot.nonloop_pred)) {
+        stats_.loop_overrides += (loop_use_ >= 0);
+        if (slot.loop_pred == taken) {
+            stats_.loop_overrides_good += (loop_use_ >= 0);
+            if (loop_use_ < 7) loop_use_++;
+        } else {
+            if (loop_use_ > -8) loop_use_--;
+        }
+    }
+
+    if (way >= 0) {
+        LoopEntry& ent = loop_[way];
+        if (slot.loop_valid && (way == slot.loop_way)) {
+            if (slot.loop_pred != taken) {
+                // wrong with full confidence: forget it
+                ent = LoopEntry();
+                return;
+            }
+            if ((slot.loop_pred != slot.nonloop_pred) && (ent.age < LoopAgeMax))
+                ent.age++;
+        }
+        if (taken == ent.dir) {
+            ent.commit_iter++;
+            if (ent.commit_iter > LoopIterMax) {
+                ent = LoopEntry();              // not a loop we can track
+                return;
+            }
+            if (ent.past_iter && (ent.commit_iter > ent.past_iter)) {
+                ent.conf = 0;
+                ent.past_iter = 0;
+            }
+        } else if (ent.commit_iter == 0) {
+            // two "exits" in a row: the body direction was guessed wrong
+            ent.dir = taken;
+            ent.commit_iter = ent.spec_iter = 1;
+            ent.past_iter = 0;
+            ent.conf = 0;
+        } else {
+            if (ent.past_iter == 0) {
+                ent.past_iter = ent.commit_iter;
+                ent.conf = 0;
+            } else if (ent.commit_iter == ent.past_iter) {
+                if (ent.conf < LoopConfMax)
+                    ent.conf++;
+                if (ent.age < LoopAgeMax)
+                    ent.age++;
+            } else {
+                ent.past_iter = ent.commit_iter;
+                ent.conf = 0;
+                if (ent.age > 0)
+                    ent.age--;
+            }
+            ent.commit_iter = 0;
+        }
+    } else if (slot.nonloop_pred != taken) {
+        // Allocate on a TAGE-SC mispredict, guessing that the loop body goes
+        // the other way
+        int set = static_cast<int>(pc_word(slot.pc) &
+                                   ((1 << loop_sets_lg_) - 1));
+        int victim = -1;
+        for (int w = 0; w < LoopAssoc; w++) {
+            LoopEntry& cand = loop_[set * LoopAssoc + w];
+            if (cand.age == 0) {
+                victim = set * LoopAssoc + w;
+                break;
+            }
+        }
+        if (victim >= 0) {
+            LoopEntry& ent = loop_[victim];
+            ent = LoopEntry();
+            ent.tag = tag;
+            ent.dir = !taken;
+            ent.age = LoopAgeAlloc;
+        } else if ((rand_bits() & 3) == 0) {
+            // age slowly, so young loops get a chance to show their trip count
+            for (int w = 0; w < LoopAssoc; w++) {
+                LoopEntry& cand = loop_[set * LoopAssoc + w];
+                if (cand.age > 0)
+                    cand.age--;
+            }
+        }
+    }
+}
+
+
+void
+TagePredict::update_sc(const BranchSlot& slot, int taken)
+{
+    if (slot.nonloop_pred != slot.tage_pred) {
+        stats_.sc_overrides++;
+        if (slot.nonloop_pred == taken)
+            stats_.sc_overrides_good++;
+    }
+    if (slot.sc_pred != slot.tage_pred) {
+        // Would-be override: tune the threshold
+        if (slot.sc_pred == taken) {
+            if (sc_thresh_ > SCThreshMin) sc_thresh_--;
+        } else {
+            if (sc_thresh_ < SCThreshMax) sc_thresh_++;
+        }
+    }
+    if ((slot.sc_pred != taken) || (abs(slot.sc_sum) < sc_thresh_)) {
+        for (int t = 0; t < SCTableCount; t++) {
+            i8& ctr = sc_tables_[t][slot.sc_idx[t]];
+            if (taken) {
+                if (ctr < SCCtrMax) ctr++;
+            } else {
+                if (ctr > SCCtrMin) ctr--;
+            }
+        }
+    }
+}
+
+
+void
+TagePredict::update_tage(const BranchSlot& slot, int taken)
+{
+    const int provider = slot.provider;
+
+    // Entries may have been replaced since lookup; only train live ones
+    TaggedEntry *prov_ent = NULL;
+    if ((provider >= 0) &&
+        (tables_[provider][slot.idx[provider]].tag == slot.tag[provider]))
+        prov_ent = &tables_[provider][slot.idx[provider]];
+
+    if (provider >= 0)
+        stats_.provider_tagged++;
+    else
+        stats_.provider_base++;
+
+    // Allocate a longer-history entry on a TAGE mispredict
+    if ((slot.tage_pred != taken) && (provider < (conf_.n_tables - 1))) {
+        int first = provider + 1;
+        // skip ahead one table, half the time, to spread allocations
+        if ((first < (conf_.n_tables - 1)) && (rand_bits() & 1))
+            first++;
+        int chosen = -1;
+        for (int i = first; i < conf_.n_tables; i++) {
+            if (tables_[i][slot.idx[i]].u == 0) {
+                chosen = i;
+                break;
+            }
+        }
+        if (chosen >= 0) {
+            TaggedEntry& ent = tables_[chosen][slot.idx[chosen]];
+            ent.tag = slot.tag[chosen];
+            ent.ctr = (taken) ? 0 : -1;
+            ent.u = 0;
+            stats_.allocs++;
+        } else {
+            for (int i = provider + 1; i < conf_.n_tables; i++) {
+                TaggedEntry& ent = tables_[i][slot.idx[i]];
+                if (ent.u > 0)
+                    ent.u--;
+            }
+            stats_.alloc_fails++;
+        }
+    }
+
+    if (prov_ent) {
+        if (slot.provider_new && (slot.provider_pred != slot.alt_pred)) {
+            if (slot.alt_pred == taken) {
+                if (use_alt_on_new_ < 7) use_alt_on_new_++;
+            } else {
+                if (use_alt_on_new_ > -8) use_alt_on_new_--;
+            }
+        }
+        if (slot.provider_pred != slot.alt_pred) {
+            if (slot.provider_pred == taken) {
+                if (prov_ent->u < 3) prov_ent->u++;
+            } else {
+                if (prov_ent->u > 0) prov_ent->u--;
+            }
+        }
+        if (taken) {
+            if (prov_ent->ctr < 3) prov_ent->ctr++;
+        } else {
+            if (prov_ent->ctr > -4) prov_ent->ctr--;
+        }
+        // A new entry hasn't earned exclusive training yet
+        if (slot.provider_new) {
+            if (slot.alt >= 0) {
+                TaggedEntry& alt_ent = tables_[slot.alt][slot.idx[slot.alt]];
+                if (alt_ent.tag == slot.tag[slot.alt]) {
+                    if (taken) {
+                        if (alt_ent.ctr < 3) alt_ent.ctr++;
+                    } else {
+                        if (alt_ent.ctr > -4) alt_ent.ctr--;
+                    }
+                }
+            } else {
+                u8& ctr = base_[slot.base_idx];
+                if (taken) { if (ctr < 3) ctr++; } else { if (ctr > 0) ctr--; }
+            }
+        }
+    } else {
+        u8& ctr = base_[slot.base_idx];
+        if (taken) { if (ctr < 3) ctr++; } else { if (ctr > 0) ctr--; }
+    }
+
+    // Graceful aging of the useful bits
+    u_tick_++;
+    if ((u_tick_ & ((I64_LIT(1) << conf_.u_reset_period_lg) - 1)) == 0) {
+        for (int i = 0; i < conf_.n_tables; i++) {
+            vector<TaggedEntry>& table = tables_[i];
+            for (int e = 0; e < intsize(table); e++)
+                table[e].u >>= 1;
+        }
+    }
+}
+
+
+void
+TagePredict::update(int hist_id, u64 pc, int taken, i64 pos)
+{
+    HistState& h = hist(hist_id);
+    BranchSlot& slot = h.slot_at(pos);
+    taken = (taken != 0);
+    if ((slot.pos != pos) || (slot.pc != pc)) {
+        stats_.stale_updates++;
+        return;
+    }
+    stats_.updates++;
+    if (pos > h.commit_pos)
+        h.commit_pos = pos;
+
+    if (conf_.loop_enable)
+        update_loop(slot, taken);
+    if (conf_.sc_enable)
+        update_sc(slot, taken);
+    update_tage(slot, taken);
+}
+
+
+void
+TagePredict::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%sTAGE-SC-L: %d tagged tables, hist", pf, conf_.n_tables);
+    for (int i = 0; i < conf_.n_tables; i++)
+        fprintf(out, " %d", hist_lens_[i]);
+    fprintf(out, "%s\n", (conf_.shared_history) ? " (shared)" : "");
+    fprintf(out, "%sTAGE-SC-L: updates %s stale %s provider base %s"
+            " tagged %s allocs %s alloc_fails %s restores %s\n", pf,
+            fmt_i64(stats_.updates), fmt_i64(stats_.stale_updates),
+            fmt_i64(stats_.provider_base), fmt_i64(stats_.provider_tagged),
+            fmt_i64(stats_.allocs), fmt_i64(stats_.alloc_fails),
+            fmt_i64(stats_.restores));
+    if (conf_.sc_enable) {
+        fprintf(out, "%sTAGE-SC-L: SC overrides %s (good %s) thresh %d\n",
+                pf, fmt_i64(stats_.sc_overrides),
+                fmt_i64(stats_.sc_overrides_good), sc_thresh_);
+    }
+    if (conf_.loop_enable) {
+        fprintf(out, "%sTAGE-SC-L: loop overrides %s (good %s)\n", pf,
+                fmt_i64(stats_.loop_overrides),
+                fmt_i64(stats_.loop_overrides_good));
+    }
+}
+
+
+
+//
+// C interface
+//
+
+TagePredict *
+tage_create(const char *name, const char *config_path, int inst_bytes)
+{
+    return new TagePredict(name, config_path, inst_bytes);
+}
+
+void
+tage_destroy(TagePredict *tp)
+{
+    delete tp;
+}
+
+void
+tage_reset_stats(TagePredict *tp)
+{
+    tp->reset_stats();
+}
+
+int
+tage_lookup(TagePredict *tp, int hist_id, u64 pc, int taken)
+{
+    return tp->lookup(hist_id, pc, taken);
+}
+
+int
+tage_probe(TagePredict *tp, int hist_id, u64 pc)
+{
+    return tp->predict(hist_id, pc);
+}
+
+i64
+tage_hist_pos(const TagePredict *tp, int hist_id)
+{
+    return tp->hist_pos(hist_id);
+}
+
+void
+tage_hist_push(TagePredict *tp, int hist_id, u64 pc, int taken)
+{
+    tp->push(hist_id, pc, taken);
+}
+
+void
+tage_hist_restore(TagePredict *tp, int hist_id, i64 pos)
+{
+    tp->restore(hist_id, pos);
+}
+
+void
+tage_hist_repair(TagePredict *tp, int hist_id, i64 pos, u64 pc, int taken)
+{
+    tp->repair(hist_id, pos, pc, taken);
+}
+
+void
+tage_update(TagePredict *tp, int hist_id, u64 pc, int taken, i64 pos)
+{
+    tp->update(hist_id, pc, taken, pos);
+}
+
+void
+tage_get_stats(const TagePredict *tp, TageStats *dest)
+{
+    *dest = tp->get_stats();
+}
+
+static void
+tage_stats_provider(StatsEmitter *em, void *data)
+{
+    const TageStats& st = static_cast<const TagePredict *>(data)->get_stats();
+    statsemit_i64(em, "hits", st.hits);
+    statsemit_i64(em, "misses", st.misses);
+    statsemit_i64(em, "updates", st.updates);
+    statsemit_i64(em, "stale_updates", st.stale_updates);
+    statsemit_i64(em, "provider_base", st.provider_base);
+    statsemit_i64(em, "provider_tagged", st.provider_tagged);
+    statsemit_i64(em, "allocs", st.allocs);
+    statsemit_i64(em, "alloc_fails", st.alloc_fails);
+    statsemit_i64(em, "sc_overrides", st.sc_overrides);
+    statsemit_i64(em, "sc_overrides_good", st.sc_overrides_good);
+    statsemit_i64(em, "loop_overrides", st.loop_overrides);
+    statsemit_i64(em, "loop_overrides_good", st.loop_overrides_good);
+    statsemit_i64(em, "restores", st.restores);
+}
+
+void
+tage_register_stats(TagePredict *tp, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, tage_stats_provider, tp);
+}
+
+void
+tage_print_stats(const TagePredict *tp, void *c_FILE_out, const char *prefix)
+{
+    tp->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
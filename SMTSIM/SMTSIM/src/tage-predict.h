@@ -0,0 +1,102 @@
+// -*- C++ -*-
+//
+// TAGE-SC-L conditional branch predictor
+//
+// $Id$
+//
+
+#ifndef TAGE_PREDICT_H
+#define TAGE_PREDICT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A TAGE predictor (Seznec & Michaud, JILP 2006) -- a bimodal base table plus
+// tagged tables indexed with geometrically-increasing global history lengths
+// -- with a small statistical corrector and a loop predictor on top, after
+// Seznec's TAGE-SC-L (CBP-5, 2016).  This can replace the core's gshare PHT;
+// see the "TageSCL" block of the Core config.
+//
+// History is far longer than the per-context 32-bit GHR, so this keeps its
+// own speculative global (and path) history: each conditional branch pushes
+// its predicted outcome at fetch time, and mispredict recovery rolls the
+// history back to a checkpoint.  A checkpoint is just the history position
+// before the branch's push (tage_hist_pos()); callers keep it with the rest
+// of their undo info, next to the GHR copy.  Histories are kept per
+// "hist_id" (an SMT context's offset within its core), or optionally shared
+// by every context on the core.  In a shared history, recovery removes only
+// the recovering thread's younger bits; other threads' bits close up behind
+// them, and their checkpoints stay valid.
+//
+// Lookup details needed for training are saved in a ring of per-branch slots
+// (indexed by history position), so "inflight_slots" must exceed the number
+// of conditional branches in flight against any one history (for a shared
+// history, plus the positions squashed since the oldest of them).  Updates whose
+// slot has since been recycled are dropped and counted as "stale_updates".
+
+typedef struct TagePredict TagePredict;
+typedef struct TageStats TageStats;
+struct StatsReg;
+
+struct TageStats {
+    i64 hits;                   // fetch-time predictions (tage_lookup())
+    i64 misses;
+    i64 updates;                // commit-time training
+    i64 stale_updates;          // ...dropped, lookup info already recycled
+    i64 provider_base;          // updates whose provider was the base table
+    i64 provider_tagged;        // ...a tagged table
+    i64 allocs, alloc_fails;    // tagged entry allocation on mispredicts
+    i64 sc_overrides, sc_overrides_good;
+    i64 loop_overrides, loop_overrides_good;
+    i64 restores;               // history rollbacks
+};
+
+
+TagePredict *tage_create(const char *name, const char *config_path,
+                         int inst_bytes);
+void tage_destroy(TagePredict *tp);
+
+void tage_reset_stats(TagePredict *tp);
+
+// Predict the branch at "pc" with the current speculative history, recording
+// the lookup for the branch's later tage_update().  tage_lookup() also
+// counts a hit/miss against "taken"; tage_probe() is for wrong-path use.
+// Neither updates the history; see tage_hist_push().
+int tage_lookup(TagePredict *tp, int hist_id, u64 pc, int taken);
+int tage_probe(TagePredict *tp, int hist_id, u64 pc);
+
+// Checkpoint: the history position a branch is about to be pushed at
+i64 tage_hist_pos(const TagePredict *tp, int hist_id);
+
+// Shift a (predicted) outcome for "pc" into the speculative history.  If
+// there's no lookup recorded for this branch at this position -- e.g. it
+// was predicted by the trace cache instead -- one is made, silently.
+void tage_hist_push(TagePredict *tp, int hist_id, u64 pc, int taken);
+
+// Roll the history back to "pos", discarding the branch pushed there and
+// everything younger.
+void tage_hist_restore(TagePredict *tp, int hist_id, i64 pos);
+
+// Roll the history back to "pos", then re-push the branch at "pc" that was
+// pushed there, with a corrected outcome; its recorded lookup is kept for
+// training.
+void tage_hist_repair(TagePredict *tp, int hist_id, i64 pos, u64 pc,
+                      int taken);
+
+// Train with the actual outcome of the branch pushed at "pos", at commit
+void tage_update(TagePredict *tp, int hist_id, u64 pc, int taken, i64 pos);
+
+void tage_get_stats(const TagePredict *tp, TageStats *dest);
+// Register a provider for TageStats at "path" (stats-reg.h)
+void tage_register_stats(TagePredict *tp, struct StatsReg *sr,
+                         const char *path);
+void tage_print_stats(const TagePredict *tp, void *c_FILE_out,
+                      const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TAGE_PREDICT_H
@@ -18,6 +18,7 @@ const char RCSid_1035344092[] =
 #include "assoc-array.h"
 #include "utils.h"
 #include "cache-params.h"
+#include "stats-reg.h"
 
 
 struct TLBArray {
@@ -192,6 +193,22 @@ tlb_get_stats(const TLBArray *tlb, TLBStats *dest)
 }
 
 
+static void
+tlb_stats_provider(StatsEmitter *em, void *data)
+{
+    const TLBArray *tlb = (const TLBArray *) data;
+    statsemit_i64(em, "hits", tlb->stats.hits);
+    statsemit_i64(em, "misses", tlb->stats.misses);
+}
+
+
+void
+tlb_register_stats(TLBArray *tlb, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, tlb_stats_provider, tlb);
+}
+
+
 u64
 tlb_calc_baseaddr(const TLBArray *tlb, u64 addr)
 {
@@ -15,6 +15,7 @@ extern "C" {
 
 typedef struct TLBArray TLBArray;
 typedef struct TLBStats TLBStats;
+struct StatsReg;
 
 
 struct TLBStats {
@@ -35,6 +36,9 @@ int tlb_probe(const TLBArray *tlb, u64 addr, int thread_id);
 void tlb_inject(TLBArray *tlb, i64 ready_time, u64 addr, int thread_id);
 
 void tlb_get_stats(const TLBArray *tlb, TLBStats *dest);
+/* Register a provider for this TLB's TLBStats at "path" (stats-reg.h) */
+void tlb_register_stats(TLBArray *tlb, struct StatsReg *sr,
+                        const char *path);
 
 u64 tlb_calc_baseaddr(const TLBArray *tlb, u64 addr);
 
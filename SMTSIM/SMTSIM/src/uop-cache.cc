@@ -0,0 +1,316 @@
+//
+// Decoded micro-op cache
+//
+// $Id$
+//
+
+const char RCSid_1760000038[] =
+"$Id$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "uop-cache.h"
+#include "core-resources.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stats-reg.h"
+
+
+using std::string;
+using std::vector;
+
+using SimCfg::conf_int;
+
+
+namespace {
+
+// Line slot masks are u64, one bit per 4-byte inst
+const int MaxBlockInsts = 64;
+
+
+struct UopCacheConfig {
+    int n_sets;
+    int assoc;
+    int uops_per_line;
+    int block_bytes;
+    int block_insts;            // block_bytes / 4
+    int block_bits;             // log2(block_bytes)
+
+    NoDefaultCopy nocopy;
+
+public:
+    UopCacheConfig(const string& cfg_path);
+    ~UopCacheConfig() { }
+};
+
+
+UopCacheConfig::UopCacheConfig(const string& cfg_path)
+{
+    string cp = cfg_path + "/";          // short-hand for config-path
+
+    n_sets = conf_int(cp + "n_sets");
+    if (n_sets < 1) {
+        exit_printf("bad %sn_sets (%d)\n", cp.c_str(), n_sets);
+    }
+    assoc = conf_int(cp + "assoc");
+    if (assoc < 1) {
+        exit_printf("bad %sassoc (%d)\n", cp.c_str(), assoc);
+    }
+    uops_per_line = conf_int(cp + "uops_per_line");
+    if (uops_per_line < 1) {
+        exit_printf("bad %suops_per_line (%d)\n", cp.c_str(),
+                    uops_per_line);
+    }
+    block_bytes = conf_int(cp + "block_bytes");
+    block_bits = log2_exact(block_bytes);
+    if ((block_bits < 2) || ((block_bytes / 4) > MaxBlockInsts)) {
+        exit_printf("bad %sblock_bytes (%d)\n", cp.c_str(), block_bytes);
+    }
+    block_insts = block_bytes / 4;
+}
+
+
+struct UopLine {
+    bool valid;
+    int master_id;
+    mem_addr block;             // pc >> block_bits
+    u64 slots;                  // bit N: inst N of the block is held
+    int n_uops;
+    i64 last_use;
+
+    UopLine() : valid(false), master_id(-1), block(0), slots(0), n_uops(0),
+                last_use(0) { }
+};
+
+} // Anonymous namespace close
+
+
+struct UopCache {
+private:
+    string name_;
+    UopCacheConfig conf_;
+    CoreResources *core_;
+    vector<UopLine> lines_;     // n_sets * assoc, set-major
+    i64 use_stamp_;
+    UopCacheStats stats_;
+
+    mem_addr block_of(mem_addr pc) const { return pc >> conf_.block_bits; }
+    int slot_of(mem_addr pc) const {
+        return static_cast<int>((pc >> 2) & (conf_.block_insts - 1));
+    }
+    int set_of(int master_id, mem_addr block) const {
+        u64 h = static_cast<u64>(block) ^
+            (static_cast<u64>(master_id) * 0x9e3779b1U);
+        return static_cast<int>(h % static_cast<u64>(conf_.n_sets));
+    }
+    UopLine *find(int master_id, mem_addr block);
+    const UopLine *find(int master_id, mem_addr block) const {
+        return const_cast<UopCache *>(this)->find(master_id, block);
+    }
+
+public:
+    UopCache(const char *name__, const char *config_path__,
+             CoreResources *core__);
+    ~UopCache() { }
+
+    bool lookup(int master_id, mem_addr pc);
+    bool covers(int master_id, mem_addr line_pc, mem_addr pc) const;
+    void delivered() { stats_.delivered++; }
+    void fill(int master_id, mem_addr pc);
+
+    void reset_stats() { memset(&stats_, 0, sizeof(stats_)); }
+    const UopCacheStats& get_stats() const { return stats_; }
+    void print_stats(FILE *out, const char *pf) const;
+};
+
+
+UopCache::UopCache(const char *name__, const char *config_path__,
+                   CoreResources *core__)
+    : name_(name__), conf_(config_path__), core_(core__),
+      lines_(conf_.n_sets * conf_.assoc), use_stamp_(0)
+{
+    reset_stats();
+}
+
+
+UopLine *
+UopCache::find(int master_id, mem_addr block)
+{
+    UopLine *set = &lines_[set_of(master_id, block) * conf_.assoc];
+    for (int way = 0; way < conf_.assoc; way++) {
+        UopLine *line = &set[way];
+        if (line->valid && (line->block == block) &&
+            (line->master_id == master_id))
+            return line;
+    }
+    return NULL;
+}
+
+
+bool
+UopCache::lookup(int master_id, mem_addr pc)
+{
+    UopLine *line = find(master_id, block_of(pc));
+    bool hit = line && ((line->slots >> slot_of(pc)) & 1);
+    stats_.lookups++;
+    if (hit) {
+        line->last_use = ++use_stamp_;
+        stats_.hits++;
+    }
+    return hit;
+}
+
+
+bool
+UopCache::covers(int master_id, mem_addr line_pc, mem_addr pc) const
+{
+    mem_addr block = block_of(pc);
+    if (block != block_of(line_pc))
+        return false;
+    const UopLine *line = find(master_id, block);
+    return line && ((line->slots >> slot_of(pc)) & 1);
+}
+
+
+void
+UopCache::fill(int master_id, mem_addr pc)
+{
+    mem_addr block = block_of(pc);
+    u64 slot_bit = U64_LIT(1) << slot_of(pc);
+    UopLine *line = find(master_id, block);
+
+    if (!line) {
+        UopLine *set = &lines_[set_of(master_id, block) * conf_.assoc];
+        line = &set[0];
+        for (int way = 0; way < conf_.assoc; way++) {
+            if (!set[way].valid) {
+                line = &set[way];
+                break;
+            }
+            if (set[way].last_use < line->last_use)
+                line = &set[way];
+        }
+        if (line->valid)
+            stats_.evictions++;
+        line->valid = true;
+        line->master_id = master_id;
+        line->block = block;
+        line->slots = 0;
+        line->n_uops = 0;
+    }
+    line->last_use = ++use_stamp_;
+
+    if (line->slots & slot_bit)
+        return;
+    if (line->n_uops >= conf_.uops_per_line) {
+        stats_.fill_overflows++;
+        return;
+    }
+    line->slots |= slot_bit;
+    line->n_uops++;
+    stats_.fills++;
+}
+
+
+void
+UopCache::print_stats(FILE *out, const char *pf) const
+{
+    fprintf(out, "%sUopCache: lookups %s hits %s (%.2f%%) delivered %s"
+            " (%.2f/hit)\n", pf,
+            fmt_i64(stats_.lookups), fmt_i64(stats_.hits),
+            (stats_.lookups) ?
+            (100.0 * stats_.hits / stats_.lookups) : 0.0,
+            fmt_i64(stats_.delivered),
+            (stats_.hits) ? ((double) stats_.delivered / stats_.hits) : 0.0);
+    fprintf(out, "%sUopCache: fills %s overflows %s evictions %s\n", pf,
+            fmt_i64(stats_.fills), fmt_i64(stats_.fill_overflows),
+            fmt_i64(stats_.evictions));
+}
+
+
+
+//
+// C interface
+//
+
+UopCache *
+uopc_create(const char *name, const char *config_path,
+            struct CoreResources *core)
+{
+    return new UopCache(name, config_path, core);
+}
+
+void
+uopc_destroy(UopCache *uc)
+{
+    delete uc;
+}
+
+int
+uopc_lookup(UopCache *uc, int master_id, mem_addr pc)
+{
+    return uc->lookup(master_id, pc);
+}
+
+int
+uopc_covers(const UopCache *uc, int master_id, mem_addr line_pc,
+            mem_addr pc)
+{
+    return uc->covers(master_id, line_pc, pc);
+}
+
+void
+uopc_delivered(UopCache *uc)
+{
+    uc->delivered();
+}
+
+void
+uopc_fill(UopCache *uc, int master_id, mem_addr pc)
+{
+    uc->fill(master_id, pc);
+}
+
+void
+uopc_reset_stats(UopCache *uc)
+{
+    uc->reset_stats();
+}
+
+void
+uopc_get_stats(const UopCache *uc, UopCacheStats *dest)
+{
+    *dest = uc->get_stats();
+}
+
+static void
+uopc_stats_provider(StatsEmitter *em, void *data)
+{
+    const UopCacheStats& st = static_cast<const UopCache *>(data)->get_stats();
+    statsemit_i64(em, "lookups", st.lookups);
+    statsemit_i64(em, "hits", st.hits);
+    statsemit_i64(em, "delivered", st.delivered);
+    statsemit_i64(em, "fills", st.fills);
+    statsemit_i64(em, "fill_overflows", st.fill_overflows);
+    statsemit_i64(em, "evictions", st.evictions);
+}
+
+void
+uopc_register_stats(UopCache *uc, StatsReg *sr, const char *path)
+{
+    statsreg_add_provider(sr, path, uopc_stats_provider, uc);
+}
+
+void
+uopc_print_stats(const UopCache *uc, void *c_FILE_out, const char *prefix)
+{
+    uc->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
@@ -0,0 +1,75 @@
+// -*- C++ -*-
+//
+// Decoded micro-op cache
+//
+// $Id$
+//
+
+#ifndef UOP_CACHE_H
+#define UOP_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each core may have one of these, enabled by its "UopCache" config block.
+//
+// Instructions leaving the last decode stage are filled into a line for
+// their aligned "block_bytes" fetch block, up to "uops_per_line" per line;
+// lines are tagged by address space, and replaced LRU within a set.
+//
+// At fetch, a thread whose next PC hits (when nothing is waiting in the
+// fetch or decode latches) skips the I-cache access, and the instructions
+// supplied by the line go straight to rename1, bypassing the decode stages
+// ("Decode/n_stages").  Delivery stops at the first instruction the line
+// doesn't hold, or at the end of the block; fetch resumes from the I-cache
+// on the next cycle.
+
+struct CoreResources;
+
+typedef struct UopCache UopCache;
+typedef struct UopCacheStats UopCacheStats;
+struct StatsReg;
+
+struct UopCacheStats {
+    i64 lookups;
+    i64 hits;
+    i64 delivered;              // insts supplied to rename1 from hits
+    i64 fills;                  // decoded insts newly added to a line
+    i64 fill_overflows;         // ...not added: line already full
+    i64 evictions;              // valid lines replaced
+};
+
+
+UopCache *uopc_create(const char *name, const char *config_path,
+                      struct CoreResources *core);
+void uopc_destroy(UopCache *uc);
+
+// Probe for the inst at "pc" at the start of a fetch; updates LRU and stats
+int uopc_lookup(UopCache *uc, int master_id, mem_addr pc);
+
+// During delivery from the line which hit for "line_pc": does it hold the
+// inst at "pc"?  (No state change.)
+int uopc_covers(const UopCache *uc, int master_id, mem_addr line_pc,
+                mem_addr pc);
+
+// An inst was sent from the uop cache to rename1
+void uopc_delivered(UopCache *uc);
+
+// The inst at "pc" is leaving decode
+void uopc_fill(UopCache *uc, int master_id, mem_addr pc);
+
+void uopc_reset_stats(UopCache *uc);
+void uopc_get_stats(const UopCache *uc, UopCacheStats *dest);
+// Register a provider for UopCacheStats at "path" (stats-reg.h)
+void uopc_register_stats(UopCache *uc, struct StatsReg *sr,
+                         const char *path);
+void uopc_print_stats(const UopCache *uc, void *c_FILE_out,
+                      const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UOP_CACHE_H
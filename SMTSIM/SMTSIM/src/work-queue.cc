@@ -38,6 +38,7 @@ const char RCSid_1187823723[] =
 #include "jtimer.h"
 #include "app-stats-log.h"
 #include "bbtracker.h"
+#include "inst-trace.h"
 
 using std::string;
 using std::list;
@@ -79,7 +80,11 @@ fast_forward_single(AppState *as, i64 ff_dist)
 
     sim_timer_was_running = jtimer_startstop(SimTimer, 0);
     jtimer_startstop(ff_timer, 1);
-    fast_forward_app(as, ff_dist);
+    if (as->itrace_in) {
+        itrace_reader_skip(as->itrace_in, as, ff_dist);
+    } else {
+        fast_forward_app(as, ff_dist);
+    }
     jtimer_startstop(ff_timer, 0);
     jtimer_startstop(SimTimer, sim_timer_was_running);
 
@@ -266,6 +271,7 @@ class JobInstance {
 
     class AppStatsCB;
     void init_appstats_log(int app_index);
+    void init_itrace_capture(int app_index);
 
     NoDefaultCopy nocopy;
 
@@ -339,11 +345,27 @@ JobInstance::JobInstance(i64 job_id_, const string& workload_path_,
         exit_printf("%s: invalid n_threads (%d)\n", fname, n_threads);
     }
 
+    string replay_trace;
+    {
+        string key(workload_path + "/replay_trace");
+        if (simcfg_have_val(key.c_str()))
+            replay_trace = simcfg_get_str(key.c_str());
+    }
+    if (!replay_trace.empty() && (n_threads != 1)) {
+        exit_printf("%s: replay_trace needs n_threads = 1\n", fname);
+    }
+
     // Create the AppStates needed to start this job
     for (int i = 0; i < n_threads; i++) {
         if (i == 0) {
             AppState *as = NULL;
-            if (!(as = appstate_new_fromfile(app_params, GlobalAlloc))) {
+            if (!replay_trace.empty()) {
+                as = appstate_new_fromtrace(app_params, GlobalAlloc,
+                                            replay_trace.c_str());
+            } else {
+                as = appstate_new_fromfile(app_params, GlobalAlloc);
+            }
+            if (!as) {
                 exit_printf("%s: AppState creation failed, app thread %d\n",
                             fname, i);
             }
@@ -362,6 +384,7 @@ JobInstance::JobInstance(i64 job_id_, const string& workload_path_,
                         "sorry\n");
         }
         init_appstats_log(i);
+        init_itrace_capture(i);
     }
 
     string ff_key = workload_path + "/ff_dist";
@@ -517,6 +540,23 @@ JobInstance::init_appstats_log(int app_index)
 }
 
 
+// Like AppStatsLog, trace capture is a global setting
+void
+JobInstance::init_itrace_capture(int app_index)
+{
+    AppState *as = apps.at(app_index);
+    if (!simcfg_get_bool("InstTrace/capture"))
+        return;
+    string file_name = string(simcfg_get_str("InstTrace/base_name")) +
+        ".A" + fmt_i64(as->app_id);
+    if (simcfg_get_bool("InstTrace/compress"))
+        file_name += ".gz";
+    sim_assert(!as->extra->itrace_out);
+    as->extra->itrace_out = itrace_writer_create(file_name.c_str(),
+                                                 &as->extra->itrace_stats);
+}
+
+
 void
 JobInstance::start()
 {
@@ -612,6 +652,10 @@ JobInstance::vacate_apps()
             appstatslog_destroy(ase->stats_log);
             ase->stats_log = NULL;
         }
+        if (ase->itrace_out) {
+            itrace_writer_destroy(ase->itrace_out);
+            ase->itrace_out = NULL;
+        }
     }
 }
 
@@ -631,6 +675,8 @@ JobInstance::final_stats()
             sim_assert(ase->stats_log);
             appstatslog_flush(ase->stats_log);
         }
+        if (ase->itrace_out)
+            itrace_writer_flush(ase->itrace_out);
     }
 }
 
@@ -1017,6 +1063,11 @@ void
 WorkQueue::app_sysexit(AppState *as)
 {
     i64 job_id = (as->extra) ? as->extra->job_id : -1;
+    if (as->extra && as->extra->itrace_out) {
+        // (as->npc is still at the exit syscall)
+        itrace_writer_exit(as->extra->itrace_out, as, as->npc,
+                           as->exit.exit_code);
+    }
     if (exit_on_app_exit) {
         printf("app_sysexit: A%d job_id %s syscall exit(%s) at "
                "inst %s time %s\n",
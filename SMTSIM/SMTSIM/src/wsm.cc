@@ -46,7 +46,6 @@ const char RCSid_1210808870[] =
 #include "gzstream.h"
 #include "mem-ref-seq.h"
 #include "tlb-array.h"
-#include "prefetch-audit.h"
 #include "mshr.h"
 #include "prog-mem.h"
 
@@ -65,6 +64,9 @@ using std::vector;
 using namespace SimCfg;
 
 
+WSM_Coord *GlobalWSMCoord = NULL;
+
+
 // Plan for WSM_DEBUG_LEVEL:
 // 0: off
 // 1: top-level per-RegularMove epoch stuff, block counts at summarize, etc.
@@ -831,6 +833,7 @@ struct TableKey_Int {
     // WARNING: default copy/assignment in use
     TableKey_Int() { }
     explicit TableKey_Int(int id__) : id(id__) { }
+    void clear() { id = 0; }
     bool operator < (const TableKey_Int& o2) const { return (id < o2.id); }
     bool operator == (const TableKey_Int& o2) const { return (id == o2.id); }
     size_t stl_hash() const {
@@ -883,7 +886,8 @@ private:
         KeyType key;
         EntType ent;            // (object lives for life of TableCAM)
         EntryIdxList::iterator lru_iter;        // (only valid w/LRU)
-        EntryBundle(const WSM_Config *conf__) : ent(conf__) { }
+        EntryBundle(const WSM_Config *conf__)
+            : valid(false), ent(conf__) { key.clear(); }
     };
     typedef vector<EntryBundle> EntryVec;
 
@@ -2028,7 +2032,8 @@ struct NextBlockEnt : public EntryBase {
         mem_addr next_addr;
     } predict;
 
-    NextBlockEnt(const WSM_Config *conf__) : EntryBase(conf__) { }
+    NextBlockEnt(const WSM_Config *conf__)
+        : EntryBase(conf__), predict() { }
 
     void block_align(mem_addr *addr) const { (*addr) &= ~(block_bytes - 1); }
 
@@ -2323,7 +2328,8 @@ struct SameObjEnt : public EntryBase {
         int next_offset;
     } predict;
 
-    SameObjEnt(const WSM_Config *conf__) : EntryBase(conf__) { }
+    SameObjEnt(const WSM_Config *conf__)
+        : EntryBase(conf__), predict() { }
 
     string fmt() const {
         ostringstream out;
@@ -2446,7 +2452,8 @@ struct PointerEnt : public EntryBase {
         int step_num;           // 0: next is ptr val, 1: next is src, 2: done
     } predict;
 
-    PointerEnt(const WSM_Config *conf__) : EntryBase(conf__) { }
+    PointerEnt(const WSM_Config *conf__)
+        : EntryBase(conf__), predict() { }
 
     string fmt() const {
         ostringstream out;
@@ -2560,7 +2567,8 @@ struct PointerChaseEnt : public EntryBase {
         ProgMem *parent_pmem;   // or NULL
     } predict;
 
-    PointerChaseEnt(const WSM_Config *conf__) : EntryBase(conf__) { }
+    PointerChaseEnt(const WSM_Config *conf__)
+        : EntryBase(conf__), predict() { }
 
     string fmt() const {
         ostringstream out;
@@ -2702,7 +2710,8 @@ struct BTBEnt : public EntryBase {
         int step_num;           // 0: next is target, 1: next is src, 2: done
     } predict;
 
-    BTBEnt(const WSM_Config *conf__) : EntryBase(conf__) { }
+    BTBEnt(const WSM_Config *conf__)
+        : EntryBase(conf__), predict() { }
 
     string fmt() const {
         ostringstream out;
@@ -2800,7 +2809,7 @@ struct BlockBTBEnt : public EntryBase {
     } predict;
 
     BlockBTBEnt(const WSM_Config *conf__)
-        : EntryBase(conf__), block_bytes(0) { }
+        : EntryBase(conf__), block_bytes(0), predict() { }
 
     mem_addr btb_block_align(mem_addr a) const {
         sim_assert(block_bytes > 0);
@@ -2911,7 +2920,8 @@ struct PCWindowEnt : public EntryBase {
         int num_blocks; // #blocks predicted so far
     } predict;
 
-    PCWindowEnt(const WSM_Config *conf__) : EntryBase(conf__) { }
+    PCWindowEnt(const WSM_Config *conf__)
+        : EntryBase(conf__), master_id(0), predict() { }
 
     string fmt() const {
         ostringstream out;
@@ -3035,7 +3045,8 @@ struct SPWindowEnt : public EntryBase {
         int num_blocks; // #blocks predicted so far
     } predict;
 
-    SPWindowEnt(const WSM_Config *conf__) : EntryBase(conf__) { }
+    SPWindowEnt(const WSM_Config *conf__)
+        : EntryBase(conf__), master_id(0), predict() { }
 
     string fmt() const {
         ostringstream out;
@@ -3152,7 +3163,8 @@ struct RetStackEnt : public EntryBase {
     } predict;
 
     RetStackEnt(const WSM_Config *conf__)
-        : EntryBase(conf__), parent_as(NULL), max_stack_size(0) { }
+        : EntryBase(conf__), parent_as(NULL), max_stack_size(0),
+          master_id(0), predict() { }
 
     string fmt() const {
         ostringstream out;
@@ -3313,7 +3325,8 @@ struct MRUEnt : public EntryBase {
     } predict;
 
     MRUEnt(const WSM_Config *conf__)
-        : EntryBase(conf__), window_size_bytes(0), max_mru_windows(0) { }
+        : EntryBase(conf__), window_size_bytes(0), max_mru_windows(0),
+          master_id(0), predict() { }
     
     mem_addr mru_window_align(mem_addr a) const {
         sim_assert(window_size_bytes > 0);
@@ -3688,9 +3701,7 @@ public:
                 pfq_->pop_front(cyc);
             } else if (cachesim_prefetch_for_wsm(core_, next_pf.base_addr(),
                                                  next_pf.excl_access(),
-                                                 pf_csource,
-                                                 next_pf.table_id(),
-                                                 next_pf.entry_id())) {
+                                                 pf_csource)) {
                 // prefetch accepted by mem subsystem
                 filter_mark_prefetched(next_pf.base_addr());
                 // warning: invalidates "next_pf"
@@ -4508,7 +4519,9 @@ public:
                      fmt_now(), xfer_time.latency,
                      xfer_time.interval, fmt_i64(start_time));
             i64 xfer_done_time =
-                corebus_access(to_core->reply_bus, xfer_time);
+                corebus_access_cores(to_core->reply_bus,
+                                     parent_->get_source_core()->core_id,
+                                     to_core->core_id, xfer_time);
             start_time = MAX_SCALAR(start_time, xfer_done_time);
             WSMDB(1)(" -> %s\n", fmt_i64(start_time));
         }
@@ -4611,7 +4624,10 @@ public:
             long xfer_bits = pfse_estimate_size_bits(sb_exported_);
             OpTime xfer_time;
             estimate_bus_xfer_time(&xfer_time, xfer_bits);
-            i64 bus_done_time = corebus_access(to_core->reply_bus, xfer_time);
+            i64 bus_done_time =
+                corebus_access_cores(to_core->reply_bus,
+                                     parent_->get_source_core()->core_id,
+                                     to_core->core_id, xfer_time);
             WSMDB(1)("%s: time %s, streambuf ->C%d xfer est %ld bits,"
                      " op-time {%d,%d}; resched at bus_done_time %s\n",
                      fname, fmt_now(),
@@ -4728,7 +4744,9 @@ public:
                      fmt_now(), xfer_time.latency, xfer_time.interval,
                      fmt_i64(xfer_done_time));
             xfer_done_time =
-                corebus_access(to_core->reply_bus, xfer_time);
+                corebus_access_cores(to_core->reply_bus,
+                                     parent_->get_source_core()->core_id,
+                                     to_core->core_id, xfer_time);
             WSMDB(1)(" -> %s\n", fmt_i64(xfer_done_time));
         }
 
@@ -5471,7 +5489,10 @@ public:
                 (virt_bits_per_ent + phys_bits_per_ent);
             OpTime xfer_time;
             estimate_bus_xfer_time(&xfer_time, xfer_bits);
-            i64 bus_done_time = corebus_access(to_core->reply_bus, xfer_time);
+            i64 bus_done_time =
+                corebus_access_cores(to_core->reply_bus,
+                                     parent_->get_source_core()->core_id,
+                                     to_core->core_id, xfer_time);
             WSMDB(1)("bus xfer est %ld bits, op-time {%d,%d}, "
                      "bus_done_time %s; ",
                      xfer_bits, xfer_time.latency,
@@ -5547,9 +5568,6 @@ public:
         printf("RegularMove: time %s commits %s, moving A%d from C%d to C%d\n",
                fmt_now(), fmt_i64(ase->total_commits),
                nomad_app_id, from_core_id, to_core_id);
-        if (GlobalPFAudit)
-            pfa_note_migrate(GlobalPFAudit, cyc, wc.reg_move.as, from_core_id,
-                             to_core_id);
         appmgr_migrate_app_soon(GlobalAppMgr, nomad_app_id,
                                 wc.reg_move.prev_targ_core,
                                 CtxHaltStyle_Fast, NULL);
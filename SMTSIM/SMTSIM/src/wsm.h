@@ -0,0 +1,78 @@
+// -*- C++ -*-
+//
+// Working-set migration: capture per-thread memory behavior in small
+// hardware tables, and use it to push or prefetch a migrating thread's
+// working set into the caches of the core it's moving to
+//
+// $Id$
+//
+
+#ifndef WSM_H
+#define WSM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// With "WSM/enable" set, one WSM_Coord is created at startup
+// (GlobalWSMCoord), and each core gets a WSM_ThreadCapture, fed with
+// committed instruction- and data-stream samples (see mem-profiler.h) for
+// the apps that the coordinator is interested in.
+//
+// The AppMgr notifies the coordinator of apps as they're added and removed,
+// and of each explicit migration: signal_deactivate() when an app is halted
+// for migration (summarizing what the source core's capture tables know
+// about it), and signal_activate() when it's swapped in at the target,
+// which starts whichever transfer mechanisms are enabled in
+// "WSM/RegularMove": oracle cache injection, cache-simulated prefetch of
+// the summary or of a future memory-reference trace, stream-buffer and
+// TLB migration, and so on.
+
+struct AppState;
+struct context;
+struct MemProfSample;
+
+typedef struct WSM_Coord WSM_Coord;
+typedef struct WSM_ThreadCapture WSM_ThreadCapture;
+
+extern WSM_Coord *GlobalWSMCoord;       // NULL unless WSM/enable
+
+
+WSM_Coord *wsm_coord_create(const char *config_path);
+void wsm_coord_destroy(WSM_Coord *coord);
+
+// The returned capture unit is owned by the caller, but must be destroyed
+// before "coord" is
+WSM_ThreadCapture *wsm_coord_create_threadcap(WSM_Coord *coord,
+                                              const char *name);
+
+void wsm_coord_register_app(WSM_Coord *coord, struct AppState *app);
+void wsm_coord_destroying_app(WSM_Coord *coord, struct AppState *app);
+
+// Should samples from "app" running on "ctx" be sent to its core's capture?
+int wsm_coord_wantsample(const WSM_Coord *coord,
+                         struct context *ctx, struct AppState *app);
+
+// NULL if table_id is out of range
+const char *wsm_table_name(const WSM_Coord *coord, int table_id);
+
+// "app" is being swapped in to "ctx", following a migration
+void wsm_coord_signal_activate(WSM_Coord *coord, struct AppState *app,
+                               struct context *ctx);
+// "app" is being halted on "ctx", for migration elsewhere
+void wsm_coord_signal_deactivate(WSM_Coord *coord, struct AppState *app,
+                                 struct context *ctx);
+
+void wsm_threadcap_reset(WSM_ThreadCapture *tc);
+void wsm_threadcap_destroy(WSM_ThreadCapture *tc);
+void wsm_threadcap_sample(WSM_ThreadCapture *tc, struct AppState *app,
+                          const struct MemProfSample *samp);
+void wsm_threadcap_printstats(const WSM_ThreadCapture *tc,
+                              void *c_FILE_out, const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // WSM_H
@@ -0,0 +1,96 @@
+#!/usr/bin/python
+#
+# Host-side simulation-rate comparison for Global/Mem/HugePages/policy.
+#
+# Runs the same fixed simulation once per policy (default "None" and
+# "Advise"), "-r" times each, and reports the "--Sim rate" line from each
+# run as KIPS (thousands of simulated instructions per host second), plus
+# the median and the speedup of each policy over the first.  Everything
+# after "--" is passed to smtsim unchanged, so the workload is whatever
+# those arguments select; e.g.:
+#
+#   huge_page_kips.py -r 3 ../smtsim/build.linux-amd64/smtsim -- \
+#       -conffile workloads-list_ffs0.conf \
+#       -confexpr 'WorkQueue/Jobs/job_1 = { start_time = 0.; workload = "applu"; };' \
+#       -confexpr 'WorkQueue/max_running_jobs = 1;' \
+#       -confexpr 'Global/thread_length = 50e6;'
+#
+# Run on an otherwise idle host; the "--RegionAlloc" lines from the first
+# non-"None" run are echoed, to confirm huge pages were actually used.
+
+import re
+import subprocess
+import sys
+from optparse import OptionParser
+
+sim_rate_re = re.compile(r'^--Sim rate: (\S+) cyc/s, (\S+) inst/s')
+
+
+def median(vals):
+    s = sorted(vals)
+    n = len(s)
+    if n % 2:
+        return s[n // 2]
+    return (s[n // 2 - 1] + s[n // 2]) / 2.0
+
+
+def run_once(exe, sim_args, policy):
+    cmd = [exe, '-confexpr',
+           'Global/Mem/HugePages/policy = "%s";' % policy] + sim_args
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            universal_newlines=True)
+    out = proc.communicate()[0]
+    if proc.returncode != 0:
+        sys.stderr.write('smtsim exited with status %d (policy %s)\n' %
+                         (proc.returncode, policy))
+        sys.exit(1)
+    kips = None
+    ralloc_lines = []
+    for line in out.splitlines():
+        m = sim_rate_re.match(line)
+        if m:
+            kips = float(m.group(2)) / 1000.0
+        elif line.startswith('--RegionAlloc'):
+            ralloc_lines.append(line)
+    if kips is None:
+        sys.stderr.write('no "--Sim rate" line in output (policy %s)\n' %
+                         policy)
+        sys.exit(1)
+    return kips, ralloc_lines
+
+
+def main():
+    parser = OptionParser(usage='%prog [options] smtsim_exe -- smtsim_args')
+    parser.add_option('-r', '--repeat', type='int', default=3,
+                      help='runs per policy (default 3)')
+    parser.add_option('-p', '--policies', default='None,Advise',
+                      help='comma-separated policies (default None,Advise)')
+    (opts, args) = parser.parse_args()
+    if len(args) < 1 or opts.repeat < 1:
+        parser.error('need smtsim_exe, and repeat >= 1')
+    exe = args[0]
+    sim_args = args[1:]
+    policies = opts.policies.split(',')
+
+    medians = []
+    shown_ralloc = False
+    for policy in policies:
+        rates = []
+        for i in range(opts.repeat):
+            kips, ralloc_lines = run_once(exe, sim_args, policy)
+            rates.append(kips)
+            print('%-8s run %d: %.1f KIPS' % (policy, i + 1, kips))
+            if policy != 'None' and not shown_ralloc and ralloc_lines:
+                for line in ralloc_lines:
+                    print('  ' + line)
+                shown_ralloc = True
+        medians.append(median(rates))
+
+    print('')
+    for (policy, med) in zip(policies, medians):
+        print('%-8s median %.1f KIPS, %.3fx vs %s' %
+              (policy, med, med / medians[0], policies[0]))
+
+
+if __name__ == '__main__':
+    main()